@@ -0,0 +1,215 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "cli/cmd_db_gc.hpp"
+
+extern "C" {
+#include <stdint.h>
+}
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cli/common.ipp"
+#include "store/exceptions.hpp"
+#include "store/gc.hpp"
+#include "store/layout.hpp"
+#include "utils/cmdline/exceptions.hpp"
+#include "utils/cmdline/options.hpp"
+#include "utils/cmdline/parser.ipp"
+#include "utils/cmdline/ui.hpp"
+#include "utils/datetime.hpp"
+#include "utils/defs.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/optional.ipp"
+#include "utils/units.hpp"
+
+namespace cmdline = utils::cmdline;
+namespace config = utils::config;
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace layout = store::layout;
+namespace units = utils::units;
+
+using cli::cmd_db_gc;
+using utils::optional;
+
+
+namespace {
+
+
+/// Number of seconds in a day.
+static const int64_t seconds_per_day = 24 * 60 * 60;
+
+
+/// Gets the value of a non-negative integer option, if given.
+///
+/// \param cmdline The parsed command line.
+/// \param name The long name of the option.
+///
+/// \return The value of the option, or none if not specified.
+///
+/// \throw cmdline::usage_error If the value is negative.
+static optional< int >
+get_count_option(const cmdline::parsed_cmdline& cmdline, const char* name)
+{
+    if (!cmdline.has_option(name))
+        return utils::none;
+    const int value = cmdline.get_option< cmdline::int_option >(name);
+    if (value < 0)
+        throw cmdline::usage_error(F("Invalid value for --%s: must be a "
+                                     "non-negative number") % name);
+    return utils::make_optional(value);
+}
+
+
+/// Builds the garbage-collection policy from the command line.
+///
+/// \param cmdline The parsed command line.
+///
+/// \return The policy to apply to the store directory.
+///
+/// \throw cmdline::usage_error If any of the options is invalid.
+static store::gc_policy
+build_policy(const cmdline::parsed_cmdline& cmdline)
+{
+    store::gc_policy policy;
+
+    const optional< int > keep_last = get_count_option(cmdline, "keep-last");
+    if (keep_last)
+        policy.keep_last = utils::make_optional(
+            static_cast< std::size_t >(keep_last.get()));
+
+    const optional< int > keep_failed = get_count_option(cmdline,
+                                                         "keep-failed");
+    if (keep_failed)
+        policy.keep_failed = utils::make_optional(
+            static_cast< std::size_t >(keep_failed.get()));
+
+    if (cmdline.has_option("max-size")) {
+        const std::string raw = cmdline.get_option< cmdline::string_option >(
+            "max-size");
+        try {
+            policy.max_size = utils::make_optional(units::bytes::parse(raw));
+        } catch (const std::runtime_error& e) {
+            throw cmdline::usage_error(F("Invalid value for --max-size: %s") %
+                                       e.what());
+        }
+    }
+
+    const optional< int > days = get_count_option(cmdline,
+                                                  "strip-passed-output");
+    if (days)
+        policy.strip_passed_output_age = utils::make_optional(
+            datetime::delta(days.get() * seconds_per_day, 0));
+
+    policy.compact = cmdline.has_option("compact");
+
+    return policy;
+}
+
+
+/// Prints a list of files affected by an action.
+///
+/// \param ui Object to interact with the I/O of the program.
+/// \param action Verb describing what was done to the files.
+/// \param files The affected files.
+static void
+print_files(cmdline::ui* ui, const std::string& action,
+            const std::vector< fs::path >& files)
+{
+    for (std::vector< fs::path >::const_iterator iter = files.begin();
+         iter != files.end(); ++iter) {
+        ui->out(F("%s %s") % action % *iter);
+    }
+}
+
+
+}  // anonymous namespace
+
+
+/// Default constructor for cmd_db_gc.
+cmd_db_gc::cmd_db_gc(void) : cli_command(
+    "db-gc", "", 0, 0,
+    "Deletes old results files from the store directory and reclaims space "
+    "from the ones that are kept")
+{
+    add_option(cmdline::int_option(
+        "keep-last", "Number of most recent runs to keep per test suite",
+        "count"));
+    add_option(cmdline::int_option(
+        "keep-failed", "Number of most recent runs with failures to keep "
+        "per test suite in addition to --keep-last", "count"));
+    add_option(cmdline::string_option(
+        "max-size", "Maximum total size of the results files (e.g. 500M)",
+        "size"));
+    add_option(cmdline::int_option(
+        "strip-passed-output", "Drop the output of passed test cases from "
+        "runs older than this many days", "days"));
+    add_option(cmdline::bool_option(
+        "compact", "Rebuild the kept results files to reclaim unused space"));
+    add_option(cmdline::bool_option(
+        "dry-run", "Only print what would be done"));
+}
+
+
+/// Entry point for the "db-gc" subcommand.
+///
+/// \param ui Object to interact with the I/O of the program.
+/// \param cmdline Representation of the command line to the subcommand.
+/// \param unused_user_config The runtime configuration of the program.
+///
+/// \return 0 if everything is OK, 1 if there is any problem.
+int
+cmd_db_gc::run(cmdline::ui* ui, const cmdline::parsed_cmdline& cmdline,
+               const config::tree& UTILS_UNUSED_PARAM(user_config))
+{
+    const store::gc_policy policy = build_policy(cmdline);
+    const bool dry_run = cmdline.has_option("dry-run");
+
+    try {
+        const store::gc_result result = store::gc(
+            layout::query_store_dir(), policy, dry_run);
+
+        print_files(ui, dry_run ? "Would remove" : "Removed", result.removed);
+        print_files(ui, dry_run ? "Would strip" : "Stripped",
+                    result.stripped);
+        print_files(ui, dry_run ? "Would compact" : "Compacted",
+                    result.compacted);
+        ui->out(F("Store size: %s before, %s after") %
+                result.size_before.format() % result.size_after.format());
+        return EXIT_SUCCESS;
+    } catch (const store::error& e) {
+        cmdline::print_error(ui, F("Garbage collection failed: %s.") %
+                             e.what());
+        return EXIT_FAILURE;
+    }
+}
@@ -135,6 +135,7 @@ cli::cmd_list::cmd_list(void) :
                 "Lists test cases and their meta-data")
 {
     add_option(build_root_option);
+    add_option(filters_from_option);
     add_option(kyuafile_option);
     add_option(cmdline::bool_option('v', "verbose", "Show properties"));
 }
@@ -154,7 +155,7 @@ cli::cmd_list::run(cmdline::ui* ui, const cmdline::parsed_cmdline& cmdline,
     progress_hooks hooks(ui, cmdline.has_option("verbose"));
     const drivers::list_tests::result result = drivers::list_tests::drive(
         kyuafile_path(cmdline), build_root_path(cmdline),
-        parse_filters(cmdline.arguments()), user_config, hooks);
+        parse_filters(cmdline), user_config, hooks);
 
     return report_unused_filters(result.unused_filters, ui) ?
         EXIT_FAILURE : EXIT_SUCCESS;
@@ -31,8 +31,10 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdlib>
+#include <istream>
 #include <map>
 #include <ostream>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -44,7 +46,6 @@
 #include "model/test_program.hpp"
 #include "model/test_result.hpp"
 #include "model/types.hpp"
-#include "store/layout.hpp"
 #include "store/read_transaction.hpp"
 #include "utils/cmdline/exceptions.hpp"
 #include "utils/cmdline/options.hpp"
@@ -63,7 +64,6 @@ namespace cmdline = utils::cmdline;
 namespace config = utils::config;
 namespace datetime = utils::datetime;
 namespace fs = utils::fs;
-namespace layout = store::layout;
 namespace text = utils::text;
 
 using cli::cmd_report;
@@ -73,6 +73,28 @@ using utils::optional;
 namespace {
 
 
+/// Time to wait between checks for new results in follow mode.
+static const datetime::delta follow_poll_interval(1, 0);
+
+
+/// Copies the contents of a stream into another one.
+///
+/// Unlike injecting the input's buffer into the output, this lets any error
+/// raised while reading the input propagate to the caller.
+///
+/// \param input The stream to read from.
+/// \param output The stream to write to.
+static void
+copy_stream(std::istream& input, std::ostream& output)
+{
+    char buffer[64 * 1024];
+    while (input.good()) {
+        input.read(buffer, sizeof(buffer));
+        output.write(buffer, input.gcount());
+    }
+}
+
+
 /// Generates a plain-text report intended to be printed to the console.
 class report_console_hooks : public drivers::scan_results::base_hooks {
     /// Stream to which to write the report.
@@ -81,11 +103,14 @@ class report_console_hooks : public drivers::scan_results::base_hooks {
     /// Whether to include details in the report or not.
     const bool _verbose;
 
+    /// Whether to print results as they are received instead of grouped.
+    const bool _follow;
+
     /// Collection of result types to include in the report.
     const cli::result_types& _results_filters;
 
-    /// Path to the results file being read.
-    const fs::path& _results_file;
+    /// Paths to the results files being read.
+    const std::vector< fs::path >& _results_files;
 
     /// The total run time of the tests.
     utils::datetime::delta _runtime;
@@ -122,10 +147,16 @@ class report_console_hooks : public drivers::scan_results::base_hooks {
 
     /// Results received, broken down by their type.
     ///
-    /// Note that this may not include all results, as keeping the whole list in
-    /// memory may be too much.
+    /// This only includes the results of the types to be reported, and only
+    /// when they are not printed as soon as they are received.
     std::map< model::test_result_type, std::vector< result_data > > _results;
 
+    /// Number of results of each type.
+    std::map< model::test_result_type, std::size_t > _counts;
+
+    /// Whether the counts and run time come from a precomputed summary.
+    bool _got_summary;
+
     /// Pretty-prints the value of an environment variable.
     ///
     /// \param indent Prefix for the lines to print.  Continuation lines
@@ -200,32 +231,59 @@ class report_console_hooks : public drivers::scan_results::base_hooks {
             }
         }
 
-        const std::string stdout_contents = result_iter.stdout_contents();
-        if (!stdout_contents.empty()) {
+        const std::shared_ptr< std::istream > stdout_stream =
+            result_iter.stdout_stream();
+        if (stdout_stream->peek() != std::istream::traits_type::eof()) {
             _output << "\n"
-                    << "Standard output:\n"
-                    << stdout_contents;
+                    << "Standard output:\n";
+            copy_stream(*stdout_stream, _output);
         }
 
-        const std::string stderr_contents = result_iter.stderr_contents();
-        if (!stderr_contents.empty()) {
+        const std::shared_ptr< std::istream > stderr_stream =
+            result_iter.stderr_stream();
+        if (stderr_stream->peek() != std::istream::traits_type::eof()) {
             _output << "\n"
-                    << "Standard error:\n"
-                    << stderr_contents;
+                    << "Standard error:\n";
+            copy_stream(*stderr_stream, _output);
         }
     }
 
+    /// Checks if a result type was requested by the user.
+    ///
+    /// \param type The type to check.
+    ///
+    /// \return True if results of this type have to be reported.
+    bool
+    is_selected(const model::test_result_type type) const
+    {
+        // TODO(jmmv): _results_filters is a list and is small enough for
+        // std::find to not be an expensive operation here (probably).  But
+        // we should be using a std::set instead.
+        return std::find(_results_filters.begin(), _results_filters.end(),
+                         type) != _results_filters.end();
+    }
+
+    /// Prints the one-line summary of a single result.
+    ///
+    /// \param data The result to print.
+    void
+    print_result(const result_data& data)
+    {
+        _output << F("%s:%s  ->  %s  [%s]\n") % data.binary_path %
+            data.test_case_name % cli::format_result(data.result) %
+            cli::format_delta(data.duration);
+    }
+
     /// Counts how many results of a given type have been received.
     std::size_t
     count_results(const model::test_result_type type)
     {
-        const std::map< model::test_result_type,
-                        std::vector< result_data > >::const_iterator iter =
-            _results.find(type);
-        if (iter == _results.end())
+        const std::map< model::test_result_type, std::size_t >::const_iterator
+            iter = _counts.find(type);
+        if (iter == _counts.end())
             return 0;
         else
-            return (*iter).second.size();
+            return (*iter).second;
     }
 
     /// Prints a set of results.
@@ -243,10 +301,7 @@ class report_console_hooks : public drivers::scan_results::base_hooks {
         _output << F("===> %s\n") % title;
         for (std::vector< result_data >::const_iterator iter = all.begin();
              iter != all.end(); iter++) {
-            _output << F("%s:%s  ->  %s  [%s]\n") % (*iter).binary_path %
-                (*iter).test_case_name %
-                cli::format_result((*iter).result) %
-                cli::format_delta((*iter).duration);
+            print_result(*iter);
         }
     }
 
@@ -255,16 +310,20 @@ public:
     ///
     /// \param [out] output_ Stream to which to write the report.
     /// \param verbose_ Whether to include details in the output or not.
+    /// \param follow_ Whether to print results as soon as they are received.
     /// \param results_filters_ The result types to include in the report.
     ///     Cannot be empty.
-    /// \param results_file_ Path to the results file being read.
+    /// \param results_files_ Paths to the results files being read.
     report_console_hooks(std::ostream& output_, const bool verbose_,
+                         const bool follow_,
                          const cli::result_types& results_filters_,
-                         const fs::path& results_file_) :
+                         const std::vector< fs::path >& results_files_) :
         _output(output_),
         _verbose(verbose_),
+        _follow(follow_),
         _results_filters(results_filters_),
-        _results_file(results_file_)
+        _results_files(results_files_),
+        _got_summary(false)
     {
         PRE(!results_filters_.empty());
     }
@@ -279,26 +338,41 @@ public:
             print_context(context);
     }
 
+    /// Callback executed when the summary of the results is computed.
+    ///
+    /// \param summary Aggregated information about all the results.
+    void
+    got_summary(const store::results_summary& summary)
+    {
+        _counts = summary.counts;
+        _runtime = summary.duration;
+        _got_summary = true;
+    }
+
     /// Callback executed when a test results is found.
     ///
     /// \param iter Container for the test result's data.
     void
     got_result(store::results_iterator& iter)
     {
-        _runtime += iter.duration();
         const model::test_result result = iter.result();
-        _results[result.type()].push_back(
-            result_data(iter.test_program()->relative_path(),
-                        iter.test_case_name(), iter.result(), iter.duration()));
-
-        if (_verbose) {
-            // TODO(jmmv): _results_filters is a list and is small enough for
-            // std::find to not be an expensive operation here (probably).  But
-            // we should be using a std::set instead.
-            if (std::find(_results_filters.begin(), _results_filters.end(),
-                          iter.result().type()) != _results_filters.end()) {
+        if (!_got_summary) {
+            _runtime += iter.duration();
+            ++_counts[result.type()];
+        }
+
+        if (is_selected(result.type())) {
+            const result_data data(iter.test_program()->relative_path(),
+                                   iter.test_case_name(), result,
+                                   iter.duration());
+            if (_follow)
+                print_result(data);
+            else
+                _results[result.type()].push_back(data);
+            if (_verbose)
                 print_test_case_and_result(iter);
-            }
+            if (_follow)
+                _output.flush();
         }
     }
 
@@ -317,8 +391,10 @@ public:
         titles[model::test_result_passed] = "Passed tests";
         titles[model::test_result_skipped] = "Skipped tests";
 
+        // In follow mode, the results have already been printed as they
+        // were received.
         for (cli::result_types::const_iterator iter = _results_filters.begin();
-             iter != _results_filters.end(); ++iter) {
+             !_follow && iter != _results_filters.end(); ++iter) {
             const types_map::const_iterator match = titles.find(*iter);
             INV_MSG(match != titles.end(), "Conditional does not match user "
                     "input validation in parse_types()");
@@ -334,7 +410,9 @@ public:
         const std::size_t total = broken + failed + passed + skipped + xfail;
 
         _output << "===> Summary\n";
-        _output << F("Results read from %s\n") % _results_file;
+        for (std::vector< fs::path >::const_iterator iter =
+                 _results_files.begin(); iter != _results_files.end(); ++iter)
+            _output << F("Results read from %s\n") % *iter;
         _output << F("Test cases: %s total, %s skipped, %s expected failures, "
                      "%s broken, %s failed\n") %
             total % skipped % xfail % broken % failed;
@@ -355,8 +433,12 @@ cmd_report::cmd_report(void) : cli_command(
     add_option(cmdline::bool_option(
         "verbose", "Include the execution context and the details of each test "
         "case in the report"));
+    add_option(filters_from_option);
     add_option(cmdline::path_option("output", "Path to the output file", "path",
                                     "/dev/stdout"));
+    add_option(cmdline::bool_option(
+        "follow", "Print results as they are recorded and wait until the "
+        "test suite run writing to the results file finishes"));
     add_option(results_filter_option);
 }
 
@@ -377,14 +459,24 @@ cmd_report::run(cmdline::ui* ui,
     std::auto_ptr< std::ostream > output = utils::open_ostream(
         cmdline.get_option< cmdline::path_option >("output"));
 
-    const fs::path results_file = layout::find_results(
-        results_file_open(cmdline));
+    const std::vector< fs::path > results_files = find_results_files(cmdline);
 
     const result_types types = get_result_types(cmdline);
+    const bool follow = cmdline.has_option("follow");
+    if (follow && results_files.size() > 1)
+        throw cmdline::usage_error("--follow can only be used with a single "
+                                   "results file");
     report_console_hooks hooks(*output.get(), cmdline.has_option("verbose"),
-                               types, results_file);
-    const drivers::scan_results::result result = drivers::scan_results::drive(
-        results_file, parse_filters(cmdline.arguments()), hooks);
+                               follow, types, results_files);
+    const drivers::scan_results::result result = follow ?
+        drivers::scan_results::follow(results_files[0],
+                                      parse_filters(cmdline),
+                                      follow_poll_interval, hooks) :
+        drivers::scan_results::drive(results_files,
+                                     parse_filters(cmdline),
+                                     std::set< model::test_result_type >(
+                                         types.begin(), types.end()),
+                                     hooks);
 
     return report_unused_filters(result.unused_filters, ui) ?
         EXIT_FAILURE : EXIT_SUCCESS;
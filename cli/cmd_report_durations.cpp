@@ -0,0 +1,298 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "cli/cmd_report_durations.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cli/common.ipp"
+#include "drivers/compare_durations.hpp"
+#include "store/layout.hpp"
+#include "utils/cmdline/exceptions.hpp"
+#include "utils/cmdline/options.hpp"
+#include "utils/cmdline/parser.ipp"
+#include "utils/datetime.hpp"
+#include "utils/defs.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/stream.hpp"
+
+namespace cmdline = utils::cmdline;
+namespace compare_durations = drivers::compare_durations;
+namespace config = utils::config;
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace layout = store::layout;
+
+using cli::cmd_report_durations;
+
+
+namespace {
+
+
+/// Number of previous runs to compare against if no baseline is given.
+static const std::size_t default_baseline_runs = 5;
+
+
+/// Gets the value of a non-negative integer option.
+///
+/// \param cmdline The parsed command line.
+/// \param name The name of the option.
+///
+/// \return The value of the option.
+///
+/// \throw cmdline::usage_error If the value is negative.
+static int
+get_count_option(const cmdline::parsed_cmdline& cmdline, const char* name)
+{
+    const int value = cmdline.get_option< cmdline::int_option >(name);
+    if (value < 0)
+        throw cmdline::usage_error(F("Invalid value for --%s: must be a "
+                                     "non-negative number") % name);
+    return value;
+}
+
+
+/// Gets the number of previous runs to compare against.
+///
+/// \param cmdline The parsed command line.
+///
+/// \return The number of runs, or 0 if the user specified explicit baselines
+/// with --baseline.
+///
+/// \throw cmdline::usage_error If the baseline flags are inconsistent.
+static std::size_t
+get_baseline_runs(const cmdline::parsed_cmdline& cmdline)
+{
+    if (cmdline.has_option("baseline")) {
+        if (cmdline.has_option("baseline-runs"))
+            throw cmdline::usage_error("--baseline and --baseline-runs are "
+                                       "mutually exclusive");
+        return 0;
+    }
+
+    if (!cmdline.has_option("baseline-runs"))
+        return default_baseline_runs;
+    const int runs = get_count_option(cmdline, "baseline-runs");
+    if (runs == 0)
+        throw cmdline::usage_error("Invalid value for --baseline-runs: must be "
+                                   "at least 1");
+    return static_cast< std::size_t >(runs);
+}
+
+
+/// Locates the baseline results files.
+///
+/// If the user specified --baseline, those files are used.  Otherwise, the
+/// baseline is formed by the runs of the test suite in the current directory
+/// that precede the current results file.
+///
+/// \param cmdline The parsed command line.
+/// \param runs The number of previous runs to use, or 0 to use the files
+///     given with --baseline.
+/// \param current Path to the results file to check for slowdowns.
+///
+/// \return The paths to the baseline results files.
+///
+/// \throw std::runtime_error If there are no runs before the current one.
+/// \throw store::error If the baseline results files cannot be found.
+static std::vector< fs::path >
+find_baselines(const cmdline::parsed_cmdline& cmdline, const std::size_t runs,
+               const fs::path& current)
+{
+    std::vector< fs::path > baselines;
+
+    if (runs == 0) {
+        const std::vector< std::string > ids =
+            cmdline.get_multi_option< cmdline::string_option >("baseline");
+        for (std::vector< std::string >::const_iterator iter = ids.begin();
+             iter != ids.end(); ++iter)
+            baselines.push_back(layout::find_results(*iter));
+        return baselines;
+    }
+
+    // The history is sorted by the time of the runs, so any file after the
+    // current one is a newer run and must not be part of the baseline.
+    const std::vector< fs::path > history = layout::find_history(
+        layout::test_suite_for_path(fs::current_path()),
+        std::numeric_limits< std::size_t >::max());
+    std::vector< fs::path >::const_iterator last = history.begin();
+    while (last != history.end() &&
+           (*last).leaf_name() != current.leaf_name())
+        ++last;
+    std::vector< fs::path >::const_iterator first = history.begin();
+    if (static_cast< std::size_t >(last - first) > runs)
+        first = last - runs;
+    baselines.insert(baselines.end(), first, last);
+    if (baselines.empty())
+        throw std::runtime_error(F("No runs before %s to use as a baseline") %
+                                 current);
+    return baselines;
+}
+
+
+/// Formats the change between two durations.
+///
+/// \param current The new duration.
+/// \param baseline The old duration.
+///
+/// \return A textual representation of the change as a percentage.
+static std::string
+format_change(const datetime::delta& current, const datetime::delta& baseline)
+{
+    if (baseline == datetime::delta()) {
+        if (current == datetime::delta())
+            return "+0%";
+        else
+            return "new";
+    }
+
+    const double ratio =
+        static_cast< double >(current.to_microseconds()) /
+        static_cast< double >(baseline.to_microseconds()) - 1.0;
+    const long percent = static_cast< long >(std::floor(ratio * 100.0 + 0.5));
+    return F("%s%s%%") % (percent < 0 ? "-" : "+") % std::labs(percent);
+}
+
+
+/// Prints the report of the slowdowns.
+///
+/// \param output Stream to which to write the report.
+/// \param result The results of the comparison.
+static void
+print_report(std::ostream& output, const compare_durations::result& result)
+{
+    if (!result.slowdowns.empty()) {
+        output << "===> Slower test cases\n";
+        for (std::vector< compare_durations::test_case_slowdown >::
+                 const_iterator iter = result.slowdowns.begin();
+             iter != result.slowdowns.end(); ++iter) {
+            const compare_durations::test_case_slowdown& slowdown = *iter;
+            output << F("%s:%s  ->  %s, was %s +/- %s  (%s)\n") %
+                slowdown.test_program % slowdown.test_case_name %
+                cli::format_delta(slowdown.current) %
+                cli::format_delta(slowdown.baseline_mean) %
+                cli::format_delta(slowdown.baseline_stddev) %
+                format_change(slowdown.current, slowdown.baseline_mean);
+        }
+    }
+
+    datetime::delta baseline_total, current_total;
+    if (!result.programs.empty()) {
+        output << "===> Test programs\n";
+        for (std::vector< compare_durations::test_program_totals >::
+                 const_iterator iter = result.programs.begin();
+             iter != result.programs.end(); ++iter) {
+            const compare_durations::test_program_totals& totals = *iter;
+            output << F("%s  ->  %s, was %s  (%s)\n") % totals.test_program %
+                cli::format_delta(totals.current) %
+                cli::format_delta(totals.baseline) %
+                format_change(totals.current, totals.baseline);
+            baseline_total += totals.baseline;
+            current_total += totals.current;
+        }
+    }
+
+    output << "===> Summary\n";
+    output << F("Baseline runs: %s\n") % result.baseline_runs;
+    output << F("Slower test cases: %s\n") % result.slowdowns.size();
+    output << F("Total time: %s, was %s  (%s)\n") %
+        cli::format_delta(current_total) % cli::format_delta(baseline_total) %
+        format_change(current_total, baseline_total);
+}
+
+
+}  // anonymous namespace
+
+
+/// Default constructor for cmd_report_durations.
+cmd_report_durations::cmd_report_durations(void) : cli_command(
+    "report-durations", "[test-filter1 .. test-filterN]", 0, -1,
+    "Lists the test cases that became slower compared to previous runs")
+{
+    add_option(results_file_open_option);
+    add_option(cmdline::string_option(
+        "baseline", "Results file to compare against; can be repeated",
+        "file"));
+    add_option(cmdline::int_option(
+        "baseline-runs", "Number of previous runs of the test suite to "
+        "compare against if --baseline is not given (default: 5)", "count"));
+    add_option(cmdline::int_option(
+        "min-delta", "Minimum slowdown to report, in milliseconds", "ms",
+        "100"));
+    add_option(filters_from_option);
+    add_option(cmdline::path_option("output", "Path to the output file", "path",
+                                    "/dev/stdout"));
+    add_option(cmdline::int_option(
+        "threshold", "Minimum slowdown to report, as a percentage of the "
+        "baseline run time", "percent", "20"));
+}
+
+
+/// Entry point for the "report-durations" subcommand.
+///
+/// \param ui Object to interact with the I/O of the program.
+/// \param cmdline Representation of the command line to the subcommand.
+/// \param unused_user_config The runtime configuration of the program.
+///
+/// \return 0 if everything is OK, 1 if any of the filters did not match any
+/// test case.
+int
+cmd_report_durations::run(cmdline::ui* ui,
+                          const cmdline::parsed_cmdline& cmdline,
+                          const config::tree& UTILS_UNUSED_PARAM(user_config))
+{
+    const compare_durations::thresholds thresholds(
+        get_count_option(cmdline, "threshold") / 100.0,
+        datetime::delta::from_microseconds(
+            static_cast< int64_t >(get_count_option(cmdline, "min-delta")) *
+            1000));
+    const std::size_t baseline_runs = get_baseline_runs(cmdline);
+
+    std::auto_ptr< std::ostream > output = utils::open_ostream(
+        cmdline.get_option< cmdline::path_option >("output"));
+
+    const fs::path current = layout::find_results(results_file_open(cmdline));
+    const std::vector< fs::path > baselines = find_baselines(
+        cmdline, baseline_runs, current);
+
+    const compare_durations::result result = compare_durations::drive(
+        baselines, current, parse_filters(cmdline), thresholds);
+    print_report(*output.get(), result);
+
+    return report_unused_filters(result.unused_filters, ui) ?
+        EXIT_FAILURE : EXIT_SUCCESS;
+}
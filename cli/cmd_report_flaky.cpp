@@ -0,0 +1,167 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "cli/cmd_report_flaky.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "cli/common.ipp"
+#include "drivers/detect_flaky.hpp"
+#include "store/layout.hpp"
+#include "utils/cmdline/exceptions.hpp"
+#include "utils/cmdline/options.hpp"
+#include "utils/cmdline/parser.ipp"
+#include "utils/datetime.hpp"
+#include "utils/defs.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/stream.hpp"
+
+namespace cmdline = utils::cmdline;
+namespace config = utils::config;
+namespace detect_flaky = drivers::detect_flaky;
+namespace fs = utils::fs;
+namespace layout = store::layout;
+
+using cli::cmd_report_flaky;
+
+
+namespace {
+
+
+/// Default number of runs to analyze.
+static const char* default_runs = "20";
+
+
+/// Determines the test suite to analyze.
+///
+/// \param cmdline The parsed command line.
+///
+/// \return The identifier of the test suite given with --test-suite, or the
+/// identifier of the test suite rooted at the current directory if the flag
+/// was not provided.  Directories are converted to their identifier.
+static std::string
+get_test_suite(const cmdline::parsed_cmdline& cmdline)
+{
+    if (!cmdline.has_option("test-suite"))
+        return layout::test_suite_for_path(fs::current_path());
+
+    const std::string id = cmdline.get_option< cmdline::string_option >(
+        "test-suite");
+    if (id.find('/') != std::string::npos ||
+        (fs::exists(fs::path(id)) && fs::is_directory(fs::path(id))))
+        return layout::test_suite_for_path(fs::path(id));
+    return id;
+}
+
+
+/// Prints the report of the flaky test cases.
+///
+/// \param output Stream to which to write the report.
+/// \param result The results of the analysis.
+static void
+print_report(std::ostream& output, const detect_flaky::result& result)
+{
+    if (!result.flaky.empty()) {
+        output << "===> Flaky test cases\n";
+        for (std::vector< detect_flaky::test_case_history >::const_iterator
+                 iter = result.flaky.begin(); iter != result.flaky.end();
+                 ++iter) {
+            const detect_flaky::test_case_history& history = *iter;
+            output << F("%s:%s  ->  %s changes in %s runs, %s failed  "
+                        "[%s +/- %s]\n") %
+                history.test_program % history.test_case_name %
+                history.transitions % history.runs % history.failures %
+                cli::format_delta(history.mean_duration) %
+                cli::format_delta(history.duration_stddev);
+        }
+    }
+
+    output << "===> Summary\n";
+    output << F("Runs analyzed: %s\n") % result.runs;
+    output << F("Flaky test cases: %s\n") % result.flaky.size();
+}
+
+
+}  // anonymous namespace
+
+
+/// Default constructor for cmd_report_flaky.
+cmd_report_flaky::cmd_report_flaky(void) : cli_command(
+    "report-flaky", "[test-filter1 .. test-filterN]", 0, -1,
+    "Lists the test cases whose result changes across the recent runs of a "
+    "test suite")
+{
+    add_option(filters_from_option);
+    add_option(cmdline::path_option("output", "Path to the output file", "path",
+                                    "/dev/stdout"));
+    add_option(cmdline::int_option(
+        "runs", "Number of most recent runs to analyze", "count",
+        default_runs));
+    add_option(cmdline::string_option(
+        "test-suite", "Identifier of the test suite or path to its root "
+        "directory; if not given, uses the current directory", "id"));
+}
+
+
+/// Entry point for the "report-flaky" subcommand.
+///
+/// \param ui Object to interact with the I/O of the program.
+/// \param cmdline Representation of the command line to the subcommand.
+/// \param unused_user_config The runtime configuration of the program.
+///
+/// \return 0 if everything is OK, 1 if any of the filters did not match any
+/// test case.
+int
+cmd_report_flaky::run(cmdline::ui* ui,
+                      const cmdline::parsed_cmdline& cmdline,
+                      const config::tree& UTILS_UNUSED_PARAM(user_config))
+{
+    const int runs = cmdline.get_option< cmdline::int_option >("runs");
+    if (runs < 2)
+        throw cmdline::usage_error("Invalid value for --runs: must be at "
+                                   "least 2");
+
+    std::auto_ptr< std::ostream > output = utils::open_ostream(
+        cmdline.get_option< cmdline::path_option >("output"));
+
+    const std::vector< fs::path > files = layout::find_history(
+        get_test_suite(cmdline), static_cast< std::size_t >(runs));
+
+    const detect_flaky::result result = detect_flaky::drive(
+        files, parse_filters(cmdline));
+    print_report(*output.get(), result);
+
+    return report_unused_filters(result.unused_filters, ui) ?
+        EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -28,11 +28,21 @@
 
 #include "cli/cmd_report_html.hpp"
 
+extern "C" {
+#include <stdint.h>
+}
+
 #include <algorithm>
 #include <cerrno>
 #include <cstdlib>
+#include <fstream>
+#include <istream>
+#include <map>
 #include <set>
 #include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "cli/common.ipp"
 #include "drivers/scan_results.hpp"
@@ -42,8 +52,9 @@
 #include "model/test_case.hpp"
 #include "model/test_program.hpp"
 #include "model/test_result.hpp"
-#include "store/layout.hpp"
+#include "store/read_backend.hpp"
 #include "store/read_transaction.hpp"
+#include "utils/cmdline/exceptions.hpp"
 #include "utils/cmdline/options.hpp"
 #include "utils/cmdline/parser.ipp"
 #include "utils/cmdline/ui.hpp"
@@ -53,14 +64,20 @@
 #include "utils/fs/exceptions.hpp"
 #include "utils/fs/operations.hpp"
 #include "utils/fs/path.hpp"
+#include "utils/logging/macros.hpp"
 #include "utils/optional.ipp"
+#include "utils/process/child.ipp"
+#include "utils/process/status.hpp"
+#include "utils/sanity.hpp"
+#include "utils/stream.hpp"
+#include "utils/text/operations.hpp"
 #include "utils/text/templates.hpp"
 
 namespace cmdline = utils::cmdline;
 namespace config = utils::config;
 namespace datetime = utils::datetime;
 namespace fs = utils::fs;
-namespace layout = store::layout;
+namespace process = utils::process;
 namespace text = utils::text;
 
 using utils::optional;
@@ -135,22 +152,330 @@ add_map(text::templates_def& templates, const config::properties_map& props,
 
     for (config::properties_map::const_iterator iter = props.begin();
          iter != props.end(); ++iter) {
-        templates.add_to_vector(key_vector, (*iter).first);
-        templates.add_to_vector(value_vector, (*iter).second);
+        templates.add_to_vector(key_vector, text::escape_xml((*iter).first));
+        templates.add_to_vector(value_vector,
+                                text::escape_xml((*iter).second));
     }
 }
 
 
-/// Generates an HTML report.
-class html_hooks : public drivers::scan_results::base_hooks {
+/// Number of test cases listed in every page of the paged layout.
+static const std::size_t tests_per_page = 1000;
+
+
+/// Number of test cases whose details are packed in a single data file.
+static const std::size_t details_per_shard = 500;
+
+
+/// Maximum number of processes that generate the details of the test cases.
+///
+/// Workers load the details of their test cases straight from the results
+/// files, so going beyond this just adds contention on the disk.
+static const std::size_t max_jobs = 64;
+
+
+/// Layouts of the HTML report.
+enum report_layout {
+    /// One page per test case plus an index listing all of them.
+    layout_simple,
+
+    /// Paginated lists of test cases with their details in data files.
+    layout_paged,
+};
+
+
+/// Settings of the report to generate.
+struct report_settings {
     /// User interface object where to report progress.
+    cmdline::ui* ui;
+
+    /// The top directory in which to create the HTML files.
+    fs::path directory;
+
+    /// Collection of result types to include in the report.
+    cli::result_types results_filters;
+
+    /// Layout of the report.
+    report_layout layout;
+
+    /// Whether to include the details of passed test cases.
+    ///
+    /// Only honored by the paged layout.
+    bool passed_details;
+
+    /// Number of processes that generate the details of the test cases.
+    std::size_t jobs;
+
+    /// Constructs a new set of settings.
+    ///
+    /// \param ui_ User interface object where to report progress.
+    /// \param directory_ The directory in which to create the HTML files.
+    /// \param results_filters_ The result types to include in the report.
+    ///     Cannot be empty.
+    /// \param layout_ Layout of the report.
+    /// \param passed_details_ Whether to include the details of passed test
+    ///     cases.
+    /// \param jobs_ Number of processes that generate the details of the test
+    ///     cases.
+    report_settings(cmdline::ui* ui_, const fs::path& directory_,
+                    const cli::result_types& results_filters_,
+                    const report_layout layout_, const bool passed_details_,
+                    const std::size_t jobs_) :
+        ui(ui_), directory(directory_), results_filters(results_filters_),
+        layout(layout_), passed_details(passed_details_), jobs(jobs_)
+    {
+        PRE(!results_filters.empty());
+        PRE(jobs > 0 && jobs <= max_jobs);
+    }
+};
+
+
+/// A test case whose details are generated by a worker process.
+struct details_item {
+    /// Position of the results file that holds the test case.
+    std::size_t file;
+
+    /// Identifier of the test case within its results file.
+    int64_t test_case_id;
+
+    /// Batch to which the test case belongs.
+    ///
+    /// The details of all the test cases of a batch are loaded at once.  In
+    /// the paged layout, every data file is a batch.
+    std::size_t batch;
+
+    /// Constructor.
+    ///
+    /// \param file_ Position of the results file that holds the test case.
+    /// \param test_case_id_ Identifier of the test case within its file.
+    /// \param batch_ Batch to which the test case belongs.
+    details_item(const std::size_t file_, const int64_t test_case_id_,
+                 const std::size_t batch_) :
+        file(file_), test_case_id(test_case_id_), batch(batch_)
+    {
+    }
+};
+
+
+/// Collection of test cases whose details are generated by a worker process.
+///
+/// Items of the same batch are consecutive.
+typedef std::vector< details_item > details_vector;
+
+
+/// Generates the files of a report out of the installed templates.
+class report_generator {
+    /// User interface object where to report progress, if any.
     cmdline::ui* _ui;
 
     /// The top directory in which to create the HTML files.
     fs::path _directory;
 
-    /// Collection of result types to include in the report.
-    const cli::result_types& _results_filters;
+    /// Cache of the templates compiled so far, keyed by their name.
+    ///
+    /// Every test case generates a file out of the same template, so parsing
+    /// each template only once saves most of the work of generating a report.
+    std::map< std::string, text::compiled_template > _compiled;
+
+public:
+    /// Constructor.
+    ///
+    /// \param ui_ User interface object where to report progress, or NULL to
+    ///     generate the files silently.
+    /// \param directory_ The directory in which to create the files.
+    report_generator(cmdline::ui* ui_, const fs::path& directory_) :
+        _ui(ui_),
+        _directory(directory_)
+    {
+    }
+
+    /// Computes the path to a file of the report.
+    ///
+    /// \param output_name The name of the file relative to the top directory.
+    ///
+    /// \return The path to the file.
+    fs::path
+    path(const std::string& output_name) const
+    {
+        return _directory / output_name;
+    }
+
+    /// Reports the generation of a file of the report.
+    ///
+    /// \param output_name The name of the file relative to the top directory.
+    void
+    report(const std::string& output_name)
+    {
+        if (_ui != NULL)
+            _ui->out(F("Generating %s") % path(output_name));
+    }
+
+    /// Instantiate a template to generate a file in the output directory.
+    ///
+    /// \param templates The templates to use.
+    /// \param template_name The name of the template.  This is automatically
+    ///     searched for in the installed directory, so do not provide a path.
+    /// \param output_name The name of the output file relative to the top
+    ///     directory.
+    ///
+    /// \throw text::error If there is any problem applying the templates.
+    void
+    generate(const text::templates_def& templates,
+             const std::string& template_name,
+             const std::string& output_name)
+    {
+        std::map< std::string, text::compiled_template >::const_iterator
+            iter = _compiled.find(template_name);
+        if (iter == _compiled.end()) {
+            const fs::path miscdir(utils::getenv_with_default(
+                 "KYUA_MISCDIR", KYUA_MISCDIR));
+            iter = _compiled.insert(std::make_pair(
+                template_name,
+                text::compiled_template::compile(miscdir / template_name)))
+                .first;
+        }
+
+        report(output_name);
+        (*iter).second.instantiate(templates, path(output_name));
+    }
+};
+
+
+/// Generates a common set of templates for all of our files.
+///
+/// \return A new templates object with common parameters.
+static text::templates_def
+common_templates(void)
+{
+    text::templates_def templates;
+    templates.add_variable("css", "report.css");
+    return templates;
+}
+
+
+/// Generates the page with the details of a test case.
+///
+/// \param generator Generator of the files of the report.
+/// \param iter Container for the test result's data.
+///
+/// \throw text::error If there is any problem applying the templates.
+static void
+write_test_case_page(report_generator& generator,
+                     store::results_iterator& iter)
+{
+    const model::test_program_ptr test_program = iter.test_program();
+    const std::string test_case_name = iter.test_case_name();
+    const model::test_result result = iter.result();
+
+    text::templates_def templates = common_templates();
+    templates.add_variable("test_case", text::escape_xml(
+        cli::format_test_case_id(*test_program, test_case_name)));
+    templates.add_variable("test_program", text::escape_xml(
+        test_program->absolute_path().str()));
+    templates.add_variable("result",
+                           text::escape_xml(cli::format_result(result)));
+    templates.add_variable("duration", cli::format_delta(iter.duration()));
+
+    const model::test_case& test_case = test_program->find(test_case_name);
+    add_map(templates, test_case.get_metadata().to_properties(),
+            "metadata_var", "metadata_value");
+
+    {
+        const std::string stdout_text = iter.stdout_contents();
+        if (!stdout_text.empty())
+            templates.add_variable("stdout", text::escape_xml(stdout_text));
+    }
+    {
+        const std::string stderr_text = iter.stderr_contents();
+        if (!stderr_text.empty())
+            templates.add_variable("stderr", text::escape_xml(stderr_text));
+    }
+
+    generator.generate(templates, "test_result.html",
+                       test_case_filename(*test_program, test_case_name));
+}
+
+
+/// Abstract hooks to generate an HTML report.
+///
+/// The hooks are only used by the main process, which is the only one that
+/// scans the results files.  If there are workers, the details of the test
+/// cases are not generated during the scan: the hooks instead record which
+/// test cases each worker has to process.
+class report_hooks : public drivers::scan_results::base_hooks {
+    /// Position of the results file of the results being scanned.
+    std::size_t _file;
+
+    /// Test cases whose details each worker has to generate.
+    ///
+    /// Empty if the details are generated by the main process.
+    std::vector< details_vector > _work;
+
+protected:
+    /// Constructor.
+    ///
+    /// \param settings Settings of the report.
+    report_hooks(const report_settings& settings) :
+        _file(0),
+        _work(settings.jobs > 1 ? settings.jobs : 0)
+    {
+    }
+
+    /// Hands the generation of the details of a test case to a worker.
+    ///
+    /// \param iter Container for the test result's data.
+    /// \param unit The unit of work to which the test case belongs.  Units are
+    ///     distributed across the workers in a round-robin fashion.
+    /// \param batch The batch to which the test case belongs.
+    ///
+    /// \return True if a worker will generate the details of the test case;
+    /// false if the caller has to generate them because there are no workers.
+    bool
+    defer_details(store::results_iterator& iter, const std::size_t unit,
+                  const std::size_t batch)
+    {
+        if (_work.empty())
+            return false;
+        _work[unit % _work.size()].push_back(
+            details_item(_file, iter.test_case_id(), batch));
+        return true;
+    }
+
+public:
+    /// Callback executed when the next results come from a different file.
+    ///
+    /// \param index The position of the results file.
+    void
+    got_results_file(const std::size_t index)
+    {
+        _file = index;
+    }
+
+    /// Gets the test cases whose details each worker has to generate.
+    ///
+    /// \return A collection with the work of every worker, which is empty if
+    /// the details have already been generated.
+    const std::vector< details_vector >&
+    work(void) const
+    {
+        return _work;
+    }
+
+    /// Writes the files that summarize the report.
+    ///
+    /// This should only be called once all the processing has been done;
+    /// i.e. when the scan_results driver returns.
+    virtual void write_summary(void) = 0;
+};
+
+
+/// Generates an HTML report with one page per test case.
+class html_hooks : public report_hooks {
+    /// Generator of the files of the report.
+    report_generator _generator;
+
+    /// Settings of the report.
+    const report_settings& _settings;
 
     /// Templates accumulator to generate the index.html file.
     text::templates_def _summary_templates;
@@ -158,16 +483,8 @@ class html_hooks : public drivers::scan_results::base_hooks {
     /// Mapping of result types to the amount of tests with such result.
     std::map< model::test_result_type, std::size_t > _types_count;
 
-    /// Generates a common set of templates for all of our files.
-    ///
-    /// \return A new templates object with common parameters.
-    static text::templates_def
-    common_templates(void)
-    {
-        text::templates_def templates;
-        templates.add_variable("css", "report.css");
-        return templates;
-    }
+    /// Number of test case pages seen so far.
+    std::size_t _n_pages;
 
     /// Adds a test case result to the summary.
     ///
@@ -221,33 +538,12 @@ class html_hooks : public drivers::scan_results::base_hooks {
 
         _summary_templates.add_to_vector(
             test_cases_vector,
-            cli::format_test_case_id(test_program, test_case_name));
+            text::escape_xml(cli::format_test_case_id(test_program,
+                                                      test_case_name)));
         _summary_templates.add_to_vector(
             test_cases_file_vector,
-            test_case_filename(test_program, test_case_name));
-    }
-
-    /// Instantiate a template to generate an HTML file in the output directory.
-    ///
-    /// \param templates The templates to use.
-    /// \param template_name The name of the template.  This is automatically
-    ///     searched for in the installed directory, so do not provide a path.
-    /// \param output_name The name of the output file.  This is a basename to
-    ///     be created within the output directory.
-    ///
-    /// \throw text::error If there is any problem applying the templates.
-    void
-    generate(const text::templates_def& templates,
-             const std::string& template_name,
-             const std::string& output_name) const
-    {
-        const fs::path miscdir(utils::getenv_with_default(
-             "KYUA_MISCDIR", KYUA_MISCDIR));
-        const fs::path template_file = miscdir / template_name;
-        const fs::path output_path(_directory / output_name);
-
-        _ui->out(F("Generating %s") % output_path);
-        text::instantiate(templates, template_file, output_path);
+            text::escape_xml(test_case_filename(test_program,
+                                                test_case_name)));
     }
 
     /// Gets the number of tests with a given result type.
@@ -270,19 +566,14 @@ class html_hooks : public drivers::scan_results::base_hooks {
 public:
     /// Constructor for the hooks.
     ///
-    /// \param ui_ User interface object where to report progress.
-    /// \param directory_ The directory in which to create the HTML files.
-    /// \param results_filters_ The result types to include in the report.
-    ///     Cannot be empty.
-    html_hooks(cmdline::ui* ui_, const fs::path& directory_,
-               const cli::result_types& results_filters_) :
-        _ui(ui_),
-        _directory(directory_),
-        _results_filters(results_filters_),
-        _summary_templates(common_templates())
+    /// \param settings_ Settings of the report.
+    html_hooks(const report_settings& settings_) :
+        report_hooks(settings_),
+        _generator(settings_.ui, settings_.directory),
+        _settings(settings_),
+        _summary_templates(common_templates()),
+        _n_pages(0)
     {
-        PRE(!results_filters_.empty());
-
         // Keep in sync with add_to_summary().
         _summary_templates.add_vector("broken_test_cases");
         _summary_templates.add_vector("broken_test_cases_file");
@@ -303,9 +594,9 @@ public:
     got_context(const model::context& context)
     {
         text::templates_def templates = common_templates();
-        templates.add_variable("cwd", context.cwd().str());
+        templates.add_variable("cwd", text::escape_xml(context.cwd().str()));
         add_map(templates, context.env(), "env_var", "env_var_value");
-        generate(templates, "context.html", "context.html");
+        _generator.generate(templates, "context.html", "context.html");
     }
 
     /// Callback executed when a test results is found.
@@ -318,46 +609,25 @@ public:
         const std::string& test_case_name = iter.test_case_name();
         const model::test_result result = iter.result();
 
-        if (std::find(_results_filters.begin(), _results_filters.end(),
-                      result.type()) == _results_filters.end()) {
+        if (std::find(_settings.results_filters.begin(),
+                      _settings.results_filters.end(),
+                      result.type()) == _settings.results_filters.end()) {
             add_to_summary(*test_program, test_case_name, result, false);
             return;
         }
 
         add_to_summary(*test_program, test_case_name, result, true);
 
-        text::templates_def templates = common_templates();
-        templates.add_variable("test_case",
-                               cli::format_test_case_id(*test_program,
-                                                        test_case_name));
-        templates.add_variable("test_program",
-                               test_program->absolute_path().str());
-        templates.add_variable("result", cli::format_result(result));
-        templates.add_variable("duration", cli::format_delta(iter.duration()));
-
-        const model::test_case& test_case = test_program->find(test_case_name);
-        add_map(templates, test_case.get_metadata().to_properties(),
-                "metadata_var", "metadata_value");
-
-        {
-            const std::string stdout_text = iter.stdout_contents();
-            if (!stdout_text.empty())
-                templates.add_variable("stdout", stdout_text);
-        }
-        {
-            const std::string stderr_text = iter.stderr_contents();
-            if (!stderr_text.empty())
-                templates.add_variable("stderr", stderr_text);
+        const std::size_t page = _n_pages++;
+        if (defer_details(iter, page, page / details_per_shard)) {
+            _generator.report(test_case_filename(*test_program,
+                                                 test_case_name));
+        } else {
+            write_test_case_page(_generator, iter);
         }
-
-        generate(templates, "test_result.html",
-                 test_case_filename(*test_program, test_case_name));
     }
 
     /// Writes the index.html file in the output directory.
-    ///
-    /// This should only be called once all the processing has been done;
-    /// i.e. when the scan_results driver returns.
     void
     write_summary(void)
     {
@@ -382,12 +652,605 @@ public:
                                         F("%s") % n_broken);
         _summary_templates.add_variable("bad_tests_count", F("%s") % n_bad);
 
-        generate(text::templates_def(), "report.css", "report.css");
-        generate(_summary_templates, "index.html", "index.html");
+        _generator.generate(text::templates_def(), "report.css", "report.css");
+        _generator.generate(_summary_templates, "index.html", "index.html");
+    }
+};
+
+
+/// Writes a block of memory as the body of a JavaScript string literal.
+///
+/// \param output The stream into which to write the literal.
+/// \param begin The first character to write.
+/// \param end The position after the last character to write.
+static void
+write_js_chars(std::ostream& output, const char* begin, const char* end)
+{
+    for (const char* iter = begin; iter != end; ++iter) {
+        const unsigned char ch = *iter;
+        switch (ch) {
+        case '"': output << "\\\""; break;
+        case '\\': output << "\\\\"; break;
+        case '\n': output << "\\n"; break;
+        case '\r': output << "\\r"; break;
+        case '\t': output << "\\t"; break;
+        default:
+            if (ch < 0x20) {
+                static const char* digits = "0123456789abcdef";
+                output << "\\u00" << digits[ch >> 4] << digits[ch & 0x0f];
+            } else {
+                output << ch;
+            }
+        }
+    }
+}
+
+
+/// Writes a string as a JavaScript string literal.
+///
+/// \param output The stream into which to write the literal.
+/// \param str The string to write.
+static void
+write_js_string(std::ostream& output, const std::string& str)
+{
+    output << '"';
+    write_js_chars(output, str.data(), str.data() + str.length());
+    output << '"';
+}
+
+
+/// Writes the contents of a stream as a JavaScript string literal.
+///
+/// \param output The stream into which to write the literal.
+/// \param input The stream to read the string from, in chunks.
+static void
+write_js_string(std::ostream& output, std::istream& input)
+{
+    output << '"';
+    char buffer[64 * 1024];
+    while (input.good()) {
+        input.read(buffer, sizeof(buffer));
+        write_js_chars(output, buffer, buffer + input.gcount());
+    }
+    output << '"';
+}
+
+
+/// Computes the name of a data file with the details of test cases.
+///
+/// \param shard The number of the data file.
+///
+/// \return The name of the file relative to the top directory.
+static std::string
+details_file_name(const std::size_t shard)
+{
+    return F("data/details-%s.js") % shard;
+}
+
+
+/// Writer of a data file with the details of test cases.
+class details_file : utils::noncopyable {
+    /// Path to the data file.
+    const fs::path _path;
+
+    /// Stream to the data file.
+    std::ofstream _output;
+
+    /// Whether the details of any test case have been written yet.
+    bool _empty;
+
+public:
+    /// Creates a new data file.
+    ///
+    /// \param path_ Path to the data file.
+    /// \param shard The number of the data file.
+    ///
+    /// \throw std::runtime_error If the file cannot be created.
+    details_file(const fs::path& path_, const std::size_t shard) :
+        _path(path_),
+        _output(path_.c_str()),
+        _empty(true)
+    {
+        if (!_output)
+            throw std::runtime_error(F("Cannot create %s") % _path);
+        _output << F("kyua.loaded(%s, {\n") % shard;
+    }
+
+    /// Adds the details of a test case to the data file.
+    ///
+    /// \param iter Container for the test result's data.
+    ///
+    /// \throw store::integrity_error If the outputs of the test case cannot be
+    ///     read.
+    void
+    add(store::results_iterator& iter)
+    {
+        if (!_empty)
+            _output << ",\n";
+        _empty = false;
+
+        const model::test_program_ptr test_program = iter.test_program();
+        write_js_string(_output, cli::format_test_case_id(
+            *test_program, iter.test_case_name()));
+        _output << ": {\"program\": ";
+        write_js_string(_output, test_program->absolute_path().str());
+        _output << ", \"result\": ";
+        write_js_string(_output, cli::format_result(iter.result()));
+        _output << ", \"duration\": ";
+        write_js_string(_output, cli::format_delta(iter.duration()));
+
+        _output << ", \"metadata\": [";
+        const model::test_case& test_case = test_program->find(
+            iter.test_case_name());
+        const config::properties_map props =
+            test_case.get_metadata().to_properties();
+        for (config::properties_map::const_iterator prop = props.begin();
+             prop != props.end(); ++prop) {
+            if (prop != props.begin())
+                _output << ", ";
+            _output << '[';
+            write_js_string(_output, (*prop).first);
+            _output << ", ";
+            write_js_string(_output, (*prop).second);
+            _output << ']';
+        }
+
+        _output << "], \"stdout\": ";
+        write_js_string(_output, *iter.stdout_stream());
+        _output << ", \"stderr\": ";
+        write_js_string(_output, *iter.stderr_stream());
+        _output << '}';
+    }
+
+    /// Finishes and closes the data file.
+    ///
+    /// \throw std::runtime_error If the file cannot be written.
+    void
+    close(void)
+    {
+        _output << "\n});\n";
+        _output.close();
+        if (_output.fail())
+            throw std::runtime_error(F("Failed to write %s") % _path);
     }
 };
 
 
+/// Gets the name with which a result type is identified in the paged layout.
+///
+/// \param type The result type.
+///
+/// \return The name of the type, which matches the values accepted by the
+/// --results-filter flag.
+static const char*
+result_type_name(const model::test_result_type type)
+{
+    switch (type) {
+    case model::test_result_broken: return "broken";
+    case model::test_result_expected_failure: return "xfail";
+    case model::test_result_failed: return "failed";
+    case model::test_result_passed: return "passed";
+    case model::test_result_skipped: return "skipped";
+    }
+    UNREACHABLE;
+}
+
+
+/// Gets the title of the pages that list the test cases of a result type.
+///
+/// \param type The result type.
+///
+/// \return A user-friendly title.
+static const char*
+result_type_title(const model::test_result_type type)
+{
+    switch (type) {
+    case model::test_result_broken: return "Broken test cases";
+    case model::test_result_expected_failure: return "Expected failures";
+    case model::test_result_failed: return "Failed test cases";
+    case model::test_result_passed: return "Passed test cases";
+    case model::test_result_skipped: return "Skipped test cases";
+    }
+    UNREACHABLE;
+}
+
+
+/// Computes the name of a page that lists the test cases of a result type.
+///
+/// \param type The result type.
+/// \param page The zero-based number of the page.
+///
+/// \return The name of the file relative to the top directory.
+static std::string
+result_type_page(const model::test_result_type type, const std::size_t page)
+{
+    return F("%s-%s.html") % result_type_name(type) % (page + 1);
+}
+
+
+/// Generates an HTML report with paginated lists of test cases.
+///
+/// Instead of generating one page per test case, which does not scale to test
+/// suites with hundreds of thousands of test cases, the test cases are listed
+/// in fixed-size pages per result type and their details are packed into data
+/// files that the pages load on demand.
+class paged_html_hooks : public report_hooks {
+    /// Representation of a test case in the pages of its result type.
+    struct listed_test_case {
+        /// The identifier of the test case.
+        std::string id;
+
+        /// The formatted duration of the test case execution.
+        std::string duration;
+
+        /// The data file holding the details of the test case, if any.
+        optional< std::size_t > shard;
+
+        /// Constructs a new listed test case.
+        ///
+        /// \param id_ The identifier of the test case.
+        /// \param duration_ The formatted duration of the test case.
+        /// \param shard_ The data file holding the details of the test case.
+        listed_test_case(const std::string& id_, const std::string& duration_,
+                         const optional< std::size_t >& shard_) :
+            id(id_), duration(duration_), shard(shard_)
+        {
+        }
+    };
+
+    /// Collection of listed test cases.
+    typedef std::vector< listed_test_case > listed_vector;
+
+    /// Generator of the files of the report.
+    report_generator _generator;
+
+    /// Settings of the report.
+    const report_settings& _settings;
+
+    /// Mapping of result types to the amount of tests with such result.
+    std::map< model::test_result_type, std::size_t > _types_count;
+
+    /// Test cases to list in the pages of every result type, in scan order.
+    std::map< model::test_result_type, listed_vector > _listed;
+
+    /// Number of test cases with details seen so far.
+    std::size_t _n_details;
+
+    /// The data file being written by this process, if any.
+    std::shared_ptr< details_file > _shard;
+
+    /// Finishes and closes the data file being written, if any.
+    ///
+    /// \throw std::runtime_error If the file cannot be written.
+    void
+    close_shard(void)
+    {
+        if (!_shard)
+            return;
+
+        const std::shared_ptr< details_file > shard = _shard;
+        _shard.reset();
+        shard->close();
+    }
+
+    /// Adds the details of a test case to the data files.
+    ///
+    /// \param iter Container for the test result's data.
+    ///
+    /// \return The number of the data file that holds the details.
+    std::size_t
+    add_details(store::results_iterator& iter)
+    {
+        const std::size_t shard = _n_details / details_per_shard;
+        const bool first = _n_details % details_per_shard == 0;
+        ++_n_details;
+
+        if (first) {
+            close_shard();
+            _generator.report(details_file_name(shard));
+        }
+        if (!defer_details(iter, shard, shard)) {
+            if (first)
+                _shard.reset(new details_file(
+                    _generator.path(details_file_name(shard)), shard));
+            _shard->add(iter);
+        }
+        return shard;
+    }
+
+    /// Gets the number of tests with a given result type.
+    ///
+    /// \param type The type to be queried.
+    ///
+    /// \return The number of tests of the given type.
+    std::size_t
+    get_count(const model::test_result_type type) const
+    {
+        const std::map< model::test_result_type, std::size_t >::const_iterator
+            iter = _types_count.find(type);
+        if (iter == _types_count.end())
+            return 0;
+        else
+            return (*iter).second;
+    }
+
+    /// Writes the pages that list the test cases of a result type.
+    ///
+    /// \param type The result type.
+    /// \param [in,out] summary Templates of the index page, to which to add the
+    ///     link to the first page, if any.
+    void
+    write_pages(const model::test_result_type type,
+                text::templates_def& summary)
+    {
+        const std::map< model::test_result_type, listed_vector >::const_iterator
+            listed = _listed.find(type);
+        if (listed == _listed.end())
+            return;
+        const listed_vector& test_cases = (*listed).second;
+        INV(!test_cases.empty());
+
+        const std::size_t n_pages =
+            (test_cases.size() + tests_per_page - 1) / tests_per_page;
+        summary.add_variable(F("%s_page") % result_type_name(type),
+                             result_type_page(type, 0));
+
+        for (std::size_t page = 0; page < n_pages; ++page) {
+            text::templates_def templates = common_templates();
+            templates.add_variable("title", result_type_title(type));
+            templates.add_variable("page", F("%s") % (page + 1));
+            templates.add_variable("pages_count", F("%s") % n_pages);
+            if (page > 0)
+                templates.add_variable("previous_page",
+                                       result_type_page(type, page - 1));
+            if (page + 1 < n_pages)
+                templates.add_variable("next_page",
+                                       result_type_page(type, page + 1));
+
+            templates.add_vector("test_cases");
+            templates.add_vector("test_cases_duration");
+            templates.add_vector("test_cases_shard");
+            const std::size_t last = std::min(test_cases.size(),
+                                              (page + 1) * tests_per_page);
+            for (std::size_t i = page * tests_per_page; i < last; ++i) {
+                const listed_test_case& test_case = test_cases[i];
+                templates.add_to_vector("test_cases",
+                                        text::escape_xml(test_case.id));
+                templates.add_to_vector("test_cases_duration",
+                                        test_case.duration);
+                templates.add_to_vector("test_cases_shard",
+                                        test_case.shard ?
+                                        F("%s") % test_case.shard.get() :
+                                        std::string());
+            }
+
+            _generator.generate(templates, "paged_results.html",
+                                result_type_page(type, page));
+        }
+    }
+
+public:
+    /// Constructor for the hooks.
+    ///
+    /// \param settings_ Settings of the report.
+    paged_html_hooks(const report_settings& settings_) :
+        report_hooks(settings_),
+        _generator(settings_.ui, settings_.directory),
+        _settings(settings_),
+        _n_details(0)
+    {
+    }
+
+    /// Callback executed when the context is loaded.
+    ///
+    /// \param context The context loaded from the database.
+    void
+    got_context(const model::context& context)
+    {
+        text::templates_def templates = common_templates();
+        templates.add_variable("cwd", text::escape_xml(context.cwd().str()));
+        add_map(templates, context.env(), "env_var", "env_var_value");
+        _generator.generate(templates, "context.html", "context.html");
+    }
+
+    /// Callback executed when a test results is found.
+    ///
+    /// \param iter Container for the test result's data.
+    void
+    got_result(store::results_iterator& iter)
+    {
+        const model::test_result_type type = iter.result().type();
+        ++_types_count[type];
+
+        if (std::find(_settings.results_filters.begin(),
+                      _settings.results_filters.end(),
+                      type) == _settings.results_filters.end())
+            return;
+
+        const std::string id = cli::format_test_case_id(
+            *iter.test_program(), iter.test_case_name());
+
+        optional< std::size_t > shard;
+        if (type != model::test_result_passed || _settings.passed_details)
+            shard = add_details(iter);
+
+        _listed[type].push_back(listed_test_case(
+            id, cli::format_delta(iter.duration()), shard));
+    }
+
+    /// Callback executed after all results have been processed.
+    ///
+    /// \param unused_r Result of the driver.
+    void
+    end(const drivers::scan_results::result& UTILS_UNUSED_PARAM(r))
+    {
+        close_shard();
+    }
+
+    /// Writes the index page and the pages that list the test cases.
+    void
+    write_summary(void)
+    {
+        text::templates_def summary = common_templates();
+        const std::size_t n_broken = get_count(model::test_result_broken);
+        const std::size_t n_failed = get_count(model::test_result_failed);
+        summary.add_variable("broken_tests_count", F("%s") % n_broken);
+        summary.add_variable("failed_tests_count", F("%s") % n_failed);
+        summary.add_variable("xfail_tests_count", F("%s") % get_count(
+            model::test_result_expected_failure));
+        summary.add_variable("skipped_tests_count", F("%s") % get_count(
+            model::test_result_skipped));
+        summary.add_variable("passed_tests_count", F("%s") % get_count(
+            model::test_result_passed));
+        summary.add_variable("bad_tests_count",
+                             F("%s") % (n_broken + n_failed));
+
+        // Keep in sync with the order of the sections in the simple layout.
+        write_pages(model::test_result_broken, summary);
+        write_pages(model::test_result_failed, summary);
+        write_pages(model::test_result_expected_failure, summary);
+        write_pages(model::test_result_skipped, summary);
+        write_pages(model::test_result_passed, summary);
+
+        _generator.generate(text::templates_def(), "report.css", "report.css");
+        _generator.generate(text::templates_def(), "report.js", "report.js");
+        _generator.generate(summary, "paged_index.html", "index.html");
+    }
+};
+
+
+/// Creates the hooks to generate a report.
+///
+/// \param settings Settings of the report.
+///
+/// \return The hooks for the layout of the report.
+static std::shared_ptr< report_hooks >
+new_hooks(const report_settings& settings)
+{
+    switch (settings.layout) {
+    case layout_simple:
+        return std::shared_ptr< report_hooks >(new html_hooks(settings));
+    case layout_paged:
+        return std::shared_ptr< report_hooks >(new paged_html_hooks(settings));
+    }
+    UNREACHABLE;
+}
+
+
+/// Subprocess that generates the details of a subset of the test cases.
+class details_worker {
+    /// Settings of the report.
+    report_settings _settings;
+
+    /// The results files that hold the test cases.
+    std::vector< fs::path > _results_files;
+
+    /// The test cases whose details to generate.
+    details_vector _items;
+
+public:
+    /// Constructor.
+    ///
+    /// \param settings_ Settings of the report.
+    /// \param results_files_ The results files that hold the test cases.
+    /// \param items_ The test cases whose details to generate.
+    details_worker(const report_settings& settings_,
+                   const std::vector< fs::path >& results_files_,
+                   const details_vector& items_) :
+        _settings(settings_),
+        _results_files(results_files_),
+        _items(items_)
+    {
+    }
+
+    /// Body of the subprocess.
+    ///
+    /// The worker opens the results files on its own, as database connections
+    /// cannot be shared across processes, and loads the data of its test cases
+    /// by their identifiers.  Consecutive test cases of the same batch and file
+    /// are loaded at once, which yields them in the same order as the scan of
+    /// the main process and thus keeps the report independent of the number of
+    /// workers.
+    void
+    operator()(void) UTILS_NORETURN
+    {
+        std::vector< store::read_backend > dbs;
+        dbs.reserve(_results_files.size());
+        std::vector< store::read_transaction > txs;
+        for (std::vector< fs::path >::const_iterator
+                 iter = _results_files.begin(); iter != _results_files.end();
+             ++iter) {
+            dbs.push_back(store::read_backend::open_ro(*iter));
+            txs.push_back(dbs.back().start_read());
+        }
+
+        report_generator generator(NULL, _settings.directory);
+        details_vector::const_iterator item = _items.begin();
+        while (item != _items.end()) {
+            const std::size_t batch = (*item).batch;
+
+            std::shared_ptr< details_file > output;
+            if (_settings.layout == layout_paged)
+                output.reset(new details_file(
+                    generator.path(details_file_name(batch)), batch));
+
+            while (item != _items.end() && (*item).batch == batch) {
+                const std::size_t file = (*item).file;
+                std::set< int64_t > ids;
+                for (; item != _items.end() && (*item).batch == batch &&
+                         (*item).file == file; ++item)
+                    ids.insert((*item).test_case_id);
+
+                store::results_iterator result = txs[file].get_results_of(ids);
+                for (; result; ++result) {
+                    if (output)
+                        output->add(result);
+                    else
+                        write_test_case_page(generator, result);
+                }
+            }
+
+            if (output)
+                output->close();
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+};
+
+
+/// Collection of running workers.
+typedef std::vector< std::shared_ptr< process::child > > workers_vector;
+
+
+/// Waits for all workers to finish and checks that they succeeded.
+///
+/// \param workers The workers to wait for.
+///
+/// \throw std::runtime_error If any of the workers failed.
+static void
+wait_workers(workers_vector& workers)
+{
+    optional< std::string > error;
+    for (workers_vector::iterator iter = workers.begin();
+         iter != workers.end(); ++iter) {
+        process::child& worker = **iter;
+        const std::string output = utils::read_stream(worker.output());
+        const process::status status = worker.wait();
+        if ((!status.exited() || status.exitstatus() != EXIT_SUCCESS) &&
+            !error) {
+            LW(F("Report worker %s failed; output was: %s") % worker.pid() %
+               output);
+            const std::string::size_type end = output.find_last_not_of('\n');
+            error = end == std::string::npos ?
+                std::string("Unknown error") : output.substr(0, end + 1);
+        }
+    }
+    if (error)
+        throw std::runtime_error(F("Failed to generate the test case pages: "
+                                   "%s") % error.get());
+}
+
+
 }  // anonymous namespace
 
 
@@ -406,6 +1269,15 @@ cli::cmd_report_html::cmd_report_html(void) : cli_command(
     add_option(cmdline::list_option(
         "results-filter", "Comma-separated list of result types to include in "
         "the report", "types", "skipped,xfail,broken,failed"));
+    add_option(cmdline::int_option(
+        "jobs", "Number of processes to use to generate the details of the "
+        "test cases", "count", "1"));
+    add_option(cmdline::string_option(
+        "layout", "Layout of the report: simple or paged", "layout",
+        "simple"));
+    add_option(cmdline::bool_option(
+        "no-passed-details", "Do not include the details of passed test "
+        "cases; only valid with --layout=paged"));
 }
 
 
@@ -424,17 +1296,70 @@ cli::cmd_report_html::run(cmdline::ui* ui,
 {
     const result_types types = get_result_types(cmdline);
 
-    const fs::path results_file = layout::find_results(
-        results_file_open(cmdline));
+    const int raw_jobs = cmdline.get_option< cmdline::int_option >("jobs");
+    if (raw_jobs < 1)
+        throw cmdline::usage_error("Invalid value for --jobs: must be at "
+                                   "least 1");
+    const std::size_t jobs = std::min(static_cast< std::size_t >(raw_jobs),
+                                      max_jobs);
+
+    const std::string layout_name =
+        cmdline.get_option< cmdline::string_option >("layout");
+    report_layout layout;
+    if (layout_name == "simple")
+        layout = layout_simple;
+    else if (layout_name == "paged")
+        layout = layout_paged;
+    else
+        throw cmdline::usage_error(F("Invalid value for --layout: unknown "
+                                     "layout '%s'") % layout_name);
+
+    const bool passed_details = !cmdline.has_option("no-passed-details");
+    if (!passed_details && layout != layout_paged)
+        throw cmdline::usage_error("--no-passed-details requires "
+                                   "--layout=paged");
+
+    const std::vector< fs::path > results_files = find_results_files(cmdline);
 
     const fs::path directory =
         cmdline.get_option< cmdline::path_option >("output");
     create_top_directory(directory, cmdline.has_option("force"));
-    html_hooks hooks(ui, directory, types);
-    drivers::scan_results::drive(results_file,
+    if (layout == layout_paged)
+        fs::mkdir(directory / "data", 0755);
+
+    const report_settings settings(ui, directory, types, layout,
+                                   passed_details, jobs);
+
+    const std::shared_ptr< report_hooks > hooks = new_hooks(settings);
+    drivers::scan_results::drive(results_files,
                                  std::set< engine::test_filter >(),
-                                 hooks);
-    hooks.write_summary();
+                                 std::set< model::test_result_type >(),
+                                 *hooks);
+
+    // The scan is the only one of the results files: the workers load the
+    // details of the test cases they were assigned by their identifiers.  They
+    // are spawned once the driver has closed the results files so that they
+    // do not inherit open database connections.
+    workers_vector workers;
+    const std::vector< details_vector >& work = hooks->work();
+    for (std::vector< details_vector >::const_iterator iter = work.begin();
+         iter != work.end(); ++iter) {
+        if ((*iter).empty())
+            continue;
+        workers.push_back(std::shared_ptr< process::child >(
+            process::child::fork_capture(details_worker(
+                settings, results_files, *iter)).release()));
+    }
+
+    try {
+        hooks->write_summary();
+    } catch (...) {
+        for (workers_vector::iterator iter = workers.begin();
+             iter != workers.end(); ++iter)
+            (*iter)->wait();
+        throw;
+    }
+    wait_workers(workers);
 
     return EXIT_SUCCESS;
 }
@@ -31,22 +31,23 @@
 #include <cstddef>
 #include <cstdlib>
 #include <set>
+#include <vector>
 
 #include "cli/common.ipp"
 #include "drivers/report_junit.hpp"
 #include "drivers/scan_results.hpp"
 #include "engine/filters.hpp"
-#include "store/layout.hpp"
+#include "model/test_result.hpp"
 #include "utils/cmdline/options.hpp"
 #include "utils/cmdline/parser.ipp"
 #include "utils/defs.hpp"
+#include "utils/fs/path.hpp"
 #include "utils/optional.ipp"
 #include "utils/stream.hpp"
 
 namespace cmdline = utils::cmdline;
 namespace config = utils::config;
 namespace fs = utils::fs;
-namespace layout = store::layout;
 
 using cli::cmd_report_junit;
 using utils::optional;
@@ -76,16 +77,15 @@ cmd_report_junit::run(cmdline::ui* UTILS_UNUSED_PARAM(ui),
                       const cmdline::parsed_cmdline& cmdline,
                       const config::tree& UTILS_UNUSED_PARAM(user_config))
 {
-    const fs::path results_file = layout::find_results(
-        results_file_open(cmdline));
+    const std::vector< fs::path > results_files = find_results_files(cmdline);
 
     std::auto_ptr< std::ostream > output = utils::open_ostream(
         cmdline.get_option< cmdline::path_option >("output"));
 
     drivers::report_junit_hooks hooks(*output.get());
-    drivers::scan_results::drive(results_file,
+    drivers::scan_results::drive(results_files,
                                  std::set< engine::test_filter >(),
-                                 hooks);
+                                 std::set< model::test_result_type >(), hooks);
 
     return EXIT_SUCCESS;
 }
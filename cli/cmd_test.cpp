@@ -32,9 +32,11 @@
 
 #include "cli/common.ipp"
 #include "drivers/run_tests.hpp"
+#include "engine/tap_parser.hpp"
 #include "model/test_program.hpp"
 #include "model/test_result.hpp"
 #include "store/layout.hpp"
+#include "utils/cmdline/exceptions.hpp"
 #include "utils/cmdline/options.hpp"
 #include "utils/cmdline/parser.ipp"
 #include "utils/cmdline/ui.hpp"
@@ -42,6 +44,7 @@
 #include "utils/datetime.hpp"
 #include "utils/format/macros.hpp"
 #include "utils/fs/path.hpp"
+#include "utils/optional.ipp"
 
 namespace cmdline = utils::cmdline;
 namespace config = utils::config;
@@ -50,6 +53,8 @@ namespace fs = utils::fs;
 namespace layout = store::layout;
 
 using cli::cmd_test;
+using utils::none;
+using utils::optional;
 
 
 namespace {
@@ -63,6 +68,9 @@ class print_hooks : public drivers::run_tests::base_hooks {
     /// Whether the tests are executed in parallel or not.
     bool _parallel;
 
+    /// Interval at which to report the progress of running TAP tests, if any.
+    optional< datetime::delta > _progress_interval;
+
 public:
     /// The amount of positive test results found so far.
     unsigned long good_count;
@@ -74,9 +82,15 @@ public:
     ///
     /// \param ui_ Object to interact with the I/O of the program.
     /// \param parallel_ True if we are executing more than one test at once.
-    print_hooks(cmdline::ui* ui_, const bool parallel_) :
+    ///     Must also be true if progress reports are enabled, as these are
+    ///     printed while the test case runs.
+    /// \param progress_interval_ Interval at which to report the progress of
+    ///     running TAP tests, or none to not report it.
+    print_hooks(cmdline::ui* ui_, const bool parallel_,
+                const optional< datetime::delta >& progress_interval_) :
         _ui(ui_),
         _parallel(parallel_),
+        _progress_interval(progress_interval_),
         good_count(0),
         bad_count(0)
     {
@@ -121,6 +135,31 @@ public:
         else
             bad_count++;
     }
+
+    /// Called when a running TAP test case reports new results.
+    ///
+    /// \param test_program The test program containing the test case.
+    /// \param test_case_name The name of the test case being executed.
+    /// \param parser The parser of the output of the test case so far.
+    virtual void
+    got_progress(const model::test_program& test_program,
+                 const std::string& test_case_name,
+                 const engine::tap_parser& parser)
+    {
+        _ui->out(F("%s  %s ok, %s not ok%s") %
+                 cli::format_test_case_id(test_program, test_case_name) %
+                 parser.ok_count() % parser.not_ok_count() %
+                 (parser.bailed_out() ? ", bailed out" : ""));
+    }
+
+    /// Gets the interval at which to report the progress of running tests.
+    ///
+    /// \return The interval requested by the user, if any.
+    virtual optional< datetime::delta >
+    progress_interval(void) const
+    {
+        return _progress_interval;
+    }
 };
 
 
@@ -132,8 +171,17 @@ cmd_test::cmd_test(void) : cli_command(
     "test", "[test-program ...]", 0, -1, "Run tests")
 {
     add_option(build_root_option);
+    add_option(filters_from_option);
     add_option(kyuafile_option);
+    add_option(cmdline::int_option(
+        "progress-interval", "Interval at which to print the number of "
+        "results reported so far by running TAP test programs; 0 to disable",
+        "seconds", "0"));
     add_option(results_file_create_option);
+    add_option(cmdline::string_option(
+        "resume", "Path to the results file of an interrupted run or its "
+        "identifier; new results are appended to it and test cases that "
+        "already have a result are not run again", "file"));
 }
 
 
@@ -148,16 +196,39 @@ int
 cmd_test::run(cmdline::ui* ui, const cmdline::parsed_cmdline& cmdline,
               const config::tree& user_config)
 {
-    const layout::results_id_file_pair results = layout::new_db(
-        results_file_create(cmdline), kyuafile_path(cmdline).branch_path());
+    const bool resume = cmdline.has_option("resume");
+    if (resume && cmdline.get_option< cmdline::string_option >(
+            results_file_create_option.long_name()) !=
+        results_file_create_option.default_value())
+        throw cmdline::usage_error(F("--resume and --%s are mutually "
+                                     "exclusive") %
+                                   results_file_create_option.long_name());
+
+    const layout::results_id_file_pair results = resume ?
+        layout::results_id_file_pair("", layout::find_results(
+            cmdline.get_option< cmdline::string_option >("resume"))) :
+        layout::new_db(results_file_create(cmdline),
+                       kyuafile_path(cmdline).branch_path());
+
+    const int progress_seconds = cmdline.get_option< cmdline::int_option >(
+        "progress-interval");
+    if (progress_seconds < 0)
+        throw cmdline::usage_error("Invalid value for --progress-interval: "
+                                   "must not be negative");
+    const optional< datetime::delta > progress_interval =
+        progress_seconds > 0 ?
+        utils::make_optional(datetime::delta(progress_seconds, 0)) :
+        optional< datetime::delta >(none);
 
+    // Progress reports are printed while tests run, so the results cannot be
+    // printed on the same line as the name of their test case.
     const bool parallel = (user_config.lookup< config::positive_int_node >(
-                               "parallelism") > 1);
+                               "parallelism") > 1) || progress_interval;
 
-    print_hooks hooks(ui, parallel);
+    print_hooks hooks(ui, parallel, progress_interval);
     const drivers::run_tests::result result = drivers::run_tests::drive(
         kyuafile_path(cmdline), build_root_path(cmdline), results.second,
-        parse_filters(cmdline.arguments()), user_config, hooks);
+        resume, parse_filters(cmdline), user_config, hooks);
 
     int exit_code;
     if (hooks.good_count > 0 || hooks.bad_count > 0) {
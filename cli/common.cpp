@@ -72,6 +72,13 @@ const cmdline::path_option cli::build_root_option(
     "path");
 
 
+/// Standard definition of the option to read test filters from a file.
+const cmdline::path_option cli::filters_from_option(
+    "filters-from",
+    "Path to a file with additional test filters, one per line",
+    "file");
+
+
 /// Standard definition of the option to specify a Kyuafile.
 const cmdline::path_option cli::kyuafile_option(
     'k', "kyuafile",
@@ -138,6 +145,33 @@ get_historical_db(void)
 }
 
 
+/// Validates a value of the results-file flag for the lookup of the file.
+///
+/// \param results_file The raw value of the flag.
+///
+/// \return The path to the database to be used.
+///
+/// \throw cmdline::error If the value passed to the flag is invalid.
+static std::string
+resolve_results_file_open(const std::string& results_file)
+{
+    if (results_file == cli::results_file_open_option.default_value()) {
+        const optional< fs::path > historical_db = get_historical_db();
+        if (historical_db)
+            return historical_db.get().str();
+    } else {
+        try {
+            (void)fs::path(results_file);
+        } catch (const fs::error& e) {
+            throw cmdline::usage_error(
+                F("Invalid value passed to --%s") %
+                cli::results_file_open_option.long_name());
+        }
+    }
+    return results_file;
+}
+
+
 /// Converts a set of result type names to identifiers.
 ///
 /// \param names The collection of names to process; may be empty.
@@ -245,21 +279,62 @@ cli::results_file_create(const cmdline::parsed_cmdline& cmdline)
 std::string
 cli::results_file_open(const cmdline::parsed_cmdline& cmdline)
 {
-    std::string results_file = cmdline.get_option< cmdline::string_option >(
-        results_file_open_option.long_name());
-    if (results_file == results_file_open_option.default_value()) {
-        const optional< fs::path > historical_db = get_historical_db();
-        if (historical_db)
-            results_file = historical_db.get().str();
-    } else {
-        try {
-            (void)fs::path(results_file);
-        } catch (const fs::error& e) {
-            throw cmdline::usage_error(F("Invalid value passed to --%s") %
-                                       results_file_open_option.long_name());
-        }
-    }
-    return results_file;
+    return resolve_results_file_open(
+        cmdline.get_option< cmdline::string_option >(
+            results_file_open_option.long_name()));
+}
+
+
+/// Gets the values of the results-file flag for the lookup of many files.
+///
+/// The flag can be given multiple times to select multiple files, in which case
+/// its default value is ignored.
+///
+/// \param cmdline The parsed command line from which to extract any possible
+///     override for the location of the databases via the --results-file flag.
+///
+/// \return The paths to the databases to be used, in the order in which they
+/// were provided.
+///
+/// \throw cmdline::error If any value passed to the flag is invalid.
+std::vector< std::string >
+cli::results_files_open(const cmdline::parsed_cmdline& cmdline)
+{
+    std::vector< std::string > raw_values =
+        cmdline.get_multi_option< cmdline::string_option >(
+            results_file_open_option.long_name());
+    INV(!raw_values.empty());
+    if (raw_values.size() > 1)
+        raw_values.erase(raw_values.begin());
+
+    std::vector< std::string > results_files;
+    for (std::vector< std::string >::const_iterator iter = raw_values.begin();
+         iter != raw_values.end(); ++iter)
+        results_files.push_back(resolve_results_file_open(*iter));
+    return results_files;
+}
+
+
+/// Locates the results files selected by the results-file flag.
+///
+/// \param cmdline The parsed command line from which to extract any possible
+///     override for the location of the databases via the --results-file flag.
+///
+/// \return The paths to the existing results files, in the order in which
+/// they were provided.
+///
+/// \throw cmdline::error If any value passed to the flag is invalid.
+/// \throw store::error If any of the results files cannot be found.
+std::vector< fs::path >
+cli::find_results_files(const cmdline::parsed_cmdline& cmdline)
+{
+    const std::vector< std::string > ids = results_files_open(cmdline);
+
+    std::vector< fs::path > results_files;
+    for (std::vector< std::string >::const_iterator iter = ids.begin();
+         iter != ids.end(); ++iter)
+        results_files.push_back(layout::find_results(*iter));
+    return results_files;
 }
 
 
@@ -314,6 +389,43 @@ cli::parse_filters(const cmdline::args_vector& args)
 }
 
 
+/// Constructs test filters from the arguments and options of a command.
+///
+/// \param cmdline The parsed command line.  The filters are taken from the
+///     arguments and, if given, from the file pointed to by the
+///     filters_from_option.  Empty lines and lines starting with '#' in the
+///     file are ignored.
+///
+/// \return The collection of filters.
+///
+/// \throw cmdline:error If the filters file cannot be read, if any of the
+///     filters is invalid, or if they represent a non-disjoint collection of
+///     filters.
+std::set< engine::test_filter >
+cli::parse_filters(const cmdline::parsed_cmdline& cmdline)
+{
+    if (!cmdline.has_option(filters_from_option.long_name()))
+        return parse_filters(cmdline.arguments());
+
+    cmdline::args_vector args = cmdline.arguments();
+
+    const fs::path file = cmdline.get_option< cmdline::path_option >(
+        filters_from_option.long_name());
+    std::ifstream input(file.c_str());
+    if (!input)
+        throw cmdline::error(F("Cannot open filters file %s") % file);
+    std::string line;
+    while (std::getline(input, line)) {
+        if (!line.empty() && line[0] != '#')
+            args.push_back(line);
+    }
+    if (input.bad())
+        throw cmdline::error(F("Failed to read filters file %s") % file);
+
+    return parse_filters(args);
+}
+
+
 /// Reports the filters that have not matched any tests as errors.
 ///
 /// \param unused The collection of unused filters to report.
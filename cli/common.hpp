@@ -52,6 +52,7 @@ namespace cli {
 
 
 extern const utils::cmdline::path_option build_root_option;
+extern const utils::cmdline::path_option filters_from_option;
 extern const utils::cmdline::path_option kyuafile_option;
 extern const utils::cmdline::string_option results_file_create_option;
 extern const utils::cmdline::string_option results_file_open_option;
@@ -83,10 +84,16 @@ utils::optional< utils::fs::path > build_root_path(
 utils::fs::path kyuafile_path(const utils::cmdline::parsed_cmdline&);
 std::string results_file_create(const utils::cmdline::parsed_cmdline&);
 std::string results_file_open(const utils::cmdline::parsed_cmdline&);
+std::vector< std::string > results_files_open(
+    const utils::cmdline::parsed_cmdline&);
+std::vector< utils::fs::path > find_results_files(
+    const utils::cmdline::parsed_cmdline&);
 result_types get_result_types(const utils::cmdline::parsed_cmdline&);
 
 std::set< engine::test_filter > parse_filters(
     const utils::cmdline::args_vector&);
+std::set< engine::test_filter > parse_filters(
+    const utils::cmdline::parsed_cmdline&);
 bool report_unused_filters(const std::set< engine::test_filter >&,
                            utils::cmdline::ui*);
 
@@ -290,6 +290,41 @@ ATF_TEST_CASE_BODY(results_file_open__explicit)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(results_files_open__default);
+ATF_TEST_CASE_BODY(results_files_open__default)
+{
+    std::map< std::string, std::vector< std::string > > options;
+    options["results-file"].push_back(
+        cli::results_file_open_option.default_value());
+    const cmdline::parsed_cmdline mock_cmdline(options, cmdline::args_vector());
+
+    const fs::path home("homedir");
+    utils::setenv("HOME", home.str());
+
+    const std::vector< std::string > files = cli::results_files_open(
+        mock_cmdline);
+    ATF_REQUIRE_EQ(1, files.size());
+    ATF_REQUIRE_EQ(cli::results_file_open_option.default_value(), files[0]);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(results_files_open__explicit);
+ATF_TEST_CASE_BODY(results_files_open__explicit)
+{
+    std::map< std::string, std::vector< std::string > > options;
+    options["results-file"].push_back(
+        cli::results_file_open_option.default_value());
+    options["results-file"].push_back("/my//path/f.db");
+    options["results-file"].push_back("g.db");
+    const cmdline::parsed_cmdline mock_cmdline(options, cmdline::args_vector());
+
+    std::vector< std::string > exp_files;
+    exp_files.push_back("/my//path/f.db");
+    exp_files.push_back("g.db");
+    ATF_REQUIRE(exp_files == cli::results_files_open(mock_cmdline));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(parse_filters__none);
 ATF_TEST_CASE_BODY(parse_filters__none)
 {
@@ -343,6 +378,66 @@ ATF_TEST_CASE_BODY(parse_filters__nondisjoint)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(parse_filters__cmdline__no_file);
+ATF_TEST_CASE_BODY(parse_filters__cmdline__no_file)
+{
+    std::map< std::string, std::vector< std::string > > options;
+    cmdline::args_vector args;
+    args.push_back("foo:bar");
+    const cmdline::parsed_cmdline mock_cmdline(options, args);
+
+    std::set< engine::test_filter > exp_filters;
+    exp_filters.insert(mkfilter("foo", "bar"));
+
+    ATF_REQUIRE(exp_filters == cli::parse_filters(mock_cmdline));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(parse_filters__cmdline__file);
+ATF_TEST_CASE_BODY(parse_filters__cmdline__file)
+{
+    atf::utils::create_file(
+        "filters",
+        "# Comment\n"
+        "dir/prog:case1\n"
+        "\n"
+        "dir/prog:case2\n"
+        "other");
+
+    std::map< std::string, std::vector< std::string > > options;
+    options["filters-from"].push_back("filters");
+    cmdline::args_vector args;
+    args.push_back("foo");
+    const cmdline::parsed_cmdline mock_cmdline(options, args);
+
+    std::set< engine::test_filter > exp_filters;
+    exp_filters.insert(mkfilter("foo", ""));
+    exp_filters.insert(mkfilter("dir/prog", "case1"));
+    exp_filters.insert(mkfilter("dir/prog", "case2"));
+    exp_filters.insert(mkfilter("other", ""));
+
+    ATF_REQUIRE(exp_filters == cli::parse_filters(mock_cmdline));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(parse_filters__cmdline__file_errors);
+ATF_TEST_CASE_BODY(parse_filters__cmdline__file_errors)
+{
+    std::map< std::string, std::vector< std::string > > options;
+    options["filters-from"].push_back("filters");
+    cmdline::args_vector args;
+    args.push_back("foo");
+    const cmdline::parsed_cmdline mock_cmdline(options, args);
+
+    ATF_REQUIRE_THROW_RE(cmdline::error, "Cannot open filters file filters",
+                         cli::parse_filters(mock_cmdline));
+
+    atf::utils::create_file("filters", "bar\nfoo:abc\n");
+    ATF_REQUIRE_THROW_RE(cmdline::error, "'foo'.*'foo:abc'.*disjoint",
+                         cli::parse_filters(mock_cmdline));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(report_unused_filters__none);
 ATF_TEST_CASE_BODY(report_unused_filters__none)
 {
@@ -461,11 +556,16 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, results_file_open__default__latest);
     ATF_ADD_TEST_CASE(tcs, results_file_open__default__historical);
     ATF_ADD_TEST_CASE(tcs, results_file_open__explicit);
+    ATF_ADD_TEST_CASE(tcs, results_files_open__default);
+    ATF_ADD_TEST_CASE(tcs, results_files_open__explicit);
 
     ATF_ADD_TEST_CASE(tcs, parse_filters__none);
     ATF_ADD_TEST_CASE(tcs, parse_filters__ok);
     ATF_ADD_TEST_CASE(tcs, parse_filters__duplicate);
     ATF_ADD_TEST_CASE(tcs, parse_filters__nondisjoint);
+    ATF_ADD_TEST_CASE(tcs, parse_filters__cmdline__no_file);
+    ATF_ADD_TEST_CASE(tcs, parse_filters__cmdline__file);
+    ATF_ADD_TEST_CASE(tcs, parse_filters__cmdline__file_errors);
 
     ATF_ADD_TEST_CASE(tcs, report_unused_filters__none);
     ATF_ADD_TEST_CASE(tcs, report_unused_filters__some);
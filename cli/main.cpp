@@ -45,11 +45,14 @@ extern "C" {
 #include "cli/cmd_about.hpp"
 #include "cli/cmd_config.hpp"
 #include "cli/cmd_db_exec.hpp"
+#include "cli/cmd_db_gc.hpp"
 #include "cli/cmd_db_migrate.hpp"
 #include "cli/cmd_debug.hpp"
 #include "cli/cmd_help.hpp"
 #include "cli/cmd_list.hpp"
 #include "cli/cmd_report.hpp"
+#include "cli/cmd_report_durations.hpp"
+#include "cli/cmd_report_flaky.hpp"
 #include "cli/cmd_report_html.hpp"
 #include "cli/cmd_report_junit.hpp"
 #include "cli/cmd_test.hpp"
@@ -186,6 +189,7 @@ safe_main(cmdline::ui* ui, int argc, const char* const argv[],
     commands.insert(new cli::cmd_about());
     commands.insert(new cli::cmd_config());
     commands.insert(new cli::cmd_db_exec());
+    commands.insert(new cli::cmd_db_gc());
     commands.insert(new cli::cmd_db_migrate());
     commands.insert(new cli::cmd_help(&options, &commands));
 
@@ -194,6 +198,8 @@ safe_main(cmdline::ui* ui, int argc, const char* const argv[],
     commands.insert(new cli::cmd_test(), "Workspace");
 
     commands.insert(new cli::cmd_report(), "Reporting");
+    commands.insert(new cli::cmd_report_durations(), "Reporting");
+    commands.insert(new cli::cmd_report_flaky(), "Reporting");
     commands.insert(new cli::cmd_report_html(), "Reporting");
     commands.insert(new cli::cmd_report_junit(), "Reporting");
 
@@ -213,6 +219,7 @@ safe_main(cmdline::ui* ui, int argc, const char* const argv[],
     } catch (const std::range_error& e) {
         throw cmdline::usage_error(e.what());
     }
+    logging::set_buffered(true);
 
     if (cmdline.arguments().empty())
         throw cmdline::usage_error("No command provided");
@@ -352,5 +359,6 @@ cli::main(const int argc, const char* const* const argv)
 
     const int exit_code = main(&ui, argc, argv);
     LI(F("Clean exit with code %s") % exit_code);
+    logging::flush();
     return exit_code;
 }
@@ -0,0 +1,406 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "drivers/compare_durations.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <utility>
+
+#include "model/test_result.hpp"
+#include "store/read_backend.hpp"
+#include "store/read_transaction.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/logging/macros.hpp"
+#include "utils/noncopyable.hpp"
+#include "utils/sanity.hpp"
+
+namespace compare_durations = drivers::compare_durations;
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+
+
+/// Number of standard deviations that a slowdown must exceed to be reported.
+const std::size_t compare_durations::max_deviations = 3;
+
+
+namespace {
+
+
+/// Identifier of a test case: relative path of its test program and its name.
+typedef std::pair< std::string, std::string > test_case_key;
+
+
+/// Sorted stream of the outcomes stored in a results file.
+///
+/// The results file is closed when the stream is destroyed.
+class outcomes_stream : utils::noncopyable {
+    /// The open results file.
+    store::read_backend _backend;
+
+    /// The transaction used to read the results file.
+    store::read_transaction _tx;
+
+    /// Iterator over the outcomes of the results file.
+    store::outcomes_iterator _iter;
+
+    /// Identifier of the current outcome; only valid if not done().
+    test_case_key _key;
+
+    /// Refreshes the cached identifier of the current outcome.
+    void
+    load_key(void)
+    {
+        if (_iter) {
+            _key.first = _iter.test_program_path();
+            _key.second = _iter.test_case_name();
+        }
+    }
+
+public:
+    /// Opens a results file and positions the stream on its first outcome.
+    ///
+    /// \param file The results file to read.
+    ///
+    /// \throw store::error If the results file cannot be read.
+    explicit outcomes_stream(const fs::path& file) :
+        _backend(store::read_backend::open_ro(file)),
+        _tx(_backend.start_read()),
+        _iter(_tx.get_outcomes())
+    {
+        load_key();
+    }
+
+    /// Checks whether the stream has been fully consumed.
+    ///
+    /// \return True if there are no more outcomes.
+    bool
+    done(void) const
+    {
+        return !_iter;
+    }
+
+    /// Gets the identifier of the current outcome.
+    ///
+    /// \return The test program and test case name of the current outcome.
+    const test_case_key&
+    key(void) const
+    {
+        PRE(!done());
+        return _key;
+    }
+
+    /// Gets the result type of the current outcome.
+    ///
+    /// \return A test result type.
+    model::test_result_type
+    result_type(void) const
+    {
+        PRE(!done());
+        return _iter.result_type();
+    }
+
+    /// Gets the run time of the current outcome.
+    ///
+    /// \return The run time in microseconds.
+    int64_t
+    duration(void) const
+    {
+        PRE(!done());
+        return _iter.duration().to_microseconds();
+    }
+
+    /// Moves to the next outcome.
+    void
+    next(void)
+    {
+        ++_iter;
+        load_key();
+    }
+};
+
+
+/// Collection of open streams.  The first one is the current run.
+///
+/// The streams are stored as pointers because the transactions they hold keep
+/// references to their backends, so they cannot be moved around.
+typedef std::vector< std::shared_ptr< outcomes_stream > > streams_vector;
+
+
+/// Checks if a result type carries a meaningful run time.
+///
+/// Test cases that did not pass usually stop early, so their run time cannot be
+/// compared against a complete run.
+///
+/// \param type The type to check.
+///
+/// \return True if the test case ran to completion.
+static bool
+is_complete(const model::test_result_type type)
+{
+    return type == model::test_result_passed;
+}
+
+
+/// Converts a number of microseconds into a delta.
+///
+/// \param value The microseconds to convert.  Negative values are clamped to
+///     zero.
+///
+/// \return The delta.
+static datetime::delta
+to_delta(const double value)
+{
+    if (value <= 0.0)
+        return datetime::delta();
+    return datetime::delta::from_microseconds(static_cast< int64_t >(value));
+}
+
+
+/// Accumulator for the run time of the test program being merged.
+struct program_accumulator {
+    /// Relative path to the test program.
+    fs::path test_program;
+
+    /// Whether any of the test cases of the program matched the filters.
+    bool matched;
+
+    /// Sum of the run time of the program in all baseline runs.
+    int64_t baseline;
+
+    /// Sum of the run time of the program in the current run.
+    int64_t current;
+
+    /// Constructor.
+    ///
+    /// \param test_program_ Relative path to the test program.
+    explicit program_accumulator(const fs::path& test_program_) :
+        test_program(test_program_), matched(false), baseline(0), current(0)
+    {
+    }
+};
+
+
+/// Records the totals of a test program if any of its test cases matched.
+///
+/// \param program The accumulated run time of the test program.
+/// \param baseline_runs Number of baseline runs.
+/// \param [in,out] programs The collection to update.
+static void
+flush_program(const program_accumulator& program,
+              const std::size_t baseline_runs,
+              std::vector< compare_durations::test_program_totals >& programs)
+{
+    if (!program.matched)
+        return;
+
+    compare_durations::test_program_totals totals(program.test_program);
+    if (baseline_runs > 0)
+        totals.baseline = to_delta(static_cast< double >(program.baseline) /
+                                   static_cast< double >(baseline_runs));
+    totals.current = to_delta(static_cast< double >(program.current));
+    programs.push_back(totals);
+}
+
+
+/// Sorts slowdowns from the largest to the smallest.
+///
+/// \param a The first slowdown to compare.
+/// \param b The second slowdown to compare.
+///
+/// \return True if a is larger than b.
+static bool
+larger_slowdown(const compare_durations::test_case_slowdown& a,
+                const compare_durations::test_case_slowdown& b)
+{
+    const int64_t delta_a = a.current.to_microseconds() -
+        a.baseline_mean.to_microseconds();
+    const int64_t delta_b = b.current.to_microseconds() -
+        b.baseline_mean.to_microseconds();
+    if (delta_a != delta_b)
+        return delta_a > delta_b;
+    if (a.test_program != b.test_program)
+        return a.test_program < b.test_program;
+    return a.test_case_name < b.test_case_name;
+}
+
+
+}  // anonymous namespace
+
+
+/// Constructs a slowdown with no data.
+///
+/// \param test_program_ Relative path to the test program.
+/// \param test_case_name_ Name of the test case.
+compare_durations::test_case_slowdown::test_case_slowdown(
+    const fs::path& test_program_, const std::string& test_case_name_) :
+    test_program(test_program_),
+    test_case_name(test_case_name_),
+    baseline_runs(0)
+{
+}
+
+
+/// Constructs the totals of a test program that did not run.
+///
+/// \param test_program_ Relative path to the test program.
+compare_durations::test_program_totals::test_program_totals(
+    const fs::path& test_program_) :
+    test_program(test_program_)
+{
+}
+
+
+/// Executes the operation.
+///
+/// All the results files are read in parallel as streams sorted by test case
+/// and merged as they are read.  At any point in time, only the current outcome
+/// of every file and the totals of the test program being merged are held in
+/// memory.
+///
+/// \param baselines The results files to compare against.
+/// \param current The results file to check for slowdowns.
+/// \param filters The test case filters as provided by the user.
+/// \param limits The criteria to flag a slowdown as significant.
+///
+/// \return A structure with all results computed by this driver.
+///
+/// \throw store::error If any of the results files cannot be read.
+compare_durations::result
+compare_durations::drive(const std::vector< fs::path >& baselines,
+                         const fs::path& current,
+                         const std::set< engine::test_filter >& filters,
+                         const thresholds& limits)
+{
+    streams_vector streams;
+    LI(F("Comparing durations in %s") % current);
+    streams.push_back(std::shared_ptr< outcomes_stream >(
+        new outcomes_stream(current)));
+    for (std::vector< fs::path >::const_iterator iter = baselines.begin();
+         iter != baselines.end(); ++iter) {
+        LI(F("Using %s as a baseline") % *iter);
+        streams.push_back(std::shared_ptr< outcomes_stream >(
+            new outcomes_stream(*iter)));
+    }
+
+    engine::filters_state filters_state(filters);
+    std::vector< test_case_slowdown > slowdowns;
+    std::vector< test_program_totals > programs;
+    std::auto_ptr< program_accumulator > program;
+    std::vector< int64_t > samples;
+    samples.reserve(baselines.size());
+
+    for (;;) {
+        const test_case_key* next = NULL;
+        for (streams_vector::const_iterator iter = streams.begin();
+             iter != streams.end(); ++iter) {
+            if (!(*iter)->done() && (next == NULL || (*iter)->key() < *next))
+                next = &(*iter)->key();
+        }
+        if (next == NULL)
+            break;
+        // The streams are advanced below, which invalidates next.
+        const test_case_key key = *next;
+
+        if (program.get() == NULL ||
+            program->test_program.str() != key.first) {
+            if (program.get() != NULL)
+                flush_program(*program, baselines.size(), programs);
+            program.reset(new program_accumulator(fs::path(key.first)));
+        }
+        const bool matched =
+            filters_state.match_test_program(program->test_program) &&
+            filters_state.match_test_case(program->test_program, key.second);
+
+        bool current_complete = false;
+        int64_t current_duration = 0;
+        samples.clear();
+        for (streams_vector::size_type i = 0; i < streams.size(); ++i) {
+            outcomes_stream& stream = *streams[i];
+            if (stream.done() || stream.key() != key)
+                continue;
+
+            if (matched) {
+                const int64_t duration = stream.duration();
+                if (i == 0) {
+                    program->current += duration;
+                    current_complete = is_complete(stream.result_type());
+                    current_duration = duration;
+                } else {
+                    program->baseline += duration;
+                    if (is_complete(stream.result_type()))
+                        samples.push_back(duration);
+                }
+            }
+            stream.next();
+        }
+        if (!matched)
+            continue;
+        program->matched = true;
+
+        if (!current_complete || samples.empty())
+            continue;
+
+        double mean = 0.0;
+        for (std::vector< int64_t >::const_iterator iter = samples.begin();
+             iter != samples.end(); ++iter)
+            mean += static_cast< double >(*iter);
+        mean /= static_cast< double >(samples.size());
+        double variance = 0.0;
+        for (std::vector< int64_t >::const_iterator iter = samples.begin();
+             iter != samples.end(); ++iter) {
+            const double diff = static_cast< double >(*iter) - mean;
+            variance += diff * diff;
+        }
+        variance /= static_cast< double >(samples.size());
+        const double stddev = std::sqrt(variance);
+
+        const double slowdown = static_cast< double >(current_duration) - mean;
+        if (slowdown <= 0.0 ||
+            slowdown < static_cast< double >(
+                limits.min_delta.to_microseconds()) ||
+            slowdown < limits.min_ratio * mean ||
+            (samples.size() >= 2 &&
+             slowdown <= static_cast< double >(max_deviations) * stddev))
+            continue;
+
+        test_case_slowdown entry(program->test_program, key.second);
+        entry.baseline_runs = samples.size();
+        entry.baseline_mean = to_delta(mean);
+        entry.baseline_stddev = to_delta(stddev);
+        entry.current = to_delta(static_cast< double >(current_duration));
+        slowdowns.push_back(entry);
+    }
+    if (program.get() != NULL)
+        flush_program(*program, baselines.size(), programs);
+
+    std::sort(slowdowns.begin(), slowdowns.end(), larger_slowdown);
+    return result(baselines.size(), slowdowns, programs,
+                  filters_state.unused());
+}
@@ -0,0 +1,165 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file drivers/compare_durations.hpp
+/// Driver to detect test cases that became slower between runs.
+///
+/// This driver module compares the run time of the test cases in a results
+/// file against the run time of the same test cases in one or more baseline
+/// results files.  The outcomes of all the files are read as sorted streams
+/// and merged on the fly, so the memory needed is independent of the number of
+/// test cases in the files.
+
+#if !defined(DRIVERS_COMPARE_DURATIONS_HPP)
+#define DRIVERS_COMPARE_DURATIONS_HPP
+
+#include <cstddef>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "engine/filters.hpp"
+#include "utils/datetime.hpp"
+#include "utils/fs/path.hpp"
+
+namespace drivers {
+namespace compare_durations {
+
+
+/// Number of standard deviations that a slowdown must exceed to be reported.
+///
+/// This only applies when there are at least two baseline runs of the test
+/// case, as otherwise there is no variance to compare against.
+extern const std::size_t max_deviations;
+
+
+/// Criteria to decide whether a slowdown is significant.
+class thresholds {
+public:
+    /// Minimum slowdown, as a fraction of the baseline run time.
+    double min_ratio;
+
+    /// Minimum slowdown, in absolute terms.
+    utils::datetime::delta min_delta;
+
+    /// Initializer for the tuple's fields.
+    ///
+    /// \param min_ratio_ Minimum slowdown as a fraction of the baseline.
+    /// \param min_delta_ Minimum slowdown in absolute terms.
+    thresholds(const double min_ratio_,
+               const utils::datetime::delta& min_delta_) :
+        min_ratio(min_ratio_),
+        min_delta(min_delta_)
+    {
+    }
+};
+
+
+/// Run time of a test case that became slower.
+class test_case_slowdown {
+public:
+    /// Relative path to the test program.
+    utils::fs::path test_program;
+
+    /// Name of the test case.
+    std::string test_case_name;
+
+    /// Number of baseline runs in which the test case passed.
+    std::size_t baseline_runs;
+
+    /// Average run time of the test case in the baseline runs.
+    utils::datetime::delta baseline_mean;
+
+    /// Standard deviation of the run time of the test case in the baselines.
+    utils::datetime::delta baseline_stddev;
+
+    /// Run time of the test case in the current run.
+    utils::datetime::delta current;
+
+    test_case_slowdown(const utils::fs::path&, const std::string&);
+};
+
+
+/// Total run time of a test program in the baseline and current runs.
+class test_program_totals {
+public:
+    /// Relative path to the test program.
+    utils::fs::path test_program;
+
+    /// Average total run time of the test program in the baseline runs.
+    utils::datetime::delta baseline;
+
+    /// Total run time of the test program in the current run.
+    utils::datetime::delta current;
+
+    test_program_totals(const utils::fs::path&);
+};
+
+
+/// Tuple containing the results of this driver.
+class result {
+public:
+    /// Number of baseline results files that were scanned.
+    std::size_t baseline_runs;
+
+    /// Test cases that became significantly slower, largest slowdown first.
+    std::vector< test_case_slowdown > slowdowns;
+
+    /// Run time of every test program, sorted by path.
+    std::vector< test_program_totals > programs;
+
+    /// Filters that did not match any available test case.
+    std::set< engine::test_filter > unused_filters;
+
+    /// Initializer for the tuple's fields.
+    ///
+    /// \param baseline_runs_ The number of baseline files that were scanned.
+    /// \param slowdowns_ The test cases that became slower, sorted.
+    /// \param programs_ The run time of every test program.
+    /// \param unused_filters_ The filters that did not match any test case.
+    result(const std::size_t baseline_runs_,
+           const std::vector< test_case_slowdown >& slowdowns_,
+           const std::vector< test_program_totals >& programs_,
+           const std::set< engine::test_filter >& unused_filters_) :
+        baseline_runs(baseline_runs_),
+        slowdowns(slowdowns_),
+        programs(programs_),
+        unused_filters(unused_filters_)
+    {
+    }
+};
+
+
+result drive(const std::vector< utils::fs::path >&, const utils::fs::path&,
+             const std::set< engine::test_filter >&, const thresholds&);
+
+
+}  // namespace compare_durations
+}  // namespace drivers
+
+#endif  // !defined(DRIVERS_COMPARE_DURATIONS_HPP)
@@ -0,0 +1,335 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "drivers/compare_durations.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+#include "engine/filters.hpp"
+#include "model/context.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "store/exceptions.hpp"
+#include "store/write_backend.hpp"
+#include "store/write_transaction.hpp"
+#include "utils/datetime.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/path.hpp"
+
+namespace compare_durations = drivers::compare_durations;
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+
+
+namespace {
+
+
+/// Outcome of a test case to record in a results file.
+struct outcome {
+    /// Relative path to the test program.
+    const char* test_program;
+
+    /// Name of the test case.
+    const char* test_case_name;
+
+    /// Type of the result.
+    model::test_result_type type;
+
+    /// Run time of the test case, in milliseconds.
+    int duration;
+};
+
+
+/// Creates a results file with the given outcomes.
+///
+/// \param db_name The database to create.
+/// \param outcomes The outcomes to store.  Test cases of the same test program
+///     must be contiguous.
+///
+/// \return The path to the created file, for convenience.
+static fs::path
+create_run(const fs::path& db_name, const std::vector< outcome >& outcomes)
+{
+    store::write_backend backend = store::write_backend::open_rw(db_name);
+    store::write_transaction tx = backend.start_write();
+    tx.put_context(model::context(fs::path("/root"),
+                                  std::map< std::string, std::string >()));
+
+    const datetime::timestamp start = datetime::timestamp::from_values(
+        2014, 1, 1, 0, 0, 0, 0);
+    std::vector< outcome >::const_iterator iter = outcomes.begin();
+    while (iter != outcomes.end()) {
+        std::vector< outcome >::const_iterator last = iter;
+        model::test_program_builder builder(
+            "plain", fs::path((*iter).test_program), fs::path("/root"),
+            "suite");
+        for (; last != outcomes.end() &&
+                 std::string((*last).test_program) == (*iter).test_program;
+             ++last)
+            builder.add_test_case((*last).test_case_name);
+        const model::test_program test_program = builder.build();
+        const int64_t tp_id = tx.put_test_program(test_program);
+
+        for (; iter != last; ++iter) {
+            const int64_t tc_id = tx.put_test_case(
+                test_program, (*iter).test_case_name, tp_id);
+            const model::test_result result =
+                (*iter).type == model::test_result_passed ?
+                model::test_result((*iter).type) :
+                model::test_result((*iter).type, "Some reason");
+            tx.put_result(result, tc_id, start, start +
+                          datetime::delta::from_microseconds(
+                              (*iter).duration * 1000));
+        }
+    }
+
+    tx.commit();
+    backend.close();
+    return db_name;
+}
+
+
+/// Thresholds used by most tests: 20% and 100ms.
+static const compare_durations::thresholds default_thresholds(
+    0.2, datetime::delta(0, 100000));
+
+
+/// Shorthand to build an outcome.
+///
+/// \param test_program Relative path to the test program.
+/// \param test_case_name Name of the test case.
+/// \param duration Run time of the test case, in milliseconds.
+/// \param type Type of the result.
+///
+/// \return The outcome.
+static outcome
+make_outcome(const char* test_program, const char* test_case_name,
+             const int duration,
+             const model::test_result_type type = model::test_result_passed)
+{
+    const outcome data = { test_program, test_case_name, type, duration };
+    return data;
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(no_baselines);
+ATF_TEST_CASE_BODY(no_baselines)
+{
+    std::vector< outcome > current;
+    current.push_back(make_outcome("dir/prog", "a", 1000));
+    current.push_back(make_outcome("dir/prog", "b", 500));
+    create_run(fs::path("current.db"), current);
+
+    const compare_durations::result result = compare_durations::drive(
+        std::vector< fs::path >(), fs::path("current.db"),
+        std::set< engine::test_filter >(), default_thresholds);
+    ATF_REQUIRE_EQ(0, result.baseline_runs);
+    ATF_REQUIRE(result.slowdowns.empty());
+    ATF_REQUIRE_EQ(1, result.programs.size());
+    ATF_REQUIRE_EQ(fs::path("dir/prog"), result.programs[0].test_program);
+    ATF_REQUIRE_EQ(datetime::delta(), result.programs[0].baseline);
+    ATF_REQUIRE_EQ(datetime::delta(1, 500000), result.programs[0].current);
+    ATF_REQUIRE(result.unused_filters.empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(one_baseline);
+ATF_TEST_CASE_BODY(one_baseline)
+{
+    // Test programs are inserted out of order on purpose to verify that the
+    // streams are merged in sorted order.
+    std::vector< outcome > baseline;
+    baseline.push_back(make_outcome("z/prog", "slower", 1000));
+    baseline.push_back(make_outcome("z/prog", "removed", 300));
+    baseline.push_back(make_outcome("a/prog", "small", 1000));
+    baseline.push_back(make_outcome("a/prog", "tiny", 10));
+    baseline.push_back(make_outcome("a/prog", "faster", 2000));
+    baseline.push_back(make_outcome("a/prog", "much_slower", 100));
+    create_run(fs::path("baseline.db"), baseline);
+
+    std::vector< outcome > current;
+    current.push_back(make_outcome("a/prog", "much_slower", 5100));
+    current.push_back(make_outcome("a/prog", "faster", 1000));
+    current.push_back(make_outcome("a/prog", "tiny", 50));
+    current.push_back(make_outcome("a/prog", "small", 1100));
+    current.push_back(make_outcome("a/prog", "new", 4000));
+    current.push_back(make_outcome("z/prog", "slower", 2000));
+    create_run(fs::path("current.db"), current);
+
+    const compare_durations::result result = compare_durations::drive(
+        std::vector< fs::path >(1, fs::path("baseline.db")),
+        fs::path("current.db"), std::set< engine::test_filter >(),
+        default_thresholds);
+    ATF_REQUIRE_EQ(1, result.baseline_runs);
+
+    ATF_REQUIRE_EQ(2, result.slowdowns.size());
+    ATF_REQUIRE_EQ(fs::path("a/prog"), result.slowdowns[0].test_program);
+    ATF_REQUIRE_EQ("much_slower", result.slowdowns[0].test_case_name);
+    ATF_REQUIRE_EQ(1, result.slowdowns[0].baseline_runs);
+    ATF_REQUIRE_EQ(datetime::delta(0, 100000),
+                   result.slowdowns[0].baseline_mean);
+    ATF_REQUIRE_EQ(datetime::delta(), result.slowdowns[0].baseline_stddev);
+    ATF_REQUIRE_EQ(datetime::delta(5, 100000), result.slowdowns[0].current);
+    ATF_REQUIRE_EQ(fs::path("z/prog"), result.slowdowns[1].test_program);
+    ATF_REQUIRE_EQ("slower", result.slowdowns[1].test_case_name);
+
+    ATF_REQUIRE_EQ(2, result.programs.size());
+    ATF_REQUIRE_EQ(fs::path("a/prog"), result.programs[0].test_program);
+    ATF_REQUIRE_EQ(datetime::delta(3, 110000), result.programs[0].baseline);
+    ATF_REQUIRE_EQ(datetime::delta(11, 250000), result.programs[0].current);
+    ATF_REQUIRE_EQ(fs::path("z/prog"), result.programs[1].test_program);
+    ATF_REQUIRE_EQ(datetime::delta(1, 300000), result.programs[1].baseline);
+    ATF_REQUIRE_EQ(datetime::delta(2, 0), result.programs[1].current);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(many_baselines__variance);
+ATF_TEST_CASE_BODY(many_baselines__variance)
+{
+    const int noisy[] = { 1000, 3000, 2000 };
+    std::vector< fs::path > baselines;
+    for (int i = 0; i < 3; ++i) {
+        std::vector< outcome > baseline;
+        baseline.push_back(make_outcome("dir/prog", "noisy", noisy[i]));
+        baseline.push_back(make_outcome("dir/prog", "steady", 1000));
+        baselines.push_back(create_run(fs::path(F("baseline%s.db") % i),
+                                       baseline));
+    }
+
+    // "noisy" is 2s slower than its mean, but that is within 3 standard
+    // deviations; "steady" is only 0.5s slower but has never varied.
+    std::vector< outcome > current;
+    current.push_back(make_outcome("dir/prog", "noisy", 4000));
+    current.push_back(make_outcome("dir/prog", "steady", 1500));
+    create_run(fs::path("current.db"), current);
+
+    const compare_durations::result result = compare_durations::drive(
+        baselines, fs::path("current.db"), std::set< engine::test_filter >(),
+        default_thresholds);
+    ATF_REQUIRE_EQ(3, result.baseline_runs);
+    ATF_REQUIRE_EQ(1, result.slowdowns.size());
+    ATF_REQUIRE_EQ("steady", result.slowdowns[0].test_case_name);
+    ATF_REQUIRE_EQ(3, result.slowdowns[0].baseline_runs);
+    ATF_REQUIRE_EQ(datetime::delta(1, 0), result.slowdowns[0].baseline_mean);
+
+    ATF_REQUIRE_EQ(1, result.programs.size());
+    ATF_REQUIRE_EQ(datetime::delta(3, 0), result.programs[0].baseline);
+    ATF_REQUIRE_EQ(datetime::delta(5, 500000), result.programs[0].current);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(only_passed);
+ATF_TEST_CASE_BODY(only_passed)
+{
+    std::vector< outcome > baseline;
+    baseline.push_back(make_outcome("dir/prog", "a", 100));
+    baseline.push_back(make_outcome("dir/prog", "b", 100,
+                                    model::test_result_failed));
+    create_run(fs::path("baseline.db"), baseline);
+
+    std::vector< outcome > current;
+    current.push_back(make_outcome("dir/prog", "a", 9000,
+                                   model::test_result_broken));
+    current.push_back(make_outcome("dir/prog", "b", 9000));
+    create_run(fs::path("current.db"), current);
+
+    const compare_durations::result result = compare_durations::drive(
+        std::vector< fs::path >(1, fs::path("baseline.db")),
+        fs::path("current.db"), std::set< engine::test_filter >(),
+        default_thresholds);
+    ATF_REQUIRE(result.slowdowns.empty());
+    ATF_REQUIRE_EQ(datetime::delta(18, 0), result.programs[0].current);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(filters);
+ATF_TEST_CASE_BODY(filters)
+{
+    std::vector< outcome > baseline;
+    baseline.push_back(make_outcome("dir/a", "slow", 100));
+    baseline.push_back(make_outcome("dir/b", "slow", 100));
+    create_run(fs::path("baseline.db"), baseline);
+
+    std::vector< outcome > current;
+    current.push_back(make_outcome("dir/a", "slow", 1000));
+    current.push_back(make_outcome("dir/b", "slow", 1000));
+    create_run(fs::path("current.db"), current);
+
+    std::set< engine::test_filter > filters;
+    filters.insert(engine::test_filter(fs::path("dir/b"), ""));
+    filters.insert(engine::test_filter(fs::path("dir/c"), ""));
+
+    const compare_durations::result result = compare_durations::drive(
+        std::vector< fs::path >(1, fs::path("baseline.db")),
+        fs::path("current.db"), filters, default_thresholds);
+    ATF_REQUIRE_EQ(1, result.slowdowns.size());
+    ATF_REQUIRE_EQ(fs::path("dir/b"), result.slowdowns[0].test_program);
+    ATF_REQUIRE_EQ(1, result.programs.size());
+    ATF_REQUIRE_EQ(fs::path("dir/b"), result.programs[0].test_program);
+
+    std::set< engine::test_filter > exp_unused;
+    exp_unused.insert(engine::test_filter(fs::path("dir/c"), ""));
+    ATF_REQUIRE(exp_unused == result.unused_filters);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(missing_db);
+ATF_TEST_CASE_BODY(missing_db)
+{
+    std::vector< outcome > current;
+    current.push_back(make_outcome("dir/prog", "a", 100));
+    create_run(fs::path("current.db"), current);
+
+    ATF_REQUIRE_THROW(store::error, compare_durations::drive(
+        std::vector< fs::path >(1, fs::path("missing.db")),
+        fs::path("current.db"), std::set< engine::test_filter >(),
+        default_thresholds));
+    ATF_REQUIRE_THROW(store::error, compare_durations::drive(
+        std::vector< fs::path >(1, fs::path("current.db")),
+        fs::path("missing.db"), std::set< engine::test_filter >(),
+        default_thresholds));
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, no_baselines);
+    ATF_ADD_TEST_CASE(tcs, one_baseline);
+    ATF_ADD_TEST_CASE(tcs, many_baselines__variance);
+    ATF_ADD_TEST_CASE(tcs, only_passed);
+    ATF_ADD_TEST_CASE(tcs, filters);
+    ATF_ADD_TEST_CASE(tcs, missing_db);
+}
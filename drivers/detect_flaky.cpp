@@ -0,0 +1,267 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "drivers/detect_flaky.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+
+#include "model/test_result.hpp"
+#include "store/read_backend.hpp"
+#include "store/read_transaction.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/logging/macros.hpp"
+#include "utils/sanity.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace detect_flaky = drivers::detect_flaky;
+
+
+namespace {
+
+
+/// Running statistics of a test case, updated as runs are scanned.
+struct accumulator {
+    /// Number of runs in which the test case passed or failed.
+    std::size_t runs;
+
+    /// Number of runs in which the test case failed.
+    std::size_t failures;
+
+    /// Number of times the outcome changed between consecutive runs.
+    std::size_t transitions;
+
+    /// Whether the test case failed in the last run that included it.
+    bool last_failed;
+
+    /// Mean of the durations seen so far, in microseconds.
+    double mean;
+
+    /// Sum of squared differences from the mean, in microseconds squared.
+    ///
+    /// This is the intermediate value of Welford's algorithm, which computes
+    /// the variance in a single pass without accumulating large sums.
+    double m2;
+
+    /// Constructor.
+    accumulator(void) :
+        runs(0), failures(0), transitions(0), last_failed(false), mean(0.0),
+        m2(0.0)
+    {
+    }
+
+    /// Accounts for a new outcome of the test case.
+    ///
+    /// \param failed Whether the test case failed in this run.
+    /// \param duration The run time of the test case in this run.
+    void
+    add(const bool failed, const datetime::delta& duration)
+    {
+        if (runs > 0 && failed != last_failed)
+            ++transitions;
+        last_failed = failed;
+        if (failed)
+            ++failures;
+        ++runs;
+
+        const double value = static_cast< double >(
+            duration.to_microseconds());
+        const double delta = value - mean;
+        mean += delta / static_cast< double >(runs);
+        m2 += delta * (value - mean);
+    }
+};
+
+
+/// Identifier of a test case: relative path of its test program and its name.
+typedef std::pair< std::string, std::string > test_case_key;
+
+
+/// Collection of the statistics of all the test cases seen so far.
+typedef std::map< test_case_key, accumulator > accumulators_map;
+
+
+/// Checks whether a result type counts as a failure.
+///
+/// \param type The type to check.
+/// \param [out] failed Set to whether the result is a failure.
+///
+/// \return False if the result does not say anything about the health of the
+/// test case, as is the case for skipped tests; true otherwise.
+static bool
+classify(const model::test_result_type type, bool& failed)
+{
+    switch (type) {
+    case model::test_result_passed:
+    case model::test_result_expected_failure:
+        failed = false;
+        return true;
+
+    case model::test_result_broken:
+    case model::test_result_failed:
+        failed = true;
+        return true;
+
+    case model::test_result_skipped:
+        return false;
+    }
+    UNREACHABLE;
+}
+
+
+/// Adds the outcomes of a single run to the statistics.
+///
+/// \param file The results file of the run.
+/// \param [in,out] accumulators The statistics to update.
+///
+/// \throw store::error If the results file cannot be read.
+static void
+scan_run(const fs::path& file, accumulators_map& accumulators)
+{
+    LI(F("Scanning outcomes in %s") % file);
+
+    store::read_backend db = store::read_backend::open_ro(file);
+    store::read_transaction tx = db.start_read();
+    for (store::outcomes_iterator iter = tx.get_outcomes(); iter; ++iter) {
+        bool failed;
+        if (!classify(iter.result_type(), failed))
+            continue;
+        accumulators[test_case_key(iter.test_program_path(),
+                                   iter.test_case_name())]
+            .add(failed, iter.duration());
+    }
+    tx.finish();
+    db.close();
+}
+
+
+/// Sorts test cases from the most to the least flaky.
+///
+/// \param a The first test case to compare.
+/// \param b The second test case to compare.
+///
+/// \return True if a is more flaky than b.
+static bool
+more_flaky(const detect_flaky::test_case_history& a,
+           const detect_flaky::test_case_history& b)
+{
+    const double rate_a = a.transition_rate();
+    const double rate_b = b.transition_rate();
+    if (rate_a != rate_b)
+        return rate_a > rate_b;
+    if (a.transitions != b.transitions)
+        return a.transitions > b.transitions;
+    if (a.duration_stddev != b.duration_stddev)
+        return a.duration_stddev > b.duration_stddev;
+    if (a.test_program != b.test_program)
+        return a.test_program < b.test_program;
+    return a.test_case_name < b.test_case_name;
+}
+
+
+}  // anonymous namespace
+
+
+/// Constructs a history with no runs.
+///
+/// \param test_program_ Relative path to the test program.
+/// \param test_case_name_ Name of the test case.
+detect_flaky::test_case_history::test_case_history(
+    const fs::path& test_program_, const std::string& test_case_name_) :
+    test_program(test_program_),
+    test_case_name(test_case_name_),
+    runs(0),
+    failures(0),
+    transitions(0)
+{
+}
+
+
+/// Computes how often the outcome of the test case changes.
+///
+/// \return The fraction of consecutive pairs of runs with different outcomes,
+/// between 0 and 1.
+double
+detect_flaky::test_case_history::transition_rate(void) const
+{
+    if (runs < 2)
+        return 0.0;
+    return static_cast< double >(transitions) / static_cast< double >(runs - 1);
+}
+
+
+/// Executes the operation.
+///
+/// \param files The results files to scan, sorted from oldest to newest.
+/// \param filters The test case filters as provided by the user.
+///
+/// \return A structure with all results computed by this driver.
+///
+/// \throw store::error If any of the results files cannot be read.
+detect_flaky::result
+detect_flaky::drive(const std::vector< fs::path >& files,
+                    const std::set< engine::test_filter >& filters)
+{
+    accumulators_map accumulators;
+    for (std::vector< fs::path >::const_iterator iter = files.begin();
+         iter != files.end(); ++iter)
+        scan_run(*iter, accumulators);
+
+    // Filters are applied once per test case instead of once per outcome.
+    engine::filters_state filters_state(filters);
+    std::vector< test_case_history > flaky;
+    for (accumulators_map::const_iterator iter = accumulators.begin();
+         iter != accumulators.end(); ++iter) {
+        const accumulator& data = (*iter).second;
+        const fs::path test_program((*iter).first.first);
+        const std::string& test_case_name = (*iter).first.second;
+
+        if (!filters_state.match_test_program(test_program) ||
+            !filters_state.match_test_case(test_program, test_case_name))
+            continue;
+        if (data.transitions == 0)
+            continue;
+
+        test_case_history history(test_program, test_case_name);
+        history.runs = data.runs;
+        history.failures = data.failures;
+        history.transitions = data.transitions;
+        history.mean_duration = datetime::delta::from_microseconds(
+            static_cast< int64_t >(data.mean));
+        history.duration_stddev = datetime::delta::from_microseconds(
+            static_cast< int64_t >(std::sqrt(
+                data.m2 / static_cast< double >(data.runs))));
+        flaky.push_back(history);
+    }
+    std::sort(flaky.begin(), flaky.end(), more_flaky);
+
+    return result(files.size(), flaky, filters_state.unused());
+}
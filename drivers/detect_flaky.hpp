@@ -0,0 +1,121 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file drivers/detect_flaky.hpp
+/// Driver to detect flaky test cases from the history of a test suite.
+///
+/// This driver module scans the results files of multiple runs of a test suite,
+/// in chronological order, and identifies the test cases whose outcome changes
+/// between runs.  Only the outcomes of the test cases are read from the
+/// results files so that long histories can be processed quickly and with
+/// memory proportional to the number of test cases.
+
+#if !defined(DRIVERS_DETECT_FLAKY_HPP)
+#define DRIVERS_DETECT_FLAKY_HPP
+
+#include <cstddef>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "engine/filters.hpp"
+#include "utils/datetime.hpp"
+#include "utils/fs/path.hpp"
+
+namespace drivers {
+namespace detect_flaky {
+
+
+/// Statistics about the history of a single test case.
+class test_case_history {
+public:
+    /// Relative path to the test program.
+    utils::fs::path test_program;
+
+    /// Name of the test case.
+    std::string test_case_name;
+
+    /// Number of runs in which the test case passed or failed.
+    ///
+    /// Runs in which the test case was skipped or did not exist are ignored.
+    std::size_t runs;
+
+    /// Number of runs in which the test case failed or was broken.
+    std::size_t failures;
+
+    /// Number of times the outcome changed between consecutive runs.
+    std::size_t transitions;
+
+    /// Average run time of the test case.
+    utils::datetime::delta mean_duration;
+
+    /// Standard deviation of the run time of the test case.
+    utils::datetime::delta duration_stddev;
+
+    test_case_history(const utils::fs::path&, const std::string&);
+
+    double transition_rate(void) const;
+};
+
+
+/// Tuple containing the results of this driver.
+class result {
+public:
+    /// Number of results files that were scanned.
+    std::size_t runs;
+
+    /// Test cases whose outcome changed at least once, most flaky first.
+    std::vector< test_case_history > flaky;
+
+    /// Filters that did not match any available test case.
+    std::set< engine::test_filter > unused_filters;
+
+    /// Initializer for the tuple's fields.
+    ///
+    /// \param runs_ The number of results files that were scanned.
+    /// \param flaky_ The test cases whose outcome changed, sorted.
+    /// \param unused_filters_ The filters that did not match any test case.
+    result(const std::size_t runs_,
+           const std::vector< test_case_history >& flaky_,
+           const std::set< engine::test_filter >& unused_filters_) :
+        runs(runs_),
+        flaky(flaky_),
+        unused_filters(unused_filters_)
+    {
+    }
+};
+
+
+result drive(const std::vector< utils::fs::path >&,
+             const std::set< engine::test_filter >&);
+
+
+}  // namespace detect_flaky
+}  // namespace drivers
+
+#endif  // !defined(DRIVERS_DETECT_FLAKY_HPP)
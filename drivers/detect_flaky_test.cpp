@@ -0,0 +1,211 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "drivers/detect_flaky.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+#include "engine/filters.hpp"
+#include "model/context.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "store/exceptions.hpp"
+#include "store/write_backend.hpp"
+#include "store/write_transaction.hpp"
+#include "utils/datetime.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/path.hpp"
+
+namespace datetime = utils::datetime;
+namespace detect_flaky = drivers::detect_flaky;
+namespace fs = utils::fs;
+
+
+namespace {
+
+
+/// Creates a results file with one outcome per test case.
+///
+/// \param db_name The database to create.
+/// \param outcomes Mapping of test case names, all in the same test program,
+///     to their results.
+/// \param duration The run time of all the test cases, in seconds.
+///
+/// \return The path to the created file, for convenience.
+static fs::path
+create_run(const fs::path& db_name,
+           const std::map< std::string, model::test_result_type >& outcomes,
+           const int duration)
+{
+    store::write_backend backend = store::write_backend::open_rw(db_name);
+    store::write_transaction tx = backend.start_write();
+    tx.put_context(model::context(fs::path("/root"),
+                                  std::map< std::string, std::string >()));
+
+    model::test_program_builder builder(
+        "plain", fs::path("dir/prog"), fs::path("/root"), "suite");
+    for (std::map< std::string, model::test_result_type >::const_iterator
+             iter = outcomes.begin(); iter != outcomes.end(); ++iter)
+        builder.add_test_case((*iter).first);
+    const model::test_program test_program = builder.build();
+    const int64_t tp_id = tx.put_test_program(test_program);
+
+    const datetime::timestamp start = datetime::timestamp::from_values(
+        2014, 1, 1, 0, 0, 0, 0);
+    for (std::map< std::string, model::test_result_type >::const_iterator
+             iter = outcomes.begin(); iter != outcomes.end(); ++iter) {
+        const int64_t tc_id = tx.put_test_case(test_program, (*iter).first,
+                                               tp_id);
+        const model::test_result result =
+            (*iter).second == model::test_result_passed ?
+            model::test_result((*iter).second) :
+            model::test_result((*iter).second, "Some reason");
+        tx.put_result(result, tc_id, start,
+                      start + datetime::delta(duration, 0));
+    }
+
+    tx.commit();
+    backend.close();
+    return db_name;
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(no_runs);
+ATF_TEST_CASE_BODY(no_runs)
+{
+    const detect_flaky::result result = detect_flaky::drive(
+        std::vector< fs::path >(), std::set< engine::test_filter >());
+    ATF_REQUIRE_EQ(0, result.runs);
+    ATF_REQUIRE(result.flaky.empty());
+    ATF_REQUIRE(result.unused_filters.empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(ranking);
+ATF_TEST_CASE_BODY(ranking)
+{
+    const model::test_result_type passed = model::test_result_passed;
+    const model::test_result_type failed = model::test_result_failed;
+    const model::test_result_type skipped = model::test_result_skipped;
+
+    // "stable" always passes, "broken" always fails, "sometimes" changes once
+    // and "flaky" changes on every run ignoring the one in which it is
+    // skipped.
+    const char* names[] = { "stable", "broken", "sometimes", "flaky" };
+    const model::test_result_type runs[][4] = {
+        { passed, failed, passed, passed },
+        { passed, failed, passed, failed },
+        { passed, failed, failed, skipped },
+        { passed, failed, failed, passed },
+    };
+
+    std::vector< fs::path > files;
+    for (int i = 0; i < 4; ++i) {
+        std::map< std::string, model::test_result_type > outcomes;
+        for (int j = 0; j < 4; ++j)
+            outcomes[names[j]] = runs[i][j];
+        files.push_back(create_run(fs::path(F("run%s.db") % i), outcomes,
+                                   i + 1));
+    }
+
+    const detect_flaky::result result = detect_flaky::drive(
+        files, std::set< engine::test_filter >());
+    ATF_REQUIRE_EQ(4, result.runs);
+    ATF_REQUIRE_EQ(2, result.flaky.size());
+
+    const detect_flaky::test_case_history& first = result.flaky[0];
+    ATF_REQUIRE_EQ(fs::path("dir/prog"), first.test_program);
+    ATF_REQUIRE_EQ("flaky", first.test_case_name);
+    ATF_REQUIRE_EQ(3, first.runs);
+    ATF_REQUIRE_EQ(1, first.failures);
+    ATF_REQUIRE_EQ(2, first.transitions);
+    ATF_REQUIRE_EQ(1.0, first.transition_rate());
+    ATF_REQUIRE_EQ(datetime::delta(2, 333333), first.mean_duration);
+
+    const detect_flaky::test_case_history& second = result.flaky[1];
+    ATF_REQUIRE_EQ("sometimes", second.test_case_name);
+    ATF_REQUIRE_EQ(4, second.runs);
+    ATF_REQUIRE_EQ(2, second.failures);
+    ATF_REQUIRE_EQ(1, second.transitions);
+    ATF_REQUIRE_EQ(datetime::delta(2, 500000), second.mean_duration);
+    ATF_REQUIRE_EQ(datetime::delta(1, 118033), second.duration_stddev);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(filters);
+ATF_TEST_CASE_BODY(filters)
+{
+    std::vector< fs::path > files;
+    for (int i = 0; i < 2; ++i) {
+        std::map< std::string, model::test_result_type > outcomes;
+        outcomes["a"] = i == 0 ? model::test_result_passed :
+            model::test_result_broken;
+        outcomes["b"] = i == 0 ? model::test_result_broken :
+            model::test_result_expected_failure;
+        files.push_back(create_run(fs::path(F("run%s.db") % i), outcomes, 1));
+    }
+
+    std::set< engine::test_filter > filters;
+    filters.insert(engine::test_filter(fs::path("dir/prog"), "b"));
+    filters.insert(engine::test_filter(fs::path("dir/other"), ""));
+
+    const detect_flaky::result result = detect_flaky::drive(files, filters);
+    ATF_REQUIRE_EQ(1, result.flaky.size());
+    ATF_REQUIRE_EQ("b", result.flaky[0].test_case_name);
+
+    std::set< engine::test_filter > exp_unused;
+    exp_unused.insert(engine::test_filter(fs::path("dir/other"), ""));
+    ATF_REQUIRE(exp_unused == result.unused_filters);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(missing_db);
+ATF_TEST_CASE_BODY(missing_db)
+{
+    std::vector< fs::path > files;
+    files.push_back(fs::path("missing.db"));
+    ATF_REQUIRE_THROW(store::error, detect_flaky::drive(
+        files, std::set< engine::test_filter >()));
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, no_runs);
+    ATF_ADD_TEST_CASE(tcs, ranking);
+    ATF_ADD_TEST_CASE(tcs, filters);
+    ATF_ADD_TEST_CASE(tcs, missing_db);
+}
@@ -29,6 +29,7 @@
 #include "drivers/report_junit.hpp"
 
 #include <algorithm>
+#include <istream>
 
 #include "model/context.hpp"
 #include "model/metadata.hpp"
@@ -195,10 +196,14 @@ drivers::report_junit_hooks::got_result(store::results_iterator& iter)
             % text::escape_xml(result.reason());
     }
 
-    const std::string stdout_contents = iter.stdout_contents();
-    if (!stdout_contents.empty()) {
-        _output << F("<system-out>%s</system-out>\n")
-            % text::escape_xml(stdout_contents);
+    {
+        const std::shared_ptr< std::istream > stdout_stream =
+            iter.stdout_stream();
+        if (stdout_stream->peek() != std::istream::traits_type::eof()) {
+            _output << "<system-out>";
+            text::escape_xml(_output, *stdout_stream);
+            _output << "</system-out>\n";
+        }
     }
 
     {
@@ -206,16 +211,20 @@ drivers::report_junit_hooks::got_result(store::results_iterator& iter)
             iter.test_case_name());
         stderr_contents += junit_metadata(test_case.get_metadata());
     }
+    _output << "<system-err>";
+    text::escape_xml(_output, stderr_contents);
     {
-        const std::string real_stderr_contents = iter.stderr_contents();
-        if (real_stderr_contents.empty()) {
-            stderr_contents += "<EMPTY>\n";
+        // The output of the test case can be large, so stream it straight into
+        // the report instead of appending it to the details above first.
+        const std::shared_ptr< std::istream > stderr_stream =
+            iter.stderr_stream();
+        if (stderr_stream->peek() == std::istream::traits_type::eof()) {
+            text::escape_xml(_output, "<EMPTY>\n");
         } else {
-            stderr_contents += real_stderr_contents;
+            text::escape_xml(_output, *stderr_stream);
         }
     }
-    _output << "<system-err>" << text::escape_xml(stderr_contents)
-            << "</system-err>\n";
+    _output << "</system-err>\n";
 
     _output << "</testcase>\n";
 }
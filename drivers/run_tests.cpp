@@ -28,34 +28,45 @@
 
 #include "drivers/run_tests.hpp"
 
+#include <fstream>
+#include <map>
+#include <string>
 #include <utility>
 
 #include "engine/config.hpp"
+#include "engine/exceptions.hpp"
 #include "engine/filters.hpp"
 #include "engine/kyuafile.hpp"
 #include "engine/scanner.hpp"
 #include "engine/scheduler.hpp"
+#include "engine/tap_parser.hpp"
 #include "model/context.hpp"
 #include "model/metadata.hpp"
 #include "model/test_case.hpp"
 #include "model/test_program.hpp"
 #include "model/test_result.hpp"
+#include "store/read_backend.hpp"
+#include "store/read_transaction.hpp"
 #include "store/write_backend.hpp"
 #include "store/write_transaction.hpp"
 #include "utils/config/tree.ipp"
 #include "utils/datetime.hpp"
 #include "utils/defs.hpp"
 #include "utils/format/macros.hpp"
+#include "utils/fs/path.hpp"
 #include "utils/logging/macros.hpp"
 #include "utils/noncopyable.hpp"
 #include "utils/optional.ipp"
 #include "utils/passwd.hpp"
+#include "utils/shared_ptr.hpp"
+#include "utils/text/exceptions.hpp"
 
 namespace config = utils::config;
 namespace datetime = utils::datetime;
 namespace fs = utils::fs;
 namespace passwd = utils::passwd;
 namespace scheduler = engine::scheduler;
+namespace text = utils::text;
 
 using utils::none;
 using utils::optional;
@@ -71,6 +82,16 @@ namespace {
 typedef std::map< fs::path, int64_t > path_to_id_map;
 
 
+/// Minimum time between two commits of the results file during a run.
+///
+/// We periodically commit the results gathered so far so that a run that is
+/// interrupted, or a machine that crashes, does not lose all the work done, and
+/// so that readers can follow the progress of the run.  Committing after every
+/// single test case would be too costly for large test suites, hence the
+/// throttling.
+static const datetime::delta checkpoint_interval(5, 0);
+
+
 /// Map of in-flight PIDs to their corresponding test case IDs.
 typedef std::map< int, int64_t > pid_to_id_map;
 
@@ -79,6 +100,91 @@ typedef std::map< int, int64_t > pid_to_id_map;
 typedef pid_to_id_map::value_type pid_and_id_pair;
 
 
+/// Follows the output of a running TAP test case to report its progress.
+class tap_follower : utils::noncopyable {
+    /// The test program containing the test case.
+    const model::test_program_ptr _test_program;
+
+    /// The name of the test case.
+    const std::string _test_case_name;
+
+    /// Path to the file that captures the stdout of the test case.
+    const fs::path _stdout_file;
+
+    /// Amount of output already fed to the parser.
+    std::streamoff _offset;
+
+    /// Parser of the output of the test case.
+    engine::tap_parser _parser;
+
+    /// Whether the output is unparseable and we gave up following it.
+    bool _broken;
+
+public:
+    /// Constructor.
+    ///
+    /// \param test_program_ The test program containing the test case.
+    /// \param test_case_name_ The name of the test case.
+    /// \param stdout_file_ Path to the file that captures the stdout of the
+    ///     test case.
+    tap_follower(const model::test_program_ptr test_program_,
+                 const std::string& test_case_name_,
+                 const fs::path& stdout_file_) :
+        _test_program(test_program_), _test_case_name(test_case_name_),
+        _stdout_file(stdout_file_), _offset(0), _broken(false)
+    {
+    }
+
+    /// Parses any new output of the test case and reports it.
+    ///
+    /// Errors in the output are only logged: the test case result is computed
+    /// from its complete output once it terminates.
+    ///
+    /// \param hooks The hooks to notify if there are new results.
+    void
+    update(drivers::run_tests::base_hooks& hooks)
+    {
+        if (_broken)
+            return;
+
+        std::ifstream input(_stdout_file.c_str(), std::ios::binary);
+        if (!input)
+            return;
+        input.seekg(_offset);
+
+        const std::size_t old_count = _parser.ok_count() +
+            _parser.not_ok_count();
+        const bool old_bailed_out = _parser.bailed_out();
+
+        char buffer[8192];
+        try {
+            while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0) {
+                _parser.feed(std::string(buffer, input.gcount()));
+                _offset += input.gcount();
+            }
+        } catch (const engine::format_error& e) {
+            LW(F("Cannot follow the progress of %s:%s: %s") %
+               _test_program->relative_path() % _test_case_name % e.what());
+            _broken = true;
+            return;
+        } catch (const text::error& e) {
+            LW(F("Cannot follow the progress of %s:%s: %s") %
+               _test_program->relative_path() % _test_case_name % e.what());
+            _broken = true;
+            return;
+        }
+
+        if (_parser.ok_count() + _parser.not_ok_count() != old_count ||
+            _parser.bailed_out() != old_bailed_out)
+            hooks.got_progress(*_test_program, _test_case_name, _parser);
+    }
+};
+
+
+/// Map of in-flight PIDs to the followers of their output.
+typedef std::map< int, std::shared_ptr< tap_follower > > pid_to_follower_map;
+
+
 /// Puts a test program in the store and returns its identifier.
 ///
 /// This function is idempotent: we maintain a side cache of already-put test
@@ -156,6 +262,8 @@ safe_cleanup(scheduler::test_result_handle handle) throw()
 /// \param [in,out] ids_cache Cache of already-put test cases.
 /// \param user_config The end-user configuration properties.
 /// \param hooks The hooks for this execution.
+/// \param [in,out] followers Followers of the output of in-flight tests.  A
+///     new follower is added if the hooks want progress reports for the test.
 ///
 /// \returns The PID for the started test and the test case's identifier in the
 /// store.
@@ -165,7 +273,8 @@ start_test(scheduler::scheduler_handle& handle,
            store::write_transaction& tx,
            path_to_id_map& ids_cache,
            const config::tree& user_config,
-           drivers::run_tests::base_hooks& hooks)
+           drivers::run_tests::base_hooks& hooks,
+           pid_to_follower_map& followers)
 {
     const model::test_program_ptr& test_program = match.first;
     const std::string& test_case_name = match.second;
@@ -179,10 +288,84 @@ start_test(scheduler::scheduler_handle& handle,
 
     const scheduler::exec_handle exec_handle = handle.spawn_test(
         test_program, test_case_name, user_config);
+
+    if (test_program->interface_name() == "tap" && hooks.progress_interval()) {
+        followers.insert(pid_to_follower_map::value_type(
+            exec_handle, std::shared_ptr< tap_follower >(new tap_follower(
+                test_program, test_case_name,
+                handle.stdout_file(exec_handle)))));
+    }
+
     return std::make_pair(exec_handle, test_case_id);
 }
 
 
+/// Records the result of a test that is skipped without being started.
+///
+/// \param match Test program and test case that were skipped.
+/// \param result The skipped result, as returned by the scheduler's
+///     requirements check.
+/// \param [in,out] tx Writable transaction to put the test results.
+/// \param [in,out] ids_cache Cache of already-put test cases.
+/// \param hooks The hooks for this execution.
+static void
+skip_test(const engine::scan_result& match,
+          const model::test_result& result,
+          store::write_transaction& tx,
+          path_to_id_map& ids_cache,
+          drivers::run_tests::base_hooks& hooks)
+{
+    const model::test_program_ptr& test_program = match.first;
+    const std::string& test_case_name = match.second;
+
+    hooks.got_test_case(*test_program, test_case_name);
+
+    const int64_t test_program_id = find_test_program_id(
+        test_program, tx, ids_cache);
+    const int64_t test_case_id = tx.put_test_case(
+        *test_program, test_case_name, test_program_id);
+
+    const datetime::timestamp now = datetime::timestamp::now();
+    tx.put_result(result, test_case_id, now, now);
+
+    hooks.got_result(*test_program, test_case_name, result,
+                     datetime::delta());
+}
+
+
+/// Waits for the completion of any in-flight test.
+///
+/// If there are tests whose output is being followed, this periodically wakes
+/// up to report their progress.
+///
+/// \param handle Scheduler handle.
+/// \param hooks The hooks for this execution.
+/// \param [in,out] followers Followers of the output of in-flight tests.  The
+///     follower of the completed test, if any, is removed.
+///
+/// \return The completion handle of the test subprocess.
+static scheduler::result_handle_ptr
+wait_test(scheduler::scheduler_handle& handle,
+          drivers::run_tests::base_hooks& hooks,
+          pid_to_follower_map& followers)
+{
+    scheduler::result_handle_ptr result_handle;
+    if (followers.empty()) {
+        result_handle = handle.wait_any();
+    } else {
+        const datetime::delta interval = hooks.progress_interval().get();
+        while ((result_handle = handle.wait_any(interval)).get() == NULL) {
+            for (pid_to_follower_map::const_iterator iter = followers.begin();
+                 iter != followers.end(); ++iter) {
+                (*iter).second->update(hooks);
+            }
+        }
+    }
+    followers.erase(result_handle->original_pid());
+    return result_handle;
+}
+
+
 /// Processes the completion of a test.
 ///
 /// \param [in,out] result_handle The completion handle of the test subprocess.
@@ -212,6 +395,86 @@ finish_test(scheduler::result_handle_ptr result_handle,
 }
 
 
+/// Commits the results gathered so far if enough time has passed.
+///
+/// \param [in,out] db The store backend in which the results are written.
+/// \param [in,out] tx Writable transaction to commit.  Replaced by a new
+///     transaction if a commit happens.
+/// \param [in,out] last_checkpoint Time of the previous commit.  Updated if a
+///     commit happens.
+static void
+maybe_checkpoint(store::write_backend& db, store::write_transaction& tx,
+                 datetime::timestamp& last_checkpoint)
+{
+    const datetime::timestamp now = datetime::timestamp::now();
+    if (now - last_checkpoint < checkpoint_interval)
+        return;
+
+    LD("Checkpointing results file");
+    tx.commit();
+    tx = db.start_write();
+    last_checkpoint = now;
+}
+
+
+/// Opens the results file for the run and sets it up.
+///
+/// \param store_path The path to the store to be used.
+/// \param resume Whether to append to an existing results file from a previous
+///     run or to create a new one.
+/// \param [out] ids_cache Cache of already-put test programs, filled in with
+///     the test programs already in the store when resuming.
+/// \param [out] completed Test cases with a result already in the store.
+///
+/// \return The backend for the results file.
+static store::write_backend
+open_store(const fs::path& store_path, const bool resume,
+           path_to_id_map& ids_cache, store::test_case_ids_set& completed)
+{
+    if (!resume)
+        return store::write_backend::open_rw(store_path);
+
+    {
+        store::read_backend db = store::read_backend::open_ro(store_path);
+        store::read_transaction tx = db.start_read();
+        completed = tx.get_completed_test_cases();
+        ids_cache = tx.get_test_program_ids();
+        tx.finish();
+        db.close();
+    }
+    LI(F("Resuming run in %s; %s test cases already completed") %
+       store_path % completed.size());
+    return store::write_backend::open_append(store_path);
+}
+
+
+/// Loads the test programs to run and prepares a scanner over them.
+///
+/// The Kyuafile is discarded before returning so that the scanner holds the
+/// only references to the test programs.  This allows each test program, and
+/// the list of test cases it loads, to be released as soon as all of its test
+/// cases have been executed instead of at the end of the run.
+///
+/// \param kyuafile_path The path to the Kyuafile to be loaded.
+/// \param build_root If not none, path to the built test programs.
+/// \param filters The test case filters as provided by the user.
+/// \param user_config The end-user configuration properties.
+/// \param handle Scheduler to use to load the test programs.
+///
+/// \return A scanner over the test programs defined in the Kyuafile.
+static engine::scanner
+load_scanner(const fs::path& kyuafile_path,
+             const optional< fs::path > build_root,
+             const std::set< engine::test_filter >& filters,
+             const config::tree& user_config,
+             scheduler::scheduler_handle& handle)
+{
+    const engine::kyuafile kyuafile = engine::kyuafile::load(
+        kyuafile_path, build_root, user_config, handle);
+    return engine::scanner(kyuafile.test_programs(), filters);
+}
+
+
 }  // anonymous namespace
 
 
@@ -221,11 +484,43 @@ drivers::run_tests::base_hooks::~base_hooks(void)
 }
 
 
+/// Called when a running TAP test case reports new results.
+///
+/// The default implementation does nothing.
+///
+/// \param unused_test_program The test program containing the test case.
+/// \param unused_test_case_name The name of the test case being executed.
+/// \param unused_parser The parser of the output of the test case so far.
+void
+drivers::run_tests::base_hooks::got_progress(
+    const model::test_program& UTILS_UNUSED_PARAM(test_program),
+    const std::string& UTILS_UNUSED_PARAM(test_case_name),
+    const engine::tap_parser& UTILS_UNUSED_PARAM(parser))
+{
+}
+
+
+/// Gets the interval at which to report the progress of running test cases.
+///
+/// The default implementation disables progress reports so that waiting for
+/// test cases does not involve periodic wake ups.
+///
+/// \return The interval between progress reports, or none to disable them.
+optional< datetime::delta >
+drivers::run_tests::base_hooks::progress_interval(void) const
+{
+    return none;
+}
+
+
 /// Executes the operation.
 ///
 /// \param kyuafile_path The path to the Kyuafile to be loaded.
 /// \param build_root If not none, path to the built test programs.
 /// \param store_path The path to the store to be used.
+/// \param resume If true, store_path must point to the results file of a
+///     previous run.  New results are appended to it and any test case that
+///     already has a result in it is not executed again.
 /// \param filters The test case filters as provided by the user.
 /// \param user_config The end-user configuration properties.
 /// \param hooks The hooks for this execution.
@@ -235,26 +530,32 @@ drivers::run_tests::result
 drivers::run_tests::drive(const fs::path& kyuafile_path,
                           const optional< fs::path > build_root,
                           const fs::path& store_path,
+                          const bool resume,
                           const std::set< engine::test_filter >& filters,
                           const config::tree& user_config,
                           base_hooks& hooks)
 {
     scheduler::scheduler_handle handle = scheduler::setup();
 
-    const engine::kyuafile kyuafile = engine::kyuafile::load(
-        kyuafile_path, build_root, user_config, handle);
-    store::write_backend db = store::write_backend::open_rw(store_path);
+    engine::scanner scanner = load_scanner(kyuafile_path, build_root, filters,
+                                           user_config, handle);
+
+    path_to_id_map ids_cache;
+    store::test_case_ids_set completed;
+    store::write_backend db = open_store(store_path, resume, ids_cache,
+                                         completed);
     store::write_transaction tx = db.start_write();
 
-    {
+    if (resume) {
+        tx.delete_unfinished_test_cases();
+    } else {
         const model::context context = scheduler::current_context();
         (void)tx.put_context(context);
     }
+    datetime::timestamp last_checkpoint = datetime::timestamp::now();
 
-    engine::scanner scanner(kyuafile.test_programs(), filters);
-
-    path_to_id_map ids_cache;
     pid_to_id_map in_flight;
+    pid_to_follower_map followers;
     std::vector< engine::scan_result > exclusive_tests;
 
     const std::size_t slots = user_config.lookup< config::positive_int_node >(
@@ -273,6 +574,25 @@ drivers::run_tests::drive(const fs::path& kyuafile_path,
             const model::test_program_ptr& test_program = match.get().first;
             const std::string& test_case_name = match.get().second;
 
+            if (completed.find(std::make_pair(
+                    test_program->relative_path(), test_case_name)) !=
+                completed.end()) {
+                LD(F("Skipping already-completed test case %s:%s") %
+                   test_program->relative_path() % test_case_name);
+                continue;
+            }
+
+            // Tests whose requirements are not met are recorded right away
+            // without spawning any subprocess for them.
+            const optional< model::test_result > skipped =
+                handle.check_requirements(test_program, test_case_name,
+                                          user_config);
+            if (skipped) {
+                skip_test(match.get(), skipped.get(), tx, ids_cache, hooks);
+                maybe_checkpoint(db, tx, last_checkpoint);
+                continue;
+            }
+
             const model::test_case& test_case = test_program->find(
                 test_case_name);
             if (test_case.get_metadata().is_exclusive()) {
@@ -282,14 +602,15 @@ drivers::run_tests::drive(const fs::path& kyuafile_path,
             }
 
             in_flight.insert(start_test(handle, match.get(), tx, ids_cache,
-                                        user_config, hooks));
+                                        user_config, hooks, followers));
         }
 
         // If there are any used slots, consume any at random and return the
         // result.  We consume slots one at a time to give preference to the
         // spawning of new tests as detailed above.
         if (!in_flight.empty()) {
-            scheduler::result_handle_ptr result_handle = handle.wait_any();
+            scheduler::result_handle_ptr result_handle = wait_test(
+                handle, hooks, followers);
 
             const pid_to_id_map::iterator iter = in_flight.find(
                 result_handle->original_pid());
@@ -297,6 +618,7 @@ drivers::run_tests::drive(const fs::path& kyuafile_path,
             in_flight.erase(iter);
 
             finish_test(result_handle, test_case_id, tx, hooks);
+            maybe_checkpoint(db, tx, last_checkpoint);
         }
     } while (!in_flight.empty() || !scanner.done());
 
@@ -305,12 +627,15 @@ drivers::run_tests::drive(const fs::path& kyuafile_path,
              iter = exclusive_tests.begin(); iter != exclusive_tests.end();
              ++iter) {
         const pid_and_id_pair data = start_test(
-            handle, *iter, tx, ids_cache, user_config, hooks);
-        scheduler::result_handle_ptr result_handle = handle.wait_any();
+            handle, *iter, tx, ids_cache, user_config, hooks, followers);
+        scheduler::result_handle_ptr result_handle = wait_test(
+            handle, hooks, followers);
         finish_test(result_handle, data.second, tx, hooks);
+        maybe_checkpoint(db, tx, last_checkpoint);
     }
 
     tx.commit();
+    db.close();
 
     handle.cleanup();
 
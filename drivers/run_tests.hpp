@@ -40,6 +40,7 @@
 #include <string>
 
 #include "engine/filters.hpp"
+#include "engine/tap_parser_fwd.hpp"
 #include "model/test_program.hpp"
 #include "model/test_result_fwd.hpp"
 #include "utils/config/tree_fwd.hpp"
@@ -73,6 +74,22 @@ public:
                             const std::string& test_case_name,
                             const model::test_result& result,
                             const utils::datetime::delta& duration) = 0;
+
+    /// Called when a running TAP test case reports new results.
+    ///
+    /// This is only called if progress_interval() returns an interval, at most
+    /// once per interval and test case, and only if the test case has printed
+    /// new results since the previous call.
+    ///
+    /// \param test_program The test program containing the test case.
+    /// \param test_case_name The name of the test case being executed.
+    /// \param parser The parser of the output of the test case so far.
+    virtual void got_progress(const model::test_program& test_program,
+                              const std::string& test_case_name,
+                              const engine::tap_parser& parser);
+
+    virtual utils::optional< utils::datetime::delta > progress_interval(void)
+        const;
 };
 
 
@@ -96,7 +113,8 @@ public:
 
 
 result drive(const utils::fs::path&, const utils::optional< utils::fs::path >,
-             const utils::fs::path&, const std::set< engine::test_filter >&,
+             const utils::fs::path&, const bool,
+             const std::set< engine::test_filter >&,
              const utils::config::tree&, base_hooks&);
 
 
@@ -28,15 +28,159 @@
 
 #include "drivers/scan_results.hpp"
 
+extern "C" {
+#include <time.h>
+}
+
+#include <cerrno>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
 #include "engine/filters.hpp"
 #include "model/context.hpp"
 #include "model/test_case.hpp"
 #include "model/test_program.hpp"
+#include "store/exceptions.hpp"
 #include "store/read_backend.hpp"
 #include "store/read_transaction.hpp"
+#include "utils/datetime.hpp"
 #include "utils/defs.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/logging/macros.hpp"
+#include "utils/logging/operations.hpp"
+#include "utils/optional.ipp"
+#include "utils/sanity.hpp"
+#include "utils/signals/exceptions.hpp"
+#include "utils/signals/interrupts.hpp"
 
+namespace datetime = utils::datetime;
 namespace fs = utils::fs;
+namespace logging = utils::logging;
+namespace signals = utils::signals;
+
+using utils::optional;
+
+
+namespace {
+
+
+/// Converts the user-provided test filters to a store results filter.
+///
+/// \param filters The test filters to convert.
+/// \param types The result types to select.
+///
+/// \return The store filter that selects the same test cases as the input.
+static store::results_filter
+make_results_filter(const std::set< engine::test_filter >& filters,
+                    const std::set< model::test_result_type >& types)
+{
+    store::results_filter results_filter;
+    for (std::set< engine::test_filter >::const_iterator
+             iter = filters.begin(); iter != filters.end(); ++iter) {
+        results_filter.test_cases.insert(std::make_pair(
+            (*iter).test_program, (*iter).test_case));
+    }
+    results_filter.types = types;
+    return results_filter;
+}
+
+
+/// Passes a result to the hooks if it matches the filters.
+///
+/// \param iter The result to process.
+/// \param [in,out] filters The filters to apply, which also track which
+///     filters have been used.
+/// \param hooks The hooks for this execution.
+static void
+process_result(store::results_iterator& iter, engine::filters_state& filters,
+               drivers::scan_results::base_hooks& hooks)
+{
+    // Results may already have been filtered by the database, but we still
+    // have to figure out which filter matched each of them to track the
+    // unused filters.
+    const model::test_program_ptr test_program = iter.test_program();
+    if (filters.match_test_program(test_program->relative_path())) {
+        const model::test_case& test_case = test_program->find(
+            iter.test_case_name());
+        if (filters.match_test_case(test_program->relative_path(),
+                                    test_case.name())) {
+            hooks.got_result(iter);
+        }
+    }
+}
+
+
+/// Passes the results of multiple scans to the hooks as a single stream.
+///
+/// Each scan yields the results of a test program consecutively and sorts the
+/// test programs by their absolute path.  This merges the scans so that the
+/// combined stream keeps these properties: whenever a test program is
+/// exhausted, the next one is taken from the scan with the smallest path,
+/// breaking ties by the position of the scan in the input.  Selecting a scan
+/// is thus only done once per test program, not once per result.
+///
+/// \param [in,out] iters The scans to merge.
+/// \param [in,out] filters The filters to apply, which also track which
+///     filters have been used.
+/// \param hooks The hooks for this execution.
+static void
+merge_results(std::vector< store::results_iterator >& iters,
+              engine::filters_state& filters,
+              drivers::scan_results::base_hooks& hooks)
+{
+    optional< std::size_t > current;
+    for (;;) {
+        std::vector< store::results_iterator >::iterator next = iters.end();
+        for (std::vector< store::results_iterator >::iterator
+                 iter = iters.begin(); iter != iters.end(); ++iter) {
+            if (!*iter)
+                continue;
+            if (next == iters.end() ||
+                (*iter).test_program()->absolute_path() <
+                (*next).test_program()->absolute_path())
+                next = iter;
+        }
+        if (next == iters.end())
+            break;
+
+        const std::size_t index = next - iters.begin();
+        if (!current || current.get() != index) {
+            hooks.got_results_file(index);
+            current = index;
+        }
+
+        const model::test_program_ptr test_program = (*next).test_program();
+        do {
+            process_result(*next, filters, hooks);
+            ++(*next);
+        } while (*next && (*next).test_program() == test_program);
+    }
+}
+
+
+/// Sleeps for a period of time unless interrupted.
+///
+/// \param delta The time to sleep for.
+///
+/// \throw signals::interrupted_error If a signal arrives while sleeping.
+static void
+interruptible_sleep(const datetime::delta& delta)
+{
+    signals::check_interrupt();
+    logging::flush();
+    // usleep(3) need not support periods of one second or longer.
+    struct ::timespec remaining;
+    remaining.tv_sec = static_cast< ::time_t >(delta.seconds);
+    remaining.tv_nsec = static_cast< long >(delta.useconds) * 1000;
+    while (::nanosleep(&remaining, &remaining) == -1 && errno == EINTR)
+        signals::check_interrupt();
+    signals::check_interrupt();
+}
+
+
+}  // anonymous namespace
 
 
 /// Pure abstract destructor.
@@ -52,6 +196,35 @@ drivers::scan_results::base_hooks::begin(void)
 }
 
 
+/// Callback executed when the summary of the results is computed.
+///
+/// This is only invoked when the results passed to the hooks are restricted to
+/// some types, and happens before any result is passed to the hooks.
+///
+/// \param unused_summary Aggregated information about all the results that
+///     match the test filters, regardless of their type.
+void
+drivers::scan_results::base_hooks::got_summary(
+    const store::results_summary& UTILS_UNUSED_PARAM(summary))
+{
+}
+
+
+/// Callback executed when the next results come from a different file.
+///
+/// This allows hooks to locate the results in their files later on, e.g. to
+/// process them in a different process.  It is invoked before the first result
+/// is passed to the hooks and whenever the results file changes.
+///
+/// \param unused_index The position of the results file in the list of files
+///     given to the driver.
+void
+drivers::scan_results::base_hooks::got_results_file(
+    const std::size_t UTILS_UNUSED_PARAM(index))
+{
+}
+
+
 /// Callback executed after all operations are performed.
 ///
 /// \param unused_r A structure with all results computed by this driver.  Note
@@ -74,34 +247,230 @@ drivers::scan_results::drive(const fs::path& store_path,
                              const std::set< engine::test_filter >& raw_filters,
                              base_hooks& hooks)
 {
+    return drive(store_path, raw_filters, std::set< model::test_result_type >(),
+                 hooks);
+}
+
+
+/// Executes the operation, only reporting results of some types.
+///
+/// The selection of test cases and result types is delegated to the database,
+/// so the cost of the scan is proportional to the number of matching results.
+///
+/// \param store_path The path to the database store.
+/// \param raw_filters The test case filters as provided by the user.
+/// \param types The types of the results to pass to the hooks.  If empty, all
+///     results are passed to the hooks.  Otherwise, the hooks also receive a
+///     summary of all the results.
+/// \param hooks The hooks for this execution.
+///
+/// \returns A structure with all results computed by this driver.
+drivers::scan_results::result
+drivers::scan_results::drive(const fs::path& store_path,
+                             const std::set< engine::test_filter >& raw_filters,
+                             const std::set< model::test_result_type >& types,
+                             base_hooks& hooks)
+{
+    return drive(std::vector< fs::path >(1, store_path), raw_filters, types,
+                 hooks);
+}
+
+
+/// Executes the operation on multiple results files as if they were one.
+///
+/// This is intended to report on a test suite run that was split in shards,
+/// each of which recorded its results in a separate file.  All the files are
+/// scanned at once and their results are merged into a single stream that
+/// follows the same order as the scan of a single file, so the hooks cannot
+/// tell the difference, except for the got_results_file() callback.  Only the
+/// context of the first file is passed to the hooks, and the summary covers
+/// the results of all files.
+///
+/// The files are scanned side by side within this process.  Other than the
+/// hooks themselves, the cost of a scan lies in building the test programs
+/// that the hooks receive, and that has to happen in the process that runs
+/// the hooks anyway.
+///
+/// \param store_paths The paths to the database stores.  Must not be empty.
+/// \param raw_filters The test case filters as provided by the user.
+/// \param types The types of the results to pass to the hooks.  If empty, all
+///     results are passed to the hooks.  Otherwise, the hooks also receive a
+///     summary of all the results.
+/// \param hooks The hooks for this execution.
+///
+/// \returns A structure with all results computed by this driver.
+drivers::scan_results::result
+drivers::scan_results::drive(const std::vector< fs::path >& store_paths,
+                             const std::set< engine::test_filter >& raw_filters,
+                             const std::set< model::test_result_type >& types,
+                             base_hooks& hooks)
+{
+    PRE(!store_paths.empty());
+
     engine::filters_state filters(raw_filters);
 
-    store::read_backend db = store::read_backend::open_ro(store_path);
-    store::read_transaction tx = db.start_read();
+    // Open all the files upfront so that any of them being invalid is
+    // detected before the hooks are invoked.  The transactions refer to
+    // their backends, so the latter must not move once created.
+    std::vector< store::read_backend > dbs;
+    dbs.reserve(store_paths.size());
+    std::vector< store::read_transaction > txs;
+    for (std::vector< fs::path >::const_iterator iter = store_paths.begin();
+         iter != store_paths.end(); ++iter) {
+        dbs.push_back(store::read_backend::open_ro(*iter));
+        txs.push_back(dbs.back().start_read());
+    }
 
     hooks.begin();
 
-    const model::context context = tx.get_context();
+    const model::context context = txs[0].get_context();
     hooks.got_context(context);
 
-    store::results_iterator iter = tx.get_results();
-    while (iter) {
-        // TODO(jmmv): We should be filtering at the test case level for
-        // efficiency, but that means we would need to execute more than one
-        // query on the database and our current interfaces don't support that.
-        //
-        // Reuse engine::filters_state for the time being because it is simpler
-        // and we get tracking of unmatched filters "for free".
-        const model::test_program_ptr test_program = iter.test_program();
-        if (filters.match_test_program(test_program->relative_path())) {
-            const model::test_case& test_case = test_program->find(
-                iter.test_case_name());
-            if (filters.match_test_case(test_program->relative_path(),
-                                        test_case.name())) {
-                hooks.got_result(iter);
+    if (!types.empty()) {
+        const store::results_filter all_types = make_results_filter(
+            raw_filters, std::set< model::test_result_type >());
+        store::results_summary summary;
+        for (std::vector< store::read_transaction >::iterator
+                 iter = txs.begin(); iter != txs.end(); ++iter) {
+            const store::results_summary partial =
+                (*iter).get_results_summary(all_types);
+            for (std::map< model::test_result_type, std::size_t >::
+                     const_iterator iter2 = partial.counts.begin();
+                 iter2 != partial.counts.end(); ++iter2)
+                summary.counts[(*iter2).first] += (*iter2).second;
+            summary.duration += partial.duration;
+        }
+        hooks.got_summary(summary);
+    }
+
+    std::vector< store::results_iterator > iters;
+    for (std::vector< store::read_transaction >::iterator iter = txs.begin();
+         iter != txs.end(); ++iter)
+        iters.push_back((*iter).get_results(make_results_filter(raw_filters,
+                                                                types)));
+    merge_results(iters, filters, hooks);
+
+    if (!types.empty()) {
+        // Filters that only match results of other types have not been seen
+        // yet.  Look for them among the results they match, which is cheap
+        // because filters are usually disjoint and thus the first result
+        // suffices.
+        const std::set< engine::test_filter > unused = filters.unused();
+        for (std::set< engine::test_filter >::const_iterator
+                 iter2 = unused.begin(); iter2 != unused.end(); ++iter2) {
+            std::set< engine::test_filter > one_filter;
+            one_filter.insert(*iter2);
+            for (std::vector< store::read_transaction >::iterator
+                     tx = txs.begin(); tx != txs.end() &&
+                     filters.unused().count(*iter2) > 0; ++tx) {
+                store::results_iterator iter3 = (*tx).get_results(
+                    make_results_filter(
+                        one_filter, std::set< model::test_result_type >()));
+                while (iter3 && filters.unused().count(*iter2) > 0) {
+                    (void)filters.match_test_case(
+                        iter3.test_program()->relative_path(),
+                        iter3.test_case_name());
+                    ++iter3;
+                }
+            }
+        }
+    }
+
+    result r(filters.unused());
+    hooks.end(r);
+    return r;
+}
+
+
+/// Executes the operation on a results file that may still be written to.
+///
+/// Results are passed to the hooks as soon as they are committed to the file
+/// by the run that is writing to it.  Results committed together are passed in
+/// the order in which their test cases were started.  The scan terminates once
+/// the run finishes or when the user interrupts it.
+///
+/// \param store_path The path to the database store.
+/// \param raw_filters The test case filters as provided by the user.
+/// \param poll_interval Time to wait between checks for new results.
+/// \param hooks The hooks for this execution.
+///
+/// \returns A structure with all results computed by this driver.
+drivers::scan_results::result
+drivers::scan_results::follow(
+    const fs::path& store_path,
+    const std::set< engine::test_filter >& raw_filters,
+    const datetime::delta& poll_interval,
+    base_hooks& hooks)
+{
+    engine::filters_state filters(raw_filters);
+
+    hooks.begin();
+
+    // Results for all test cases below this identifier have been processed,
+    // except for those in pending.
+    int64_t next_id = 0;
+    // Identifiers below next_id of the test cases that were still running the
+    // last time we looked.  Bounded by the number of test cases that run
+    // concurrently, so each poll only costs as much as the new results.
+    std::set< int64_t > pending;
+    bool got_context = false;
+
+    try {
+        signals::interrupts_handler interrupts;
+
+        for (;;) {
+            // Connections are kept short-lived on purpose: the writer needs
+            // exclusive access to the database to mark it as complete.
+            store::read_backend db = store::read_backend::open_ro(store_path);
+            const bool live = db.is_live();
+            store::read_transaction tx = db.start_read();
+
+            if (!got_context) {
+                try {
+                    hooks.got_context(tx.get_context());
+                    hooks.got_results_file(0);
+                    got_context = true;
+                } catch (const store::error& e) {
+                    if (!live)
+                        throw;
+                    LD(F("Context not available yet: %s") % e.what());
+                }
             }
+
+            if (got_context) {
+                if (!pending.empty()) {
+                    store::results_iterator iter = tx.get_results_of(pending);
+                    while (iter) {
+                        pending.erase(iter.test_case_id());
+                        process_result(iter, filters, hooks);
+                        ++iter;
+                    }
+                }
+
+                optional< int64_t > last_id;
+                store::results_iterator iter = tx.get_results_since(next_id);
+                while (iter) {
+                    last_id = iter.test_case_id();
+                    process_result(iter, filters, hooks);
+                    ++iter;
+                }
+                if (last_id) {
+                    const std::set< int64_t > unfinished =
+                        tx.get_unfinished_test_cases(next_id, last_id.get());
+                    pending.insert(unfinished.begin(), unfinished.end());
+                    next_id = last_id.get() + 1;
+                }
+            }
+
+            tx.finish();
+            db.close();
+
+            if (!live)
+                break;
+            interruptible_sleep(poll_interval);
         }
-        ++iter;
+    } catch (const signals::interrupted_error& e) {
+        LI(F("Stopped following %s: %s") % store_path % e.what());
     }
 
     result r(filters.unused());
@@ -41,10 +41,13 @@ extern "C" {
 #include <stdint.h>
 }
 
+#include <cstddef>
 #include <set>
+#include <vector>
 
 #include "engine/filters.hpp"
 #include "model/context_fwd.hpp"
+#include "model/test_result_fwd.hpp"
 #include "store/read_transaction_fwd.hpp"
 #include "utils/datetime_fwd.hpp"
 #include "utils/fs/path_fwd.hpp"
@@ -84,6 +87,9 @@ public:
     /// \param context The context loaded from the database.
     virtual void got_context(const model::context& context) = 0;
 
+    virtual void got_summary(const store::results_summary& summary);
+    virtual void got_results_file(const std::size_t index);
+
     /// Callback executed when a test results is found.
     ///
     /// \param iter Container for the test result's data.  Some of the data are
@@ -97,6 +103,13 @@ public:
 
 result drive(const utils::fs::path&, const std::set< engine::test_filter >&,
              base_hooks&);
+result drive(const utils::fs::path&, const std::set< engine::test_filter >&,
+             const std::set< model::test_result_type >&, base_hooks&);
+result drive(const std::vector< utils::fs::path >&,
+             const std::set< engine::test_filter >&,
+             const std::set< model::test_result_type >&, base_hooks&);
+result follow(const utils::fs::path&, const std::set< engine::test_filter >&,
+              const utils::datetime::delta&, base_hooks&);
 
 
 }  // namespace scan_results
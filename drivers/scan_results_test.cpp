@@ -28,7 +28,17 @@
 
 #include "drivers/scan_results.hpp"
 
+extern "C" {
+#include <sys/wait.h>
+
+#include <unistd.h>
+}
+
+#include <cstdlib>
+#include <map>
 #include <set>
+#include <string>
+#include <vector>
 
 #include <atf-c++.hpp>
 
@@ -70,9 +80,21 @@ public:
     /// The captured context, if any.
     optional< model::context > _context;
 
+    /// The captured summary, if any.
+    optional< store::results_summary > _summary;
+
     /// The captured results, flattened as "program:test_case:result".
     std::set< std::string > _results;
 
+    /// The test programs of the captured results, in the order received.
+    std::vector< fs::path > _programs;
+
+    /// The results file reported by the last call to got_results_file().
+    optional< std::size_t > _file;
+
+    /// The results files of the captured results, in the order received.
+    std::vector< std::size_t > _files;
+
     /// Constructor.
     capture_hooks(void) :
         _begin_called(false)
@@ -106,6 +128,25 @@ public:
         _context = context;
     }
 
+    /// Callback executed when the summary of the results is computed.
+    ///
+    /// \param summary Aggregated information about the results.
+    void got_summary(const store::results_summary& summary)
+    {
+        PRE(!_summary);
+        PRE(_results.empty());
+        _summary = summary;
+    }
+
+    /// Callback executed when the next results come from a different file.
+    ///
+    /// \param index The position of the results file.
+    void got_results_file(const std::size_t index)
+    {
+        PRE(!_file || _file.get() != index);
+        _file = index;
+    }
+
     /// Callback executed when a test results is found.
     ///
     /// \param iter Container for the test result's data.
@@ -122,6 +163,8 @@ public:
                         iter.test_program()->absolute_path() %
                         iter.test_case_name() % type % iter.result().reason() %
                         iter.duration().seconds % iter.duration().useconds);
+        _programs.push_back(iter.test_program()->absolute_path());
+        _files.push_back(_file.get());
     }
 };
 
@@ -237,6 +280,141 @@ ATF_TEST_CASE_BODY(ok__filters)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(ok__types);
+ATF_TEST_CASE_BODY(ok__types)
+{
+    populate_results_file("test.db", 3);
+
+    std::set< engine::test_filter > filters;
+    filters.insert(engine::test_filter(fs::path("dir/prog_1"), ""));
+    filters.insert(engine::test_filter(fs::path("dir/prog_2"), "case_1"));
+    filters.insert(engine::test_filter(fs::path("dir/prog_3"), ""));
+
+    std::set< model::test_result_type > types;
+    types.insert(model::test_result_passed);
+
+    capture_hooks hooks;
+    const drivers::scan_results::result result = drivers::scan_results::drive(
+        fs::path("test.db"), filters, types, hooks);
+    ATF_REQUIRE(hooks._begin_called);
+    ATF_REQUIRE(hooks._end_result);
+
+    // Filters that only match results of other types are still used.
+    std::set< engine::test_filter > unused_filters;
+    unused_filters.insert(engine::test_filter(fs::path("dir/prog_3"), ""));
+    ATF_REQUIRE_EQ(unused_filters, result.unused_filters);
+
+    ATF_REQUIRE(hooks._results.empty());
+    ATF_REQUIRE(hooks._summary);
+    const store::results_summary& summary = hooks._summary.get();
+    ATF_REQUIRE_EQ(1, summary.counts.size());
+    ATF_REQUIRE_EQ(4, summary.counts.find(model::test_result_skipped)->second);
+    ATF_REQUIRE_EQ(datetime::delta(16, 49), summary.duration);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(ok__many_files);
+ATF_TEST_CASE_BODY(ok__many_files)
+{
+    populate_results_file("test1.db", 2);
+    populate_results_file("test2.db", 3);
+
+    std::vector< fs::path > files;
+    files.push_back(fs::path("test1.db"));
+    files.push_back(fs::path("test2.db"));
+
+    std::set< engine::test_filter > filters;
+    filters.insert(engine::test_filter(fs::path("dir/prog_2"), "case_1"));
+    filters.insert(engine::test_filter(fs::path("dir/prog_0"), ""));
+
+    capture_hooks hooks;
+    const drivers::scan_results::result result = drivers::scan_results::drive(
+        files, filters, std::set< model::test_result_type >(), hooks);
+    ATF_REQUIRE(result.unused_filters.empty());
+    ATF_REQUIRE(hooks._begin_called);
+    ATF_REQUIRE(hooks._end_result);
+    ATF_REQUIRE(!hooks._summary);
+
+    // Only the context of the first file is reported.
+    std::map< std::string, std::string > env;
+    env["VAR0"] = "Value 0";
+    env["VAR1"] = "Value 1";
+    const model::context context(fs::path("/root"), env);
+    ATF_REQUIRE(context == hooks._context.get());
+
+    std::set< std::string > results;
+    results.insert("/root/dir/prog_0:case_0:skipped:Count 0:4:10");
+    results.insert("/root/dir/prog_0:case_1:skipped:Count 1:4:11");
+    results.insert("/root/dir/prog_0:case_2:skipped:Count 2:4:12");
+    results.insert("/root/dir/prog_2:case_1:skipped:Count 1:4:13");
+    ATF_REQUIRE_EQ(results, hooks._results);
+
+    // The results of both files are merged in test program order.
+    std::vector< fs::path > programs;
+    programs.push_back(fs::path("/root/dir/prog_0"));
+    programs.push_back(fs::path("/root/dir/prog_0"));
+    programs.push_back(fs::path("/root/dir/prog_0"));
+    programs.push_back(fs::path("/root/dir/prog_0"));
+    programs.push_back(fs::path("/root/dir/prog_0"));
+    programs.push_back(fs::path("/root/dir/prog_2"));
+    ATF_REQUIRE(programs == hooks._programs);
+
+    std::vector< std::size_t > files_of_results;
+    files_of_results.push_back(0);
+    files_of_results.push_back(0);
+    files_of_results.push_back(1);
+    files_of_results.push_back(1);
+    files_of_results.push_back(1);
+    files_of_results.push_back(1);
+    ATF_REQUIRE(files_of_results == hooks._files);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(ok__many_files__types);
+ATF_TEST_CASE_BODY(ok__many_files__types)
+{
+    populate_results_file("test1.db", 2);
+    populate_results_file("test2.db", 3);
+
+    std::vector< fs::path > files;
+    files.push_back(fs::path("test1.db"));
+    files.push_back(fs::path("test2.db"));
+
+    std::set< model::test_result_type > types;
+    types.insert(model::test_result_passed);
+
+    capture_hooks hooks;
+    (void)drivers::scan_results::drive(
+        files, std::set< engine::test_filter >(), types, hooks);
+
+    ATF_REQUIRE(hooks._results.empty());
+    ATF_REQUIRE(hooks._summary);
+    const store::results_summary& summary = hooks._summary.get();
+    ATF_REQUIRE_EQ(1, summary.counts.size());
+    ATF_REQUIRE_EQ(13,
+                   summary.counts.find(model::test_result_skipped)->second);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(missing_db__many_files);
+ATF_TEST_CASE_BODY(missing_db__many_files)
+{
+    populate_results_file("test1.db", 2);
+
+    std::vector< fs::path > files;
+    files.push_back(fs::path("test1.db"));
+    files.push_back(fs::path("test2.db"));
+
+    capture_hooks hooks;
+    ATF_REQUIRE_THROW(
+        store::error,
+        drivers::scan_results::drive(files, std::set< engine::test_filter >(),
+                                     std::set< model::test_result_type >(),
+                                     hooks));
+    ATF_REQUIRE(!hooks._begin_called);
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(missing_db);
 ATF_TEST_CASE_BODY(missing_db)
 {
@@ -249,9 +427,134 @@ ATF_TEST_CASE_BODY(missing_db)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(follow__completed);
+ATF_TEST_CASE_BODY(follow__completed)
+{
+    populate_results_file("test.db", 2);
+
+    std::set< engine::test_filter > filters;
+    filters.insert(engine::test_filter(fs::path("dir/prog_1"), ""));
+    filters.insert(engine::test_filter(fs::path("dir/prog_3"), ""));
+
+    capture_hooks hooks;
+    const drivers::scan_results::result result =
+        drivers::scan_results::follow(fs::path("test.db"), filters,
+                                      datetime::delta(0, 1), hooks);
+    ATF_REQUIRE(hooks._begin_called);
+    ATF_REQUIRE(hooks._end_result);
+    ATF_REQUIRE(hooks._context);
+
+    std::set< engine::test_filter > unused_filters;
+    unused_filters.insert(engine::test_filter(fs::path("dir/prog_3"), ""));
+    ATF_REQUIRE_EQ(unused_filters, result.unused_filters);
+
+    std::set< std::string > results;
+    results.insert("/root/dir/prog_1:case_0:skipped:Count 0:4:11");
+    results.insert("/root/dir/prog_1:case_1:skipped:Count 1:4:12");
+    ATF_REQUIRE_EQ(results, hooks._results);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(follow__out_of_order);
+ATF_TEST_CASE_BODY(follow__out_of_order)
+{
+    int fds[2];
+    ATF_REQUIRE(::pipe(fds) != -1);
+
+    const pid_t pid = ::fork();
+    ATF_REQUIRE(pid != -1);
+    if (pid == 0) {
+        ::close(fds[0]);
+        store::write_backend backend = store::write_backend::open_rw(
+            fs::path("test.db"));
+
+        const model::test_program test_program = model::test_program_builder(
+            "fake", fs::path("dir/prog"), fs::path("/root"), "suite")
+            .add_test_case("case_0").add_test_case("case_1")
+            .add_test_case("case_2").build();
+        const datetime::timestamp start =
+            datetime::timestamp::from_microseconds(1000000);
+        const datetime::timestamp end =
+            datetime::timestamp::from_microseconds(2000000);
+
+        store::write_transaction tx = backend.start_write();
+        tx.put_context(model::context(fs::path("/root"),
+                                      std::map< std::string, std::string >()));
+        const int64_t tp_id = tx.put_test_program(test_program);
+        const int64_t tc0_id = tx.put_test_case(test_program, "case_0", tp_id);
+        const int64_t tc1_id = tx.put_test_case(test_program, "case_1", tp_id);
+        tx.put_result(model::test_result(model::test_result_passed),
+                      tc1_id, start, end);
+        tx.commit();
+
+        // Let the reader see case_0 still running before case_2 starts.
+        if (::write(fds[1], "x", 1) != 1)
+            std::abort();
+        ::close(fds[1]);
+        ::usleep(200000);
+
+        store::write_transaction tx2 = backend.start_write();
+        const int64_t tc2_id = tx2.put_test_case(test_program, "case_2", tp_id);
+        tx2.put_result(model::test_result(model::test_result_passed),
+                       tc2_id, start, end);
+        tx2.commit();
+        ::usleep(200000);
+
+        store::write_transaction tx3 = backend.start_write();
+        tx3.put_result(model::test_result(model::test_result_skipped, "Late"),
+                       tc0_id, start, end);
+        tx3.commit();
+        ::usleep(200000);
+
+        backend.close();
+        std::exit(EXIT_SUCCESS);
+    }
+    ::close(fds[1]);
+    char ready;
+    ATF_REQUIRE_EQ(1, ::read(fds[0], &ready, 1));
+    ::close(fds[0]);
+
+    capture_hooks hooks;
+    drivers::scan_results::follow(fs::path("test.db"),
+                                  std::set< engine::test_filter >(),
+                                  datetime::delta(0, 10000), hooks);
+
+    int status;
+    ATF_REQUIRE(::waitpid(pid, &status, 0) != -1);
+    ATF_REQUIRE(WIFEXITED(status));
+    ATF_REQUIRE_EQ(EXIT_SUCCESS, WEXITSTATUS(status));
+
+    std::set< std::string > results;
+    results.insert("/root/dir/prog:case_0:skipped:Late:1:0");
+    results.insert("/root/dir/prog:case_1:passed::1:0");
+    results.insert("/root/dir/prog:case_2:passed::1:0");
+    ATF_REQUIRE_EQ(results, hooks._results);
+    ATF_REQUIRE_EQ(3, hooks._programs.size());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(follow__missing_db);
+ATF_TEST_CASE_BODY(follow__missing_db)
+{
+    capture_hooks hooks;
+    ATF_REQUIRE_THROW(
+        store::error,
+        drivers::scan_results::follow(fs::path("test.db"),
+                                      std::set< engine::test_filter >(),
+                                      datetime::delta(0, 1), hooks));
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, ok__all);
     ATF_ADD_TEST_CASE(tcs, ok__filters);
+    ATF_ADD_TEST_CASE(tcs, ok__types);
+    ATF_ADD_TEST_CASE(tcs, ok__many_files);
+    ATF_ADD_TEST_CASE(tcs, ok__many_files__types);
     ATF_ADD_TEST_CASE(tcs, missing_db);
+    ATF_ADD_TEST_CASE(tcs, missing_db__many_files);
+    ATF_ADD_TEST_CASE(tcs, follow__completed);
+    ATF_ADD_TEST_CASE(tcs, follow__out_of_order);
+    ATF_ADD_TEST_CASE(tcs, follow__missing_db);
 }
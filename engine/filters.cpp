@@ -232,6 +232,35 @@ engine::operator<<(std::ostream& output, const test_filter& object)
 engine::test_filters::test_filters(const std::set< test_filter >& filters_) :
     _filters(filters_)
 {
+    for (std::set< test_filter >::const_iterator iter = _filters.begin();
+         iter != _filters.end(); ++iter) {
+        _index[(*iter).test_program].insert((*iter).test_case);
+    }
+}
+
+
+/// Looks for a filter that selects all test cases within a path.
+///
+/// \param name The test program to look for.
+///
+/// \return The path of the filter that selects all test cases of the test
+/// program, either because it names the test program itself or one of its
+/// parent directories.  If more than one filter qualifies, the one with the
+/// shortest path is returned, which is the one that sorts first.
+optional< fs::path >
+engine::test_filters::find_parent_filter(const fs::path& name) const
+{
+    // Mimics the behavior of fs::path::is_parent_of() when walking up the path
+    // so that the results are the same as those of test_filter.
+    optional< fs::path > found = none;
+    fs::path current = name;
+    do {
+        const index_map::const_iterator iter = _index.find(current);
+        if (iter != _index.end() && (*iter).second.count("") > 0)
+            found = current;
+        current = current.branch_path();
+    } while (current != fs::path(".") && current != fs::path("/"));
+    return found;
 }
 
 
@@ -252,12 +281,9 @@ engine::test_filters::match_test_program(const fs::path& name) const
     if (_filters.empty())
         return true;
 
-    bool matches = false;
-    for (std::set< test_filter >::const_iterator iter = _filters.begin();
-         !matches && iter != _filters.end(); iter++) {
-        matches = (*iter).matches_test_program(name);
-    }
-    return matches;
+    if (_index.find(name) != _index.end())
+        return true;
+    return static_cast< bool >(find_parent_filter(name));
 }
 
 
@@ -279,11 +305,15 @@ engine::test_filters::match_test_case(const fs::path& test_program,
     }
 
     optional< test_filter > found = none;
-    for (std::set< test_filter >::const_iterator iter = _filters.begin();
-         !found && iter != _filters.end(); iter++) {
-        if ((*iter).matches_test_case(test_program, test_case))
-            found = *iter;
+    const optional< fs::path > parent = find_parent_filter(test_program);
+    if (parent) {
+        found = test_filter(parent.get(), "");
+    } else {
+        const index_map::const_iterator iter = _index.find(test_program);
+        if (iter != _index.end() && (*iter).second.count(test_case) > 0)
+            found = test_filter(test_program, test_case);
     }
+    INV(!found || found.get().matches_test_case(test_program, test_case));
     INV(!found || match_test_program(test_program));
     return match(static_cast< bool >(found), found);
 }
@@ -317,23 +347,28 @@ engine::test_filters::difference(const std::set< test_filter >& matched) const
 void
 engine::check_disjoint_filters(const std::set< engine::test_filter >& filters)
 {
-    // Yes, this is an O(n^2) algorithm.  However, we can assume that the number
-    // of test filters (which are provided by the user on the command line) on a
-    // particular run is in the order of tens, and thus this should not cause
-    // any serious performance trouble.
-    for (std::set< test_filter >::const_iterator i1 = filters.begin();
-         i1 != filters.end(); i1++) {
-        for (std::set< test_filter >::const_iterator i2 = filters.begin();
-             i2 != filters.end(); i2++) {
-            const test_filter& filter1 = *i1;
-            const test_filter& filter2 = *i2;
-
-            if (i1 != i2 && filter1.contains(filter2)) {
+    // Filters may be read from files and thus be in the order of tens of
+    // thousands.  Instead of comparing every pair of filters, look up the only
+    // filters that can contain each filter: those that select all the test
+    // cases of the filter's path or of any of its parent directories.
+    for (std::set< test_filter >::const_iterator iter = filters.begin();
+         iter != filters.end(); iter++) {
+        const test_filter& filter = *iter;
+
+        // A filter that selects a whole path does not contain itself.
+        bool check = !filter.test_case.empty();
+        fs::path current = filter.test_program;
+        do {
+            const test_filter container(current, "");
+            if (check && filters.find(container) != filters.end()) {
+                INV(container.contains(filter));
                 throw std::runtime_error(
                     F("Filters '%s' and '%s' are not disjoint") %
-                    filter1.str() % filter2.str());
+                    container.str() % filter.str());
             }
-        }
+            check = true;
+            current = current.branch_path();
+        } while (current != fs::path(".") && current != fs::path("/"));
     }
 }
 
@@ -38,6 +38,7 @@
 
 #include "engine/filters_fwd.hpp"
 
+#include <map>
 #include <ostream>
 #include <string>
 #include <set>
@@ -93,6 +94,20 @@ class test_filters {
     /// The user-provided filters.
     std::set< test_filter > _filters;
 
+    /// Index of the filters by test program or subdirectory.
+    ///
+    /// Maps the path of every filter to the names of the test cases it selects
+    /// in that path, where an empty name selects all of them.  This allows
+    /// matching a test program with one lookup per component of its path,
+    /// regardless of the number of filters.
+    typedef std::map< utils::fs::path, std::set< std::string > > index_map;
+
+    /// The user-provided filters, indexed by their paths.
+    index_map _index;
+
+    utils::optional< utils::fs::path > find_parent_filter(
+        const utils::fs::path&) const;
+
 public:
     explicit test_filters(const std::set< test_filter >&);
 
@@ -32,8 +32,13 @@
 
 #include <atf-c++.hpp>
 
+#include "utils/format/macros.hpp"
+#include "utils/optional.ipp"
+
 namespace fs = utils::fs;
 
+using utils::optional;
+
 
 namespace {
 
@@ -377,6 +382,75 @@ ATF_TEST_CASE_BODY(test_filters__match_test_case__some_filters)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(test_filters__match_test_case__nested_filters)
+ATF_TEST_CASE_BODY(test_filters__match_test_case__nested_filters)
+{
+    std::set< engine::test_filter > raw_filters;
+    raw_filters.insert(mkfilter("a/b/c", ""));
+    raw_filters.insert(mkfilter("a/b", ""));
+    raw_filters.insert(mkfilter("a/b/c", "foo"));
+    raw_filters.insert(mkfilter("x/y", "foo"));
+
+    const engine::test_filters filters(raw_filters);
+    engine::test_filters::match match;
+
+    match = filters.match_test_case(fs::path("a/b/c"), "foo");
+    ATF_REQUIRE(match.first);
+    ATF_REQUIRE_EQ("a/b", match.second.get().str());
+
+    match = filters.match_test_case(fs::path("x/y"), "foo");
+    ATF_REQUIRE(match.first);
+    ATF_REQUIRE_EQ("x/y:foo", match.second.get().str());
+
+    match = filters.match_test_case(fs::path("x/y/z"), "foo");
+    ATF_REQUIRE(!match.first);
+    match = filters.match_test_case(fs::path("a"), "foo");
+    ATF_REQUIRE(!match.first);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(test_filters__match_test_case__many_filters)
+ATF_TEST_CASE_BODY(test_filters__match_test_case__many_filters)
+{
+    std::set< engine::test_filter > raw_filters;
+    for (int i = 0; i < 1000; ++i) {
+        raw_filters.insert(engine::test_filter(
+            fs::path(F("dir%s/prog%s") % (i % 10) % i), F("case%s") % (i % 7)));
+        if (i % 100 == 0)
+            raw_filters.insert(engine::test_filter(
+                fs::path(F("other/dir%s") % i), ""));
+    }
+
+    const engine::test_filters filters(raw_filters);
+    for (int i = 0; i < 1100; i += 3) {
+        const fs::path programs[] = {
+            fs::path(F("dir%s/prog%s") % (i % 10) % i),
+            fs::path(F("other/dir%s/prog") % i),
+        };
+        for (std::size_t j = 0; j < 2; ++j) {
+            const std::string test_case = F("case%s") % (i % 5);
+
+            optional< engine::test_filter > exp_filter;
+            bool exp_program = false;
+            for (std::set< engine::test_filter >::const_iterator iter =
+                     raw_filters.begin(); iter != raw_filters.end(); ++iter) {
+                exp_program |= (*iter).matches_test_program(programs[j]);
+                if (!exp_filter &&
+                    (*iter).matches_test_case(programs[j], test_case))
+                    exp_filter = *iter;
+            }
+
+            ATF_REQUIRE_EQ(exp_program,
+                           filters.match_test_program(programs[j]));
+            const engine::test_filters::match match = filters.match_test_case(
+                programs[j], test_case);
+            ATF_REQUIRE_EQ(static_cast< bool >(exp_filter), match.first);
+            ATF_REQUIRE(exp_filter == match.second);
+        }
+    }
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(test_filters__match_test_program__no_filters)
 ATF_TEST_CASE_BODY(test_filters__match_test_program__no_filters)
 {
@@ -483,6 +557,21 @@ ATF_TEST_CASE_BODY(check_disjoint_filters__fail)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(check_disjoint_filters__nested);
+ATF_TEST_CASE_BODY(check_disjoint_filters__nested)
+{
+    std::set< engine::test_filter > filters;
+    filters.insert(mkfilter("a/b/c", "d"));
+    filters.insert(mkfilter("a/b/cd", ""));
+    filters.insert(mkfilter("a/bc", ""));
+    engine::check_disjoint_filters(filters);
+
+    filters.insert(mkfilter("a/b", ""));
+    ATF_REQUIRE_THROW_RE(std::runtime_error, "'a/b'.*'a/b/c:d'.*not disjoint",
+                         engine::check_disjoint_filters(filters));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(filters_state__match_test_program);
 ATF_TEST_CASE_BODY(filters_state__match_test_program)
 {
@@ -573,6 +662,8 @@ ATF_INIT_TEST_CASES(tcs)
 
     ATF_ADD_TEST_CASE(tcs, test_filters__match_test_case__no_filters);
     ATF_ADD_TEST_CASE(tcs, test_filters__match_test_case__some_filters);
+    ATF_ADD_TEST_CASE(tcs, test_filters__match_test_case__nested_filters);
+    ATF_ADD_TEST_CASE(tcs, test_filters__match_test_case__many_filters);
     ATF_ADD_TEST_CASE(tcs, test_filters__match_test_program__no_filters);
     ATF_ADD_TEST_CASE(tcs, test_filters__match_test_program__some_filters);
     ATF_ADD_TEST_CASE(tcs, test_filters__difference__no_filters);
@@ -581,6 +672,7 @@ ATF_INIT_TEST_CASES(tcs)
 
     ATF_ADD_TEST_CASE(tcs, check_disjoint_filters__ok);
     ATF_ADD_TEST_CASE(tcs, check_disjoint_filters__fail);
+    ATF_ADD_TEST_CASE(tcs, check_disjoint_filters__nested);
 
     ATF_ADD_TEST_CASE(tcs, filters_state__match_test_program);
     ATF_ADD_TEST_CASE(tcs, filters_state__match_test_case);
@@ -28,9 +28,24 @@
 
 #include "engine/kyuafile.hpp"
 
+extern "C" {
+#include <unistd.h>
+}
+
 #include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
 #include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
 #include <stdexcept>
+#include <utility>
 
 #include <lutok/exceptions.hpp>
 #include <lutok/operations.hpp>
@@ -45,17 +60,24 @@
 #include "utils/config/tree.ipp"
 #include "utils/datetime.hpp"
 #include "utils/format/macros.hpp"
+#include "utils/fs/exceptions.hpp"
 #include "utils/fs/lua_module.hpp"
 #include "utils/fs/operations.hpp"
 #include "utils/logging/macros.hpp"
 #include "utils/noncopyable.hpp"
 #include "utils/optional.ipp"
+#include "utils/process/child.ipp"
+#include "utils/process/status.hpp"
 #include "utils/sanity.hpp"
+#include "utils/shared_ptr.hpp"
+#include "utils/text/operations.ipp"
 
 namespace config = utils::config;
 namespace datetime = utils::datetime;
 namespace fs = utils::fs;
+namespace process = utils::process;
 namespace scheduler = engine::scheduler;
+namespace text = utils::text;
 
 using utils::none;
 using utils::optional;
@@ -106,6 +128,181 @@ relativize(const fs::path& root, const fs::path& file)
 }
 
 
+/// Writes a length-prefixed string to a stream.
+///
+/// \param output The stream into which to write the string.
+/// \param str The string to write.  May contain any character.
+static void
+write_string(std::ostream& output, const std::string& str)
+{
+    output << str.length() << ':' << str << '\n';
+}
+
+
+/// Reads a string previously written by write_string().
+///
+/// \param input The stream from which to read the string.
+///
+/// \return The read string.
+///
+/// \throw std::runtime_error If the input is truncated or malformed.
+static std::string
+read_string(std::istream& input)
+{
+    std::string::size_type length;
+    char delimiter;
+    if (!(input >> length) || !input.get(delimiter) || delimiter != ':')
+        throw std::runtime_error("Invalid string length");
+
+    std::string str(length, '\0');
+    if (length > 0 && !input.read(&str[0], length))
+        throw std::runtime_error("Truncated string");
+    if (!input.get(delimiter) || delimiter != '\n')
+        throw std::runtime_error("Missing string terminator");
+    return str;
+}
+
+
+/// Serializes the definitions of a collection of test programs.
+///
+/// Only the data that comes from the Kyuafile is stored: the test case lists
+/// are loaded lazily and thus do not need to cross process boundaries.
+///
+/// \param output The stream into which to write the test programs.
+/// \param test_programs The test programs to serialize.
+static void
+write_test_programs(std::ostream& output,
+                    const model::test_programs_vector& test_programs)
+{
+    for (model::test_programs_vector::const_iterator iter =
+             test_programs.begin(); iter != test_programs.end(); ++iter) {
+        const model::test_program& test_program = **iter;
+
+        write_string(output, "program");
+        write_string(output, test_program.interface_name());
+        write_string(output, test_program.relative_path().str());
+        write_string(output, test_program.test_suite_name());
+
+        const model::properties_map props =
+            test_program.get_metadata().to_properties();
+        write_string(output, F("%s") % props.size());
+        for (model::properties_map::const_iterator iter2 = props.begin();
+             iter2 != props.end(); ++iter2) {
+            write_string(output, (*iter2).first);
+            write_string(output, (*iter2).second);
+        }
+    }
+}
+
+
+/// Serializes the fs.exists() queries issued by the Lua code of a Kyuafile.
+///
+/// The directories scanned with fs.files() are not handled here: they are
+/// dependencies of the Kyuafile just like the Kyuafile itself.
+///
+/// \param output The stream into which to write the queries.
+/// \param queries The queries to serialize.
+static void
+write_exists_queries(std::ostream& output, const fs::lua_queries& queries)
+{
+    for (std::map< fs::path, bool >::const_iterator iter =
+             queries.exists.begin(); iter != queries.exists.end(); ++iter) {
+        write_string(output, "exists");
+        write_string(output, (*iter).first.str());
+        write_string(output, (*iter).second ? "true" : "false");
+    }
+}
+
+
+/// Deserializes a test program written by write_test_programs().
+///
+/// \pre The record type preceding the test program has already been consumed.
+///
+/// \param input The stream from which to read the test program.
+/// \param build_root The root directory of the test programs.
+/// \param user_config User configuration holding any test suite properties
+///     to be passed to the list operation.
+/// \param scheduler_handle The scheduler context to use for loading the test
+///     case lists.
+///
+/// \return The test program.
+///
+/// \throw std::runtime_error If the input is invalid.
+static model::test_program_ptr
+read_test_program(std::istream& input, const fs::path& build_root,
+                  const config::tree& user_config,
+                  scheduler::scheduler_handle& scheduler_handle)
+{
+    const std::string interface = read_string(input);
+    const fs::path path(read_string(input));
+    const std::string test_suite = read_string(input);
+
+    model::metadata_builder mdbuilder;
+    const std::size_t nprops = text::to_type< std::size_t >(read_string(input));
+    for (std::size_t i = 0; i < nprops; ++i) {
+        const std::string property = read_string(input);
+        mdbuilder.set_string(property, read_string(input));
+    }
+
+    return model::test_program_ptr(new scheduler::lazy_test_program(
+        interface, path, build_root, test_suite, mdbuilder.build(),
+        user_config, scheduler_handle));
+}
+
+
+class parser;
+
+
+/// Subprocess hook to load an included Kyuafile.
+///
+/// The results of the load are written to a file in the format read by
+/// parser::read_include_results().  The file is only terminated by an 'end'
+/// record if the load completed, so that a crashed subprocess can be told apart
+/// from an empty Kyuafile.
+class include_loader {
+    /// Root directory of the test suite.
+    fs::path _source_root;
+
+    /// Root directory of the test programs.
+    fs::path _build_root;
+
+    /// Name of the Kyuafile to load relative to _source_root.
+    fs::path _relative_filename;
+
+    /// File into which to write the loaded test programs.
+    fs::path _results_file;
+
+    /// User configuration to pass to the parser.
+    const config::tree* _user_config;
+
+    /// Scheduler context to pass to the parser.
+    scheduler::scheduler_handle* _scheduler_handle;
+
+public:
+    /// Constructor.
+    ///
+    /// \param source_root_ Root directory of the test suite.
+    /// \param build_root_ Root directory of the test programs.
+    /// \param relative_filename_ Name of the Kyuafile to load relative to
+    ///     source_root_.
+    /// \param results_file_ File into which to write the loaded test programs.
+    /// \param user_config_ User configuration to pass to the parser.
+    /// \param scheduler_handle_ Scheduler context to pass to the parser.
+    include_loader(const fs::path& source_root_, const fs::path& build_root_,
+                   const fs::path& relative_filename_,
+                   const fs::path& results_file_,
+                   const config::tree& user_config_,
+                   scheduler::scheduler_handle& scheduler_handle_) :
+        _source_root(source_root_), _build_root(build_root_),
+        _relative_filename(relative_filename_), _results_file(results_file_),
+        _user_config(&user_config_), _scheduler_handle(&scheduler_handle_)
+    {
+    }
+
+    void operator()(void);
+};
+
+
 /// Implementation of a parser for Kyuafiles.
 ///
 /// The main purpose of having this as a class is to keep track of global state
@@ -124,6 +321,41 @@ class parser : utils::noncopyable {
     /// Name of the Kyuafile to load relative to _source_root.
     const fs::path _relative_filename;
 
+    /// User configuration holding any test suite properties.
+    const config::tree& _user_config;
+
+    /// The scheduler context to use for loading the test case lists.
+    scheduler::scheduler_handle& _scheduler_handle;
+
+    /// Maximum number of included files to load concurrently.
+    ///
+    /// If 1, included files are loaded in-line as soon as include() is called.
+    /// Otherwise, they are recorded in _deferred_includes and loaded in
+    /// subprocesses once this file has been fully processed.
+    const std::size_t _include_parallelism;
+
+    /// Representation of an include() call whose processing is delayed.
+    struct deferred_include {
+        /// Position in _test_programs where the included programs belong.
+        std::size_t position;
+
+        /// Name of the included file relative to _source_root.
+        fs::path file;
+
+        /// Constructor.
+        ///
+        /// \param position_ Position in _test_programs where the included
+        ///     programs belong.
+        /// \param file_ Name of the included file relative to _source_root.
+        deferred_include(const std::size_t position_, const fs::path& file_) :
+            position(position_), file(file_)
+        {
+        }
+    };
+
+    /// Collection of include() calls pending processing.
+    std::vector< deferred_include > _deferred_includes;
+
     /// Version of the Kyuafile file format requested by the parsed file.
     ///
     /// This is set once the Kyuafile invokes the syntax() call.
@@ -140,6 +372,19 @@ class parser : utils::noncopyable {
     /// the Kyuafile.
     model::test_programs_vector _test_programs;
 
+    /// Files and directories whose contents determine the parsed results.
+    ///
+    /// These are the Kyuafiles processed so far, including the included ones,
+    /// and the directories containing them.  This also holds the directories
+    /// scanned by the included files processed in subprocesses.
+    std::vector< fs::path > _files;
+
+    /// File system queries issued by the Lua code of the processed Kyuafiles.
+    ///
+    /// These also determine the parsed results, as the Kyuafiles can define
+    /// test programs conditionally on the contents of the file system.
+    fs::lua_queries _queries;
+
     /// Safely gets _test_suite and respects any test program overrides.
     ///
     /// \param program_override The test program-specific test suite name.  May
@@ -168,6 +413,154 @@ class parser : utils::noncopyable {
         return test_suite;
     }
 
+    /// Reads the results of a subprocess that loaded an included file.
+    ///
+    /// \post _files and _queries are extended with the files processed and the
+    /// queries issued by the subprocess.  The directories scanned by the
+    /// subprocess are recorded in _files.
+    ///
+    /// \param results_file File written by include_loader.
+    /// \param file Name of the included file, for error reporting purposes.
+    ///
+    /// \return The test programs defined by the included file.
+    ///
+    /// \throw std::runtime_error If the included file failed to load or if the
+    ///     subprocess did not complete.
+    model::test_programs_vector
+    read_include_results(const fs::path& results_file, const fs::path& file)
+    {
+        model::test_programs_vector test_programs;
+        optional< std::string > error;
+        try {
+            std::ifstream input(results_file.c_str());
+            if (!input)
+                throw std::runtime_error(F("Cannot open %s") % results_file);
+
+            std::string type;
+            while ((type = read_string(input)) != "end") {
+                if (type == "error") {
+                    error = utils::make_optional(read_string(input));
+                } else if (type == "file") {
+                    _files.push_back(fs::path(read_string(input)));
+                } else if (type == "exists") {
+                    const fs::path path(read_string(input));
+                    _queries.exists[path] = text::to_type< bool >(
+                        read_string(input));
+                } else if (type == "program") {
+                    test_programs.push_back(read_test_program(
+                        input, _build_root, _user_config, _scheduler_handle));
+                } else {
+                    throw std::runtime_error(F("Unknown record '%s'") % type);
+                }
+            }
+        } catch (const std::runtime_error& e) {
+            throw std::runtime_error(F("Load of '%s' did not complete: %s") %
+                                     file % e.what());
+        }
+
+        if (error)
+            throw std::runtime_error(error.get());
+        return test_programs;
+    }
+
+    /// Loads the included files recorded in _deferred_includes.
+    ///
+    /// Each included file is processed in its own subprocess and with its own
+    /// Lua state, and at most _include_parallelism of these run at once.  The
+    /// subprocesses are awaited for in the order in which the include() calls
+    /// happened, which makes both the resulting test programs and any reported
+    /// error match those of a sequential load.
+    ///
+    /// \post _test_programs contains the test programs of the included files in
+    /// the positions in which they were included.
+    ///
+    /// \throw std::runtime_error If any of the included files fails to load.
+    void
+    load_deferred_includes(void)
+    {
+        const fs::path& work_directory =
+            _scheduler_handle.root_work_directory();
+
+        typedef std::pair< std::size_t, std::shared_ptr< process::child > >
+            running_load;
+        std::deque< running_load > running;
+
+        std::vector< model::test_programs_vector > loaded(
+            _deferred_includes.size());
+        optional< std::string > error;
+        std::size_t next = 0;
+        while ((!error && next < _deferred_includes.size()) ||
+               !running.empty()) {
+            while (!error && next < _deferred_includes.size() &&
+                   running.size() < _include_parallelism) {
+                const fs::path prefix = work_directory /
+                    (F("kyuafile.%s") % next).str();
+                try {
+                    std::auto_ptr< process::child > child =
+                        process::child::fork_files(
+                            include_loader(_source_root, _build_root,
+                                           _deferred_includes[next].file,
+                                           fs::path(prefix.str() + ".results"),
+                                           _user_config, _scheduler_handle),
+                            fs::path(prefix.str() + ".stdout"),
+                            fs::path(prefix.str() + ".stderr"));
+                    running.push_back(running_load(
+                        next, std::shared_ptr< process::child >(
+                            child.release())));
+                    ++next;
+                } catch (const std::runtime_error& e) {
+                    error = utils::make_optional(std::string(e.what()));
+                }
+            }
+            if (running.empty())
+                break;
+
+            const running_load load = running.front();
+            running.pop_front();
+            const process::status status = load.second->wait();
+            if (error)
+                continue;
+
+            const fs::path& file = _deferred_includes[load.first].file;
+            const fs::path prefix = work_directory /
+                (F("kyuafile.%s") % load.first).str();
+            try {
+                loaded[load.first] = read_include_results(
+                    fs::path(prefix.str() + ".results"), file);
+            } catch (const std::runtime_error& e) {
+                LW(F("Subprocess loading %s terminated with %s; see %s.stderr")
+                   % file % status % prefix);
+                error = utils::make_optional(std::string(e.what()));
+                continue;
+            }
+
+            try {
+                fs::unlink(fs::path(prefix.str() + ".results"));
+                fs::unlink(fs::path(prefix.str() + ".stdout"));
+                fs::unlink(fs::path(prefix.str() + ".stderr"));
+            } catch (const fs::error& e) {
+                LW(F("Failed to clean up after loading %s: %s") % file %
+                   e.what());
+            }
+        }
+        if (error)
+            throw std::runtime_error(error.get());
+
+        model::test_programs_vector merged;
+        std::size_t position = 0;
+        for (std::size_t i = 0; i < _deferred_includes.size(); ++i) {
+            const std::size_t end = _deferred_includes[i].position;
+            merged.insert(merged.end(), _test_programs.begin() + position,
+                          _test_programs.begin() + end);
+            merged.insert(merged.end(), loaded[i].begin(), loaded[i].end());
+            position = end;
+        }
+        merged.insert(merged.end(), _test_programs.begin() + position,
+                      _test_programs.end());
+        _test_programs.swap(merged);
+        _deferred_includes.clear();
+    }
+
 public:
     /// Initializes the parser and the Lua state.
     ///
@@ -180,13 +573,21 @@ public:
     ///     to be passed to the list operation.
     /// \param scheduler_handle The scheduler context to use for loading the
     ///     test case lists.
+    /// \param include_parallelism_ Maximum number of included files to load
+    ///     concurrently.  If 1, included files are loaded sequentially in this
+    ///     process.
     parser(const fs::path& source_root_, const fs::path& build_root_,
            const fs::path& relative_filename_,
            const config::tree& user_config,
-           scheduler::scheduler_handle& scheduler_handle) :
+           scheduler::scheduler_handle& scheduler_handle,
+           const std::size_t include_parallelism_) :
         _source_root(source_root_), _build_root(build_root_),
-        _relative_filename(relative_filename_)
+        _relative_filename(relative_filename_), _user_config(user_config),
+        _scheduler_handle(scheduler_handle),
+        _include_parallelism(include_parallelism_)
     {
+        PRE(_include_parallelism >= 1);
+
         lutok::stack_cleaner cleaner(_state);
 
         _state.push_cxx_function(lua_syntax);
@@ -224,7 +625,8 @@ public:
         _state.open_base();
         _state.open_string();
         _state.open_table();
-        fs::open_fs(_state, callback_current_kyuafile().branch_path());
+        fs::open_fs(_state, callback_current_kyuafile().branch_path(),
+                    &_queries);
     }
 
     /// Destructor.
@@ -261,7 +663,8 @@ public:
     /// Callback for the Kyuafile include() function.
     ///
     /// \post _test_programs is extended with the the test programs defined by
-    /// the included file.
+    /// the included file, or the file is recorded in _deferred_includes if
+    /// includes are processed concurrently.
     ///
     /// \param raw_file Path to the file to include.
     /// \param user_config User configuration holding any test suite properties
@@ -274,9 +677,21 @@ public:
     {
         const fs::path file = relativize(_relative_filename.branch_path(),
                                          raw_file);
-        const model::test_programs_vector subtps =
-            parser(_source_root, _build_root, file, user_config,
-                   scheduler_handle).parse();
+        if (_include_parallelism > 1) {
+            _deferred_includes.push_back(
+                deferred_include(_test_programs.size(), file));
+            return;
+        }
+
+        parser subparser(_source_root, _build_root, file, user_config,
+                         scheduler_handle, 1);
+        const model::test_programs_vector& subtps = subparser.parse();
+        std::copy(subparser.files().begin(), subparser.files().end(),
+                  std::back_inserter(_files));
+        _queries.exists.insert(subparser.queries().exists.begin(),
+                               subparser.queries().exists.end());
+        _queries.listed.insert(subparser.queries().listed.begin(),
+                               subparser.queries().listed.end());
 
         std::copy(subtps.begin(), subtps.end(),
                   std::back_inserter(_test_programs));
@@ -379,6 +794,8 @@ public:
         PRE(_test_programs.empty());
 
         const fs::path load_path = relativize(_source_root, _relative_filename);
+        _files.push_back(load_path);
+        _files.push_back(load_path.branch_path());
         try {
             lutok::do_file(_state, load_path.str(), 0, 0, 0);
         } catch (const std::runtime_error& e) {
@@ -394,11 +811,74 @@ public:
         if (!_version)
             throw engine::load_error(load_path, "syntax() never called");
 
+        if (!_deferred_includes.empty()) {
+            try {
+                load_deferred_includes();
+            } catch (const std::runtime_error& e) {
+                throw engine::load_error(load_path, e.what());
+            }
+        }
+
         return _test_programs;
     }
+
+    /// Gets the files whose contents determine the results of parse().
+    ///
+    /// \return The paths to the processed Kyuafiles and their directories.
+    const std::vector< fs::path >&
+    files(void) const
+    {
+        return _files;
+    }
+
+    /// Gets the file system queries that determine the results of parse().
+    ///
+    /// \return The queries issued by the Lua code of the processed Kyuafiles.
+    const fs::lua_queries&
+    queries(void) const
+    {
+        return _queries;
+    }
 };
 
 
+/// Loads the included Kyuafile and dumps its test programs.
+///
+/// This is executed in a subprocess and never returns.
+void
+include_loader::operator()(void)
+{
+    {
+        std::ofstream output(_results_file.c_str());
+        try {
+            parser subparser(_source_root, _build_root, _relative_filename,
+                             *_user_config, *_scheduler_handle, 1);
+            write_test_programs(output, subparser.parse());
+            for (std::vector< fs::path >::const_iterator iter =
+                     subparser.files().begin();
+                 iter != subparser.files().end(); ++iter) {
+                write_string(output, "file");
+                write_string(output, (*iter).str());
+            }
+            for (std::set< fs::path >::const_iterator iter =
+                     subparser.queries().listed.begin();
+                 iter != subparser.queries().listed.end(); ++iter) {
+                write_string(output, "file");
+                write_string(output, (*iter).str());
+            }
+            write_exists_queries(output, subparser.queries());
+        } catch (const engine::load_error& e) {
+            write_string(output, "error");
+            write_string(output, e.what());
+        }
+        write_string(output, "end");
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    ::_exit(EXIT_SUCCESS);
+}
+
+
 /// Glue to invoke parser::callback_test_program() from Lua.
 ///
 /// This is a helper function for the various *_test_program() calls, as they
@@ -592,6 +1072,214 @@ lua_test_suite(lutok::state& state)
 }
 
 
+/// Computes the path to the manifest of a Kyuafile.
+///
+/// \param directory The directory holding the cached manifests.
+/// \param file The absolute path to the top-level Kyuafile.
+///
+/// \return The path to the file holding the manifest.
+static fs::path
+manifest_path(const fs::path& directory, const fs::path& file)
+{
+    std::string name = file.str();
+    for (std::string::iterator iter = name.begin(); iter != name.end();
+         ++iter) {
+        if (*iter == '/')
+            *iter = '_';
+    }
+    return directory / (name + ".manifest");
+}
+
+
+/// Loads the cached manifest of a Kyuafile.
+///
+/// The manifest is only used if all the files and directories it depends on
+/// still have the same modification times, if all the paths that the Kyuafiles
+/// probed with fs.exists() still give the same answer, and if all of its test
+/// programs still exist.  Validating these only requires a few stat(2) calls,
+/// which is much cheaper than executing the Lua code of the Kyuafiles again.
+///
+/// \param directory The directory holding the cached manifests.
+/// \param file The absolute path to the top-level Kyuafile.
+/// \param build_root The absolute path to the root of the test programs.
+/// \param user_config User configuration holding any test suite properties
+///     to be passed to the list operation.
+/// \param scheduler_handle The scheduler context to use for loading the test
+///     case lists.
+///
+/// \return The test programs defined by the Kyuafile, or none if there is no
+/// manifest for the Kyuafile or if it is out of date.
+static optional< model::test_programs_vector >
+read_manifest(const fs::path& directory, const fs::path& file,
+              const fs::path& build_root, const config::tree& user_config,
+              scheduler::scheduler_handle& scheduler_handle)
+{
+    const fs::path path = manifest_path(directory, file);
+
+    std::ifstream input(path.c_str());
+    if (!input)
+        return none;
+
+    try {
+        if (read_string(input) != "kyua-manifest-2" ||
+            read_string(input) != file.str() ||
+            read_string(input) != build_root.str()) {
+            LD(F("Manifest %s does not match %s") % path % file);
+            return none;
+        }
+
+        model::test_programs_vector test_programs;
+        std::string type;
+        while ((type = read_string(input)) != "end") {
+            if (type == "file") {
+                const fs::path dependency(read_string(input));
+                const std::string mtime = read_string(input);
+                const std::string actual_mtime = F("%s") %
+                    fs::modification_time(dependency).to_microseconds();
+                if (actual_mtime != mtime) {
+                    LD(F("Manifest %s is out of date: %s changed") % path %
+                       dependency);
+                    return none;
+                }
+            } else if (type == "exists") {
+                const fs::path probe(read_string(input));
+                const bool exists = text::to_type< bool >(read_string(input));
+                if (fs::exists(probe) != exists) {
+                    LD(F("Manifest %s is out of date: %s %s") % path % probe %
+                       (exists ? "vanished" : "appeared"));
+                    return none;
+                }
+            } else if (type == "program") {
+                const model::test_program_ptr test_program = read_test_program(
+                    input, build_root, user_config, scheduler_handle);
+                if (!scheduler::registered_interface_names().count(
+                        test_program->interface_name()) ||
+                    !fs::exists(build_root / test_program->relative_path())) {
+                    LD(F("Manifest %s is out of date: %s changed") % path %
+                       test_program->relative_path());
+                    return none;
+                }
+                test_programs.push_back(test_program);
+            } else {
+                throw std::runtime_error(F("Unknown record '%s'") % type);
+            }
+        }
+
+        LD(F("Loaded test programs of %s from %s") % file % path);
+        return utils::make_optional(test_programs);
+    } catch (const std::runtime_error& e) {
+        // Also catches the fs::error raised when a dependency vanishes.
+        LW(F("Ignoring invalid manifest %s: %s") % path % e.what());
+        return none;
+    }
+}
+
+
+/// Serializes a dependency of a manifest on the contents of a file.
+///
+/// \param output The stream into which to write the dependency.
+/// \param file The file or directory the manifest depends on.
+/// \param load_time The time at which the Kyuafiles started to be processed.
+///
+/// \return True if the dependency was written; false if the file was modified
+/// too recently for its modification time to reveal any later change.
+///
+/// \throw fs::error If the file cannot be queried.
+static bool
+write_dependency(std::ostream& output, const fs::path& file,
+                 const datetime::timestamp& load_time)
+{
+    const fs::path dependency = file.is_absolute() ? file : file.to_absolute();
+    const datetime::timestamp mtime = fs::modification_time(dependency);
+    if (!fs::is_stable_mtime(mtime, load_time)) {
+        LD(F("Not caching test programs: %s was modified too recently") %
+           dependency);
+        return false;
+    }
+    write_string(output, "file");
+    write_string(output, dependency.str());
+    write_string(output, F("%s") % mtime.to_microseconds());
+    return true;
+}
+
+
+/// Stores the manifest of a Kyuafile in the cache.
+///
+/// The file is replaced atomically so that concurrent readers never see a
+/// partially-written manifest.
+///
+/// Nothing is stored if any of the files the test programs depend on was
+/// modified too close to load_time: the modification time of such a file does
+/// not prove that the Kyuafiles saw its latest contents.
+///
+/// \param directory The directory holding the cached manifests.  Created if it
+///     does not exist.
+/// \param file The absolute path to the top-level Kyuafile.
+/// \param build_root The absolute path to the root of the test programs.
+/// \param files The files and directories the test programs depend on.
+/// \param queries The file system queries the test programs depend on.
+/// \param load_time The time at which the Kyuafiles started to be processed.
+/// \param test_programs The test programs defined by the Kyuafile.
+///
+/// \throw engine::error If the manifest cannot be stored.
+static void
+write_manifest(const fs::path& directory, const fs::path& file,
+               const fs::path& build_root, const std::vector< fs::path >& files,
+               const fs::lua_queries& queries,
+               const datetime::timestamp& load_time,
+               const model::test_programs_vector& test_programs)
+{
+    std::ostringstream contents;
+    write_string(contents, "kyua-manifest-2");
+    write_string(contents, file.str());
+    write_string(contents, build_root.str());
+    try {
+        for (std::vector< fs::path >::const_iterator iter = files.begin();
+             iter != files.end(); ++iter) {
+            if (!write_dependency(contents, *iter, load_time))
+                return;
+        }
+        for (std::set< fs::path >::const_iterator iter = queries.listed.begin();
+             iter != queries.listed.end(); ++iter) {
+            if (!write_dependency(contents, *iter, load_time))
+                return;
+        }
+    } catch (const fs::error& e) {
+        throw engine::error(F("Cannot query Kyuafile: %s") % e.what());
+    }
+    write_exists_queries(contents, queries);
+    write_test_programs(contents, test_programs);
+    write_string(contents, "end");
+
+    try {
+        if (!fs::exists(directory))
+            fs::mkdir_p(directory, 0755);
+    } catch (const fs::error& e) {
+        throw engine::error(F("Cannot create %s: %s") % directory % e.what());
+    }
+
+    const fs::path path = manifest_path(directory, file);
+    const fs::path temp_path(F("%s.%s") % path % ::getpid());
+    {
+        std::ofstream output(temp_path.c_str());
+        if (!output)
+            throw engine::error(F("Cannot create %s") % temp_path);
+        output << contents.str();
+        output.close();
+        if (!output) {
+            ::unlink(temp_path.c_str());
+            throw engine::error(F("Failed to write %s") % temp_path);
+        }
+    }
+    if (std::rename(temp_path.c_str(), path.c_str()) == -1) {
+        const int original_errno = errno;
+        ::unlink(temp_path.c_str());
+        throw engine::error(F("Cannot rename %s to %s: %s") % temp_path %
+                            path % std::strerror(original_errno));
+    }
+}
+
+
 }  // anonymous namespace
 
 
@@ -625,6 +1313,10 @@ engine::kyuafile::~kyuafile(void)
 
 /// Parses a test suite configuration file.
 ///
+/// If the list_cache_dir setting is defined, the test programs are loaded from
+/// the manifest cached in that directory if it is still valid, and the
+/// manifest is updated otherwise.
+///
 /// \param file The file to parse.
 /// \param user_build_root If not none, specifies a path to a directory
 ///     containing the test programs themselves.  The layout of the build root
@@ -657,10 +1349,45 @@ engine::kyuafile::load(const fs::path& file,
     const fs::path abs_build_root = build_root_.is_absolute() ?
         build_root_ : build_root_.to_absolute();
 
-    return kyuafile(source_root_, build_root_,
-                    parser(source_root_, abs_build_root,
-                           fs::path(file.leaf_name()), user_config,
-                           scheduler_handle).parse());
+    // Included files are loaded concurrently to speed up the processing of
+    // large test suites, but only the top-level file does so: nested includes
+    // are processed sequentially within the subprocess that loads their
+    // parent.
+    const std::size_t include_parallelism = user_config.is_set("parallelism") ?
+        user_config.lookup< config::positive_int_node >("parallelism") : 1;
+
+    optional< fs::path > cache_directory;
+    if (user_config.is_set("list_cache_dir"))
+        cache_directory = fs::path(user_config.lookup< config::string_node >(
+            "list_cache_dir"));
+    const fs::path abs_file = file.is_absolute() ? file : file.to_absolute();
+
+    if (cache_directory) {
+        const optional< model::test_programs_vector > test_programs =
+            read_manifest(cache_directory.get(), abs_file, abs_build_root,
+                          user_config, scheduler_handle);
+        if (test_programs)
+            return kyuafile(source_root_, build_root_, test_programs.get());
+    }
+
+    const datetime::timestamp load_time = datetime::timestamp::now();
+    parser root_parser(source_root_, abs_build_root,
+                       fs::path(file.leaf_name()), user_config,
+                       scheduler_handle, include_parallelism);
+    const model::test_programs_vector& test_programs = root_parser.parse();
+
+    if (cache_directory) {
+        try {
+            write_manifest(cache_directory.get(), abs_file, abs_build_root,
+                           root_parser.files(), root_parser.queries(),
+                           load_time, test_programs);
+        } catch (const engine::error& e) {
+            LW(F("Failed to cache the test programs of %s: %s") % file %
+               e.what());
+        }
+    }
+
+    return kyuafile(source_root_, build_root_, test_programs);
 }
 
 
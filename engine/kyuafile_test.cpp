@@ -30,6 +30,7 @@
 
 extern "C" {
 #include <unistd.h>
+#include <utime.h>
 }
 
 #include <stdexcept>
@@ -41,6 +42,7 @@ extern "C" {
 #include <lutok/test_utils.hpp>
 
 #include "engine/atf.hpp"
+#include "engine/config.hpp"
 #include "engine/exceptions.hpp"
 #include "engine/plain.hpp"
 #include "engine/scheduler.hpp"
@@ -60,6 +62,7 @@ namespace fs = utils::fs;
 namespace scheduler = engine::scheduler;
 
 using utils::none;
+using utils::optional;
 
 
 ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__empty);
@@ -442,6 +445,396 @@ ATF_TEST_CASE_BODY(kyuafile__load__fs_calls_are_relative)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__parallel_includes);
+ATF_TEST_CASE_BODY(kyuafile__load__parallel_includes)
+{
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    atf::utils::create_file(
+        "Kyuafile",
+        "syntax(2)\n"
+        "test_suite('root')\n"
+        "plain_test_program{name='1st'}\n"
+        "include('dir1/Kyuafile')\n"
+        "plain_test_program{name='2nd'}\n"
+        "include('dir2/Kyuafile')\n"
+        "include('dir3/Kyuafile')\n"
+        "plain_test_program{name='3rd'}\n");
+
+    fs::mkdir(fs::path("dir1"), 0755);
+    atf::utils::create_file(
+        "dir1/Kyuafile",
+        "syntax(2)\n"
+        "test_suite('one')\n"
+        "atf_test_program{name='a', timeout=15}\n"
+        "include('subdir/Kyuafile')\n"
+        "atf_test_program{name='b', ['custom.x']='y z'}\n");
+    fs::mkdir(fs::path("dir1/subdir"), 0755);
+    atf::utils::create_file(
+        "dir1/subdir/Kyuafile",
+        "syntax(2)\n"
+        "tap_test_program{name='c', test_suite='nested'}\n");
+
+    fs::mkdir(fs::path("dir2"), 0755);
+    atf::utils::create_file("dir2/Kyuafile", "syntax(2)\n");
+
+    fs::mkdir(fs::path("dir3"), 0755);
+    atf::utils::create_file(
+        "dir3/Kyuafile",
+        "syntax(2)\n"
+        "plain_test_program{name='d', test_suite='three'}\n");
+
+    atf::utils::create_file("1st", "");
+    atf::utils::create_file("2nd", "");
+    atf::utils::create_file("3rd", "");
+    atf::utils::create_file("dir1/a", "");
+    atf::utils::create_file("dir1/b", "");
+    atf::utils::create_file("dir1/subdir/c", "");
+    atf::utils::create_file("dir3/d", "");
+
+    config::tree user_config = engine::default_config();
+    user_config.set< config::positive_int_node >("parallelism", 2);
+
+    const engine::kyuafile suite = engine::kyuafile::load(
+        fs::path("Kyuafile"), none, user_config, handle);
+    const model::test_programs_vector& tps = suite.test_programs();
+    ATF_REQUIRE_EQ(7, tps.size());
+
+    ATF_REQUIRE_EQ(fs::path("1st"), tps[0]->relative_path());
+    ATF_REQUIRE_EQ("root", tps[0]->test_suite_name());
+
+    ATF_REQUIRE_EQ("atf", tps[1]->interface_name());
+    ATF_REQUIRE_EQ(fs::path("dir1/a"), tps[1]->relative_path());
+    ATF_REQUIRE_EQ("one", tps[1]->test_suite_name());
+    ATF_REQUIRE_EQ(fs::current_path() / "dir1/a", tps[1]->absolute_path());
+    ATF_REQUIRE_EQ(model::metadata_builder()
+                   .set_timeout(datetime::delta(15, 0)).build(),
+                   tps[1]->get_metadata());
+
+    ATF_REQUIRE_EQ("tap", tps[2]->interface_name());
+    ATF_REQUIRE_EQ(fs::path("dir1/subdir/c"), tps[2]->relative_path());
+    ATF_REQUIRE_EQ("nested", tps[2]->test_suite_name());
+
+    ATF_REQUIRE_EQ(fs::path("dir1/b"), tps[3]->relative_path());
+    ATF_REQUIRE_EQ(model::metadata_builder().add_custom("x", "y z").build(),
+                   tps[3]->get_metadata());
+
+    ATF_REQUIRE_EQ(fs::path("2nd"), tps[4]->relative_path());
+    ATF_REQUIRE_EQ(fs::path("dir3/d"), tps[5]->relative_path());
+    ATF_REQUIRE_EQ("three", tps[5]->test_suite_name());
+    ATF_REQUIRE_EQ(fs::path("3rd"), tps[6]->relative_path());
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__parallel_includes__error);
+ATF_TEST_CASE_BODY(kyuafile__load__parallel_includes__error)
+{
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    atf::utils::create_file(
+        "Kyuafile",
+        "syntax(2)\n"
+        "include('dir1/Kyuafile')\n"
+        "include('dir2/Kyuafile')\n"
+        "include('dir3/Kyuafile')\n");
+
+    fs::mkdir(fs::path("dir1"), 0755);
+    atf::utils::create_file("dir1/Kyuafile", "syntax(2)\n");
+    fs::mkdir(fs::path("dir2"), 0755);
+    atf::utils::create_file(
+        "dir2/Kyuafile",
+        "syntax(2)\n"
+        "plain_test_program{name='missing', test_suite='two'}\n");
+    fs::mkdir(fs::path("dir3"), 0755);
+    atf::utils::create_file("dir3/Kyuafile", "syntax(2)\nfoo = {\n");
+
+    config::tree user_config = engine::default_config();
+    user_config.set< config::positive_int_node >("parallelism", 8);
+
+    ATF_REQUIRE_THROW_RE(engine::load_error,
+                         "Load of 'dir2/Kyuafile' failed: "
+                         "Non-existent.*'dir2/missing'",
+                         engine::kyuafile::load(fs::path("Kyuafile"), none,
+                                                user_config, handle));
+
+    handle.cleanup();
+}
+
+
+/// Sets the modification time of a file.
+///
+/// \param file The file to modify.
+/// \param mtime The new modification time, in seconds since the epoch.
+static void
+set_mtime(const char* file, const long mtime)
+{
+    struct ::utimbuf times;
+    times.actime = mtime;
+    times.modtime = mtime;
+    ATF_REQUIRE(::utime(file, &times) != -1);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__manifest__reused);
+ATF_TEST_CASE_BODY(kyuafile__load__manifest__reused)
+{
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    config::tree user_config = engine::default_config();
+    user_config.set< config::string_node >("list_cache_dir", "cache");
+
+    fs::mkdir(fs::path("root"), 0755);
+    atf::utils::create_file("root/one", "");
+    atf::utils::create_file("root/two", "");
+    atf::utils::create_file(
+        "root/Kyuafile",
+        "syntax(2)\n"
+        "plain_test_program{name='one', test_suite='first', timeout=5}\n");
+    set_mtime("root/Kyuafile", 1000);
+    set_mtime("root", 1000);
+
+    {
+        const engine::kyuafile suite = engine::kyuafile::load(
+            fs::path("root/Kyuafile"), none, user_config, handle);
+        ATF_REQUIRE_EQ(1, suite.test_programs().size());
+        ATF_REQUIRE_EQ(fs::path("one"),
+                       suite.test_programs()[0]->relative_path());
+    }
+    ATF_REQUIRE(fs::exists(fs::path("cache")));
+
+    // Replace the contents of the file without changing its modification
+    // time: the cached manifest must be used.
+    atf::utils::create_file(
+        "root/Kyuafile",
+        "syntax(2)\n"
+        "plain_test_program{name='two', test_suite='second'}\n");
+    set_mtime("root/Kyuafile", 1000);
+    {
+        const engine::kyuafile suite = engine::kyuafile::load(
+            fs::path("root/Kyuafile"), none, user_config, handle);
+        ATF_REQUIRE_EQ(1, suite.test_programs().size());
+        const model::test_program& test_program = *suite.test_programs()[0];
+        ATF_REQUIRE_EQ("plain", test_program.interface_name());
+        ATF_REQUIRE_EQ(fs::path("one"), test_program.relative_path());
+        ATF_REQUIRE_EQ(fs::current_path() / "root/one",
+                       test_program.absolute_path());
+        ATF_REQUIRE_EQ("first", test_program.test_suite_name());
+        ATF_REQUIRE_EQ(model::metadata_builder()
+                       .set_timeout(datetime::delta(5, 0)).build(),
+                       test_program.get_metadata());
+    }
+
+    set_mtime("root/Kyuafile", 2000);
+    {
+        const engine::kyuafile suite = engine::kyuafile::load(
+            fs::path("root/Kyuafile"), none, user_config, handle);
+        ATF_REQUIRE_EQ(1, suite.test_programs().size());
+        ATF_REQUIRE_EQ(fs::path("two"),
+                       suite.test_programs()[0]->relative_path());
+        ATF_REQUIRE_EQ("second", suite.test_programs()[0]->test_suite_name());
+    }
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__manifest__include_changed);
+ATF_TEST_CASE_BODY(kyuafile__load__manifest__include_changed)
+{
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    config::tree user_config = engine::default_config();
+    user_config.set< config::string_node >("list_cache_dir", "cache");
+
+    fs::mkdir(fs::path("root"), 0755);
+    atf::utils::create_file(
+        "root/Kyuafile",
+        "syntax(2)\n"
+        "include('dir/Kyuafile')\n");
+    fs::mkdir(fs::path("root/dir"), 0755);
+    atf::utils::create_file("root/dir/one", "");
+    atf::utils::create_file("root/dir/two", "");
+    atf::utils::create_file(
+        "root/dir/Kyuafile",
+        "syntax(2)\n"
+        "plain_test_program{name='one', test_suite='first'}\n");
+    set_mtime("root/dir/Kyuafile", 1000);
+    set_mtime("root/dir", 1000);
+    set_mtime("root/Kyuafile", 1000);
+    set_mtime("root", 1000);
+
+    {
+        const engine::kyuafile suite = engine::kyuafile::load(
+            fs::path("root/Kyuafile"), none, user_config, handle);
+        ATF_REQUIRE_EQ(1, suite.test_programs().size());
+        ATF_REQUIRE_EQ(fs::path("dir/one"),
+                       suite.test_programs()[0]->relative_path());
+    }
+
+    atf::utils::create_file(
+        "root/dir/Kyuafile",
+        "syntax(2)\n"
+        "plain_test_program{name='one', test_suite='first'}\n"
+        "plain_test_program{name='two', test_suite='first'}\n");
+    set_mtime("root/dir/Kyuafile", 2000);
+    {
+        const engine::kyuafile suite = engine::kyuafile::load(
+            fs::path("root/Kyuafile"), none, user_config, handle);
+        ATF_REQUIRE_EQ(2, suite.test_programs().size());
+        ATF_REQUIRE_EQ(fs::path("dir/one"),
+                       suite.test_programs()[0]->relative_path());
+        ATF_REQUIRE_EQ(fs::path("dir/two"),
+                       suite.test_programs()[1]->relative_path());
+    }
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__manifest__racy);
+ATF_TEST_CASE_BODY(kyuafile__load__manifest__racy)
+{
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    config::tree user_config = engine::default_config();
+    user_config.set< config::string_node >("list_cache_dir", "cache");
+
+    fs::mkdir(fs::path("root"), 0755);
+    atf::utils::create_file("root/one", "");
+    atf::utils::create_file("root/two", "");
+    atf::utils::create_file(
+        "root/Kyuafile",
+        "syntax(2)\n"
+        "plain_test_program{name='one', test_suite='first'}\n");
+    const datetime::timestamp mtime = fs::modification_time(
+        fs::path("root/Kyuafile"));
+
+    {
+        const engine::kyuafile suite = engine::kyuafile::load(
+            fs::path("root/Kyuafile"), none, user_config, handle);
+        ATF_REQUIRE_EQ(1, suite.test_programs().size());
+        ATF_REQUIRE_EQ(fs::path("one"),
+                       suite.test_programs()[0]->relative_path());
+    }
+
+    // The file was modified too recently for its modification time to
+    // reveal this change, so no manifest can have been stored for it.
+    atf::utils::create_file(
+        "root/Kyuafile",
+        "syntax(2)\n"
+        "plain_test_program{name='two', test_suite='first'}\n");
+    set_mtime("root/Kyuafile", mtime.to_seconds());
+    {
+        const engine::kyuafile suite = engine::kyuafile::load(
+            fs::path("root/Kyuafile"), none, user_config, handle);
+        ATF_REQUIRE_EQ(1, suite.test_programs().size());
+        ATF_REQUIRE_EQ(fs::path("two"),
+                       suite.test_programs()[0]->relative_path());
+    }
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__manifest__exists_changed);
+ATF_TEST_CASE_BODY(kyuafile__load__manifest__exists_changed)
+{
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    config::tree user_config = engine::default_config();
+    user_config.set< config::string_node >("list_cache_dir", "cache");
+
+    fs::mkdir(fs::path("root"), 0755);
+    fs::mkdir(fs::path("build"), 0755);
+    atf::utils::create_file("build/one", "");
+    atf::utils::create_file("build/two", "");
+    atf::utils::create_file(
+        "root/Kyuafile",
+        F("syntax(2)\n"
+          "test_suite('first')\n"
+          "plain_test_program{name='one'}\n"
+          "if fs.exists('%s') then\n"
+          "    plain_test_program{name='two'}\n"
+          "end\n") % (fs::current_path() / "build/enable-two"));
+    set_mtime("root/Kyuafile", 1000);
+    set_mtime("root", 1000);
+
+    const optional< fs::path > build_root(fs::path("build"));
+    {
+        const engine::kyuafile suite = engine::kyuafile::load(
+            fs::path("root/Kyuafile"), build_root, user_config, handle);
+        ATF_REQUIRE_EQ(1, suite.test_programs().size());
+    }
+
+    // The build root is not a dependency of the Kyuafile, so only the record
+    // of the fs.exists() call can tell that the manifest is out of date.
+    atf::utils::create_file("build/enable-two", "");
+    {
+        const engine::kyuafile suite = engine::kyuafile::load(
+            fs::path("root/Kyuafile"), build_root, user_config, handle);
+        ATF_REQUIRE_EQ(2, suite.test_programs().size());
+        ATF_REQUIRE_EQ(fs::path("two"),
+                       suite.test_programs()[1]->relative_path());
+    }
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__manifest__files_changed);
+ATF_TEST_CASE_BODY(kyuafile__load__manifest__files_changed)
+{
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    config::tree user_config = engine::default_config();
+    user_config.set< config::string_node >("list_cache_dir", "cache");
+
+    fs::mkdir(fs::path("root"), 0755);
+    fs::mkdir(fs::path("build"), 0755);
+    atf::utils::create_file("build/one", "");
+    atf::utils::create_file(
+        "root/Kyuafile",
+        F("syntax(2)\n"
+          "test_suite('first')\n"
+          "names = {}\n"
+          "for file in fs.files('%s') do\n"
+          "    if file ~= '.' and file ~= '..' then\n"
+          "        table.insert(names, file)\n"
+          "    end\n"
+          "end\n"
+          "table.sort(names)\n"
+          "for _, name in ipairs(names) do\n"
+          "    plain_test_program{name=name}\n"
+          "end\n") % (fs::current_path() / "build"));
+    set_mtime("root/Kyuafile", 1000);
+    set_mtime("root", 1000);
+    set_mtime("build", 1000);
+
+    const optional< fs::path > build_root(fs::path("build"));
+    {
+        const engine::kyuafile suite = engine::kyuafile::load(
+            fs::path("root/Kyuafile"), build_root, user_config, handle);
+        ATF_REQUIRE_EQ(1, suite.test_programs().size());
+    }
+
+    atf::utils::create_file("build/two", "");
+    set_mtime("build", 2000);
+    {
+        const engine::kyuafile suite = engine::kyuafile::load(
+            fs::path("root/Kyuafile"), build_root, user_config, handle);
+        ATF_REQUIRE_EQ(2, suite.test_programs().size());
+        ATF_REQUIRE_EQ(fs::path("one"),
+                       suite.test_programs()[0]->relative_path());
+        ATF_REQUIRE_EQ(fs::path("two"),
+                       suite.test_programs()[1]->relative_path());
+    }
+
+    handle.cleanup();
+}
+
+
 /// Verifies that load raises a load_error on a given input.
 ///
 /// \param file Name of the file to load.
@@ -593,6 +986,13 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__build_directory);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__absolute_paths_are_stable);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__fs_calls_are_relative);
+    ATF_ADD_TEST_CASE(tcs, kyuafile__load__parallel_includes);
+    ATF_ADD_TEST_CASE(tcs, kyuafile__load__parallel_includes__error);
+    ATF_ADD_TEST_CASE(tcs, kyuafile__load__manifest__reused);
+    ATF_ADD_TEST_CASE(tcs, kyuafile__load__manifest__include_changed);
+    ATF_ADD_TEST_CASE(tcs, kyuafile__load__manifest__racy);
+    ATF_ADD_TEST_CASE(tcs, kyuafile__load__manifest__exists_changed);
+    ATF_ADD_TEST_CASE(tcs, kyuafile__load__manifest__files_changed);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__test_program_not_basename);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__lua_error);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__syntax__not_called);
@@ -0,0 +1,318 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "engine/list_cache.hpp"
+
+extern "C" {
+#include <sys/stat.h>
+
+#include <unistd.h>
+}
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "engine/exceptions.hpp"
+#include "model/exceptions.hpp"
+#include "model/metadata.hpp"
+#include "model/test_case.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "utils/datetime.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/exceptions.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/logging/macros.hpp"
+#include "utils/optional.ipp"
+
+namespace config = utils::config;
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+
+using utils::none;
+using utils::optional;
+
+
+namespace {
+
+
+/// Checks if any of the keys or values of a properties map spans many lines.
+///
+/// \param properties The properties to check.
+///
+/// \return True if the properties cannot be represented in our file format.
+static bool
+has_newlines(const config::properties_map& properties)
+{
+    for (config::properties_map::const_iterator iter = properties.begin();
+         iter != properties.end(); ++iter) {
+        if ((*iter).first.find('\n') != std::string::npos ||
+            (*iter).second.find('\n') != std::string::npos)
+            return true;
+    }
+    return false;
+}
+
+
+/// Computes the path to the cached list of a test program.
+///
+/// Different test programs may map to the same file.  This is harmless as the
+/// header of the file identifies the test program it belongs to.
+///
+/// \param directory The directory holding the cached lists.
+/// \param test_program The test program to query.
+///
+/// \return The path to the file holding the cached list.
+static fs::path
+cached_list_path(const fs::path& directory,
+                 const model::test_program& test_program)
+{
+    std::string name = test_program.absolute_path().str();
+    for (std::string::iterator iter = name.begin(); iter != name.end();
+         ++iter) {
+        if (*iter == '/')
+            *iter = '_';
+    }
+    return directory / (name + ".list");
+}
+
+
+/// Parses the test cases of a cached list.
+///
+/// \param input The stream to read from, positioned after the header.
+///
+/// \return The parsed test cases.
+///
+/// \throw engine::format_error If the input is invalid.
+/// \throw model::error If any of the metadata properties is invalid.
+static model::test_cases_map
+parse_cached_test_cases(std::istream& input)
+{
+    model::test_cases_map_builder test_cases_builder;
+
+    std::string line;
+    while (std::getline(input, line).good()) {
+        if (line.substr(0, 7) != "ident: " || line.length() == 7)
+            throw engine::format_error(F("Invalid test case identifier '%s'") %
+                                       line);
+        const std::string name = line.substr(7);
+
+        model::metadata_builder mdbuilder;
+        while (std::getline(input, line).good() && !line.empty()) {
+            const std::string::size_type pos = line.find(": ");
+            if (pos == std::string::npos)
+                throw engine::format_error(F("Invalid property line '%s'") %
+                                           line);
+            mdbuilder.set_string(line.substr(0, pos), line.substr(pos + 2));
+        }
+        test_cases_builder.add(name, mdbuilder.build());
+    }
+    if (!input.eof())
+        throw engine::format_error("Read error");
+
+    return test_cases_builder.build();
+}
+
+
+}  // anonymous namespace
+
+
+/// Computes the key that identifies the cached list of a test program.
+///
+/// The key records the identity, size and modification time of the test
+/// program binary, plus the variables passed to its list operation, so that
+/// any change to them invalidates the cached list.  The key must be computed
+/// before listing the test program: a binary replaced while being listed then
+/// does not get the list of its previous version associated to it.
+///
+/// \param test_program The test program to query.
+/// \param vars User-provided variables passed to the list operation.
+///
+/// \return The key, which is the textual header of the cached list including
+/// its terminating empty line, or none if the list cannot be cached.  This
+/// happens if the test program cannot be queried, if any of the variables
+/// spans many lines or if the binary was modified too recently for its
+/// modification time to reflect later changes.
+optional< std::string >
+engine::cached_list_key(const model::test_program& test_program,
+                        const config::properties_map& vars)
+{
+    const fs::path program = test_program.absolute_path();
+
+    if (has_newlines(vars)) {
+        LD(F("Not caching the list of %s: multi-line variables") % program);
+        return none;
+    }
+
+    const datetime::timestamp now = datetime::timestamp::now();
+    struct ::stat sb;
+    if (::stat(program.c_str(), &sb) == -1) {
+        // Let the regular listing of the test program report the problem.
+        return none;
+    }
+    const datetime::timestamp mtime = datetime::timestamp::from_microseconds(
+        static_cast< int64_t >(sb.st_mtime) * 1000000);
+    if (!fs::is_stable_mtime(mtime, now)) {
+        LD(F("Not caching the list of %s: modified too recently") % program);
+        return none;
+    }
+
+    std::ostringstream header;
+    header << "Content-Type: application/X-kyua-list; version=\"3\"\n";
+    header << "interface: " << test_program.interface_name() << '\n';
+    header << "program: " << program << '\n';
+    header << "device: " << static_cast< uint64_t >(sb.st_dev) << '\n';
+    header << "inode: " << static_cast< uint64_t >(sb.st_ino) << '\n';
+    header << "size: " << static_cast< uint64_t >(sb.st_size) << '\n';
+    header << "mtime: " << mtime.to_microseconds() << '\n';
+    for (config::properties_map::const_iterator iter = vars.begin();
+         iter != vars.end(); ++iter) {
+        header << "var: " << (*iter).first << '=' << (*iter).second << '\n';
+    }
+    header << '\n';
+    return utils::make_optional(header.str());
+}
+
+
+/// Loads the cached list of test cases of a test program.
+///
+/// \param directory The directory holding the cached lists.
+/// \param test_program The test program whose test cases to load.
+/// \param key The current key of the test program, as returned by
+///     cached_list_key().
+///
+/// \return The list of test cases, or none if there is no cached list for the
+/// test program or if it is out of date.
+optional< model::test_cases_map >
+engine::read_cached_list(const fs::path& directory,
+                         const model::test_program& test_program,
+                         const std::string& key)
+{
+    const fs::path path = cached_list_path(directory, test_program);
+
+    std::ifstream input(path.c_str());
+    if (!input)
+        return none;
+
+    std::string header;
+    std::string line;
+    while (std::getline(input, line).good()) {
+        header += line + '\n';
+        if (line.empty())
+            break;
+    }
+    if (header != key) {
+        LD(F("Cached list %s is out of date") % path);
+        return none;
+    }
+
+    try {
+        const model::test_cases_map test_cases = parse_cached_test_cases(input);
+        LD(F("Loaded test cases of %s from %s") % test_program.absolute_path() %
+           path);
+        return utils::make_optional(test_cases);
+    } catch (const std::runtime_error& e) {
+        LW(F("Ignoring invalid cached list %s: %s") % path % e.what());
+        return none;
+    }
+}
+
+
+/// Stores the list of test cases of a test program in the cache.
+///
+/// The file is replaced atomically so that concurrent readers never see a
+/// partially-written list.
+///
+/// \param directory The directory holding the cached lists.  Created if it
+///     does not exist.
+/// \param test_program The test program whose test cases to store.
+/// \param key The key of the test program, as returned by cached_list_key()
+///     before the test program was listed.
+/// \param test_cases The list of test cases of the test program.
+///
+/// \throw engine::error If the list cannot be stored.
+void
+engine::write_cached_list(const fs::path& directory,
+                          const model::test_program& test_program,
+                          const std::string& key,
+                          const model::test_cases_map& test_cases)
+{
+    std::ostringstream contents;
+    contents << key;
+    for (model::test_cases_map::const_iterator iter = test_cases.begin();
+         iter != test_cases.end(); ++iter) {
+        const model::test_case& test_case = (*iter).second;
+        // Only store what the test program reported so that the defaults and
+        // the metadata of the test program still apply when loading the list.
+        const model::properties_map props =
+            test_case.get_metadata().to_set_properties();
+        if (test_case.fake_result() || has_newlines(props) ||
+            (*iter).first.find('\n') != std::string::npos)
+            throw engine::error(F("Cannot cache test case %s") %
+                                (*iter).first);
+
+        contents << "ident: " << (*iter).first << '\n';
+        for (model::properties_map::const_iterator iter2 = props.begin();
+             iter2 != props.end(); ++iter2) {
+            contents << (*iter2).first << ": " << (*iter2).second << '\n';
+        }
+        contents << '\n';
+    }
+
+    try {
+        if (!fs::exists(directory))
+            fs::mkdir_p(directory, 0755);
+    } catch (const fs::error& e) {
+        throw engine::error(F("Cannot create %s: %s") % directory % e.what());
+    }
+
+    const fs::path path = cached_list_path(directory, test_program);
+    const fs::path temp_path(F("%s.%s") % path % ::getpid());
+    {
+        std::ofstream output(temp_path.c_str());
+        if (!output)
+            throw engine::error(F("Cannot create %s") % temp_path);
+        output << contents.str();
+        output.close();
+        if (!output) {
+            ::unlink(temp_path.c_str());
+            throw engine::error(F("Failed to write %s") % temp_path);
+        }
+    }
+    if (std::rename(temp_path.c_str(), path.c_str()) == -1) {
+        const int original_errno = errno;
+        ::unlink(temp_path.c_str());
+        throw engine::error(F("Cannot rename %s to %s: %s") % temp_path %
+                            path % std::strerror(original_errno));
+    }
+}
@@ -0,0 +1,60 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file engine/list_cache.hpp
+/// On-disk cache of the test case lists of test programs.
+///
+/// Listing the test cases of a test program requires executing it, which is
+/// costly when we only want to run one of its test cases.  The functions in
+/// this module store the lists obtained from test programs so that later runs
+/// can reuse them for as long as the test program binaries do not change.
+
+#if !defined(ENGINE_LIST_CACHE_HPP)
+#define ENGINE_LIST_CACHE_HPP
+
+#include <string>
+
+#include "model/test_case_fwd.hpp"
+#include "model/test_program_fwd.hpp"
+#include "utils/config/tree_fwd.hpp"
+#include "utils/fs/path_fwd.hpp"
+#include "utils/optional_fwd.hpp"
+
+namespace engine {
+
+
+utils::optional< std::string > cached_list_key(
+    const model::test_program&, const utils::config::properties_map&);
+utils::optional< model::test_cases_map > read_cached_list(
+    const utils::fs::path&, const model::test_program&, const std::string&);
+void write_cached_list(const utils::fs::path&, const model::test_program&,
+                       const std::string&, const model::test_cases_map&);
+
+}  // namespace engine
+
+#endif  // !defined(ENGINE_LIST_CACHE_HPP)
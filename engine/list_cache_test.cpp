@@ -0,0 +1,331 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "engine/list_cache.hpp"
+
+extern "C" {
+#include <utime.h>
+}
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <string>
+
+#include <atf-c++.hpp>
+
+#include "model/metadata.hpp"
+#include "model/test_case.hpp"
+#include "model/test_program.hpp"
+#include "utils/config/tree.ipp"
+#include "utils/datetime.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/optional.ipp"
+#include "utils/units.hpp"
+
+namespace config = utils::config;
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace units = utils::units;
+
+using utils::optional;
+
+
+namespace {
+
+
+/// Sets the modification time of a file.
+///
+/// \param file The file to modify.
+/// \param mtime The new modification time, in seconds since the epoch.
+static void
+set_mtime(const char* file, const long mtime)
+{
+    struct ::utimbuf times;
+    times.actime = mtime;
+    times.modtime = mtime;
+    ATF_REQUIRE(::utime(file, &times) != -1);
+}
+
+
+/// Creates a fake test program binary.
+///
+/// The binary gets a modification time in the past so that its list can be
+/// cached right away.
+///
+/// \param name Name of the binary to create in the current directory.
+/// \param contents Contents of the binary.
+///
+/// \return A test program that points to the binary.
+static model::test_program
+make_test_program(const char* name, const char* contents)
+{
+    std::ofstream output(name);
+    ATF_REQUIRE(output);
+    output << contents;
+    output.close();
+    set_mtime(name, 1000);
+
+    return model::test_program_builder(
+        "mock", fs::path(name), fs::current_path(), "the-suite").build();
+}
+
+
+/// Computes the key of a test program whose list can be cached.
+///
+/// \param program The test program to query.
+/// \param vars User-provided variables passed to the list operation.
+///
+/// \return The key of the test program.
+static std::string
+get_key(const model::test_program& program,
+        const config::properties_map& vars = config::properties_map())
+{
+    const optional< std::string > key = engine::cached_list_key(program, vars);
+    ATF_REQUIRE(key);
+    return key.get();
+}
+
+
+/// Constructs a list of test cases with non-default metadata.
+///
+/// \return A collection of test cases.
+static model::test_cases_map
+make_test_cases(void)
+{
+    return model::test_cases_map_builder()
+        .add("first")
+        .add("second", model::metadata_builder()
+             .add_allowed_architecture("i386")
+             .add_allowed_architecture("x86_64")
+             .add_custom("X-foo", "some value")
+             .set_description("Some long text")
+             .set_has_cleanup(true)
+             .set_required_memory(units::bytes(1024))
+             .set_required_user("root")
+             .set_timeout(datetime::delta(123, 0))
+             .build())
+        .build();
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(cached_list_key__recently_modified);
+ATF_TEST_CASE_BODY(cached_list_key__recently_modified)
+{
+    const model::test_program program = make_test_program("program", "abc");
+    set_mtime("program", static_cast< long >(std::time(NULL)));
+    ATF_REQUIRE(!engine::cached_list_key(program, config::properties_map()));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(cached_list_key__program_missing);
+ATF_TEST_CASE_BODY(cached_list_key__program_missing)
+{
+    const model::test_program program = make_test_program("program", "abc");
+    fs::unlink(fs::path("program"));
+    ATF_REQUIRE(!engine::cached_list_key(program, config::properties_map()));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(cached_list_key__multiline_var);
+ATF_TEST_CASE_BODY(cached_list_key__multiline_var)
+{
+    const model::test_program program = make_test_program("program", "abc");
+
+    config::properties_map vars;
+    vars["var1"] = "first\nsecond";
+    ATF_REQUIRE(!engine::cached_list_key(program, vars));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read_cached_list__missing);
+ATF_TEST_CASE_BODY(read_cached_list__missing)
+{
+    const model::test_program program = make_test_program("program", "abc");
+    ATF_REQUIRE(!engine::read_cached_list(fs::path("cache"), program,
+                                          get_key(program)));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(write_cached_list__round_trip);
+ATF_TEST_CASE_BODY(write_cached_list__round_trip)
+{
+    const model::test_program program = make_test_program("program", "abc");
+    const model::test_cases_map test_cases = make_test_cases();
+
+    config::properties_map vars;
+    vars["var1"] = "value1";
+    vars["var2"] = "value with spaces";
+
+    engine::write_cached_list(fs::path("cache/subdir"), program,
+                              get_key(program, vars), test_cases);
+    ATF_REQUIRE(fs::exists(fs::path("cache/subdir")));
+
+    const optional< model::test_cases_map > cached =
+        engine::read_cached_list(fs::path("cache/subdir"), program,
+                                 get_key(program, vars));
+    ATF_REQUIRE(cached);
+    ATF_REQUIRE(test_cases == cached.get());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read_cached_list__program_metadata);
+ATF_TEST_CASE_BODY(read_cached_list__program_metadata)
+{
+    const model::test_program program = make_test_program("program", "abc");
+    engine::write_cached_list(fs::path("cache"), program, get_key(program),
+                              make_test_cases());
+
+    const optional< model::test_cases_map > cached =
+        engine::read_cached_list(fs::path("cache"), program, get_key(program));
+    ATF_REQUIRE(cached);
+
+    const model::metadata program_md = model::metadata_builder()
+        .set_required_user("unprivileged")
+        .set_timeout(datetime::delta(5, 0))
+        .build();
+    const model::test_program loaded(
+        "mock", fs::path("program"), fs::current_path(), "the-suite",
+        program_md, cached.get());
+
+    const model::metadata first = loaded.find("first").get_metadata();
+    ATF_REQUIRE_EQ("unprivileged", first.required_user());
+    ATF_REQUIRE(datetime::delta(5, 0) == first.timeout());
+
+    const model::metadata second = loaded.find("second").get_metadata();
+    ATF_REQUIRE_EQ("root", second.required_user());
+    ATF_REQUIRE(datetime::delta(123, 0) == second.timeout());
+    ATF_REQUIRE_EQ("Some long text", second.description());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read_cached_list__program_changed);
+ATF_TEST_CASE_BODY(read_cached_list__program_changed)
+{
+    const model::test_program program = make_test_program("program", "abc");
+    engine::write_cached_list(fs::path("cache"), program, get_key(program),
+                              make_test_cases());
+    ATF_REQUIRE(engine::read_cached_list(fs::path("cache"), program,
+                                         get_key(program)));
+
+    make_test_program("program", "abcd");
+    ATF_REQUIRE(!engine::read_cached_list(fs::path("cache"), program,
+                                          get_key(program)));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read_cached_list__program_replaced);
+ATF_TEST_CASE_BODY(read_cached_list__program_replaced)
+{
+    const model::test_program program = make_test_program("program", "abc");
+    engine::write_cached_list(fs::path("cache"), program, get_key(program),
+                              make_test_cases());
+
+    // Same size and modification time; only the inode changes.
+    make_test_program("program.new", "xyz");
+    ATF_REQUIRE(std::rename("program.new", "program") != -1);
+    ATF_REQUIRE(!engine::read_cached_list(fs::path("cache"), program,
+                                          get_key(program)));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read_cached_list__other_program);
+ATF_TEST_CASE_BODY(read_cached_list__other_program)
+{
+    const model::test_program program1 = make_test_program("program1", "abc");
+    const model::test_program program2 = make_test_program("program2", "abc");
+    engine::write_cached_list(fs::path("cache"), program1, get_key(program1),
+                              make_test_cases());
+    ATF_REQUIRE(engine::read_cached_list(fs::path("cache"), program1,
+                                         get_key(program1)));
+    ATF_REQUIRE(!engine::read_cached_list(fs::path("cache"), program2,
+                                          get_key(program2)));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read_cached_list__vars_changed);
+ATF_TEST_CASE_BODY(read_cached_list__vars_changed)
+{
+    const model::test_program program = make_test_program("program", "abc");
+
+    config::properties_map vars;
+    vars["var1"] = "value1";
+    engine::write_cached_list(fs::path("cache"), program,
+                              get_key(program, vars), make_test_cases());
+
+    vars["var1"] = "value2";
+    ATF_REQUIRE(!engine::read_cached_list(fs::path("cache"), program,
+                                          get_key(program, vars)));
+    ATF_REQUIRE(!engine::read_cached_list(fs::path("cache"), program,
+                                          get_key(program)));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read_cached_list__invalid_contents);
+ATF_TEST_CASE_BODY(read_cached_list__invalid_contents)
+{
+    const model::test_program program = make_test_program("program", "abc");
+    engine::write_cached_list(fs::path("cache"), program, get_key(program),
+                              make_test_cases());
+
+    // Locate the cached list through its mangled name.
+    std::string name = (fs::current_path() / "program").str();
+    for (std::string::iterator iter = name.begin(); iter != name.end();
+         ++iter) {
+        if (*iter == '/')
+            *iter = '_';
+    }
+    std::ofstream output((fs::path("cache") / (name + ".list")).c_str(),
+                         std::ios::app);
+    ATF_REQUIRE(output);
+    output << "ident: third\ntimeout: not-a-number\n\n";
+    output.close();
+
+    ATF_REQUIRE(!engine::read_cached_list(fs::path("cache"), program,
+                                          get_key(program)));
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, cached_list_key__recently_modified);
+    ATF_ADD_TEST_CASE(tcs, cached_list_key__program_missing);
+    ATF_ADD_TEST_CASE(tcs, cached_list_key__multiline_var);
+    ATF_ADD_TEST_CASE(tcs, read_cached_list__missing);
+    ATF_ADD_TEST_CASE(tcs, write_cached_list__round_trip);
+    ATF_ADD_TEST_CASE(tcs, read_cached_list__program_metadata);
+    ATF_ADD_TEST_CASE(tcs, read_cached_list__program_changed);
+    ATF_ADD_TEST_CASE(tcs, read_cached_list__program_replaced);
+    ATF_ADD_TEST_CASE(tcs, read_cached_list__other_program);
+    ATF_ADD_TEST_CASE(tcs, read_cached_list__vars_changed);
+    ATF_ADD_TEST_CASE(tcs, read_cached_list__invalid_contents);
+}
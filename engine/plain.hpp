@@ -48,6 +48,9 @@ public:
         const utils::fs::path&,
         const utils::fs::path&) const;
 
+    utils::optional< model::test_cases_map > fixed_test_cases(
+        const model::test_program&) const;
+
     void exec_test(const model::test_program&, const std::string&,
                    const utils::config::properties_map&,
                    const utils::fs::path&) const
@@ -28,27 +28,39 @@
 
 #include "engine/requirements.hpp"
 
+#include <map>
+#include <utility>
+
 #include "model/metadata.hpp"
 #include "model/types.hpp"
 #include "utils/config/nodes.ipp"
 #include "utils/config/tree.ipp"
+#include "utils/datetime.hpp"
 #include "utils/format/macros.hpp"
 #include "utils/fs/operations.hpp"
 #include "utils/fs/path.hpp"
 #include "utils/memory.hpp"
+#include "utils/optional.ipp"
 #include "utils/passwd.hpp"
 #include "utils/sanity.hpp"
 #include "utils/units.hpp"
 
 namespace config = utils::config;
+namespace datetime = utils::datetime;
 namespace fs = utils::fs;
 namespace passwd = utils::passwd;
 namespace units = utils::units;
 
+using utils::optional;
+
 
 namespace {
 
 
+/// Period of time during which a free disk space query can be reused.
+static const datetime::delta disk_space_ttl(1, 0);
+
+
 /// Checks if all required configuration variables are present.
 ///
 /// \param required_configs Set of required variable names.
@@ -121,35 +133,6 @@ check_allowed_platforms(const model::strings_set& allowed_platforms,
 }
 
 
-/// Checks if the current user matches the required user.
-///
-/// \param required_user Name of the required user category.
-/// \param user_config Runtime user configuration.
-///
-/// \return Empty if the current user fits the required user characteristics or
-/// an error message otherwise.
-static std::string
-check_required_user(const std::string& required_user,
-                    const config::tree& user_config)
-{
-    if (!required_user.empty()) {
-        const passwd::user user = passwd::current_user();
-        if (required_user == "root") {
-            if (!user.is_root())
-                return "Requires root privileges";
-        } else if (required_user == "unprivileged") {
-            if (user.is_root())
-                if (!user_config.is_set("unprivileged_user"))
-                    return "Requires an unprivileged user but the "
-                        "unprivileged-user configuration variable is not "
-                        "defined";
-        } else
-            UNREACHABLE_MSG("Value of require.user not properly validated");
-    }
-    return "";
-}
-
-
 /// Checks if all required files exist.
 ///
 /// \param required_files Set of paths.
@@ -168,75 +151,209 @@ check_required_files(const model::paths_set& required_files)
 }
 
 
-/// Checks if all required programs exist.
-///
-/// \param required_programs Set of paths.
-///
-/// \return Empty if the required programs all exist or an error message
-/// otherwise.
-static std::string
-check_required_programs(const model::paths_set& required_programs)
-{
-    for (model::paths_set::const_iterator iter = required_programs.begin();
-         iter != required_programs.end(); iter++) {
-        if ((*iter).is_absolute()) {
-            if (!fs::exists(*iter))
-                return F("Required program '%s' not found") % *iter;
-        } else {
-            if (!fs::find_in_path((*iter).c_str()))
-                return F("Required program '%s' not found in PATH") % *iter;
+}  // anonymous namespace
+
+
+/// Internal implementation of the requirements_checker.
+struct engine::requirements_checker::impl : utils::noncopyable {
+    /// Collection of memoized program lookups keyed by the required path.
+    typedef std::map< fs::path, bool > programs_map;
+
+    /// Free disk space of a directory and the time at which it was queried.
+    typedef std::pair< datetime::timestamp, units::bytes > disk_space_entry;
+
+    /// Collection of memoized disk space queries keyed by directory.
+    typedef std::map< fs::path, disk_space_entry > disk_space_map;
+
+    /// Whether each required program has been found or not.
+    programs_map _programs;
+
+    /// The current user, if already queried.
+    optional< passwd::user > _current_user;
+
+    /// The amount of physical memory, if already queried.
+    optional< units::bytes > _physical_memory;
+
+    /// Free disk space of the work directories checked so far.
+    disk_space_map _disk_space;
+
+    /// Returns the current user, querying it only once.
+    ///
+    /// \return The current user.
+    const passwd::user&
+    current_user(void)
+    {
+        if (!_current_user)
+            _current_user = passwd::current_user();
+        return _current_user.get();
+    }
+
+    /// Checks if a required program exists, querying the system only once.
+    ///
+    /// \param program The required program; if relative, it is looked up in
+    ///     the PATH.
+    ///
+    /// \return True if the program exists; false otherwise.
+    bool
+    program_exists(const fs::path& program)
+    {
+        const programs_map::const_iterator iter = _programs.find(program);
+        if (iter != _programs.end())
+            return (*iter).second;
+
+        bool exists;
+        if (program.is_absolute())
+            exists = fs::exists(program);
+        else
+            exists = static_cast< bool >(fs::find_in_path(program.c_str()));
+        _programs.insert(programs_map::value_type(program, exists));
+        return exists;
+    }
+
+    /// Returns the amount of physical memory, querying it only once.
+    ///
+    /// \return The amount of physical memory, or zero if unknown.
+    const units::bytes&
+    physical_memory(void)
+    {
+        if (!_physical_memory)
+            _physical_memory = utils::physical_memory();
+        return _physical_memory.get();
+    }
+
+    /// Returns the free disk space of a directory.
+    ///
+    /// Unlike the other queries, the free disk space changes while tests run,
+    /// so the memoized values are only reused for a short period of time.
+    ///
+    /// \param directory The directory to query.
+    ///
+    /// \return The free disk space of the file system hosting directory.
+    units::bytes
+    free_disk_space(const fs::path& directory)
+    {
+        const datetime::timestamp now = datetime::timestamp::now();
+
+        const disk_space_map::const_iterator iter = _disk_space.find(directory);
+        if (iter != _disk_space.end()) {
+            const datetime::timestamp& queried = (*iter).second.first;
+            if (queried <= now && now - queried < disk_space_ttl)
+                return (*iter).second.second;
         }
+
+        const units::bytes free_space = fs::free_disk_space(directory);
+        _disk_space.erase(directory);
+        _disk_space.insert(disk_space_map::value_type(
+            directory, disk_space_entry(now, free_space)));
+        return free_space;
     }
-    return "";
-}
 
+    /// Checks if the current user matches the required user.
+    ///
+    /// \param required_user Name of the required user category.
+    /// \param user_config Runtime user configuration.
+    ///
+    /// \return Empty if the current user fits the required user
+    /// characteristics or an error message otherwise.
+    std::string
+    check_required_user(const std::string& required_user,
+                        const config::tree& user_config)
+    {
+        if (!required_user.empty()) {
+            const passwd::user& user = current_user();
+            if (required_user == "root") {
+                if (!user.is_root())
+                    return "Requires root privileges";
+            } else if (required_user == "unprivileged") {
+                if (user.is_root())
+                    if (!user_config.is_set("unprivileged_user"))
+                        return "Requires an unprivileged user but the "
+                            "unprivileged-user configuration variable is not "
+                            "defined";
+            } else
+                UNREACHABLE_MSG("Value of require.user not properly "
+                                "validated");
+        }
+        return "";
+    }
 
-/// Checks if the current system has the specified amount of memory.
-///
-/// \param required_memory Amount of required physical memory, or zero if not
-///     applicable.
-///
-/// \return Empty if the current system has the required amount of memory or an
-/// error message otherwise.
-static std::string
-check_required_memory(const units::bytes& required_memory)
-{
-    if (required_memory > 0) {
-        const units::bytes physical_memory = utils::physical_memory();
-        if (physical_memory > 0 && physical_memory < required_memory)
-            return F("Requires %s bytes of physical memory but only %s "
-                     "available") %
-                required_memory.format() % physical_memory.format();
+    /// Checks if all required programs exist.
+    ///
+    /// \param required_programs Set of paths.
+    ///
+    /// \return Empty if the required programs all exist or an error message
+    /// otherwise.
+    std::string
+    check_required_programs(const model::paths_set& required_programs)
+    {
+        for (model::paths_set::const_iterator iter = required_programs.begin();
+             iter != required_programs.end(); iter++) {
+            if (!program_exists(*iter)) {
+                if ((*iter).is_absolute())
+                    return F("Required program '%s' not found") % *iter;
+                else
+                    return F("Required program '%s' not found in PATH") %
+                        *iter;
+            }
+        }
+        return "";
     }
-    return "";
-}
 
+    /// Checks if the current system has the specified amount of memory.
+    ///
+    /// \param required_memory Amount of required physical memory, or zero if
+    ///     not applicable.
+    ///
+    /// \return Empty if the current system has the required amount of memory
+    /// or an error message otherwise.
+    std::string
+    check_required_memory(const units::bytes& required_memory)
+    {
+        if (required_memory > 0) {
+            const units::bytes& available = physical_memory();
+            if (available > 0 && available < required_memory)
+                return F("Requires %s bytes of physical memory but only %s "
+                         "available") %
+                    required_memory.format() % available.format();
+        }
+        return "";
+    }
 
-/// Checks if the work directory's file system has enough free disk space.
-///
-/// \param required_disk_space Amount of required free disk space, or zero if
-///     not applicable.
-/// \param work_directory Path to where the test case will be run.
-///
-/// \return Empty if the file system where the work directory is hosted has
-/// enough free disk space or an error message otherwise.
-static std::string
-check_required_disk_space(const units::bytes& required_disk_space,
-                          const fs::path& work_directory)
-{
-    if (required_disk_space > 0) {
-        const units::bytes free_disk_space = fs::free_disk_space(
-            work_directory);
-        if (free_disk_space < required_disk_space)
-            return F("Requires %s bytes of free disk space but only %s "
-                     "available") %
-                required_disk_space.format() % free_disk_space.format();
+    /// Checks if the work directory's file system has enough free disk space.
+    ///
+    /// \param required_disk_space Amount of required free disk space, or zero
+    ///     if not applicable.
+    /// \param work_directory Path to where the test case will be run.
+    ///
+    /// \return Empty if the file system where the work directory is hosted
+    /// has enough free disk space or an error message otherwise.
+    std::string
+    check_required_disk_space(const units::bytes& required_disk_space,
+                              const fs::path& work_directory)
+    {
+        if (required_disk_space > 0) {
+            const units::bytes available = free_disk_space(work_directory);
+            if (available < required_disk_space)
+                return F("Requires %s bytes of free disk space but only %s "
+                         "available") %
+                    required_disk_space.format() % available.format();
+        }
+        return "";
     }
-    return "";
+};
+
+
+/// Constructor.
+engine::requirements_checker::requirements_checker(void) :
+    _pimpl(new impl())
+{
 }
 
 
-}  // anonymous namespace
+/// Destructor.
+engine::requirements_checker::~requirements_checker(void)
+{
+}
 
 
 /// Checks if all the requirements specified by the test case are met.
@@ -249,9 +366,10 @@ check_required_disk_space(const units::bytes& required_disk_space,
 /// \return A string describing the reason for skipping the test, or empty if
 /// the test should be executed.
 std::string
-engine::check_reqs(const model::metadata& md, const config::tree& cfg,
-                   const std::string& test_suite,
-                   const fs::path& work_directory)
+engine::requirements_checker::check(const model::metadata& md,
+                                    const config::tree& cfg,
+                                    const std::string& test_suite,
+                                    const fs::path& work_directory)
 {
     std::string reason;
 
@@ -267,7 +385,7 @@ engine::check_reqs(const model::metadata& md, const config::tree& cfg,
     if (!reason.empty())
         return reason;
 
-    reason = check_required_user(md.required_user(), cfg);
+    reason = _pimpl->check_required_user(md.required_user(), cfg);
     if (!reason.empty())
         return reason;
 
@@ -275,19 +393,41 @@ engine::check_reqs(const model::metadata& md, const config::tree& cfg,
     if (!reason.empty())
         return reason;
 
-    reason = check_required_programs(md.required_programs());
+    reason = _pimpl->check_required_programs(md.required_programs());
     if (!reason.empty())
         return reason;
 
-    reason = check_required_memory(md.required_memory());
+    reason = _pimpl->check_required_memory(md.required_memory());
     if (!reason.empty())
         return reason;
 
-    reason = check_required_disk_space(md.required_disk_space(),
-                                       work_directory);
+    reason = _pimpl->check_required_disk_space(md.required_disk_space(),
+                                               work_directory);
     if (!reason.empty())
         return reason;
 
     INV(reason.empty());
     return reason;
 }
+
+
+/// Checks if all the requirements specified by the test case are met.
+///
+/// This is a convenience wrapper over requirements_checker for callers that
+/// only need to check a single test case.
+///
+/// \param md The test metadata.
+/// \param cfg The engine configuration.
+/// \param test_suite Name of the test suite the test belongs to.
+/// \param work_directory Path to where the test case will be run.
+///
+/// \return A string describing the reason for skipping the test, or empty if
+/// the test should be executed.
+std::string
+engine::check_reqs(const model::metadata& md, const config::tree& cfg,
+                   const std::string& test_suite,
+                   const fs::path& work_directory)
+{
+    requirements_checker checker;
+    return checker.check(md, cfg, test_suite, work_directory);
+}
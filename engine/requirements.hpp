@@ -37,10 +37,34 @@
 #include "model/metadata_fwd.hpp"
 #include "utils/config/tree_fwd.hpp"
 #include "utils/fs/path_fwd.hpp"
+#include "utils/noncopyable.hpp"
+#include "utils/shared_ptr.hpp"
 
 namespace engine {
 
 
+/// Evaluator of test case requirements with memoized system queries.
+///
+/// Checking the requirements of a test case may involve expensive queries to
+/// the system, such as looking up programs in the PATH or computing the free
+/// disk space of a file system.  Instances of this class remember the results
+/// of these queries so that checking the requirements of many test cases only
+/// pays for each distinct query once.
+class requirements_checker : utils::noncopyable {
+    struct impl;
+
+    /// Pointer to the shared internal implementation.
+    std::shared_ptr< impl > _pimpl;
+
+public:
+    requirements_checker(void);
+    ~requirements_checker(void);
+
+    std::string check(const model::metadata&, const utils::config::tree&,
+                      const std::string&, const utils::fs::path&);
+};
+
+
 std::string check_reqs(const model::metadata&, const utils::config::tree&,
                        const std::string&, const utils::fs::path&);
 
@@ -478,6 +478,53 @@ ATF_TEST_CASE_BODY(check_reqs__required_programs__fail_relative)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(requirements_checker__memoizes_programs);
+ATF_TEST_CASE_BODY(requirements_checker__memoizes_programs)
+{
+    const model::metadata md = model::metadata_builder()
+        .add_required_program(fs::path("foo"))
+        .build();
+
+    fs::mkdir(fs::path("bin"), 0755);
+    atf::utils::create_file("bin/foo", "");
+    utils::setenv("PATH", (fs::current_path() / "bin").str());
+
+    engine::requirements_checker checker;
+    ATF_REQUIRE(checker.check(md, engine::empty_config(), "",
+                              fs::path(".")).empty());
+
+    fs::unlink(fs::path("bin/foo"));
+    ATF_REQUIRE(checker.check(md, engine::empty_config(), "",
+                              fs::path(".")).empty());
+
+    engine::requirements_checker fresh_checker;
+    ATF_REQUIRE_MATCH("'foo' not found in PATH$",
+                      fresh_checker.check(md, engine::empty_config(), "",
+                                          fs::path(".")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(requirements_checker__memoizes_user);
+ATF_TEST_CASE_BODY(requirements_checker__memoizes_user)
+{
+    const model::metadata md = model::metadata_builder()
+        .set_required_user("root")
+        .build();
+
+    engine::requirements_checker checker;
+
+    passwd::set_current_user_for_testing(passwd::user("", 123, 1));
+    ATF_REQUIRE_MATCH("Requires root privileges",
+                      checker.check(md, engine::empty_config(), "",
+                                    fs::path(".")));
+
+    passwd::set_current_user_for_testing(passwd::user("", 0, 1));
+    ATF_REQUIRE_MATCH("Requires root privileges",
+                      checker.check(md, engine::empty_config(), "",
+                                    fs::path(".")));
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, check_reqs__none);
@@ -508,4 +555,7 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, check_reqs__required_programs__ok);
     ATF_ADD_TEST_CASE(tcs, check_reqs__required_programs__fail_absolute);
     ATF_ADD_TEST_CASE(tcs, check_reqs__required_programs__fail_relative);
+
+    ATF_ADD_TEST_CASE(tcs, requirements_checker__memoizes_programs);
+    ATF_ADD_TEST_CASE(tcs, requirements_checker__memoizes_user);
 }
@@ -158,7 +158,18 @@ struct engine::scanner::impl : utils::noncopyable {
     {
         const std::string test_case_name = first_test_cases.get()[0];
         first_test_cases.get().pop_front();
-        return scan_result(pending_test_programs[0], test_case_name);
+        const engine::scan_result result(pending_test_programs[0],
+                                         test_case_name);
+
+        // Forget about the test program as soon as we have returned all of its
+        // test cases so that it can be released once the caller is done with
+        // the results.
+        if (first_test_cases.get().empty()) {
+            pending_test_programs.pop_front();
+            first_test_cases = none;
+        }
+
+        return result;
     }
 };
 
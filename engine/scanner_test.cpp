@@ -332,6 +332,41 @@ ATF_TEST_CASE_BODY(scanner__no_filters__verify_lazy_loads)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(scanner__no_filters__release_programs);
+ATF_TEST_CASE_BODY(scanner__no_filters__release_programs)
+{
+    model::test_programs_vector test_programs;
+    test_programs.push_back(new_test_program(
+        "dir/program-1", "first_test", "second_test", NULL));
+    test_programs.push_back(new_test_program(
+        "dir/program-2", "first_test", NULL));
+
+    const std::set< engine::test_filter > filters;
+
+    engine::scanner scanner(test_programs, filters);
+    const model::test_program_ptr program1 = test_programs[0];
+    test_programs.clear();
+
+    {
+        optional< engine::scan_result > result = scanner.yield();
+        ATF_REQUIRE(result);
+        ATF_REQUIRE_EQ(program1, result.get().first);
+        ATF_REQUIRE(program1.use_count() > 2);
+    }
+    {
+        optional< engine::scan_result > result = scanner.yield();
+        ATF_REQUIRE(result);
+        ATF_REQUIRE_EQ(program1, result.get().first);
+    }
+    // The scanner must not keep the first program once it has returned all of
+    // its test cases, even before the next one is requested.
+    ATF_REQUIRE_EQ(1, program1.use_count());
+
+    ATF_REQUIRE(scanner.yield());
+    ATF_REQUIRE(!scanner.yield());
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(scanner__with_filters__no_tests);
 ATF_TEST_CASE_BODY(scanner__with_filters__no_tests)
 {
@@ -468,6 +503,7 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, scanner__no_filters__many_tests_in_one_program);
     ATF_ADD_TEST_CASE(tcs, scanner__no_filters__many_tests_per_many_programs);
     ATF_ADD_TEST_CASE(tcs, scanner__no_filters__verify_lazy_loads);
+    ATF_ADD_TEST_CASE(tcs, scanner__no_filters__release_programs);
 
     ATF_ADD_TEST_CASE(tcs, scanner__with_filters__no_tests);
     ATF_ADD_TEST_CASE(tcs, scanner__with_filters__no_matches);
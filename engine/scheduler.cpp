@@ -35,10 +35,14 @@ extern "C" {
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
+#include <map>
+#include <set>
 #include <stdexcept>
+#include <utility>
 
 #include "engine/config.hpp"
 #include "engine/exceptions.hpp"
+#include "engine/list_cache.hpp"
 #include "engine/requirements.hpp"
 #include "model/context.hpp"
 #include "model/metadata.hpp"
@@ -206,6 +210,9 @@ struct test_exec_data : public exec_data {
     /// denote that no further attempts shall be made at cleaning this up.
     bool needs_cleanup;
 
+    /// Path to the file that captures the stdout of the test.
+    const fs::path stdout_file;
+
     /// The exit_handle for this test once it has completed.
     ///
     /// This is set externally when the test case has finished, as we need this
@@ -219,12 +226,16 @@ struct test_exec_data : public exec_data {
     /// \param test_case_name_ Name of the test case.
     /// \param interface_ Test program-specific execution interface.
     /// \param user_config_ User configuration passed to the test.
+    /// \param stdout_file_ Path to the file that captures the stdout of the
+    ///     test.
     test_exec_data(const model::test_program_ptr test_program_,
                    const std::string& test_case_name_,
                    const std::shared_ptr< scheduler::interface >& interface_,
-                   const config::tree& user_config_) :
+                   const config::tree& user_config_,
+                   const fs::path& stdout_file_) :
         exec_data(test_program_, test_case_name_),
-        interface(interface_), user_config(user_config_)
+        interface(interface_), user_config(user_config_),
+        stdout_file(stdout_file_)
     {
         const model::test_case& test_case = test_program->find(test_case_name);
         needs_cleanup = test_case.get_metadata().has_cleanup();
@@ -277,6 +288,19 @@ typedef std::shared_ptr< exec_data > exec_data_ptr;
 typedef std::map< int, exec_data_ptr > exec_data_map;
 
 
+/// Pair of a test program as provided by the caller and its absolute copy.
+///
+/// The original test program is only weakly referenced so that the scheduler
+/// does not extend its lifetime.
+typedef std::pair< std::weak_ptr< model::test_program >,
+                   model::test_program_ptr > absolute_program_pair;
+
+
+/// Mapping of test programs to their copies with absolute paths.
+typedef std::map< const model::test_program*, absolute_program_pair >
+    absolute_programs_map;
+
+
 /// Enforces a test program to hold an absolute path.
 ///
 /// TODO(jmmv): This function (which is a pretty ugly hack) exists because we
@@ -352,8 +376,8 @@ class run_test_program {
     /// Interface of the test program to execute.
     std::shared_ptr< scheduler::interface > _interface;
 
-    /// Test program to execute.
-    const model::test_program _test_program;
+    /// Test program to execute, with absolute paths.
+    const model::test_program_ptr _test_program;
 
     /// Name of the test case to execute.
     const std::string& _test_case_name;
@@ -361,13 +385,17 @@ class run_test_program {
     /// User-provided configuration variables.
     const config::tree& _user_config;
 
+    /// Whether the requirements of the test case were checked by the parent.
+    const bool _requirements_checked;
+
     /// Verifies if the test case needs to be skipped or not.
     ///
-    /// We could very well run this on the scheduler parent process before
-    /// issuing the fork.  However, doing this here in the child process is
-    /// better for two reasons: first, it allows us to continue using the simple
-    /// spawn/wait abstraction of the scheduler; and, second, we parallelize the
-    /// requirements checks among tests.
+    /// This is only done if the caller did not already check the requirements
+    /// of the test case in the parent process with
+    /// scheduler_handle::check_requirements(), which is the preferred approach
+    /// because it avoids spawning subprocesses for skipped tests.  Checking in
+    /// the child keeps the simple spawn/wait abstraction of the scheduler for
+    /// any other callers.
     ///
     /// \post If the test's preconditions are not met, the caller process is
     /// terminated with a special exit code and a "skipped cookie" is written to
@@ -378,12 +406,12 @@ class run_test_program {
     void
     do_requirements_check(const fs::path& skipped_cookie_path)
     {
-        const model::test_case& test_case = _test_program.find(
+        const model::test_case& test_case = _test_program->find(
             _test_case_name);
 
         const std::string skip_reason = engine::check_reqs(
             test_case.get_metadata(), _user_config,
-            _test_program.test_suite_name(),
+            _test_program->test_suite_name(),
             fs::current_path());
         if (skip_reason.empty())
             return;
@@ -407,18 +435,23 @@ public:
     /// Constructor.
     ///
     /// \param interface Interface of the test program to execute.
-    /// \param test_program Test program to execute.
+    /// \param test_program Test program to execute, as returned by
+    ///     scheduler_handle::impl::absolute_program().
     /// \param test_case_name Name of the test case to execute.
     /// \param user_config User-provided configuration variables.
+    /// \param requirements_checked Whether the requirements of the test case
+    ///     were already checked by the parent process.
     run_test_program(
         const std::shared_ptr< scheduler::interface > interface,
         const model::test_program_ptr test_program,
         const std::string& test_case_name,
-        const config::tree& user_config) :
+        const config::tree& user_config,
+        const bool requirements_checked) :
         _interface(interface),
-        _test_program(force_absolute_paths(*test_program)),
+        _test_program(test_program),
         _test_case_name(test_case_name),
-        _user_config(user_config)
+        _user_config(user_config),
+        _requirements_checked(requirements_checked)
     {
     }
 
@@ -426,16 +459,17 @@ public:
     void
     operator()(const fs::path& control_directory)
     {
-        const model::test_case& test_case = _test_program.find(
+        const model::test_case& test_case = _test_program->find(
             _test_case_name);
         if (test_case.fake_result())
             ::_exit(EXIT_SUCCESS);
 
-        do_requirements_check(control_directory / skipped_cookie);
+        if (!_requirements_checked)
+            do_requirements_check(control_directory / skipped_cookie);
 
         const config::properties_map vars = scheduler::generate_config(
-            _user_config, _test_program.test_suite_name());
-        _interface->exec_test(_test_program, _test_case_name, vars,
+            _user_config, _test_program->test_suite_name());
+        _interface->exec_test(*_test_program, _test_case_name, vars,
                               control_directory);
     }
 };
@@ -446,8 +480,8 @@ class run_test_cleanup {
     /// Interface of the test program to execute.
     std::shared_ptr< scheduler::interface > _interface;
 
-    /// Test program to execute.
-    const model::test_program _test_program;
+    /// Test program to execute, with absolute paths.
+    const model::test_program_ptr _test_program;
 
     /// Name of the test case to execute.
     const std::string& _test_case_name;
@@ -459,7 +493,8 @@ public:
     /// Constructor.
     ///
     /// \param interface Interface of the test program to execute.
-    /// \param test_program Test program to execute.
+    /// \param test_program Test program to execute, as returned by
+    ///     scheduler_handle::impl::absolute_program().
     /// \param test_case_name Name of the test case to execute.
     /// \param user_config User-provided configuration variables.
     run_test_cleanup(
@@ -468,7 +503,7 @@ public:
         const std::string& test_case_name,
         const config::tree& user_config) :
         _interface(interface),
-        _test_program(force_absolute_paths(*test_program)),
+        _test_program(test_program),
         _test_case_name(test_case_name),
         _user_config(user_config)
     {
@@ -479,8 +514,8 @@ public:
     operator()(const fs::path& control_directory)
     {
         const config::properties_map vars = scheduler::generate_config(
-            _user_config, _test_program.test_suite_name());
-        _interface->exec_cleanup(_test_program, _test_case_name, vars,
+            _user_config, _test_program->test_suite_name());
+        _interface->exec_cleanup(*_test_program, _test_case_name, vars,
                                  control_directory);
     }
 };
@@ -503,6 +538,20 @@ find_interface(const std::string& name)
 }  // anonymous namespace
 
 
+/// Returns the test cases list of a test program without executing it.
+///
+/// \param unused_test_program The test program to query.
+///
+/// \return Always none, as most test interfaces can only learn the test cases
+/// of a test program by executing it.
+optional< model::test_cases_map >
+scheduler::interface::fixed_test_cases(
+    const model::test_program& UTILS_UNUSED_PARAM(test_program)) const
+{
+    return none;
+}
+
+
 void
 scheduler::interface::exec_cleanup(
     const model::test_program& UTILS_UNUSED_PARAM(test_program),
@@ -794,6 +843,23 @@ struct engine::scheduler::scheduler_handle::impl : utils::noncopyable {
     /// Mapping of exec handles to the data required at run time.
     exec_data_map all_exec_data;
 
+    /// Cache of the test programs passed to the subprocesses.
+    ///
+    /// Entries are created on the first spawn of any test case of a program.
+    /// They only hold weak references to the original test programs and are
+    /// discarded when spawning a new program if their original is gone.
+    absolute_programs_map absolute_programs;
+
+    /// Memoized evaluator of the requirements of the test cases.
+    engine::requirements_checker requirements_checker;
+
+    /// Test cases whose requirements have been checked but not yet spawned.
+    ///
+    /// The test programs are only used as keys and are never dereferenced.
+    /// Entries are removed when the test case is spawned.
+    std::set< std::pair< const model::test_program*, std::string > >
+        checked_tests;
+
     /// Collection of test_exec_data objects.
     typedef std::vector< const test_exec_data* > test_exec_data_vector;
 
@@ -853,6 +919,56 @@ struct engine::scheduler::scheduler_handle::impl : utils::noncopyable {
         return tests_data;
     }
 
+    /// Gets the version of a test program to pass to the subprocesses.
+    ///
+    /// The subprocesses need a test program with absolute paths; see
+    /// force_absolute_paths() for details.  Building such a program copies
+    /// all of its test cases, so we do it only once per program and share the
+    /// result across all the test cases and cleanup routines that we spawn
+    /// for it.  Otherwise, running all the test cases of a program would take
+    /// quadratic time on the number of test cases.
+    ///
+    /// \param test_program The test program as provided by the caller.
+    ///
+    /// \return A test program with absolute paths.
+    model::test_program_ptr
+    absolute_program(const model::test_program_ptr test_program)
+    {
+        const absolute_programs_map::const_iterator iter =
+            absolute_programs.find(test_program.get());
+        if (iter != absolute_programs.end() &&
+            !(*iter).second.first.expired())
+            return (*iter).second.second;
+
+        prune_absolute_programs();
+
+        const model::test_program_ptr absolute(new model::test_program(
+            force_absolute_paths(*test_program)));
+        absolute_programs.insert(absolute_programs_map::value_type(
+            test_program.get(), absolute_program_pair(test_program,
+                                                      absolute)));
+        return absolute;
+    }
+
+    /// Discards the absolute copies of test programs that are gone.
+    ///
+    /// A test program is gone once the caller no longer holds it and none of
+    /// its test cases or cleanup routines are in flight, as the exec_data
+    /// objects reference it.  This keeps the memory used by the cache bounded
+    /// by the test programs in use instead of by all the test programs seen
+    /// during the lifetime of the scheduler.
+    void
+    prune_absolute_programs(void)
+    {
+        absolute_programs_map::iterator iter = absolute_programs.begin();
+        while (iter != absolute_programs.end()) {
+            if ((*iter).second.first.expired())
+                absolute_programs.erase(iter++);
+            else
+                ++iter;
+        }
+    }
+
     /// Cleans up a single test case synchronously.
     ///
     /// \param test_data The data of the previously executed test case to be
@@ -900,8 +1016,8 @@ struct engine::scheduler::scheduler_handle::impl : utils::noncopyable {
            test_case_name);
 
         const executor::exec_handle handle = generic.spawn_followup(
-            run_test_cleanup(interface, test_program, test_case_name,
-                             user_config),
+            run_test_cleanup(interface, absolute_program(test_program),
+                             test_case_name, user_config),
             body_handle, cleanup_timeout);
 
         const exec_data_ptr data(new cleanup_exec_data(
@@ -910,6 +1026,134 @@ struct engine::scheduler::scheduler_handle::impl : utils::noncopyable {
 
         return handle;
     }
+
+    /// Processes the termination of a subprocess.
+    ///
+    /// Note that if the terminated test case has a cleanup routine, this
+    /// function is the one in charge of spawning the cleanup routine
+    /// asynchronously.
+    ///
+    /// \param handle The exit handle of the terminated subprocess.
+    ///
+    /// \return The result of the execution of a test case, or NULL if the
+    /// subprocess was a test case body that needs its cleanup routine to run
+    /// before its result can be reported.
+    result_handle_ptr
+    process_exit(executor::exit_handle handle)
+    {
+        const exec_data_map::iterator iter = all_exec_data.find(
+            handle.original_pid());
+        exec_data_ptr& data = (*iter).second;
+
+        utils::dump_stacktrace_if_available(
+            data->test_program->absolute_path(), generic, handle);
+
+        optional< model::test_result > result;
+        try {
+            test_exec_data* test_data = &dynamic_cast< test_exec_data& >(
+                *data.get());
+
+            test_data->exit_handle = handle;
+
+            const model::test_case& test_case = test_data->test_program->find(
+                test_data->test_case_name);
+
+            result = test_case.fake_result();
+
+            if (!result && handle.status() && handle.status().get().exited() &&
+                handle.status().get().exitstatus() == exit_skipped) {
+                // If the test's process terminated with our magic
+                // "exit_skipped" status, there are two cases to handle.  The
+                // first is the case where the "skipped cookie" exists, in
+                // which case we never got to actually invoke the test program;
+                // if that's the case, handle it here.  The second case is where
+                // the test case actually decided to exit with the
+                // "exit_skipped" status; in that case, just fall back to the
+                // regular status handling.
+                const fs::path skipped_cookie_path =
+                    handle.control_directory() / skipped_cookie;
+                std::ifstream input(skipped_cookie_path.c_str());
+                if (input) {
+                    result = model::test_result(model::test_result_skipped,
+                                                utils::read_stream(input));
+                    input.close();
+
+                    // If we determined that the test needs to be skipped, we
+                    // do not want to run the cleanup routine because doing so
+                    // could result in errors.  However, we still want to run
+                    // the cleanup routine if the test's body reports a skip
+                    // (because actions could have already been taken).
+                    test_data->needs_cleanup = false;
+                }
+            }
+            if (!result) {
+                result = test_data->interface->compute_result(
+                    handle.status(),
+                    handle.control_directory(),
+                    handle.stdout_file(),
+                    handle.stderr_file());
+            }
+            INV(result);
+
+            if (!result.get().good()) {
+                append_files_listing(handle.work_directory(),
+                                     handle.stderr_file());
+            }
+
+            if (test_data->needs_cleanup) {
+                INV(test_case.get_metadata().has_cleanup());
+                // The test body has completed and we have processed it.  If
+                // there is a cleanup routine, trigger it now and let the
+                // caller wait for any other test completion.  The caller never
+                // knows about cleanup routines.
+                spawn_cleanup(test_data->test_program,
+                              test_data->test_case_name,
+                              test_data->user_config, handle, result.get());
+                test_data->needs_cleanup = false;
+                return result_handle_ptr();
+            }
+        } catch (const std::bad_cast& e) {
+            const cleanup_exec_data* cleanup_data =
+                &dynamic_cast< const cleanup_exec_data& >(*data.get());
+
+            // Handle the completion of cleanup subprocesses internally: the
+            // caller is not aware that these exist so, when we return, we must
+            // return the data for the original test that triggered this
+            // routine.  For example, because the caller wants to see the exact
+            // same exec_handle that was returned by spawn_test.
+
+            const model::test_result& body_result = cleanup_data->body_result;
+            if (body_result.good()) {
+                if (!handle.status()) {
+                    result = model::test_result(model::test_result_broken,
+                                                "Test case cleanup timed out");
+                } else {
+                    if (!handle.status().get().exited() ||
+                        handle.status().get().exitstatus() != EXIT_SUCCESS) {
+                        result = model::test_result(
+                            model::test_result_broken,
+                            "Test case cleanup did not terminate "
+                            "successfully");
+                    } else {
+                        result = body_result;
+                    }
+                }
+            } else {
+                result = body_result;
+            }
+
+            handle = cleanup_data->body_exit_handle;
+        }
+        INV(result);
+
+        std::shared_ptr< result_handle::bimpl > result_handle_bimpl(
+            new result_handle::bimpl(handle, all_exec_data));
+        std::shared_ptr< test_result_handle::impl > test_result_handle_impl(
+            new test_result_handle::impl(
+                data->test_program, data->test_case_name, result.get()));
+        return result_handle_ptr(new test_result_handle(
+            result_handle_bimpl, test_result_handle_impl));
+    }
 };
 
 
@@ -1005,7 +1249,9 @@ scheduler::setup(void)
 
 /// Retrieves the list of test cases from a test program.
 ///
-/// This operation is currently synchronous.
+/// This operation is currently synchronous.  The test program is not executed
+/// if its interface knows the list of test cases upfront or if the list is
+/// present in the cache pointed to by the list_cache_dir setting.
 ///
 /// This operation should never throw.  Any errors during the processing of the
 /// test case list are subsumed into a single test case in the return value that
@@ -1026,6 +1272,27 @@ scheduler::scheduler_handle::list_tests(
     const std::shared_ptr< scheduler::interface > interface = find_interface(
         test_program->interface_name());
 
+    const optional< model::test_cases_map > fixed_test_cases =
+        interface->fixed_test_cases(*test_program);
+    if (fixed_test_cases)
+        return fixed_test_cases.get();
+
+    optional< fs::path > cache_dir;
+    optional< std::string > cache_key;
+    if (user_config.is_set("list_cache_dir")) {
+        cache_dir = fs::path(user_config.lookup< config::string_node >(
+            "list_cache_dir"));
+        // The key must describe the binary as it was before listing it.
+        cache_key = cached_list_key(*test_program, scheduler::generate_config(
+            user_config, test_program->test_suite_name()));
+    }
+    if (cache_key) {
+        const optional< model::test_cases_map > cached_test_cases =
+            read_cached_list(cache_dir.get(), *test_program, cache_key.get());
+        if (cached_test_cases)
+            return cached_test_cases.get();
+    }
+
     try {
         const executor::exec_handle exec_handle = _pimpl->generic.spawn(
             list_test_cases(interface, test_program, user_config),
@@ -1042,6 +1309,15 @@ scheduler::scheduler_handle::list_tests(
         if (test_cases.empty())
             throw std::runtime_error("Empty test cases list");
 
+        if (cache_key) {
+            try {
+                write_cached_list(cache_dir.get(), *test_program,
+                                  cache_key.get(), test_cases);
+            } catch (const engine::error& e) {
+                LW(F("Failed to cache test cases list: %s") % e.what());
+            }
+        }
+
         return test_cases;
     } catch (const std::runtime_error& e) {
         // TODO(jmmv): This is a very ugly workaround for the fact that we
@@ -1059,6 +1335,45 @@ scheduler::scheduler_handle::list_tests(
 }
 
 
+/// Checks the requirements of a test case without spawning it.
+///
+/// The results of the system queries needed to evaluate the requirements are
+/// memoized across calls, so checking many test cases with similar
+/// requirements is cheap.  If the test case can run, a subsequent call to
+/// spawn_test() for it does not check the requirements again.
+///
+/// \param test_program The container test program.
+/// \param test_case_name The name of the test case to check.
+/// \param user_config User-provided configuration variables.
+///
+/// \return A skipped result if the requirements of the test case are not met;
+/// none if the test case has to be spawned.
+optional< model::test_result >
+scheduler::scheduler_handle::check_requirements(
+    const model::test_program_ptr test_program,
+    const std::string& test_case_name,
+    const config::tree& user_config)
+{
+    const model::test_case& test_case = test_program->find(test_case_name);
+    if (test_case.fake_result())
+        return none;
+
+    const std::string skip_reason = _pimpl->requirements_checker.check(
+        test_case.get_metadata(), user_config, test_program->test_suite_name(),
+        root_work_directory());
+    if (!skip_reason.empty()) {
+        LI(F("Skipping %s:%s without spawning it: %s") %
+           test_program->absolute_path() % test_case_name % skip_reason);
+        return utils::make_optional(
+            model::test_result(model::test_result_skipped, skip_reason));
+    }
+
+    _pimpl->checked_tests.insert(std::make_pair(test_program.get(),
+                                                test_case_name));
+    return none;
+}
+
+
 /// Forks and executes a test case asynchronously.
 ///
 /// Note that the caller needn't know if the test has a cleanup routine or not.
@@ -1092,14 +1407,18 @@ scheduler::scheduler_handle::spawn_test(
             "unprivileged_user");
     }
 
+    const bool requirements_checked = _pimpl->checked_tests.erase(
+        std::make_pair(test_program.get(), test_case_name)) > 0;
+
     const executor::exec_handle handle = _pimpl->generic.spawn(
-        run_test_program(interface, test_program, test_case_name,
-                         user_config),
+        run_test_program(interface, _pimpl->absolute_program(test_program),
+                         test_case_name, user_config, requirements_checked),
         test_case.get_metadata().timeout(),
         unprivileged_user);
 
     const exec_data_ptr data(new test_exec_data(
-        test_program, test_case_name, interface, user_config));
+        test_program, test_case_name, interface, user_config,
+        handle.stdout_file()));
     _pimpl->all_exec_data.insert(exec_data_map::value_type(handle.pid(), data));
 
     return handle.pid();
@@ -1117,125 +1436,66 @@ scheduler::scheduler_handle::spawn_test(
 scheduler::result_handle_ptr
 scheduler::scheduler_handle::wait_any(void)
 {
-    _pimpl->generic.check_interrupt();
-
-    executor::exit_handle handle = _pimpl->generic.wait_any();
+    for (;;) {
+        _pimpl->generic.check_interrupt();
 
-    const exec_data_map::iterator iter = _pimpl->all_exec_data.find(
-        handle.original_pid());
-    exec_data_ptr& data = (*iter).second;
+        const result_handle_ptr result_handle = _pimpl->process_exit(
+            _pimpl->generic.wait_any());
+        if (result_handle.get() != NULL)
+            return result_handle;
+    }
+}
 
-    utils::dump_stacktrace_if_available(data->test_program->absolute_path(),
-                                        _pimpl->generic, handle);
 
-    optional< model::test_result > result;
-    try {
-        test_exec_data* test_data = &dynamic_cast< test_exec_data& >(
-            *data.get());
-
-        test_data->exit_handle = handle;
-
-        const model::test_case& test_case = test_data->test_program->find(
-            test_data->test_case_name);
-
-        result = test_case.fake_result();
-
-        if (!result && handle.status() && handle.status().get().exited() &&
-            handle.status().get().exitstatus() == exit_skipped) {
-            // If the test's process terminated with our magic "exit_skipped"
-            // status, there are two cases to handle.  The first is the case
-            // where the "skipped cookie" exists, in which case we never got to
-            // actually invoke the test program; if that's the case, handle it
-            // here.  The second case is where the test case actually decided to
-            // exit with the "exit_skipped" status; in that case, just fall back
-            // to the regular status handling.
-            const fs::path skipped_cookie_path = handle.control_directory() /
-                skipped_cookie;
-            std::ifstream input(skipped_cookie_path.c_str());
-            if (input) {
-                result = model::test_result(model::test_result_skipped,
-                                            utils::read_stream(input));
-                input.close();
-
-                // If we determined that the test needs to be skipped, we do not
-                // want to run the cleanup routine because doing so could result
-                // in errors.  However, we still want to run the cleanup routine
-                // if the test's body reports a skip (because actions could have
-                // already been taken).
-                test_data->needs_cleanup = false;
-            }
-        }
-        if (!result) {
-            result = test_data->interface->compute_result(
-                handle.status(),
-                handle.control_directory(),
-                handle.stdout_file(),
-                handle.stderr_file());
-        }
-        INV(result);
-
-        if (!result.get().good()) {
-            append_files_listing(handle.work_directory(),
-                                 handle.stderr_file());
-        }
+/// Waits for completion of any forked test case for a limited amount of time.
+///
+/// This is like wait_any() but returns control to the caller if no test case
+/// completes before the timeout expires, which lets the caller do periodic
+/// work while test cases run.
+///
+/// \param timeout Maximum amount of time to wait for.
+///
+/// \return The result of the execution of a subprocess, or NULL if no test
+/// case completed before the timeout.
+scheduler::result_handle_ptr
+scheduler::scheduler_handle::wait_any(const datetime::delta& timeout)
+{
+    const datetime::timestamp deadline = datetime::timestamp::now() + timeout;
+    for (;;) {
+        _pimpl->generic.check_interrupt();
+
+        const datetime::timestamp now = datetime::timestamp::now();
+        const optional< executor::exit_handle > handle =
+            _pimpl->generic.wait_any(
+                now < deadline ? deadline - now : datetime::delta());
+        if (!handle)
+            return result_handle_ptr();
+
+        const result_handle_ptr result_handle = _pimpl->process_exit(
+            handle.get());
+        if (result_handle.get() != NULL)
+            return result_handle;
+    }
+}
 
-        if (test_data->needs_cleanup) {
-            INV(test_case.get_metadata().has_cleanup());
-            // The test body has completed and we have processed it.  If there
-            // is a cleanup routine, trigger it now and wait for any other test
-            // completion.  The caller never knows about cleanup routines.
-            _pimpl->spawn_cleanup(test_data->test_program,
-                                  test_data->test_case_name,
-                                  test_data->user_config, handle, result.get());
-            test_data->needs_cleanup = false;
-
-            // TODO(jmmv): Chaining this call is ugly.  We'd be better off by
-            // looping over terminated processes until we got a result suitable
-            // for user consumption.  For the time being this is good enough and
-            // not a problem because the call chain won't get big: the majority
-            // of test cases do not have cleanup routines.
-            return wait_any();
-        }
-    } catch (const std::bad_cast& e) {
-        const cleanup_exec_data* cleanup_data =
-            &dynamic_cast< const cleanup_exec_data& >(*data.get());
-
-        // Handle the completion of cleanup subprocesses internally: the caller
-        // is not aware that these exist so, when we return, we must return the
-        // data for the original test that triggered this routine.  For example,
-        // because the caller wants to see the exact same exec_handle that was
-        // returned by spawn_test.
-
-        const model::test_result& body_result = cleanup_data->body_result;
-        if (body_result.good()) {
-            if (!handle.status()) {
-                result = model::test_result(model::test_result_broken,
-                                            "Test case cleanup timed out");
-            } else {
-                if (!handle.status().get().exited() ||
-                    handle.status().get().exitstatus() != EXIT_SUCCESS) {
-                    result = model::test_result(
-                        model::test_result_broken,
-                        "Test case cleanup did not terminate successfully");
-                } else {
-                    result = body_result;
-                }
-            }
-        } else {
-            result = body_result;
-        }
 
-        handle = cleanup_data->body_exit_handle;
-    }
-    INV(result);
-
-    std::shared_ptr< result_handle::bimpl > result_handle_bimpl(
-        new result_handle::bimpl(handle, _pimpl->all_exec_data));
-    std::shared_ptr< test_result_handle::impl > test_result_handle_impl(
-        new test_result_handle::impl(
-            data->test_program, data->test_case_name, result.get()));
-    return result_handle_ptr(new test_result_handle(result_handle_bimpl,
-                                                    test_result_handle_impl));
+/// Gets the path to the file that captures the stdout of a running test case.
+///
+/// The file is written to as the test case runs, so callers can follow its
+/// progress.  Note that the file may not exist until the test case starts.
+///
+/// \param handle The handle returned by spawn_test() for the test case.
+///
+/// \return The path to the stdout file of the test case.
+fs::path
+scheduler::scheduler_handle::stdout_file(const exec_handle handle) const
+{
+    const exec_data_map::const_iterator iter = _pimpl->all_exec_data.find(
+        handle);
+    PRE(iter != _pimpl->all_exec_data.end());
+    const test_exec_data* test_data = &dynamic_cast< const test_exec_data& >(
+        *(*iter).second.get());
+    return test_data->stdout_file;
 }
 
 
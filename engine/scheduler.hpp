@@ -113,6 +113,18 @@ public:
         const utils::fs::path& stdout_path,
         const utils::fs::path& stderr_path) const = 0;
 
+    /// Returns the test cases list of a test program without executing it.
+    ///
+    /// Interfaces whose test programs always expose the same test cases can
+    /// override this to spare the scheduler from spawning the list operation.
+    ///
+    /// \param test_program The test program to query.
+    ///
+    /// \return A list of test cases or none if the test program must be
+    /// executed to obtain it.
+    virtual utils::optional< model::test_cases_map > fixed_test_cases(
+        const model::test_program& test_program) const;
+
     /// Executes a test case of the test program.
     ///
     /// This method is intended to be called within a subprocess and is expected
@@ -246,10 +258,16 @@ public:
 
     model::test_cases_map list_tests(const model::test_program*,
                                      const utils::config::tree&);
+    utils::optional< model::test_result > check_requirements(
+        const model::test_program_ptr, const std::string&,
+        const utils::config::tree&);
     exec_handle spawn_test(const model::test_program_ptr,
                            const std::string&,
                            const utils::config::tree&);
     result_handle_ptr wait_any(void);
+    result_handle_ptr wait_any(const utils::datetime::delta&);
+
+    utils::fs::path stdout_file(const exec_handle) const;
 
     result_handle_ptr debug_test(const model::test_program_ptr,
                                  const std::string&,
@@ -33,11 +33,13 @@ extern "C" {
 
 #include <signal.h>
 #include <unistd.h>
+#include <utime.h>
 }
 
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <set>
 #include <string>
 
 #include <atf-c++.hpp>
@@ -207,6 +209,38 @@ class mock_interface : public scheduler::interface {
         do_exit(EXIT_SUCCESS);
     }
 
+    /// Executes a test case that prints the identity of its test program.
+    ///
+    /// \param test_program The test program to execute.
+    void
+    exec_print_program(const model::test_program& test_program) const
+        UTILS_NORETURN
+    {
+        std::cout << F("Test program: %s\n") % &test_program;
+        std::cout << F("Test cases: %s\n") % &test_program.test_cases();
+        std::cout << F("Path: %s\n") % test_program.absolute_path();
+
+        do_exit(EXIT_SUCCESS);
+    }
+
+    /// Executes a test case that prints a message and waits for a cookie.
+    ///
+    /// \param test_program The test program to execute.  The cookie is
+    ///     expected in its root directory.
+    void
+    exec_wait_for_cookie(const model::test_program& test_program) const
+        UTILS_NORETURN
+    {
+        std::cout << "waiting\n";
+        std::cout.flush();
+
+        const fs::path cookie = test_program.root() / "cookie";
+        while (!fs::exists(cookie))
+            ::usleep(10000);
+
+        do_exit(EXIT_SUCCESS);
+    }
+
 public:
     /// Executes a test program's list operation.
     ///
@@ -235,6 +269,14 @@ public:
             }
         } else if (name == "empty") {
             do_exit(EXIT_SUCCESS);
+        } else if (name == "list_count") {
+            const fs::path log = test_program.absolute_path().branch_path() /
+                "list_count.log";
+            std::ofstream output(log.c_str(), std::ios::app);
+            output << "x";
+            output.close();
+            std::cout << F("run_%s\n") % utils::read_file(log).length();
+            do_exit(EXIT_SUCCESS);
         } else if (name == "misbehave") {
             std::abort();
         } else if (name == "timeout") {
@@ -270,7 +312,7 @@ public:
         if (name == "check_i_exist") {
             ATF_REQUIRE(status.get().exited());
             ATF_REQUIRE_EQ(EXIT_SUCCESS, status.get().exitstatus());
-        } else if (name == "empty") {
+        } else if (name == "empty" || name == "list_count") {
             ATF_REQUIRE(status.get().exited());
             ATF_REQUIRE_EQ(EXIT_SUCCESS, status.get().exitstatus());
         } else if (name == "misbehave") {
@@ -342,8 +384,12 @@ public:
             exec_exit(EXIT_SUCCESS);
         } else if (starts_with(test_case_name, "print_params")) {
             exec_print_params(test_program, test_case_name, vars);
+        } else if (starts_with(test_case_name, "print_program")) {
+            exec_print_program(test_program);
         } else if (starts_with(test_case_name, "skip_body_pass_cleanup")) {
             exec_exit(EXIT_SUCCESS);
+        } else if (starts_with(test_case_name, "wait_for_cookie")) {
+            exec_wait_for_cookie(test_program);
         } else {
             std::cerr << "Unknown test case " << test_case_name << '\n';
             std::abort();
@@ -562,6 +608,61 @@ ATF_TEST_CASE_BODY(integration__list_empty)
 }
 
 
+/// Creates a fake test program binary whose list can be cached.
+///
+/// Lists of recently-modified binaries are not cached, so this gives the
+/// binary a modification time in the past.
+///
+/// \param name Name of the binary to create in the current directory.
+static void
+create_old_program(const char* name)
+{
+    atf::utils::create_file(name, "");
+    struct ::utimbuf times;
+    times.actime = 1000;
+    times.modtime = 1000;
+    ATF_REQUIRE(::utime(name, &times) != -1);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__list_cache);
+ATF_TEST_CASE_BODY(integration__list_cache)
+{
+    create_old_program("list_count");
+
+    config::tree user_config = engine::empty_config();
+    user_config.set_string("list_cache_dir", "cache");
+
+    const model::test_cases_map exp_test_cases = model::test_cases_map_builder()
+        .add("run_1").build();
+    ATF_REQUIRE_EQ(exp_test_cases, check_integration_list(
+        "list_count", fs::path("."), user_config));
+    ATF_REQUIRE_EQ(exp_test_cases, check_integration_list(
+        "list_count", fs::path("."), user_config));
+
+    const model::test_cases_map exp_uncached_test_cases =
+        model::test_cases_map_builder().add("run_2").build();
+    ATF_REQUIRE_EQ(exp_uncached_test_cases, check_integration_list(
+        "list_count", fs::path(".")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__list_cache__not_on_failure);
+ATF_TEST_CASE_BODY(integration__list_cache__not_on_failure)
+{
+    create_old_program("misbehave");
+
+    config::tree user_config = engine::empty_config();
+    user_config.set_string("list_cache_dir", "cache");
+
+    const model::test_cases_map test_cases = check_integration_list(
+        "misbehave", fs::path("."), user_config);
+    ATF_REQUIRE_EQ(1, test_cases.size());
+    ATF_REQUIRE(test_cases.begin()->second.fake_result());
+    ATF_REQUIRE(!fs::exists(fs::path("cache")));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(integration__run_one);
 ATF_TEST_CASE_BODY(integration__run_one)
 {
@@ -590,6 +691,72 @@ ATF_TEST_CASE_BODY(integration__run_one)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(integration__wait_any_timeout);
+ATF_TEST_CASE_BODY(integration__wait_any_timeout)
+{
+    const model::test_program_ptr program = model::test_program_builder(
+        "mock", fs::path("the-program"), fs::current_path(), "the-suite")
+        .add_test_case("wait_for_cookie").build_ptr();
+
+    const config::tree user_config = engine::empty_config();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    const scheduler::exec_handle exec_handle = handle.spawn_test(
+        program, "wait_for_cookie", user_config);
+    const fs::path stdout_file = handle.stdout_file(exec_handle);
+
+    // The test case cannot complete until we create the cookie, so the waits
+    // must time out while we can observe its output as it runs.
+    for (int i = 0; !atf::utils::grep_file("waiting", stdout_file.str());
+         i++) {
+        ATF_REQUIRE(i < 600);
+        ATF_REQUIRE(handle.wait_any(datetime::delta(0, 100000)).get() ==
+                    NULL);
+    }
+
+    atf::utils::create_file("cookie", "");
+    scheduler::result_handle_ptr result_handle = handle.wait_any(
+        datetime::delta(60, 0));
+    ATF_REQUIRE(result_handle.get() != NULL);
+    ATF_REQUIRE_EQ(exec_handle, result_handle->original_pid());
+    ATF_REQUIRE_EQ(stdout_file, result_handle->stdout_file());
+    result_handle->cleanup();
+    result_handle.reset();
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__wait_any_timeout__cleanup);
+ATF_TEST_CASE_BODY(integration__wait_any_timeout__cleanup)
+{
+    const model::test_program_ptr program = model::test_program_builder(
+        "mock", fs::path("the-program"), fs::current_path(), "the-suite")
+        .add_test_case("fail_body_pass_cleanup")
+        .set_metadata(model::metadata_builder().set_has_cleanup(true).build())
+        .build_ptr();
+
+    const config::tree user_config = engine::empty_config();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    (void)handle.spawn_test(program, "fail_body_pass_cleanup", user_config);
+
+    // The result must not be returned until the cleanup routine has run.
+    scheduler::result_handle_ptr result_handle = handle.wait_any(
+        datetime::delta(60, 0));
+    ATF_REQUIRE(result_handle.get() != NULL);
+    ATF_REQUIRE(atf::utils::compare_file(
+        result_handle->stdout_file().str(),
+        "exec_cleanup was called\n"));
+    result_handle->cleanup();
+    result_handle.reset();
+
+    handle.cleanup();
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(integration__run_many);
 ATF_TEST_CASE_BODY(integration__run_many)
 {
@@ -728,6 +895,74 @@ ATF_TEST_CASE_BODY(integration__run_check_paths)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(integration__run_share_program);
+ATF_TEST_CASE_BODY(integration__run_share_program)
+{
+    fs::mkdir_p(fs::path("root"), 0755);
+
+    model::test_program_builder builder(
+        "mock", fs::path("the-program"), fs::path("root"), "the-suite");
+    for (int i = 0; i < 1000; ++i)
+        builder.add_test_case(F("print_program %s") % i);
+    const model::test_program_ptr program = builder.build_ptr();
+
+    const config::tree user_config = engine::empty_config();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    std::set< std::string > outputs;
+    for (int i = 0; i < 3; ++i) {
+        (void)handle.spawn_test(program, F("print_program %s") % (i * 100),
+                                user_config);
+    }
+    for (int i = 0; i < 3; ++i) {
+        scheduler::result_handle_ptr result_handle = handle.wait_any();
+        const scheduler::test_result_handle* test_result_handle =
+            dynamic_cast< const scheduler::test_result_handle* >(
+                result_handle.get());
+        ATF_REQUIRE_EQ(model::test_result(model::test_result_passed, "Exit 0"),
+                       test_result_handle->test_result());
+        ATF_REQUIRE_EQ(program, test_result_handle->test_program());
+        outputs.insert(utils::read_file(result_handle->stdout_file()));
+        result_handle->cleanup();
+        result_handle.reset();
+    }
+
+    // All the subprocesses must have received the same test program object
+    // and it must have been made absolute.
+    ATF_REQUIRE_EQ(1, outputs.size());
+    const std::string exp_path = F("Path: %s\n") %
+        (fs::current_path() / "root/the-program");
+    ATF_REQUIRE((*outputs.begin()).find(exp_path) != std::string::npos);
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__run_release_program);
+ATF_TEST_CASE_BODY(integration__run_release_program)
+{
+    const model::test_program_ptr program = model::test_program_builder(
+        "mock", fs::path("the-program"), fs::path("."), "the-suite")
+        .add_test_case("exit 1").build_ptr();
+
+    const config::tree user_config = engine::empty_config();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    (void)handle.spawn_test(program, "exit 1", user_config);
+    ATF_REQUIRE(program.use_count() > 1);
+
+    scheduler::result_handle_ptr result_handle = handle.wait_any();
+    result_handle->cleanup();
+    result_handle.reset();
+
+    ATF_REQUIRE_EQ(1, program.use_count());
+
+    handle.cleanup();
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(integration__parameters_and_output);
 ATF_TEST_CASE_BODY(integration__parameters_and_output)
 {
@@ -957,6 +1192,45 @@ ATF_TEST_CASE_BODY(integration__check_requirements)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(integration__check_requirements__parent);
+ATF_TEST_CASE_BODY(integration__check_requirements__parent)
+{
+    const model::test_program_ptr program = model::test_program_builder(
+        "mock", fs::path("the-program"), fs::current_path(), "the-suite")
+        .add_test_case("exit 12", model::metadata_builder()
+                       .add_required_config("abcde").build())
+        .add_test_case("exit 41")
+        .build_ptr();
+
+    const config::tree user_config = engine::empty_config();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    const optional< model::test_result > skipped = handle.check_requirements(
+        program, "exit 12", user_config);
+    ATF_REQUIRE(skipped);
+    ATF_REQUIRE_EQ(model::test_result(
+                       model::test_result_skipped,
+                       "Required configuration property 'abcde' not defined"),
+                   skipped.get());
+
+    ATF_REQUIRE(!handle.check_requirements(program, "exit 41", user_config));
+    (void)handle.spawn_test(program, "exit 41", user_config);
+
+    scheduler::result_handle_ptr result_handle = handle.wait_any();
+    const scheduler::test_result_handle* test_result_handle =
+        dynamic_cast< const scheduler::test_result_handle* >(
+            result_handle.get());
+    ATF_REQUIRE_EQ("exit 41", test_result_handle->test_case_name());
+    ATF_REQUIRE_EQ(model::test_result(model::test_result_passed, "Exit 41"),
+                   test_result_handle->test_result());
+    result_handle->cleanup();
+    result_handle.reset();
+
+    handle.cleanup();
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(integration__stacktrace);
 ATF_TEST_CASE_BODY(integration__stacktrace)
 {
@@ -1213,11 +1487,17 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, integration__list_timeout);
     ATF_ADD_TEST_CASE(tcs, integration__list_fail);
     ATF_ADD_TEST_CASE(tcs, integration__list_empty);
+    ATF_ADD_TEST_CASE(tcs, integration__list_cache);
+    ATF_ADD_TEST_CASE(tcs, integration__list_cache__not_on_failure);
 
     ATF_ADD_TEST_CASE(tcs, integration__run_one);
+    ATF_ADD_TEST_CASE(tcs, integration__wait_any_timeout);
+    ATF_ADD_TEST_CASE(tcs, integration__wait_any_timeout__cleanup);
     ATF_ADD_TEST_CASE(tcs, integration__run_many);
 
     ATF_ADD_TEST_CASE(tcs, integration__run_check_paths);
+    ATF_ADD_TEST_CASE(tcs, integration__run_share_program);
+    ATF_ADD_TEST_CASE(tcs, integration__run_release_program);
     ATF_ADD_TEST_CASE(tcs, integration__parameters_and_output);
 
     ATF_ADD_TEST_CASE(tcs, integration__fake_result);
@@ -1228,6 +1508,7 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, integration__cleanup__body_bad__cleanup_bad);
     ATF_ADD_TEST_CASE(tcs, integration__cleanup__timeout);
     ATF_ADD_TEST_CASE(tcs, integration__check_requirements);
+    ATF_ADD_TEST_CASE(tcs, integration__check_requirements__parent);
     ATF_ADD_TEST_CASE(tcs, integration__stacktrace);
     ATF_ADD_TEST_CASE(tcs, integration__list_files_on_failure__none);
     ATF_ADD_TEST_CASE(tcs, integration__list_files_on_failure__some);
@@ -137,6 +137,20 @@ engine::tap_interface::parse_list(
 }
 
 
+/// Returns the test cases list of a test program without executing it.
+///
+/// \param unused_test_program The test program to query.
+///
+/// \return A list with the single test case exposed by TAP test programs.
+optional< model::test_cases_map >
+engine::tap_interface::fixed_test_cases(
+    const model::test_program& UTILS_UNUSED_PARAM(test_program)) const
+{
+    return utils::make_optional(
+        model::test_cases_map_builder().add("main").build());
+}
+
+
 /// Executes a test case of the test program.
 ///
 /// This method is intended to be called within a subprocess and is expected
@@ -29,6 +29,7 @@
 #include "engine/tap_parser.hpp"
 
 #include <fstream>
+#include <vector>
 
 #include "engine/exceptions.hpp"
 #include "utils/format/macros.hpp"
@@ -49,14 +50,8 @@ using utils::optional;
 const engine::tap_plan engine::all_skipped_plan(1, 0);
 
 
-namespace {
-
-
-/// Implementation of the TAP parser.
-///
-/// This is a class only to simplify keeping global constant values around (like
-/// prebuilt regular expressions).
-class tap_parser : utils::noncopyable {
+/// Internal implementation of the TAP parser.
+struct engine::tap_parser::impl : utils::noncopyable {
     /// Regular expression to match plan lines.
     text::regex _plan_regex;
 
@@ -69,62 +64,85 @@ class tap_parser : utils::noncopyable {
     /// Regular expression to match a single test result.
     text::regex _result_regex;
 
+    /// The plan found so far, if any.
+    optional< engine::tap_plan > plan;
+
+    /// If not empty, the reason why all tests were skipped.
+    std::string all_skipped_reason;
+
+    /// Whether the test program bailed out early or not.
+    bool bailed_out;
+
+    /// Number of 'ok' results found so far.
+    std::size_t ok_count;
+
+    /// Number of 'not ok' results found so far.
+    std::size_t not_ok_count;
+
+    /// The 'not ok' result lines found so far.
+    std::vector< std::string > failures;
+
+    /// Trailing data given to feed() that does not yet form a complete line.
+    std::string partial_line;
+
+    /// Sets up the TAP parser state.
+    impl(void) :
+        _plan_regex(text::regex::compile("^([0-9]+)\\.\\.([0-9]+)", 2)),
+        _todo_regex(text::regex::compile("TODO[ \t]*(.*)$", 2)),
+        _skip_regex(text::regex::compile("(SKIP|skip)[ \t]*(.*)$", 2)),
+        _result_regex(text::regex::compile("^(not ok|ok)[ \t-]+[0-9]*", 1)),
+        bailed_out(false), ok_count(0), not_ok_count(0)
+    {
+    }
+
     /// Checks if a line contains a TAP plan and extracts its data.
     ///
     /// \param line The line to try to parse.
-    /// \param [in,out] out_plan Used to store the found plan, if any.  The same
-    ///     output variable should be given to all calls to this function so
-    ///     that duplicate plan entries can be discovered.
-    /// \param [out] out_all_skipped_reason Used to store the reason for all
-    ///     tests being skipped, if any.  If this is set to a non-empty value,
-    ///     then the out_plan is set to 1..0.
     ///
     /// \return True if the line matched a plan; false otherwise.
     ///
     /// \throw engine::format_error If the input is invalid.
     /// \throw text::error If the input is invalid.
     bool
-    try_parse_plan(const std::string& line,
-                   optional< engine::tap_plan >& out_plan,
-                   std::string& out_all_skipped_reason)
+    try_parse_plan(const std::string& line)
     {
         const text::regex_matches plan_matches = _plan_regex.match(line);
         if (!plan_matches)
             return false;
-        const engine::tap_plan plan(
+        const engine::tap_plan new_plan(
             text::to_type< std::size_t >(plan_matches.get(1)),
             text::to_type< std::size_t >(plan_matches.get(2)));
 
-        if (out_plan)
+        if (plan)
             throw engine::format_error(
                 F("Found duplicate plan %s..%s (saw %s..%s earlier)") %
-                plan.first % plan.second %
-                out_plan.get().first % out_plan.get().second);
+                new_plan.first % new_plan.second %
+                plan.get().first % plan.get().second);
 
-        std::string all_skipped_reason;
+        std::string new_all_skipped_reason;
         const text::regex_matches skip_matches = _skip_regex.match(line);
         if (skip_matches) {
-            if (plan != engine::all_skipped_plan) {
+            if (new_plan != engine::all_skipped_plan) {
                 throw engine::format_error(F("Skipped plan must be %s..%s") %
                                            engine::all_skipped_plan.first %
                                            engine::all_skipped_plan.second);
             }
-            all_skipped_reason = skip_matches.get(2);
-            if (all_skipped_reason.empty())
-                all_skipped_reason = "No reason specified";
+            new_all_skipped_reason = skip_matches.get(2);
+            if (new_all_skipped_reason.empty())
+                new_all_skipped_reason = "No reason specified";
         } else {
-            if (plan.first > plan.second)
+            if (new_plan.first > new_plan.second)
                 throw engine::format_error(F("Found reversed plan %s..%s") %
-                                           plan.first % plan.second);
+                                           new_plan.first % new_plan.second);
         }
 
-        INV(!out_plan);
-        out_plan = plan;
-        out_all_skipped_reason = all_skipped_reason;
+        INV(!plan);
+        plan = new_plan;
+        all_skipped_reason = new_all_skipped_reason;
 
-        POST(out_plan);
-        POST(out_all_skipped_reason.empty() ||
-             out_plan.get() == engine::all_skipped_plan);
+        POST(plan);
+        POST(all_skipped_reason.empty() ||
+             plan.get() == engine::all_skipped_plan);
 
         return true;
     }
@@ -132,36 +150,33 @@ class tap_parser : utils::noncopyable {
     /// Checks if a line contains a TAP test result and extracts its data.
     ///
     /// \param line The line to try to parse.
-    /// \param [in,out] out_ok_count Accumulator for 'ok' results.
-    /// \param [in,out] out_not_ok_count Accumulator for 'not ok' results.
-    /// \param [out] out_bailed_out Set to true if the test bailed out.
     ///
     /// \return True if the line matched a result; false otherwise.
     ///
     /// \throw engine::format_error If the input is invalid.
     /// \throw text::error If the input is invalid.
     bool
-    try_parse_result(const std::string& line, std::size_t& out_ok_count,
-                     std::size_t& out_not_ok_count, bool& out_bailed_out)
+    try_parse_result(const std::string& line)
     {
-        PRE(!out_bailed_out);
+        PRE(!bailed_out);
 
         const text::regex_matches result_matches = _result_regex.match(line);
         if (result_matches) {
             if (result_matches.get(1) == "ok") {
-                ++out_ok_count;
+                ++ok_count;
             } else {
                 INV(result_matches.get(1) == "not ok");
                 if (_todo_regex.match(line) || _skip_regex.match(line)) {
-                    ++out_ok_count;
+                    ++ok_count;
                 } else {
-                    ++out_not_ok_count;
+                    ++not_ok_count;
+                    failures.push_back(line);
                 }
             }
             return true;
         } else {
             if (line.find("Bail out!") == 0) {
-                out_bailed_out = true;
+                bailed_out = true;
                 return true;
             } else {
                 return false;
@@ -169,68 +184,24 @@ class tap_parser : utils::noncopyable {
         }
     }
 
-public:
-    /// Sets up the TAP parser state.
-    tap_parser(void) :
-        _plan_regex(text::regex::compile("^([0-9]+)\\.\\.([0-9]+)", 2)),
-        _todo_regex(text::regex::compile("TODO[ \t]*(.*)$", 2)),
-        _skip_regex(text::regex::compile("(SKIP|skip)[ \t]*(.*)$", 2)),
-        _result_regex(text::regex::compile("^(not ok|ok)[ \t-]+[0-9]*", 1))
-    {
-    }
-
-    /// Parses an input file containing TAP output.
-    ///
-    /// \param input The stream to read from.
+    /// Processes a single line of TAP output.
     ///
-    /// \return The results of the parsing in the form of a tap_summary object.
+    /// \param line The line to process, without its terminating newline.
     ///
-    /// \throw engine::format_error If there are any syntax errors in the input.
-    /// \throw text::error If there are any syntax errors in the input.
-    engine::tap_summary
-    parse(std::ifstream& input)
+    /// \throw engine::format_error If the input is invalid.
+    /// \throw text::error If the input is invalid.
+    void
+    parse_line(const std::string& line)
     {
-        optional< engine::tap_plan > plan;
-        std::string all_skipped_reason;
-        bool bailed_out = false;
-        std::size_t ok_count = 0, not_ok_count = 0;
-
-        std::string line;
-        while (!bailed_out && std::getline(input, line)) {
-            if (try_parse_result(line, ok_count, not_ok_count, bailed_out))
-                continue;
-            (void)try_parse_plan(line, plan, all_skipped_reason);
-        }
-
-        if (bailed_out) {
-            return engine::tap_summary::new_bailed_out();
-        } else {
-            if (!plan)
-                throw engine::format_error(
-                    "Output did not contain any TAP plan and the program did "
-                    "not bail out");
-
-            if (plan.get() == engine::all_skipped_plan) {
-                return engine::tap_summary::new_all_skipped(all_skipped_reason);
-            } else {
-                const std::size_t exp_count = plan.get().second -
-                    plan.get().first + 1;
-                const std::size_t actual_count = ok_count + not_ok_count;
-                if (exp_count != actual_count) {
-                    throw engine::format_error(
-                        "Reported plan differs from actual executed tests");
-                }
-                return engine::tap_summary::new_results(plan.get(), ok_count,
-                                                        not_ok_count);
-            }
-        }
+        if (bailed_out)
+            return;
+        if (try_parse_result(line))
+            return;
+        (void)try_parse_plan(line);
     }
 };
 
 
-}  // anonymous namespace
-
-
 /// Constructs a TAP summary with the results of parsing a TAP output.
 ///
 /// \param bailed_out_ Whether the test program bailed out early or not.
@@ -412,6 +383,143 @@ engine::operator<<(std::ostream& output, const tap_summary& summary)
 }
 
 
+/// Constructor.
+engine::tap_parser::tap_parser(void) :
+    _pimpl(new impl())
+{
+}
+
+
+/// Destructor.
+engine::tap_parser::~tap_parser(void)
+{
+}
+
+
+/// Processes a chunk of TAP output.
+///
+/// The chunk need not be aligned to line boundaries: any trailing incomplete
+/// line is held until the rest of it is fed or until finish() is called.  This
+/// allows feeding the output of a test program as it is produced.
+///
+/// \param data The chunk of output to process.
+///
+/// \throw engine::format_error If there are any syntax errors in the input.
+/// \throw text::error If there are any syntax errors in the input.
+void
+engine::tap_parser::feed(const std::string& data)
+{
+    std::string::size_type start = 0;
+    std::string::size_type end;
+    while ((end = data.find('\n', start)) != std::string::npos) {
+        if (_pimpl->partial_line.empty()) {
+            _pimpl->parse_line(data.substr(start, end - start));
+        } else {
+            _pimpl->partial_line += data.substr(start, end - start);
+            const std::string line = _pimpl->partial_line;
+            _pimpl->partial_line.clear();
+            _pimpl->parse_line(line);
+        }
+        start = end + 1;
+    }
+    _pimpl->partial_line += data.substr(start);
+}
+
+
+/// Checks whether the test program has bailed out so far.
+///
+/// \return True if a "Bail out!" line has been seen.
+bool
+engine::tap_parser::bailed_out(void) const
+{
+    return _pimpl->bailed_out;
+}
+
+
+/// Gets the plan found so far.
+///
+/// \return The TAP plan, or none if it has not been seen yet.
+const optional< engine::tap_plan >&
+engine::tap_parser::plan(void) const
+{
+    return _pimpl->plan;
+}
+
+
+/// Gets the number of 'ok' test results found so far.
+///
+/// \return A count of results.  Skipped and TODO results are included here.
+std::size_t
+engine::tap_parser::ok_count(void) const
+{
+    return _pimpl->ok_count;
+}
+
+
+/// Gets the number of 'not ok' test results found so far.
+///
+/// \return A count of results.
+std::size_t
+engine::tap_parser::not_ok_count(void) const
+{
+    return _pimpl->not_ok_count;
+}
+
+
+/// Gets the 'not ok' result lines found so far.
+///
+/// \return The collection of lines, in the order in which they were found.
+const std::vector< std::string >&
+engine::tap_parser::failures(void) const
+{
+    return _pimpl->failures;
+}
+
+
+/// Completes the parsing of the TAP output.
+///
+/// \return The results of the parsing in the form of a tap_summary object.
+///
+/// \throw engine::format_error If there are any syntax errors in the input.
+/// \throw text::error If there are any syntax errors in the input.
+engine::tap_summary
+engine::tap_parser::finish(void)
+{
+    if (!_pimpl->partial_line.empty()) {
+        const std::string line = _pimpl->partial_line;
+        _pimpl->partial_line.clear();
+        _pimpl->parse_line(line);
+    }
+
+    if (_pimpl->bailed_out) {
+        return engine::tap_summary::new_bailed_out();
+    } else {
+        const optional< engine::tap_plan >& plan = _pimpl->plan;
+        if (!plan)
+            throw engine::format_error(
+                "Output did not contain any TAP plan and the program did "
+                "not bail out");
+
+        if (plan.get() == engine::all_skipped_plan) {
+            return engine::tap_summary::new_all_skipped(
+                _pimpl->all_skipped_reason);
+        } else {
+            const std::size_t exp_count = plan.get().second -
+                plan.get().first + 1;
+            const std::size_t actual_count = _pimpl->ok_count +
+                _pimpl->not_ok_count;
+            if (exp_count != actual_count) {
+                throw engine::format_error(
+                    "Reported plan differs from actual executed tests");
+            }
+            return engine::tap_summary::new_results(plan.get(),
+                                                    _pimpl->ok_count,
+                                                    _pimpl->not_ok_count);
+        }
+    }
+}
+
+
 /// Parses an input file containing the TAP output of a test program.
 ///
 /// \param filename Path to the file to parse.
@@ -428,7 +536,11 @@ engine::parse_tap_output(const utils::fs::path& filename)
         throw engine::load_error(filename, "Failed to open TAP output file");
 
     try {
-        return tap_summary(tap_parser().parse(input));
+        tap_parser parser;
+        std::string line;
+        while (!parser.bailed_out() && std::getline(input, line))
+            parser.feed(line + '\n');
+        return parser.finish();
     } catch (const engine::format_error& e) {
         throw engine::load_error(filename, e.what());
     } catch (const text::error& e) {
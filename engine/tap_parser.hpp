@@ -37,8 +37,12 @@
 #include <cstddef>
 #include <ostream>
 #include <string>
+#include <vector>
 
 #include "utils/fs/path_fwd.hpp"
+#include "utils/noncopyable.hpp"
+#include "utils/optional_fwd.hpp"
+#include "utils/shared_ptr.hpp"
 
 namespace engine {
 
@@ -90,6 +94,33 @@ public:
 std::ostream& operator<<(std::ostream&, const tap_summary&);
 
 
+/// Incremental parser of TAP output.
+///
+/// The parser consumes the output of a test program in arbitrary chunks, so
+/// it can follow the output of a test program while it is still running, and
+/// only keeps the running counters and the failed results in memory.
+class tap_parser : utils::noncopyable {
+    struct impl;
+
+    /// Pointer to the shared internal implementation.
+    std::shared_ptr< impl > _pimpl;
+
+public:
+    tap_parser(void);
+    ~tap_parser(void);
+
+    void feed(const std::string&);
+
+    bool bailed_out(void) const;
+    const utils::optional< tap_plan >& plan(void) const;
+    std::size_t ok_count(void) const;
+    std::size_t not_ok_count(void) const;
+    const std::vector< std::string >& failures(void) const;
+
+    tap_summary finish(void);
+};
+
+
 tap_summary parse_tap_output(const utils::fs::path&);
 
 
@@ -42,6 +42,7 @@ namespace engine {
 typedef std::pair< std::size_t, std::size_t > tap_plan;
 
 
+class tap_parser;
 class tap_summary;
 
 
@@ -29,6 +29,8 @@
 #include "engine/tap_parser.hpp"
 
 #include <fstream>
+#include <string>
+#include <vector>
 
 #include <atf-c++.hpp>
 
@@ -36,6 +38,7 @@
 #include "utils/format/containers.ipp"
 #include "utils/format/macros.hpp"
 #include "utils/fs/path.hpp"
+#include "utils/optional.ipp"
 
 namespace fs = utils::fs;
 
@@ -416,6 +419,71 @@ ATF_TEST_CASE_BODY(parse_tap_output__open_failure)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(tap_parser__partial_lines);
+ATF_TEST_CASE_BODY(tap_parser__partial_lines)
+{
+    engine::tap_parser parser;
+    ATF_REQUIRE(!parser.plan());
+
+    parser.feed("1..");
+    ATF_REQUIRE(!parser.plan());
+    parser.feed("3\nok - 1\nnot o");
+    ATF_REQUIRE_EQ(engine::tap_plan(1, 3), parser.plan().get());
+    ATF_REQUIRE_EQ(1, parser.ok_count());
+    ATF_REQUIRE_EQ(0, parser.not_ok_count());
+
+    parser.feed("k - 2 Some failure\n");
+    ATF_REQUIRE_EQ(1, parser.ok_count());
+    ATF_REQUIRE_EQ(1, parser.not_ok_count());
+
+    parser.feed("not ok - 3 # TODO Not yet");
+    ATF_REQUIRE_EQ(1, parser.ok_count());
+
+    const engine::tap_summary exp_summary =
+        engine::tap_summary::new_results(engine::tap_plan(1, 3), 2, 1);
+    ATF_REQUIRE_EQ(exp_summary, parser.finish());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(tap_parser__failures);
+ATF_TEST_CASE_BODY(tap_parser__failures)
+{
+    engine::tap_parser parser;
+    parser.feed("ok - 1\n"
+                "not ok - 2 First\n"
+                "# Some diagnostic\n"
+                "not ok - 3 # SKIP Not here\n"
+                "not ok - 4 Second\n");
+
+    std::vector< std::string > exp_failures;
+    exp_failures.push_back("not ok - 2 First");
+    exp_failures.push_back("not ok - 4 Second");
+    ATF_REQUIRE_EQ(exp_failures, parser.failures());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(tap_parser__bail_out);
+ATF_TEST_CASE_BODY(tap_parser__bail_out)
+{
+    engine::tap_parser parser;
+    parser.feed("1..2\nok - 1\n");
+    ATF_REQUIRE(!parser.bailed_out());
+    parser.feed("Bail out! Oops\n1..3\n");
+    ATF_REQUIRE(parser.bailed_out());
+    ATF_REQUIRE_EQ(engine::tap_summary::new_bailed_out(), parser.finish());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(tap_parser__double_plan);
+ATF_TEST_CASE_BODY(tap_parser__double_plan)
+{
+    engine::tap_parser parser;
+    parser.feed("1..2\n");
+    ATF_REQUIRE_THROW_RE(engine::format_error, "duplicate plan",
+                         parser.feed("ok - 1\n1..3\n"));
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, tap_summary__bailed_out);
@@ -441,4 +509,9 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, parse_tap_output__bail_out);
     ATF_ADD_TEST_CASE(tcs, parse_tap_output__bail_out_wins_over_no_plan);
     ATF_ADD_TEST_CASE(tcs, parse_tap_output__open_failure);
+
+    ATF_ADD_TEST_CASE(tcs, tap_parser__partial_lines);
+    ATF_ADD_TEST_CASE(tcs, tap_parser__failures);
+    ATF_ADD_TEST_CASE(tcs, tap_parser__bail_out);
+    ATF_ADD_TEST_CASE(tcs, tap_parser__double_plan);
 }
@@ -0,0 +1,126 @@
+# Copyright 2026 The Kyua Authors.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+# * Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimer.
+# * Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimer in the
+#   documentation and/or other materials provided with the distribution.
+# * Neither the name of Google Inc. nor the names of its contributors
+#   may be used to endorse or promote products derived from this software
+#   without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Executes a mock test suite to generate a results file in the store.
+#
+# \param dbfile_name File to which to write the path to the generated database
+#     file.
+run_tests() {
+    local dbfile_name="${1}"; shift
+
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+atf_test_program{name="simple_all_pass"}
+EOF
+
+    utils_cp_helper simple_all_pass .
+    atf_check -s exit:0 -o save:stdout -e empty kyua test
+    grep '^Results saved to ' stdout | cut -d ' ' -f 4 >"${dbfile_name}"
+    rm stdout
+}
+
+
+utils_test_case no_policies
+no_policies_body() {
+    run_tests dbfile_name1
+    run_tests dbfile_name2
+
+    atf_check -s exit:0 -o match:"^Store size: " -o not-match:"Removed" \
+        -e empty kyua db-gc
+    [ -f "$(cat dbfile_name1)" ] || atf_fail "Results file deleted"
+    [ -f "$(cat dbfile_name2)" ] || atf_fail "Results file deleted"
+}
+
+
+utils_test_case keep_last
+keep_last_body() {
+    run_tests dbfile_name1
+    run_tests dbfile_name2
+    run_tests dbfile_name3
+
+    atf_check -s exit:0 -o match:"^Removed $(cat dbfile_name1)\$" \
+        -o not-match:"Removed $(cat dbfile_name2)" \
+        -o not-match:"Removed $(cat dbfile_name3)" \
+        -e empty kyua db-gc --keep-last=2
+    [ ! -f "$(cat dbfile_name1)" ] || atf_fail "Results file not deleted"
+    [ -f "$(cat dbfile_name2)" ] || atf_fail "Results file deleted"
+    [ -f "$(cat dbfile_name3)" ] || atf_fail "Results file deleted"
+
+    atf_check -s exit:0 -o match:"Results read from $(cat dbfile_name3)" \
+        -e empty kyua report
+}
+
+
+utils_test_case dry_run
+dry_run_body() {
+    run_tests dbfile_name1
+    run_tests dbfile_name2
+
+    atf_check -s exit:0 -o match:"^Would remove $(cat dbfile_name1)\$" \
+        -o match:"^Would compact $(cat dbfile_name2)\$" \
+        -e empty kyua db-gc --keep-last=0 --compact --dry-run
+    [ -f "$(cat dbfile_name1)" ] || atf_fail "Results file deleted"
+}
+
+
+utils_test_case invalid_max_size
+invalid_max_size_body() {
+    atf_check -s exit:3 -o empty \
+        -e match:"Invalid value for --max-size: Invalid bytes quantity '1Z'" \
+        kyua db-gc --max-size=1Z
+}
+
+
+utils_test_case invalid_count
+invalid_count_body() {
+    atf_check -s exit:3 -o empty -e match:"Invalid value for --keep-last" \
+        kyua db-gc --keep-last=-1
+}
+
+
+utils_test_case too_many_arguments
+too_many_arguments_body() {
+    cat >stderr <<EOF
+Usage error for command db-gc: Too many arguments.
+Type 'kyua help db-gc' for usage information.
+EOF
+    atf_check -s exit:3 -o empty -e file:stderr kyua db-gc abc def
+}
+
+
+atf_init_test_cases() {
+    atf_add_test_case no_policies
+    atf_add_test_case keep_last
+    atf_add_test_case dry_run
+
+    atf_add_test_case invalid_max_size
+    atf_add_test_case invalid_count
+
+    atf_add_test_case too_many_arguments
+}
@@ -343,6 +343,48 @@ EOF
 }
 
 
+utils_test_case filters_from_flag
+filters_from_flag_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("top-level")
+include("subdir/Kyuafile")
+atf_test_program{name="first"}
+EOF
+    utils_cp_helper simple_all_pass first
+
+    mkdir subdir
+    cat >subdir/Kyuafile <<EOF
+syntax(2)
+test_suite("in-subdir")
+atf_test_program{name="second"}
+EOF
+    utils_cp_helper simple_some_fail subdir/second
+
+    cat >filters <<EOF
+# Selected test cases.
+subdir/second:fail
+
+first:skip
+EOF
+
+    cat >expout <<EOF
+subdir/second:fail
+first:pass
+first:skip
+EOF
+    atf_check -s exit:0 -o file:expout -e empty \
+        kyua list --filters-from=filters first:pass
+
+    echo "subdir/second:foo" >>filters
+    cat >experr <<EOF
+kyua: W: No test cases matched by the filter 'subdir/second:foo'.
+EOF
+    atf_check -s exit:1 -o ignore -e file:experr \
+        kyua list --filters-from=filters
+}
+
+
 utils_test_case kyuafile_flag__no_args
 kyuafile_flag__no_args_body() {
     cat >Kyuafile <<EOF
@@ -582,6 +624,8 @@ atf_init_test_cases() {
 
     atf_add_test_case build_root_flag
 
+    atf_add_test_case filters_from_flag
+
     atf_add_test_case kyuafile_flag__no_args
     atf_add_test_case kyuafile_flag__some_args
 
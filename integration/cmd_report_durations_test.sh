@@ -0,0 +1,142 @@
+# Copyright 2026 The Kyua Authors.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+# * Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimer.
+# * Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimer in the
+#   documentation and/or other materials provided with the distribution.
+# * Neither the name of Google Inc. nor the names of its contributors
+#   may be used to endorse or promote products derived from this software
+#   without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Executes a mock test suite with a test program that sleeps for a while.
+#
+# \param delay Number of seconds the test case has to sleep for.
+# \param dbfile_name File to which to write the path to the generated database
+#     file.
+run_tests() {
+    local delay="${1}"; shift
+    local dbfile_name="${1}"; shift
+
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+plain_test_program{name="prog"}
+EOF
+
+    cat >prog <<EOF
+#! /bin/sh
+sleep ${delay}
+EOF
+    chmod +x prog
+
+    atf_check -s exit:0 -o save:stdout -e empty kyua test
+    grep '^Results saved to ' stdout | cut -d ' ' -f 4 >"${dbfile_name}"
+    rm stdout
+}
+
+
+utils_test_case previous_runs
+previous_runs_body() {
+    run_tests 0 dbfile_name1
+    run_tests 0 dbfile_name2
+    run_tests 2 dbfile_name3
+
+    atf_check -s exit:0 -o match:"^===> Slower test cases\$" \
+        -o match:"^prog:main  ->  2\.[0-9]{3}s, was 0\.[0-9]{3}s" \
+        -o match:"^prog  ->  2\.[0-9]{3}s, was 0\.[0-9]{3}s" \
+        -o match:"^Baseline runs: 2\$" \
+        -o match:"^Slower test cases: 1\$" \
+        -e empty kyua report-durations
+
+    atf_check -s exit:0 -o match:"^Baseline runs: 1\$" \
+        -e empty kyua report-durations --baseline-runs=1
+
+    atf_check -s exit:0 -o match:"^Baseline runs: 1\$" \
+        -o match:"^Slower test cases: 0\$" \
+        -e empty kyua report-durations --results-file="$(cat dbfile_name2)"
+}
+
+
+utils_test_case explicit_baseline
+explicit_baseline_body() {
+    run_tests 2 dbfile_name1
+    run_tests 0 dbfile_name2
+
+    atf_check -s exit:0 -o match:"^Slower test cases: 0\$" \
+        -e empty kyua report-durations --baseline="$(cat dbfile_name1)"
+
+    atf_check -s exit:0 -o match:"^prog:main  ->  " \
+        -o match:"^Baseline runs: 1\$" \
+        -o match:"^Slower test cases: 1\$" \
+        -e empty kyua report-durations --baseline="$(cat dbfile_name2)" \
+        --results-file="$(cat dbfile_name1)"
+
+    atf_check -s exit:0 -o match:"^Slower test cases: 0\$" \
+        -e empty kyua report-durations --baseline="$(cat dbfile_name2)" \
+        --results-file="$(cat dbfile_name1)" --min-delta=5000
+}
+
+
+utils_test_case filters
+filters_body() {
+    run_tests 0 dbfile_name1
+    run_tests 2 dbfile_name2
+
+    atf_check -s exit:1 -o match:"^prog:main  ->  " \
+        -e match:"No test cases matched by the filter 'other'" \
+        kyua report-durations prog other
+}
+
+
+utils_test_case no_baseline
+no_baseline_body() {
+    run_tests 0 dbfile_name1
+
+    atf_check -s exit:1 -o empty \
+        -e match:"No runs before .* to use as a baseline" \
+        kyua report-durations
+}
+
+
+utils_test_case conflicting_flags
+conflicting_flags_body() {
+    atf_check -s exit:3 -o empty \
+        -e match:"--baseline and --baseline-runs are mutually exclusive" \
+        kyua report-durations --baseline=foo --baseline-runs=2
+}
+
+
+utils_test_case invalid_count
+invalid_count_body() {
+    atf_check -s exit:3 -o empty -e match:"Invalid value for --threshold" \
+        kyua report-durations --threshold=-1
+}
+
+
+atf_init_test_cases() {
+    atf_add_test_case previous_runs
+    atf_add_test_case explicit_baseline
+    atf_add_test_case filters
+    atf_add_test_case no_baseline
+
+    atf_add_test_case conflicting_flags
+    atf_add_test_case invalid_count
+}
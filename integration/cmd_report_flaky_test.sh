@@ -0,0 +1,126 @@
+# Copyright 2026 The Kyua Authors.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+# * Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimer.
+# * Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimer in the
+#   documentation and/or other materials provided with the distribution.
+# * Neither the name of Google Inc. nor the names of its contributors
+#   may be used to endorse or promote products derived from this software
+#   without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Executes a mock test suite with a test program named 'prog'.
+#
+# \param helper Name of the helper to install as the test program.
+# \param exit_code Expected exit code of the run.
+run_tests() {
+    local helper="${1}"; shift
+    local exit_code="${1}"; shift
+
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+atf_test_program{name="prog"}
+EOF
+
+    rm -f prog
+    utils_cp_helper "${helper}" prog
+    atf_check -s exit:"${exit_code}" -o ignore -e empty kyua test
+}
+
+
+utils_test_case no_changes
+no_changes_body() {
+    run_tests simple_all_pass 0
+    run_tests simple_all_pass 0
+
+    cat >expout <<EOF
+===> Summary
+Runs analyzed: 2
+Flaky test cases: 0
+EOF
+    atf_check -s exit:0 -o file:expout -e empty kyua report-flaky
+}
+
+
+utils_test_case some_changes
+some_changes_body() {
+    run_tests expect_all_pass 0
+    run_tests expect_some_fail 1
+    run_tests expect_all_pass 0
+
+    atf_check -s exit:0 -o match:"^===> Flaky test cases\$" \
+        -o match:"^prog:die  ->  2 changes in 3 runs, 1 failed  \[" \
+        -o match:"^prog:exit  ->  2 changes in 3 runs, 1 failed  \[" \
+        -o not-match:"^prog:pass " \
+        -o match:"^Runs analyzed: 3\$" \
+        -o match:"^Flaky test cases: 5\$" \
+        -e empty kyua report-flaky
+
+    atf_check -s exit:0 -o match:"^Runs analyzed: 2\$" \
+        -o match:"^prog:die  ->  1 changes in 2 runs, 1 failed  \[" \
+        -e empty kyua report-flaky --runs=2
+}
+
+
+utils_test_case filters
+filters_body() {
+    run_tests expect_all_pass 0
+    run_tests expect_some_fail 1
+
+    atf_check -s exit:1 -o match:"^prog:die " -o not-match:"^prog:exit " \
+        -o match:"^Flaky test cases: 1\$" \
+        -e match:"No test cases matched by the filter 'prog:foo'" \
+        kyua report-flaky prog:die prog:foo
+}
+
+
+utils_test_case test_suite_flag
+test_suite_flag_body() {
+    mkdir subdir
+    cd subdir
+    run_tests expect_all_pass 0
+    run_tests expect_some_fail 1
+    cd -
+
+    atf_check -s exit:0 -o match:"^prog:die " -e empty \
+        kyua report-flaky --test-suite="$(pwd)/subdir"
+    atf_check -s exit:1 -o empty \
+        -e match:"No previous results file found for test suite" \
+        kyua report-flaky
+}
+
+
+utils_test_case invalid_runs
+invalid_runs_body() {
+    atf_check -s exit:3 -o empty \
+        -e match:"Invalid value for --runs: must be at least 2" \
+        kyua report-flaky --runs=1
+}
+
+
+atf_init_test_cases() {
+    atf_add_test_case no_changes
+    atf_add_test_case some_changes
+    atf_add_test_case filters
+    atf_add_test_case test_suite_flag
+
+    atf_add_test_case invalid_runs
+}
@@ -250,6 +250,101 @@ results_filter__invalid_body() {
 }
 
 
+utils_test_case jobs__ok
+jobs__ok_body() {
+    run_tests "mock1" unused_dbfile_name
+
+    atf_check -s exit:0 -o save:stdout1 -e empty kyua report-html \
+        --results-filter= --output=html1
+    atf_check -s exit:0 -o save:stdout4 -e empty kyua report-html \
+        --results-filter= --output=html4 --jobs=4
+    sed -e 's,html1/,html/,' stdout1 >expout
+    atf_check -o file:expout sed -e 's,html4/,html/,' stdout4
+    atf_check -o empty diff -r html1 html4
+}
+
+
+utils_test_case layout__paged
+layout__paged_body() {
+    run_tests "mock1" unused_dbfile_name
+
+    atf_check -s exit:0 -o save:stdout -e empty kyua report-html \
+        --layout=paged
+    for f in \
+        html/index.html \
+        html/context.html \
+        html/report.css \
+        html/report.js \
+        html/failed-1.html \
+        html/skipped-1.html \
+        html/data/details-0.js
+    do
+        test -f "${f}" || atf_fail "Missing ${f}"
+        grep "^Generating ${f}\$" stdout || atf_fail "${f} not reported"
+    done
+    test ! -f html/simple_some_fail_fail.html \
+        || atf_fail "Unexpected test case page"
+    test ! -f html/passed-1.html || atf_fail "Unexpected passed page"
+
+    atf_check -o match:"2 TESTS FAILING" -o match:'href="failed-1.html"' \
+        -o not-match:'href="passed-1.html"' cat html/index.html
+
+    check_in_file html/failed-1.html "simple_some_fail:fail"
+    check_not_in_file html/failed-1.html "simple_all_pass:skip"
+
+    check_in_file html/data/details-0.js \
+        '"simple_some_fail:fail": ' "This is the stdout of fail" \
+        "This is the stderr of fail"
+    check_not_in_file html/data/details-0.js "simple_all_pass:pass"
+}
+
+
+utils_test_case layout__paged_no_passed_details
+layout__paged_no_passed_details_body() {
+    run_tests "mock1" unused_dbfile_name
+
+    atf_check -s exit:0 -o ignore -e empty kyua report-html \
+        --layout=paged --results-filter=passed,failed --no-passed-details
+    check_in_file html/passed-1.html "simple_all_pass:pass" \
+        "data-shard=\"\""
+    check_in_file html/data/details-0.js '"simple_some_fail:fail": '
+    check_not_in_file html/data/details-0.js "simple_all_pass:pass"
+}
+
+
+utils_test_case layout__paged_jobs
+layout__paged_jobs_body() {
+    run_tests "mock1" unused_dbfile_name
+
+    atf_check -s exit:0 -o save:stdout1 -e empty kyua report-html \
+        --layout=paged --results-filter= --output=html1
+    atf_check -s exit:0 -o save:stdout4 -e empty kyua report-html \
+        --layout=paged --results-filter= --output=html4 --jobs=4
+    sed -e 's,html1/,html/,' stdout1 >expout
+    atf_check -o file:expout sed -e 's,html4/,html/,' stdout4
+    atf_check -o empty diff -r html1 html4
+}
+
+
+utils_test_case layout__invalid
+layout__invalid_body() {
+    atf_check -s exit:3 -o empty \
+        -e match:"Invalid value for --layout: unknown layout 'foo'" \
+        kyua report-html --layout=foo
+    atf_check -s exit:3 -o empty \
+        -e match:"--no-passed-details requires --layout=paged" \
+        kyua report-html --no-passed-details
+}
+
+
+utils_test_case jobs__invalid
+jobs__invalid_body() {
+    atf_check -s exit:3 -o empty \
+        -e match:"Invalid value for --jobs: must be at least 1" \
+        kyua report-html --jobs=0
+}
+
+
 atf_init_test_cases() {
     atf_add_test_case default_behavior__ok
     atf_add_test_case default_behavior__no_store
@@ -264,4 +359,12 @@ atf_init_test_cases() {
 
     atf_add_test_case results_filter__ok
     atf_add_test_case results_filter__invalid
+
+    atf_add_test_case jobs__ok
+    atf_add_test_case jobs__invalid
+
+    atf_add_test_case layout__paged
+    atf_add_test_case layout__paged_no_passed_details
+    atf_add_test_case layout__paged_jobs
+    atf_add_test_case layout__invalid
 }
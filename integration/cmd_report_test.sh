@@ -107,6 +107,37 @@ results_file__explicit_body() {
 }
 
 
+utils_test_case results_file__many
+results_file__many_body() {
+    utils_install_durations_wrapper
+
+    run_tests "mock1" dbfile_name1
+    run_tests "mock2" dbfile_name2
+
+    cat >expout <<EOF
+===> Skipped tests
+simple_all_pass:skip  ->  skipped: The reason for skipping is this  [S.UUUs]
+simple_all_pass:skip  ->  skipped: The reason for skipping is this  [S.UUUs]
+===> Summary
+Results read from $(cat dbfile_name1)
+Results read from $(cat dbfile_name2)
+Test cases: 4 total, 2 skipped, 0 expected failures, 0 broken, 0 failed
+Total time: S.UUUs
+EOF
+    atf_check -s exit:0 -o file:expout -e empty kyua report \
+        --results-file="$(cat dbfile_name1)" \
+        --results-file="$(cat dbfile_name2)"
+
+    atf_check -s exit:0 -o match:"MOCK=mock1" -o not-match:"MOCK=mock2" \
+        -e empty kyua report --results-file="$(cat dbfile_name1)" \
+        --results-file="$(cat dbfile_name2)" --verbose
+
+    atf_check -s exit:3 -o empty -e match:"--follow can only be used" \
+        kyua report --results-file="$(cat dbfile_name1)" \
+        --results-file="$(cat dbfile_name2)" --follow
+}
+
+
 utils_test_case results_file__not_found
 results_file__not_found_body() {
     atf_check -s exit:2 -o empty -e match:"kyua: E: No previous results.*foo" \
@@ -315,6 +346,24 @@ EOF
 }
 
 
+utils_test_case follow__completed
+follow__completed_body() {
+    utils_install_durations_wrapper
+
+    run_tests "mock1" dbfile_name1
+
+    cat >expout <<EOF
+simple_all_pass:pass  ->  passed  [S.UUUs]
+===> Summary
+Results read from $(cat dbfile_name1)
+Test cases: 2 total, 1 skipped, 0 expected failures, 0 broken, 0 failed
+Total time: S.UUUs
+EOF
+    atf_check -s exit:0 -o file:expout -e empty kyua report --follow \
+        --results-filter=passed
+}
+
+
 utils_test_case results_filter__multiple_all_match
 results_filter__multiple_all_match_body() {
     utils_install_durations_wrapper
@@ -360,6 +409,7 @@ atf_init_test_cases() {
     atf_add_test_case default_behavior__no_store
 
     atf_add_test_case results_file__explicit
+    atf_add_test_case results_file__many
     atf_add_test_case results_file__not_found
 
     atf_add_test_case filter__ok
@@ -374,4 +424,6 @@ atf_init_test_cases() {
     atf_add_test_case results_filter__one
     atf_add_test_case results_filter__multiple_all_match
     atf_add_test_case results_filter__multiple_some_match
+
+    atf_add_test_case follow__completed
 }
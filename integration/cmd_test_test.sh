@@ -635,6 +635,53 @@ EOF
 }
 
 
+utils_test_case progress_interval
+progress_interval_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+tap_test_program{name="slow"}
+EOF
+
+    cat >slow <<EOF
+#! /bin/sh
+echo 1..3
+echo ok 1 - first
+sleep 3
+echo not ok 2 - second
+sleep 3
+echo ok 3 - third
+EOF
+    chmod +x slow
+
+    atf_check -s exit:1 -o save:stdout -e empty kyua test \
+        --progress-interval=1
+    atf_check -s exit:0 -o ignore -e empty \
+        grep '^slow:main  1 ok, 0 not ok$' stdout
+    atf_check -s exit:0 -o ignore -e empty \
+        grep '^slow:main  1 ok, 1 not ok$' stdout
+    atf_check -s exit:0 -o ignore -e empty \
+        grep '^slow:main  ->  failed: ' stdout
+    atf_check -s exit:0 -o ignore -e empty grep '^0/1 passed' stdout
+}
+
+
+utils_test_case progress_interval__invalid
+progress_interval__invalid_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+EOF
+
+    cat >experr <<EOF
+Usage error for command test: Invalid value for --progress-interval: must not be negative.
+Type 'kyua help test' for usage information.
+EOF
+    atf_check -s exit:3 -o empty -e file:experr kyua test \
+        --progress-interval=-1
+}
+
+
 utils_test_case results_file__ok
 results_file__ok_body() {
     cat >Kyuafile <<EOF
@@ -680,6 +727,49 @@ EOF
 }
 
 
+utils_test_case resume__ok
+resume__ok_body() {
+    utils_install_timestamp_wrapper
+
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+atf_test_program{name="simple_all_pass"}
+EOF
+    utils_cp_helper simple_all_pass .
+    atf_check -s exit:0 -o match:"simple_all_pass:pass" \
+        -o not-match:"simple_all_pass:skip" -e empty \
+        kyua test -r results.db simple_all_pass:pass
+
+    cat >expout <<EOF
+simple_all_pass:skip  ->  skipped: The reason for skipping is this  [S.UUUs]
+
+Results saved to $(pwd)/results.db
+
+1/1 passed (0 failed)
+EOF
+    atf_check -s exit:0 -o file:expout -e empty kyua test --resume=results.db
+
+    atf_check -s exit:0 -o match:"2 total" -e empty \
+        kyua report --results-file=results.db
+}
+
+
+utils_test_case resume__conflicting_flags
+resume__conflicting_flags_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+atf_test_program{name="simple_all_pass"}
+EOF
+    utils_cp_helper simple_all_pass .
+    atf_check -s exit:0 -o ignore -e empty kyua test -r results.db
+
+    atf_check -s exit:3 -o empty -e match:"--resume and --results-file" \
+        kyua test --resume=results.db --results-file=other.db
+}
+
+
 utils_test_case build_root_flag
 build_root_flag_body() {
     utils_install_timestamp_wrapper
@@ -1044,10 +1134,17 @@ atf_init_test_cases() {
     atf_add_test_case config_behavior
 
     atf_add_test_case store_contents
+
+    atf_add_test_case progress_interval
+    atf_add_test_case progress_interval__invalid
+
     atf_add_test_case results_file__ok
     atf_add_test_case results_file__fail
     atf_add_test_case results_file__reuse
 
+    atf_add_test_case resume__ok
+    atf_add_test_case resume__conflicting_flags
+
     atf_add_test_case build_root_flag
 
     atf_add_test_case kyuafile_flag__no_args
@@ -0,0 +1,140 @@
+/* Copyright 2026 The Kyua Authors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of Google Inc. nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+
+// Loads the details of the test cases listed in a page of the report.
+//
+// The details are stored in data files, each holding a subset of the test
+// cases of the report.  A data file consists of a call to kyua.loaded() with
+// the number of the file and a mapping of test case identifiers to their
+// details, so data files can be loaded with plain script elements even when
+// the report is accessed through the local file system.
+var kyua = {
+    // Details of the test cases, keyed by the number of their data file.
+    shards: {},
+
+    // Rows waiting for the data file that holds their details.
+    pending: {},
+
+    // Records the contents of a data file and shows the rows waiting for it.
+    loaded: function(shard, details) {
+        kyua.shards[shard] = details;
+        var rows = kyua.pending[shard] || [];
+        delete kyua.pending[shard];
+        for (var i = 0; i < rows.length; i++)
+            kyua.show(rows[i]);
+    },
+
+    // Shows or hides the details of the test case in a row.
+    toggle: function(row) {
+        var next = row.nextElementSibling;
+        if (next && next.className == "details") {
+            next.parentNode.removeChild(next);
+            return;
+        }
+
+        var shard = row.getAttribute("data-shard");
+        if (shard == "") {
+            kyua.insert(row, [kyua.element("p",
+                "The details of this test case were not included in the " +
+                "report.")]);
+        } else if (shard in kyua.shards) {
+            kyua.show(row);
+        } else if (shard in kyua.pending) {
+            kyua.pending[shard].push(row);
+        } else {
+            kyua.pending[shard] = [row];
+            var script = document.createElement("script");
+            script.src = "data/details-" + shard + ".js";
+            document.getElementsByTagName("head")[0].appendChild(script);
+        }
+    },
+
+    // Creates an element with the given text.
+    element: function(tag, text) {
+        var element = document.createElement(tag);
+        element.appendChild(document.createTextNode(text));
+        return element;
+    },
+
+    // Inserts a row after the given one with the given elements.
+    insert: function(row, elements) {
+        var next = row.nextElementSibling;
+        if (next && next.className == "details")
+            return;
+
+        var cell = document.createElement("td");
+        cell.colSpan = row.cells.length;
+        for (var i = 0; i < elements.length; i++)
+            cell.appendChild(elements[i]);
+
+        var details = document.createElement("tr");
+        details.className = "details";
+        details.appendChild(cell);
+        row.parentNode.insertBefore(details, row.nextSibling);
+    },
+
+    // Shows the details of the test case in a row once they are loaded.
+    show: function(row) {
+        var shard = kyua.shards[row.getAttribute("data-shard")];
+        var details = shard[row.cells[0].textContent];
+        var elements = [];
+
+        var properties = document.createElement("ul");
+        properties.appendChild(kyua.element("li",
+            "Test program: " + details.program));
+        properties.appendChild(kyua.element("li", "Result: " + details.result));
+        properties.appendChild(kyua.element("li",
+            "Duration: " + details.duration));
+        elements.push(properties);
+
+        elements.push(kyua.element("h3", "Metadata"));
+        var metadata = document.createElement("ul");
+        for (var i = 0; i < details.metadata.length; i++) {
+            var item = document.createElement("li");
+            item.appendChild(kyua.element("tt", details.metadata[i][0] +
+                " = " + details.metadata[i][1]));
+            metadata.appendChild(item);
+        }
+        elements.push(metadata);
+
+        var outputs = [["stdout", "Standard output"],
+                       ["stderr", "Standard error"]];
+        for (var i = 0; i < outputs.length; i++) {
+            var name = outputs[i][0];
+            elements.push(kyua.element("h3", outputs[i][1]));
+            if (details[name] == "")
+                elements.push(kyua.element("p", "Test case did not write " +
+                    "anything to " + name + "."));
+            else
+                elements.push(kyua.element("pre", details[name]));
+        }
+
+        kyua.insert(row, elements);
+    }
+};
@@ -28,7 +28,9 @@
 
 #include "model/metadata.hpp"
 
+#include <map>
 #include <memory>
+#include <set>
 
 #include "model/exceptions.hpp"
 #include "model/types.hpp"
@@ -66,6 +68,25 @@ namespace {
 static optional< config::tree > defaults;
 
 
+/// Collection of interned metadata properties keyed by their textual form.
+typedef std::map< model::properties_map,
+                  std::weak_ptr< const config::tree > > interned_props_map;
+
+
+/// Global collection of interned metadata properties.
+///
+/// This is allocated on first use and never released so that metadata objects
+/// with static storage can be safely destroyed at program exit.  Entries are
+/// removed as soon as the last metadata object referencing them goes away.
+static interned_props_map* interned_props = NULL;
+
+
+/// Global arena of interned strings.
+///
+/// Strings in this arena live until the program exits.
+static std::set< std::string >* interned_strings = NULL;
+
+
 /// A leaf node that holds a bytes quantity.
 class bytes_node : public config::native_leaf_node< units::bytes > {
 public:
@@ -362,19 +383,111 @@ set(config::tree& tree, const std::string& key,
 }
 
 
+/// Deleter for interned metadata properties.
+///
+/// Removes the properties from the global collection of interned properties
+/// before releasing them.
+class interned_props_deleter {
+    /// Entry of the properties in interned_props.
+    interned_props_map::iterator _entry;
+
+public:
+    /// Constructor.
+    ///
+    /// \param entry_ Entry of the properties in interned_props.
+    explicit interned_props_deleter(const interned_props_map::iterator entry_) :
+        _entry(entry_)
+    {
+    }
+
+    /// Releases the properties.
+    ///
+    /// \param props The properties to release.
+    void
+    operator()(const config::tree* props)
+    {
+        interned_props->erase(_entry);
+        delete props;
+    }
+};
+
+
+/// Gets a shared copy of a set of metadata properties.
+///
+/// Metadata objects are created in large numbers (one per test case) but most
+/// of them hold the exact same properties.  Given that each tree is costly to
+/// keep around, all metadata objects with the same properties share a single
+/// tree.
+///
+/// \param props The properties to intern.  Must not be modified afterwards.
+///
+/// \return The shared copy of the properties, which may be props itself if
+/// these properties had not been seen before.
+static std::shared_ptr< const config::tree >
+intern_props(const config::tree& props)
+{
+    if (interned_props == NULL)
+        interned_props = new interned_props_map();
+
+    const std::pair< interned_props_map::iterator, bool > result =
+        interned_props->insert(interned_props_map::value_type(
+            props.all_properties(), std::weak_ptr< const config::tree >()));
+    if (!result.second) {
+        // Trees are considered equal if their textual forms match, so the key
+        // of the collection is enough to identify the properties.
+        const std::shared_ptr< const config::tree > interned =
+            (*result.first).second.lock();
+        INV(interned.get() != NULL);
+        return interned;
+    }
+
+    const std::shared_ptr< const config::tree > interned(
+        new config::tree(props), interned_props_deleter(result.first));
+    (*result.first).second = interned;
+    return interned;
+}
+
+
+/// Gets the shared copy of a string.
+///
+/// \param str The string to intern.
+///
+/// \return A pointer to the copy of the string in the arena.  All calls with
+/// the same string return the same pointer.
+static const std::string*
+intern_string(const std::string& str)
+{
+    if (interned_strings == NULL)
+        interned_strings = new std::set< std::string >();
+    return &*interned_strings->insert(str).first;
+}
+
+
 }  // anonymous namespace
 
 
 /// Internal implementation of the metadata class.
 struct model::metadata::impl : utils::noncopyable {
-    /// Metadata properties.
-    config::tree props;
+    /// Metadata properties, except for the description.
+    ///
+    /// This tree is shared with other metadata objects and must not be
+    /// modified.
+    std::shared_ptr< const config::tree > props;
+
+    /// Description of the test, or NULL if not set.
+    ///
+    /// The description is kept out of props because it is usually different
+    /// for every test case, which would defeat the sharing of the properties.
+    const std::string* description;
 
     /// Constructor.
     ///
     /// \param props_ Metadata properties of the test.
-    impl(const utils::config::tree& props_) :
-        props(props_)
+    /// \param description_ Description of the test, or NULL if not set.
+    impl(const std::shared_ptr< const config::tree > props_,
+         const std::string* description_) :
+        props(props_),
+        description(description_)
     {
     }
 
@@ -386,17 +499,28 @@ struct model::metadata::impl : utils::noncopyable {
     bool
     operator==(const impl& other) const
     {
-        return (get_defaults().combine(props) ==
-                get_defaults().combine(other.props));
+        static const std::string empty;
+        const std::string& this_description =
+            description != NULL ? *description : empty;
+        const std::string& other_description =
+            other.description != NULL ? *other.description : empty;
+        if (this_description != other_description)
+            return false;
+
+        return (props == other.props ||
+                get_defaults().combine(*props) ==
+                get_defaults().combine(*other.props));
     }
 };
 
 
 /// Constructor.
 ///
-/// \param props Metadata properties of the test.
-model::metadata::metadata(const utils::config::tree& props) :
-    _pimpl(new impl(props))
+/// \param props Metadata properties of the test, except for the description.
+/// \param description Description of the test, or NULL if not set.
+model::metadata::metadata(const std::shared_ptr< const config::tree > props,
+                          const std::string* description) :
+    _pimpl(new impl(props, description))
 {
 }
 
@@ -416,7 +540,11 @@ model::metadata::~metadata(void)
 model::metadata
 model::metadata::apply_overrides(const metadata& overrides) const
 {
-    return metadata(_pimpl->props.combine(overrides._pimpl->props));
+    return metadata(
+        std::shared_ptr< const config::tree >(new config::tree(
+            _pimpl->props->combine(*overrides._pimpl->props))),
+        overrides._pimpl->description != NULL ?
+        overrides._pimpl->description : _pimpl->description);
 }
 
 
@@ -426,8 +554,8 @@ model::metadata::apply_overrides(const metadata& overrides) const
 const model::strings_set&
 model::metadata::allowed_architectures(void) const
 {
-    if (_pimpl->props.is_set("allowed_architectures")) {
-        return _pimpl->props.lookup< config::strings_set_node >(
+    if (_pimpl->props->is_set("allowed_architectures")) {
+        return _pimpl->props->lookup< config::strings_set_node >(
             "allowed_architectures");
     } else {
         return get_defaults().lookup< config::strings_set_node >(
@@ -442,8 +570,8 @@ model::metadata::allowed_architectures(void) const
 const model::strings_set&
 model::metadata::allowed_platforms(void) const
 {
-    if (_pimpl->props.is_set("allowed_platforms")) {
-        return _pimpl->props.lookup< config::strings_set_node >(
+    if (_pimpl->props->is_set("allowed_platforms")) {
+        return _pimpl->props->lookup< config::strings_set_node >(
             "allowed_platforms");
     } else {
         return get_defaults().lookup< config::strings_set_node >(
@@ -458,7 +586,7 @@ model::metadata::allowed_platforms(void) const
 model::properties_map
 model::metadata::custom(void) const
 {
-    return _pimpl->props.all_properties("custom", true);
+    return _pimpl->props->all_properties("custom", true);
 }
 
 
@@ -468,8 +596,8 @@ model::metadata::custom(void) const
 const std::string&
 model::metadata::description(void) const
 {
-    if (_pimpl->props.is_set("description")) {
-        return _pimpl->props.lookup< config::string_node >("description");
+    if (_pimpl->description != NULL) {
+        return *_pimpl->description;
     } else {
         return get_defaults().lookup< config::string_node >("description");
     }
@@ -482,8 +610,8 @@ model::metadata::description(void) const
 bool
 model::metadata::has_cleanup(void) const
 {
-    if (_pimpl->props.is_set("has_cleanup")) {
-        return _pimpl->props.lookup< config::bool_node >("has_cleanup");
+    if (_pimpl->props->is_set("has_cleanup")) {
+        return _pimpl->props->lookup< config::bool_node >("has_cleanup");
     } else {
         return get_defaults().lookup< config::bool_node >("has_cleanup");
     }
@@ -497,8 +625,8 @@ model::metadata::has_cleanup(void) const
 bool
 model::metadata::is_exclusive(void) const
 {
-    if (_pimpl->props.is_set("is_exclusive")) {
-        return _pimpl->props.lookup< config::bool_node >("is_exclusive");
+    if (_pimpl->props->is_set("is_exclusive")) {
+        return _pimpl->props->lookup< config::bool_node >("is_exclusive");
     } else {
         return get_defaults().lookup< config::bool_node >("is_exclusive");
     }
@@ -511,8 +639,8 @@ model::metadata::is_exclusive(void) const
 const model::strings_set&
 model::metadata::required_configs(void) const
 {
-    if (_pimpl->props.is_set("required_configs")) {
-        return _pimpl->props.lookup< config::strings_set_node >(
+    if (_pimpl->props->is_set("required_configs")) {
+        return _pimpl->props->lookup< config::strings_set_node >(
             "required_configs");
     } else {
         return get_defaults().lookup< config::strings_set_node >(
@@ -527,8 +655,8 @@ model::metadata::required_configs(void) const
 const units::bytes&
 model::metadata::required_disk_space(void) const
 {
-    if (_pimpl->props.is_set("required_disk_space")) {
-        return _pimpl->props.lookup< bytes_node >("required_disk_space");
+    if (_pimpl->props->is_set("required_disk_space")) {
+        return _pimpl->props->lookup< bytes_node >("required_disk_space");
     } else {
         return get_defaults().lookup< bytes_node >("required_disk_space");
     }
@@ -541,8 +669,8 @@ model::metadata::required_disk_space(void) const
 const model::paths_set&
 model::metadata::required_files(void) const
 {
-    if (_pimpl->props.is_set("required_files")) {
-        return _pimpl->props.lookup< paths_set_node >("required_files");
+    if (_pimpl->props->is_set("required_files")) {
+        return _pimpl->props->lookup< paths_set_node >("required_files");
     } else {
         return get_defaults().lookup< paths_set_node >("required_files");
     }
@@ -555,8 +683,8 @@ model::metadata::required_files(void) const
 const units::bytes&
 model::metadata::required_memory(void) const
 {
-    if (_pimpl->props.is_set("required_memory")) {
-        return _pimpl->props.lookup< bytes_node >("required_memory");
+    if (_pimpl->props->is_set("required_memory")) {
+        return _pimpl->props->lookup< bytes_node >("required_memory");
     } else {
         return get_defaults().lookup< bytes_node >("required_memory");
     }
@@ -569,8 +697,8 @@ model::metadata::required_memory(void) const
 const model::paths_set&
 model::metadata::required_programs(void) const
 {
-    if (_pimpl->props.is_set("required_programs")) {
-        return _pimpl->props.lookup< paths_set_node >("required_programs");
+    if (_pimpl->props->is_set("required_programs")) {
+        return _pimpl->props->lookup< paths_set_node >("required_programs");
     } else {
         return get_defaults().lookup< paths_set_node >("required_programs");
     }
@@ -583,8 +711,8 @@ model::metadata::required_programs(void) const
 const std::string&
 model::metadata::required_user(void) const
 {
-    if (_pimpl->props.is_set("required_user")) {
-        return _pimpl->props.lookup< user_node >("required_user");
+    if (_pimpl->props->is_set("required_user")) {
+        return _pimpl->props->lookup< user_node >("required_user");
     } else {
         return get_defaults().lookup< user_node >("required_user");
     }
@@ -598,8 +726,8 @@ model::metadata::required_user(void) const
 const datetime::delta&
 model::metadata::timeout(void) const
 {
-    if (_pimpl->props.is_set("timeout")) {
-        return _pimpl->props.lookup< delta_node >("timeout");
+    if (_pimpl->props->is_set("timeout")) {
+        return _pimpl->props->lookup< delta_node >("timeout");
     } else {
         return get_defaults().lookup< delta_node >("timeout");
     }
@@ -612,8 +740,28 @@ model::metadata::timeout(void) const
 model::properties_map
 model::metadata::to_properties(void) const
 {
-    const config::tree fully_specified = get_defaults().combine(_pimpl->props);
-    return fully_specified.all_properties();
+    const config::tree fully_specified = get_defaults().combine(
+        *_pimpl->props);
+    model::properties_map props = fully_specified.all_properties();
+    props["description"] = description();
+    return props;
+}
+
+
+/// Externalizes the explicitly-set metadata to a set of key/value pairs.
+///
+/// Unlike to_properties(), this does not fill in the defaults of the unset
+/// properties, so the result can be used to rebuild an object that still
+/// inherits those properties from, e.g., the metadata of its test program.
+///
+/// \return A key/value representation of the set properties.
+model::properties_map
+model::metadata::to_set_properties(void) const
+{
+    model::properties_map props = _pimpl->props->all_properties();
+    if (_pimpl->description != NULL)
+        props["description"] = *_pimpl->description;
+    return props;
 }
 
 
@@ -670,9 +818,12 @@ model::operator<<(std::ostream& output, const metadata& object)
 
 /// Internal implementation of the metadata_builder class.
 struct model::metadata_builder::impl : utils::noncopyable {
-    /// Collection of requirements.
+    /// Collection of requirements, except for the description.
     config::tree props;
 
+    /// Description of the test, if set.
+    optional< std::string > description;
+
     /// Whether we have created a metadata object or not.
     bool built;
 
@@ -685,9 +836,11 @@ struct model::metadata_builder::impl : utils::noncopyable {
 
     /// Constructor.
     impl(const model::metadata& base) :
-        props(base._pimpl->props.deep_copy()),
+        props(base._pimpl->props->deep_copy()),
         built(false)
     {
+        if (base._pimpl->description != NULL)
+            description = *base._pimpl->description;
     }
 };
 
@@ -895,7 +1048,7 @@ model::metadata_builder::set_custom(const model::properties_map& props)
 model::metadata_builder&
 model::metadata_builder::set_description(const std::string& description)
 {
-    set< config::string_node >(_pimpl->props, "description", description);
+    _pimpl->description = description;
     return *this;
 }
 
@@ -1032,6 +1185,11 @@ model::metadata_builder&
 model::metadata_builder::set_string(const std::string& key,
                                     const std::string& value)
 {
+    if (key == "description") {
+        _pimpl->description = value;
+        return *this;
+    }
+
     try {
         _pimpl->props.set_string(key, value);
     } catch (const config::unknown_key_error& e) {
@@ -1074,5 +1232,7 @@ model::metadata_builder::build(void) const
     PRE(!_pimpl->built);
     _pimpl->built = true;
 
-    return metadata(_pimpl->props);
+    return metadata(intern_props(_pimpl->props),
+                    _pimpl->description ?
+                    intern_string(_pimpl->description.get()) : NULL);
 }
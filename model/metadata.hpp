@@ -58,8 +58,10 @@ class metadata {
 
     friend class metadata_builder;
 
+    metadata(const std::shared_ptr< const utils::config::tree >,
+             const std::string*);
+
 public:
-    metadata(const utils::config::tree&);
     ~metadata(void);
 
     metadata apply_overrides(const metadata&) const;
@@ -79,6 +81,7 @@ public:
     const utils::datetime::delta& timeout(void) const;
 
     model::properties_map to_properties(void) const;
+    model::properties_map to_set_properties(void) const;
 
     bool operator==(const metadata&) const;
     bool operator!=(const metadata&) const;
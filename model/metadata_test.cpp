@@ -298,6 +298,40 @@ ATF_TEST_CASE_BODY(override_all_with_set_string)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(interned);
+ATF_TEST_CASE_BODY(interned)
+{
+    const model::metadata md1 = model::metadata_builder()
+        .add_allowed_architecture("a")
+        .set_description("First")
+        .build();
+    const model::metadata md2 = model::metadata_builder()
+        .add_allowed_architecture("a")
+        .set_description("Second")
+        .build();
+    const model::metadata md3 = model::metadata_builder()
+        .add_allowed_architecture("b")
+        .set_description("First")
+        .build();
+
+    ATF_REQUIRE_EQ("First", md1.description());
+    ATF_REQUIRE_EQ("Second", md2.description());
+    ATF_REQUIRE_EQ("First", md3.description());
+    ATF_REQUIRE(md1 != md2);
+
+    ATF_REQUIRE_EQ(&md1.allowed_architectures(), &md2.allowed_architectures());
+    ATF_REQUIRE(&md1.allowed_architectures() != &md3.allowed_architectures());
+    ATF_REQUIRE_EQ(&md1.description(), &md3.description());
+
+    const model::metadata md4 = model::metadata_builder(md1)
+        .add_allowed_architecture("c")
+        .build();
+    ATF_REQUIRE_EQ(2, md4.allowed_architectures().size());
+    ATF_REQUIRE_EQ("First", md4.description());
+    ATF_REQUIRE_EQ(1, md1.allowed_architectures().size());
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(to_properties);
 ATF_TEST_CASE_BODY(to_properties)
 {
@@ -327,6 +361,29 @@ ATF_TEST_CASE_BODY(to_properties)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(to_set_properties);
+ATF_TEST_CASE_BODY(to_set_properties)
+{
+    const model::metadata md = model::metadata_builder()
+        .add_allowed_architecture("abc")
+        .set_required_memory(units::bytes(1024))
+        .set_timeout(datetime::delta(300, 0))
+        .add_custom("foo", "bar")
+        .build();
+
+    model::properties_map props;
+    props["allowed_architectures"] = "abc";
+    props["custom.foo"] = "bar";
+    props["required_memory"] = "1.00K";
+    props["timeout"] = "300";
+    ATF_REQUIRE_EQ(props, md.to_set_properties());
+
+    props["description"] = "";
+    ATF_REQUIRE_EQ(props, model::metadata_builder(md).set_description("")
+                   .build().to_set_properties());
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(operators_eq_and_ne__empty);
 ATF_TEST_CASE_BODY(operators_eq_and_ne__empty)
 {
@@ -384,6 +441,18 @@ ATF_TEST_CASE_BODY(operators_eq_and_ne__equal_overriden_defaults)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(operators_eq_and_ne__empty_description);
+ATF_TEST_CASE_BODY(operators_eq_and_ne__empty_description)
+{
+    const model::metadata md1 = model::metadata_builder().build();
+    const model::metadata md2 = model::metadata_builder()
+        .set_description("")
+        .build();
+    ATF_REQUIRE(  md1 == md2);
+    ATF_REQUIRE(!(md1 != md2));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(operators_eq_and_ne__different);
 ATF_TEST_CASE_BODY(operators_eq_and_ne__different)
 {
@@ -444,12 +513,15 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, apply_overrides);
     ATF_ADD_TEST_CASE(tcs, override_all_with_setters);
     ATF_ADD_TEST_CASE(tcs, override_all_with_set_string);
+    ATF_ADD_TEST_CASE(tcs, interned);
     ATF_ADD_TEST_CASE(tcs, to_properties);
+    ATF_ADD_TEST_CASE(tcs, to_set_properties);
 
     ATF_ADD_TEST_CASE(tcs, operators_eq_and_ne__empty);
     ATF_ADD_TEST_CASE(tcs, operators_eq_and_ne__copy);
     ATF_ADD_TEST_CASE(tcs, operators_eq_and_ne__equal);
     ATF_ADD_TEST_CASE(tcs, operators_eq_and_ne__equal_overriden_defaults);
+    ATF_ADD_TEST_CASE(tcs, operators_eq_and_ne__empty_description);
     ATF_ADD_TEST_CASE(tcs, operators_eq_and_ne__different);
 
     ATF_ADD_TEST_CASE(tcs, output__defaults);
@@ -0,0 +1,530 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "store/catalog.hpp"
+
+extern "C" {
+#include <stdint.h>
+}
+
+#include <cctype>
+#include <cstring>
+#include <set>
+
+#include "model/test_result.hpp"
+#include "store/dbtypes.hpp"
+#include "store/exceptions.hpp"
+#include "utils/datetime.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/directory.hpp"
+#include "utils/fs/exceptions.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/logging/macros.hpp"
+#include "utils/noncopyable.hpp"
+#include "utils/optional.ipp"
+#include "utils/sqlite/database.hpp"
+#include "utils/sqlite/exceptions.hpp"
+#include "utils/sqlite/statement.ipp"
+#include "utils/sqlite/transaction.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace sqlite = utils::sqlite;
+
+using utils::none;
+using utils::optional;
+
+
+namespace {
+
+
+/// Name of the catalog database within the store directory.
+static const char* catalog_name = "catalog.db";
+
+
+/// Definition of the catalog tables.
+///
+/// The catalog can be rebuilt at any time from the store directory, so we do
+/// not bother versioning its schema like we do for the results files.
+static const char* catalog_schema =
+    "CREATE TABLE IF NOT EXISTS runs ("
+    "    file_name TEXT PRIMARY KEY,"
+    "    test_suite TEXT NOT NULL,"
+    "    timestamp TEXT NOT NULL,"
+    "    duration INTEGER"
+    ");"
+    "CREATE INDEX IF NOT EXISTS index_runs_by_test_suite"
+    "    ON runs (test_suite, timestamp);"
+    "CREATE TABLE IF NOT EXISTS run_counts ("
+    "    file_name TEXT NOT NULL REFERENCES runs,"
+    "    result_type TEXT NOT NULL,"
+    "    count INTEGER NOT NULL,"
+    "    PRIMARY KEY (file_name, result_type)"
+    ");"
+    "CREATE TABLE IF NOT EXISTS store_state ("
+    "    store_mtime INTEGER NOT NULL"
+    ");";
+
+
+/// Checks if a string is a timestamp as encoded in results file names.
+///
+/// \param str The string to check.
+///
+/// \return True if the string has the YYYYMMDD-HHMMSS-uuuuuu form.
+static bool
+is_timestamp(const std::string& str)
+{
+    const char* format = "00000000-000000-000000";
+    if (str.length() != std::strlen(format))
+        return false;
+    for (std::string::size_type i = 0; i < str.length(); ++i) {
+        if (format[i] == '-') {
+            if (str[i] != '-')
+                return false;
+        } else {
+            if (!std::isdigit(static_cast< unsigned char >(str[i])))
+                return false;
+        }
+    }
+    return true;
+}
+
+
+/// Splits the name of a results file into its components.
+///
+/// \param name The base name of the file.
+/// \param [out] test_suite The identifier of the test suite, if the name is
+///     valid.
+/// \param [out] timestamp The timestamp of the run, if the name is valid.
+///
+/// \return True if the name is that of a results file; false otherwise.
+static bool
+parse_file_name(const std::string& name, std::string& test_suite,
+                std::string& timestamp)
+{
+    const std::string prefix = "results.";
+    const std::string suffix = ".db";
+
+    if (name.length() <= prefix.length() + suffix.length() ||
+        name.compare(0, prefix.length(), prefix) != 0 ||
+        name.compare(name.length() - suffix.length(), suffix.length(),
+                     suffix) != 0)
+        return false;
+
+    const std::string id = name.substr(
+        prefix.length(), name.length() - prefix.length() - suffix.length());
+    const std::string::size_type dot = id.rfind('.');
+    if (dot == std::string::npos || dot == 0 ||
+        !is_timestamp(id.substr(dot + 1)))
+        return false;
+
+    test_suite = id.substr(0, dot);
+    timestamp = id.substr(dot + 1);
+    return true;
+}
+
+
+/// Inserts or replaces a run in the catalog.
+///
+/// \param db The catalog database.
+/// \param file_name Base name of the results file.
+/// \param test_suite Identifier of the test suite of the run.
+/// \param timestamp Timestamp of the run.
+/// \param summary Summary of the results of the run, if it finished.
+///
+/// \throw sqlite::error If there is a problem writing to the database.
+static void
+put_run(sqlite::database& db, const std::string& file_name,
+        const std::string& test_suite, const std::string& timestamp,
+        const optional< store::results_summary >& summary)
+{
+    sqlite::statement delete_stmt = db.create_statement(
+        "DELETE FROM run_counts WHERE file_name == :file_name");
+    delete_stmt.bind(":file_name", file_name);
+    delete_stmt.step_without_results();
+
+    sqlite::statement stmt = db.create_statement(
+        "INSERT OR REPLACE INTO runs (file_name, test_suite, timestamp, "
+        "                             duration) "
+        "VALUES (:file_name, :test_suite, :timestamp, :duration)");
+    stmt.bind(":file_name", file_name);
+    stmt.bind(":test_suite", test_suite);
+    stmt.bind(":timestamp", timestamp);
+    if (summary)
+        store::bind_delta(stmt, ":duration", summary.get().duration);
+    else
+        stmt.bind(":duration", sqlite::null());
+    stmt.step_without_results();
+
+    if (!summary)
+        return;
+
+    sqlite::statement counts_stmt = db.create_statement(
+        "INSERT INTO run_counts (file_name, result_type, count) "
+        "VALUES (:file_name, :result_type, :count)");
+    counts_stmt.bind(":file_name", file_name);
+    for (std::map< model::test_result_type, std::size_t >::const_iterator
+             iter = summary.get().counts.begin();
+         iter != summary.get().counts.end(); ++iter) {
+        store::bind_test_result_type(counts_stmt, ":result_type",
+                                     (*iter).first);
+        counts_stmt.bind(":count", static_cast< int64_t >((*iter).second));
+        counts_stmt.step_without_results();
+        counts_stmt.reset();
+    }
+}
+
+
+/// Removes a run from the catalog.
+///
+/// \param db The catalog database.
+/// \param file_name Base name of the results file.
+///
+/// \throw sqlite::error If there is a problem writing to the database.
+static void
+delete_run(sqlite::database& db, const std::string& file_name)
+{
+    sqlite::statement counts_stmt = db.create_statement(
+        "DELETE FROM run_counts WHERE file_name == :file_name");
+    counts_stmt.bind(":file_name", file_name);
+    counts_stmt.step_without_results();
+
+    sqlite::statement stmt = db.create_statement(
+        "DELETE FROM runs WHERE file_name == :file_name");
+    stmt.bind(":file_name", file_name);
+    stmt.step_without_results();
+}
+
+
+}  // anonymous namespace
+
+
+/// Constructs a new catalog entry.
+///
+/// \param file_ Path to the results file.
+/// \param test_suite_ Identifier of the test suite the results belong to.
+/// \param timestamp_ Timestamp of the run, as encoded in the file name.
+/// \param summary_ Summary of the results, if the run finished.
+store::catalog_entry::catalog_entry(
+    const fs::path& file_, const std::string& test_suite_,
+    const std::string& timestamp_,
+    const optional< results_summary >& summary_) :
+    file(file_), test_suite(test_suite_), timestamp(timestamp_),
+    summary(summary_)
+{
+}
+
+
+/// Internal implementation for the catalog.
+struct store::catalog::impl : utils::noncopyable {
+    /// Path to the store directory described by the catalog.
+    fs::path store_dir;
+
+    /// The SQLite database holding the catalog.
+    sqlite::database db;
+
+    /// Constructor.
+    ///
+    /// \param store_dir_ Path to the store directory.
+    /// \param db_ The SQLite database holding the catalog.
+    impl(const fs::path& store_dir_, sqlite::database& db_) :
+        store_dir(store_dir_), db(db_)
+    {
+    }
+
+    /// Brings the list of files in the catalog in line with the directory.
+    ///
+    /// This is cheap if the directory has not been modified since the last
+    /// time we looked at it.
+    ///
+    /// \throw sqlite::error If there is a problem accessing the catalog.
+    /// \throw fs::error If there is a problem scanning the directory.
+    void
+    sync(void)
+    {
+        const datetime::timestamp now = datetime::timestamp::now();
+        const datetime::timestamp mtime = fs::modification_time(store_dir);
+
+        {
+            sqlite::statement stmt = db.create_statement(
+                "SELECT store_mtime FROM store_state");
+            if (stmt.step() && column_timestamp(stmt, "store_mtime") == mtime)
+                return;
+        }
+
+        LI(F("Synchronizing catalog with the contents of %s") % store_dir);
+
+        sqlite::transaction tx = db.begin_transaction();
+
+        std::set< std::string > stale;
+        {
+            sqlite::statement stmt = db.create_statement(
+                "SELECT file_name FROM runs");
+            while (stmt.step())
+                stale.insert(stmt.safe_column_text("file_name"));
+        }
+
+        const fs::directory dir(store_dir);
+        for (fs::directory::const_iterator iter = dir.begin();
+             iter != dir.end(); ++iter) {
+            std::string test_suite, timestamp;
+            if (!parse_file_name(iter->name, test_suite, timestamp))
+                continue;
+
+            if (stale.erase(iter->name) == 0) {
+                LD(F("Adding %s to the catalog") % iter->name);
+                put_run(db, iter->name, test_suite, timestamp, none);
+            }
+        }
+
+        for (std::set< std::string >::const_iterator iter = stale.begin();
+             iter != stale.end(); ++iter) {
+            LD(F("Removing %s from the catalog") % *iter);
+            delete_run(db, *iter);
+        }
+
+        // A file created right after we scanned the directory may not alter
+        // its modification time, so only remember the latter once it is old
+        // enough for this to be impossible.
+        db.exec("DELETE FROM store_state");
+        if (fs::is_stable_mtime(mtime, now)) {
+            sqlite::statement stmt = db.create_statement(
+                "INSERT INTO store_state (store_mtime) VALUES (:store_mtime)");
+            bind_timestamp(stmt, ":store_mtime", mtime);
+            stmt.step_without_results();
+        }
+
+        tx.commit();
+    }
+};
+
+
+/// Constructs a new catalog.
+///
+/// \param pimpl_ The internal data.
+store::catalog::catalog(impl* pimpl_) :
+    _pimpl(pimpl_)
+{
+}
+
+
+/// Destructor.
+store::catalog::~catalog(void)
+{
+}
+
+
+/// Opens the catalog of a store directory, creating it if necessary.
+///
+/// \param store_dir Path to the store directory.  Must exist.
+///
+/// \return The catalog.
+///
+/// \throw store::error If the catalog cannot be opened or created.
+store::catalog
+store::catalog::open(const fs::path& store_dir)
+{
+    const fs::path file = store_dir / catalog_name;
+    try {
+        sqlite::database db = sqlite::database::open(
+            file, sqlite::open_readwrite | sqlite::open_create);
+        db.exec("PRAGMA busy_timeout = 10000");
+        // Keep the rollback journal around after transactions so that our own
+        // writes do not change the modification time of the store directory.
+        db.exec("PRAGMA journal_mode = PERSIST");
+        db.exec(catalog_schema);
+        return catalog(new impl(store_dir, db));
+    } catch (const sqlite::error& e) {
+        throw error(F("Cannot open catalog %s: %s") % file % e.what());
+    }
+}
+
+
+/// Records a new run whose results are still being written.
+///
+/// \param file Path to the results file, which must live in the store
+///     directory.  Files whose name does not follow the scheme of the store
+///     directory are ignored.
+///
+/// \throw store::error If there is a problem updating the catalog.
+void
+store::catalog::add(const fs::path& file)
+{
+    std::string test_suite, timestamp;
+    if (!parse_file_name(file.leaf_name(), test_suite, timestamp)) {
+        LD(F("Not adding %s to the catalog: not a results file") % file);
+        return;
+    }
+
+    try {
+        sqlite::transaction tx = _pimpl->db.begin_transaction();
+        put_run(_pimpl->db, file.leaf_name(), test_suite, timestamp, none);
+        tx.commit();
+    } catch (const sqlite::error& e) {
+        throw error(F("Cannot add %s to the catalog: %s") % file % e.what());
+    }
+}
+
+
+/// Records the summary of a finished run.
+///
+/// \param file Path to the results file, which must live in the store
+///     directory.  Files whose name does not follow the scheme of the store
+///     directory are ignored.
+/// \param summary Summary of all the results in the file.
+///
+/// \throw store::error If there is a problem updating the catalog.
+void
+store::catalog::put_summary(const fs::path& file,
+                            const results_summary& summary)
+{
+    std::string test_suite, timestamp;
+    if (!parse_file_name(file.leaf_name(), test_suite, timestamp)) {
+        LD(F("Not adding %s to the catalog: not a results file") % file);
+        return;
+    }
+
+    try {
+        sqlite::transaction tx = _pimpl->db.begin_transaction();
+        put_run(_pimpl->db, file.leaf_name(), test_suite, timestamp,
+                utils::make_optional(summary));
+        tx.commit();
+    } catch (const sqlite::error& e) {
+        throw error(F("Cannot add %s to the catalog: %s") % file % e.what());
+    }
+}
+
+
+/// Forgets about a results file.
+///
+/// \param file Path to the results file.
+///
+/// \throw store::error If there is a problem updating the catalog.
+void
+store::catalog::remove(const fs::path& file)
+{
+    try {
+        sqlite::transaction tx = _pimpl->db.begin_transaction();
+        delete_run(_pimpl->db, file.leaf_name());
+        tx.commit();
+    } catch (const sqlite::error& e) {
+        throw error(F("Cannot remove %s from the catalog: %s") % file %
+                    e.what());
+    }
+}
+
+
+/// Locates the results file of the latest run of a test suite.
+///
+/// \param test_suite Identifier of the test suite to query.
+///
+/// \return Path to the results file, or none if there are no results files
+/// for the given test suite.
+///
+/// \throw store::error If there is a problem querying the catalog.
+optional< fs::path >
+store::catalog::find_latest(const std::string& test_suite)
+{
+    try {
+        _pimpl->sync();
+
+        sqlite::statement stmt = _pimpl->db.create_statement(
+            "SELECT file_name FROM runs WHERE test_suite == :test_suite "
+            "ORDER BY timestamp DESC LIMIT 1");
+        stmt.bind(":test_suite", test_suite);
+        if (stmt.step())
+            return utils::make_optional(
+                _pimpl->store_dir / stmt.safe_column_text("file_name"));
+        else
+            return none;
+    } catch (const fs::error& e) {
+        throw error(F("Cannot synchronize catalog: %s") % e.what());
+    } catch (const sqlite::error& e) {
+        throw error(F("Cannot query catalog: %s") % e.what());
+    }
+}
+
+
+/// Lists the runs recorded in the catalog.
+///
+/// \param test_suite If not none, only return the runs of this test suite.
+///
+/// \return The runs, sorted by test suite and then by timestamp.
+///
+/// \throw store::error If there is a problem querying the catalog.
+store::catalog_entries
+store::catalog::list(const optional< std::string >& test_suite)
+{
+    catalog_entries entries;
+    try {
+        _pimpl->sync();
+
+        sqlite::statement stmt = _pimpl->db.create_statement(
+            std::string("SELECT file_name, test_suite, timestamp, duration "
+                        "FROM runs ") +
+            (test_suite ? "WHERE test_suite == :test_suite " : "") +
+            "ORDER BY test_suite, timestamp");
+        if (test_suite)
+            stmt.bind(":test_suite", test_suite.get());
+
+        sqlite::statement counts_stmt = _pimpl->db.create_statement(
+            "SELECT result_type, count FROM run_counts "
+            "WHERE file_name == :file_name");
+
+        while (stmt.step()) {
+            const std::string file_name = stmt.safe_column_text("file_name");
+
+            optional< results_summary > summary;
+            if (stmt.column_type(stmt.column_id("duration")) !=
+                sqlite::type_null) {
+                results_summary run_summary;
+                run_summary.duration = column_delta(stmt, "duration");
+
+                counts_stmt.reset();
+                counts_stmt.bind(":file_name", file_name);
+                while (counts_stmt.step()) {
+                    run_summary.counts[column_test_result_type(
+                        counts_stmt, "result_type")] =
+                        static_cast< std::size_t >(
+                            counts_stmt.safe_column_int64("count"));
+                }
+                summary = run_summary;
+            }
+
+            entries.push_back(catalog_entry(
+                _pimpl->store_dir / file_name,
+                stmt.safe_column_text("test_suite"),
+                stmt.safe_column_text("timestamp"), summary));
+        }
+    } catch (const fs::error& e) {
+        throw error(F("Cannot synchronize catalog: %s") % e.what());
+    } catch (const sqlite::error& e) {
+        throw error(F("Cannot query catalog: %s") % e.what());
+    }
+    return entries;
+}
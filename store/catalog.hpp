@@ -0,0 +1,104 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file store/catalog.hpp
+/// Index of the results files in the store directory.
+///
+/// The catalog is a small database that lives alongside the results files in
+/// the store directory and records which files exist, the test suite and
+/// timestamp they belong to and, for the runs that have finished, a summary of
+/// their results.  This allows locating the latest results file of a test
+/// suite and listing past runs without scanning the directory or opening every
+/// results file.
+///
+/// The catalog is merely a cache: the results files are the authoritative
+/// source of data.  Files added to or removed from the store directory behind
+/// our back are detected by looking at the modification time of the directory,
+/// in which case the list of files in the catalog is resynchronized.
+
+#if !defined(STORE_CATALOG_HPP)
+#define STORE_CATALOG_HPP
+
+#include "store/catalog_fwd.hpp"
+
+#include <string>
+
+#include "store/read_transaction.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/optional.hpp"
+#include "utils/shared_ptr.hpp"
+
+namespace store {
+
+
+/// Information about a results file recorded in the catalog.
+struct catalog_entry {
+    /// Path to the results file.
+    utils::fs::path file;
+
+    /// Identifier of the test suite the results belong to.
+    std::string test_suite;
+
+    /// Timestamp of the run, as encoded in the name of the file.
+    std::string timestamp;
+
+    /// Summary of the results, or none if the run has not finished yet.
+    utils::optional< results_summary > summary;
+
+    catalog_entry(const utils::fs::path&, const std::string&,
+                  const std::string&,
+                  const utils::optional< results_summary >&);
+};
+
+
+/// Handle to the catalog of a store directory.
+class catalog {
+    struct impl;
+
+    /// Pointer to the shared internal implementation.
+    std::shared_ptr< impl > _pimpl;
+
+    catalog(impl*);
+
+public:
+    ~catalog(void);
+
+    static catalog open(const utils::fs::path&);
+
+    void add(const utils::fs::path&);
+    void put_summary(const utils::fs::path&, const results_summary&);
+    void remove(const utils::fs::path&);
+
+    utils::optional< utils::fs::path > find_latest(const std::string&);
+    catalog_entries list(const utils::optional< std::string >&);
+};
+
+
+}  // namespace store
+
+#endif  // !defined(STORE_CATALOG_HPP)
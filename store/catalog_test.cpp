@@ -0,0 +1,193 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "store/catalog.hpp"
+
+#include <atf-c++.hpp>
+
+#include "model/test_result.hpp"
+#include "store/exceptions.hpp"
+#include "utils/datetime.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/logging/operations.hpp"
+#include "utils/optional.ipp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace logging = utils::logging;
+
+using utils::none;
+using utils::optional;
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(open__missing_dir);
+ATF_TEST_CASE_BODY(open__missing_dir)
+{
+    ATF_REQUIRE_THROW_RE(store::error, "Cannot open catalog",
+                         store::catalog::open(fs::path("missing")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(find_latest);
+ATF_TEST_CASE_BODY(find_latest)
+{
+    logging::set_inmemory();
+
+    const fs::path store_dir("store");
+    fs::mkdir(store_dir, 0755);
+    atf::utils::create_file(
+        (store_dir / "results.a.20140613-194515-000000.db").str(), "");
+    atf::utils::create_file(
+        (store_dir / "results.a.20140614-194515-123456.db").str(), "");
+    atf::utils::create_file(
+        (store_dir / "results.a.b.20150101-000000-000000.db").str(), "");
+    atf::utils::create_file(
+        (store_dir / "results.a.20160101-000000-00000.db").str(), "");
+    atf::utils::create_file((store_dir / "something-else.db").str(), "");
+
+    store::catalog catalog = store::catalog::open(store_dir);
+    ATF_REQUIRE_EQ(store_dir / "results.a.20140614-194515-123456.db",
+                   catalog.find_latest("a").get());
+    ATF_REQUIRE_EQ(store_dir / "results.a.b.20150101-000000-000000.db",
+                   catalog.find_latest("a.b").get());
+    ATF_REQUIRE(!catalog.find_latest("b"));
+
+    atf::utils::create_file(
+        (store_dir / "results.a.20140615-000000-000000.db").str(), "");
+    ATF_REQUIRE_EQ(store_dir / "results.a.20140615-000000-000000.db",
+                   catalog.find_latest("a").get());
+
+    fs::unlink(store_dir / "results.a.20140615-000000-000000.db");
+    fs::unlink(store_dir / "results.a.20140614-194515-123456.db");
+    ATF_REQUIRE_EQ(store_dir / "results.a.20140613-194515-000000.db",
+                   catalog.find_latest("a").get());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(find_latest__persistent);
+ATF_TEST_CASE_BODY(find_latest__persistent)
+{
+    logging::set_inmemory();
+
+    const fs::path store_dir("store");
+    fs::mkdir(store_dir, 0755);
+    atf::utils::create_file(
+        (store_dir / "results.a.20140613-194515-000000.db").str(), "");
+
+    {
+        store::catalog catalog = store::catalog::open(store_dir);
+        ATF_REQUIRE_EQ(store_dir / "results.a.20140613-194515-000000.db",
+                       catalog.find_latest("a").get());
+    }
+    ATF_REQUIRE(fs::exists(store_dir / "catalog.db"));
+
+    store::catalog catalog = store::catalog::open(store_dir);
+    ATF_REQUIRE_EQ(store_dir / "results.a.20140613-194515-000000.db",
+                   catalog.find_latest("a").get());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(add_and_put_summary);
+ATF_TEST_CASE_BODY(add_and_put_summary)
+{
+    logging::set_inmemory();
+
+    const fs::path store_dir("store");
+    fs::mkdir(store_dir, 0755);
+    const fs::path file1 = store_dir / "results.a.20140613-194515-000000.db";
+    const fs::path file2 = store_dir / "results.b.20140614-194515-000000.db";
+    atf::utils::create_file(file1.str(), "");
+    atf::utils::create_file(file2.str(), "");
+
+    store::catalog catalog = store::catalog::open(store_dir);
+    catalog.add(file1);
+    catalog.add(file2);
+    catalog.add(fs::path("not-a-results-file.db"));
+
+    store::results_summary summary;
+    summary.counts[model::test_result_passed] = 5;
+    summary.counts[model::test_result_failed] = 2;
+    summary.duration = datetime::delta(12, 345);
+    catalog.put_summary(file2, summary);
+
+    const store::catalog_entries entries = catalog.list(none);
+    ATF_REQUIRE_EQ(2, entries.size());
+
+    ATF_REQUIRE_EQ(file1, entries[0].file);
+    ATF_REQUIRE_EQ("a", entries[0].test_suite);
+    ATF_REQUIRE_EQ("20140613-194515-000000", entries[0].timestamp);
+    ATF_REQUIRE(!entries[0].summary);
+
+    ATF_REQUIRE_EQ(file2, entries[1].file);
+    ATF_REQUIRE_EQ("b", entries[1].test_suite);
+    ATF_REQUIRE_EQ("20140614-194515-000000", entries[1].timestamp);
+    ATF_REQUIRE(entries[1].summary);
+    ATF_REQUIRE(summary.counts == entries[1].summary.get().counts);
+    ATF_REQUIRE_EQ(summary.duration, entries[1].summary.get().duration);
+
+    const store::catalog_entries b_entries = catalog.list(
+        utils::make_optional(std::string("b")));
+    ATF_REQUIRE_EQ(1, b_entries.size());
+    ATF_REQUIRE_EQ(file2, b_entries[0].file);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(remove);
+ATF_TEST_CASE_BODY(remove)
+{
+    logging::set_inmemory();
+
+    const fs::path store_dir("store");
+    fs::mkdir(store_dir, 0755);
+    const fs::path file1 = store_dir / "results.a.20140613-194515-000000.db";
+    const fs::path file2 = store_dir / "results.a.20140614-194515-000000.db";
+    atf::utils::create_file(file1.str(), "");
+    atf::utils::create_file(file2.str(), "");
+
+    store::catalog catalog = store::catalog::open(store_dir);
+    ATF_REQUIRE_EQ(file2, catalog.find_latest("a").get());
+
+    fs::unlink(file2);
+    catalog.remove(file2);
+    ATF_REQUIRE_EQ(file1, catalog.find_latest("a").get());
+    ATF_REQUIRE_EQ(1, catalog.list(none).size());
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, open__missing_dir);
+
+    ATF_ADD_TEST_CASE(tcs, find_latest);
+    ATF_ADD_TEST_CASE(tcs, find_latest__persistent);
+
+    ATF_ADD_TEST_CASE(tcs, add_and_put_summary);
+
+    ATF_ADD_TEST_CASE(tcs, remove);
+}
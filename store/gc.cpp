@@ -0,0 +1,444 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "store/gc.hpp"
+
+extern "C" {
+#include <stdint.h>
+}
+
+#include <algorithm>
+#include <vector>
+
+#include "model/test_result.hpp"
+#include "store/catalog.hpp"
+#include "store/exceptions.hpp"
+#include "store/read_backend.hpp"
+#include "store/read_transaction.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/exceptions.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/logging/macros.hpp"
+#include "utils/optional.ipp"
+#include "utils/sqlite/database.hpp"
+#include "utils/sqlite/exceptions.hpp"
+#include "utils/sqlite/statement.ipp"
+#include "utils/sqlite/transaction.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace sqlite = utils::sqlite;
+namespace units = utils::units;
+
+using utils::none;
+using utils::optional;
+
+
+namespace {
+
+
+/// Collection of runs, referenced from a catalog_entries vector.
+typedef std::vector< const store::catalog_entry* > entry_ptrs_vector;
+
+
+/// Checks whether a run had any failures.
+///
+/// \param entry The run to check.
+///
+/// \return True if the run has failed or broken test cases; false otherwise,
+/// including when the results of the run are unknown.
+static bool
+has_failures(const store::catalog_entry& entry)
+{
+    if (!entry.summary)
+        return false;
+    const std::map< model::test_result_type, std::size_t >& counts =
+        entry.summary.get().counts;
+    return counts.find(model::test_result_failed) != counts.end() ||
+        counts.find(model::test_result_broken) != counts.end();
+}
+
+
+/// Sorting predicate to put the most recent runs first.
+///
+/// \param a The first run to compare.
+/// \param b The second run to compare.
+///
+/// \return True if a is more recent than b.
+static bool
+newest_first(const store::catalog_entry* a, const store::catalog_entry* b)
+{
+    return a->timestamp > b->timestamp;
+}
+
+
+/// Sorting predicate to decide which runs to delete first to save space.
+///
+/// \param a The first run to compare.
+/// \param b The second run to compare.
+///
+/// \return True if a should be deleted before b.
+static bool
+least_valuable_first(const store::catalog_entry* a,
+                     const store::catalog_entry* b)
+{
+    const bool a_failed = has_failures(*a);
+    const bool b_failed = has_failures(*b);
+    if (a_failed != b_failed)
+        return !a_failed;
+    return a->timestamp < b->timestamp;
+}
+
+
+/// Computes the paths of the files that may live next to a results file.
+///
+/// These are the lock file of the write backend and the journal files of
+/// SQLite.  They are left behind if the process writing to the results file
+/// does not terminate cleanly.
+///
+/// \param file The results file.
+///
+/// \return The paths to the companion files, which need not exist.
+static std::vector< fs::path >
+companion_files(const fs::path& file)
+{
+    std::vector< fs::path > files;
+    files.push_back(store::detail::live_lock_file(file));
+    files.push_back(fs::path(file.str() + "-journal"));
+    files.push_back(fs::path(file.str() + "-shm"));
+    files.push_back(fs::path(file.str() + "-wal"));
+    return files;
+}
+
+
+/// Computes the disk space taken by a results file and its companion files.
+///
+/// \param file The results file to query.
+///
+/// \return The total size of the files.
+///
+/// \throw fs::error If the results file cannot be queried.
+static units::bytes
+disk_usage(const fs::path& file)
+{
+    uint64_t total = fs::file_size(file);
+    const std::vector< fs::path > companions = companion_files(file);
+    for (std::vector< fs::path >::const_iterator iter = companions.begin();
+         iter != companions.end(); ++iter) {
+        try {
+            total += fs::file_size(*iter);
+        } catch (const fs::error& unused_error) {
+            // Companion files are optional and come and go with the writer.
+        }
+    }
+    return units::bytes(total);
+}
+
+
+/// Gets the size of a results file from a precomputed collection.
+///
+/// \param sizes The sizes of the results files.
+/// \param file The results file to query.
+///
+/// \return The size of the file, or 0 if unknown.
+static units::bytes
+size_of(const std::map< fs::path, units::bytes >& sizes, const fs::path& file)
+{
+    const std::map< fs::path, units::bytes >::const_iterator iter =
+        sizes.find(file);
+    return iter == sizes.end() ? units::bytes() : (*iter).second;
+}
+
+
+/// Drops the stdout and stderr of the passed test cases of a results file.
+///
+/// \param file The results file to process.
+/// \param dry_run If true, only check whether there is anything to drop.
+///
+/// \return True if there was any output to drop.
+///
+/// \throw store::error If there is a problem accessing the results file.
+static bool
+strip_passed_output(const fs::path& file, const bool dry_run)
+{
+    sqlite::database db = store::detail::open_and_setup(
+        file, dry_run ? sqlite::open_readonly : sqlite::open_readwrite);
+    try {
+        sqlite::statement stmt = db.create_statement(
+            "SELECT COUNT(*) FROM test_case_files "
+            "    JOIN test_results "
+            "    ON test_case_files.test_case_id = test_results.test_case_id "
+            "WHERE test_results.result_type == 'passed'");
+        if (!stmt.step() || stmt.column_int64(0) == 0)
+            return false;
+        stmt.step_without_results();
+
+        if (!dry_run) {
+            sqlite::transaction tx = db.begin_transaction();
+            db.exec("DELETE FROM test_case_files WHERE test_case_id IN ("
+                    "    SELECT test_case_id FROM test_results"
+                    "    WHERE result_type == 'passed')");
+            db.exec("DELETE FROM files WHERE file_id NOT IN ("
+                    "    SELECT file_id FROM test_case_files)");
+            tx.commit();
+        }
+        return true;
+    } catch (const sqlite::error& e) {
+        throw store::error(F("Cannot drop output from %s: %s") % file %
+                           e.what());
+    }
+}
+
+
+/// Rebuilds a results file to reclaim unused space.
+///
+/// \param file The results file to compact.
+///
+/// \throw store::error If there is a problem compacting the results file.
+static void
+compact(const fs::path& file)
+{
+    sqlite::database db = store::detail::open_and_setup(
+        file, sqlite::open_readwrite);
+    try {
+        db.exec("VACUUM");
+    } catch (const sqlite::error& e) {
+        throw store::error(F("Cannot compact %s: %s") % file % e.what());
+    }
+}
+
+
+}  // anonymous namespace
+
+
+/// Constructs a policy that keeps everything.
+store::gc_policy::gc_policy(void) :
+    compact(false)
+{
+}
+
+
+/// Selects the runs to delete according to the retention policies.
+///
+/// \param entries The runs in the store directory.
+/// \param sizes The sizes of the results files of the runs, including the
+///     sizes of the lock and journal files next to them.
+/// \param live The results files of the runs that are still in progress.
+/// \param policy The retention policies to apply.
+///
+/// \return The results files to delete.
+std::set< fs::path >
+store::detail::select_removals(
+    const catalog_entries& entries,
+    const std::map< fs::path, units::bytes >& sizes,
+    const std::set< fs::path >& live,
+    const gc_policy& policy)
+{
+    std::map< std::string, entry_ptrs_vector > by_suite;
+    for (catalog_entries::const_iterator iter = entries.begin();
+         iter != entries.end(); ++iter) {
+        by_suite[(*iter).test_suite].push_back(&(*iter));
+    }
+
+    std::set< fs::path > removals;
+    entry_ptrs_vector candidates;
+    for (std::map< std::string, entry_ptrs_vector >::iterator
+             iter = by_suite.begin(); iter != by_suite.end(); ++iter) {
+        entry_ptrs_vector& runs = (*iter).second;
+        std::sort(runs.begin(), runs.end(), newest_first);
+
+        std::size_t failed_runs = 0;
+        for (std::size_t i = 0; i < runs.size(); ++i) {
+            const catalog_entry& run = *runs[i];
+            const bool failed = has_failures(run);
+            if (failed)
+                ++failed_runs;
+
+            if (i == 0 || live.find(run.file) != live.end())
+                continue;
+
+            if ((!policy.keep_last || i < policy.keep_last.get()) ||
+                (failed && policy.keep_failed &&
+                 failed_runs <= policy.keep_failed.get()))
+                candidates.push_back(&run);
+            else
+                removals.insert(run.file);
+        }
+    }
+
+    if (policy.max_size) {
+        uint64_t total = 0;
+        for (catalog_entries::const_iterator iter = entries.begin();
+             iter != entries.end(); ++iter) {
+            if (removals.find((*iter).file) == removals.end())
+                total += size_of(sizes, (*iter).file);
+        }
+
+        std::sort(candidates.begin(), candidates.end(), least_valuable_first);
+        for (entry_ptrs_vector::const_iterator iter = candidates.begin();
+             iter != candidates.end() && total > policy.max_size.get();
+             ++iter) {
+            removals.insert((*iter)->file);
+            total -= size_of(sizes, (*iter)->file);
+        }
+    }
+
+    return removals;
+}
+
+
+/// Applies retention and compaction policies to the store directory.
+///
+/// \param store_dir Path to the store directory.
+/// \param policy The policies to apply.
+/// \param dry_run If true, do not modify anything and only report what would
+///     be done.
+///
+/// \return The actions performed.
+///
+/// \throw store::error If there is a problem accessing the store directory or
+///     modifying any of its results files.
+store::gc_result
+store::gc(const fs::path& store_dir, const gc_policy& policy,
+          const bool dry_run)
+{
+    catalog catalog = catalog::open(store_dir);
+    catalog_entries entries = catalog.list(none);
+
+    gc_result result;
+
+    std::map< fs::path, units::bytes > sizes;
+    std::set< fs::path > live;
+    uint64_t size_before = 0;
+    for (catalog_entries::iterator iter = entries.begin();
+         iter != entries.end(); ++iter) {
+        catalog_entry& entry = *iter;
+
+        try {
+            sizes[entry.file] = disk_usage(entry.file);
+            size_before += sizes[entry.file];
+        } catch (const fs::error& e) {
+            LW(F("Cannot get size of %s: %s") % entry.file % e.what());
+        }
+
+        if (!entry.summary) {
+            // The run did not finish, either because it is still in progress
+            // or because it was interrupted, or the results file predates the
+            // catalog.  Find out which case this is.
+            try {
+                read_backend backend = read_backend::open_ro(entry.file);
+                if (backend.is_live()) {
+                    LI(F("Keeping %s: run in progress") % entry.file);
+                    live.insert(entry.file);
+                } else {
+                    entry.summary = backend.start_read().get_results_summary(
+                        results_filter());
+                    if (!dry_run)
+                        catalog.put_summary(entry.file, entry.summary.get());
+                }
+            } catch (const store::error& e) {
+                LW(F("Cannot summarize %s: %s") % entry.file % e.what());
+            }
+        }
+    }
+    result.size_before = units::bytes(size_before);
+
+    const std::set< fs::path > removals = detail::select_removals(
+        entries, sizes, live, policy);
+
+    std::string cutoff;
+    if (policy.strip_passed_output_age) {
+        cutoff = (datetime::timestamp::now() -
+                  policy.strip_passed_output_age.get()).strftime(
+                      "%Y%m%d-%H%M%S");
+    }
+
+    uint64_t size_after = 0;
+    for (catalog_entries::const_iterator iter = entries.begin();
+         iter != entries.end(); ++iter) {
+        const catalog_entry& entry = *iter;
+
+        if (removals.find(entry.file) != removals.end()) {
+            LI(F("Removing %s") % entry.file);
+            result.removed.push_back(entry.file);
+            if (!dry_run) {
+                try {
+                    fs::unlink(entry.file);
+                } catch (const fs::error& e) {
+                    throw error(e.what());
+                }
+                // Files left behind by a run that did not terminate cleanly,
+                // if any.
+                const std::vector< fs::path > companions = companion_files(
+                    entry.file);
+                for (std::vector< fs::path >::const_iterator iter2 =
+                         companions.begin(); iter2 != companions.end();
+                     ++iter2) {
+                    if (!fs::exists(*iter2))
+                        continue;
+                    try {
+                        fs::unlink(*iter2);
+                    } catch (const fs::error& e) {
+                        LW(F("Cannot remove %s: %s") % *iter2 % e.what());
+                    }
+                }
+                catalog.remove(entry.file);
+            }
+            continue;
+        }
+
+        if (live.find(entry.file) == live.end()) {
+            if (policy.strip_passed_output_age &&
+                entry.timestamp.substr(0, cutoff.length()) < cutoff &&
+                strip_passed_output(entry.file, dry_run)) {
+                LI(F("Dropped output of passed tests from %s") % entry.file);
+                result.stripped.push_back(entry.file);
+            }
+
+            if (policy.compact) {
+                LI(F("Compacting %s") % entry.file);
+                if (!dry_run)
+                    compact(entry.file);
+                result.compacted.push_back(entry.file);
+            }
+        }
+
+        if (dry_run) {
+            size_after += size_of(sizes, entry.file);
+        } else {
+            try {
+                size_after += disk_usage(entry.file);
+            } catch (const fs::error& e) {
+                LW(F("Cannot get size of %s: %s") % entry.file % e.what());
+            }
+        }
+    }
+    result.size_after = units::bytes(size_after);
+
+    return result;
+}
@@ -0,0 +1,118 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file store/gc.hpp
+/// Retention and compaction of the results files in the store directory.
+
+#if !defined(STORE_GC_HPP)
+#define STORE_GC_HPP
+
+#include "store/gc_fwd.hpp"
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "store/catalog_fwd.hpp"
+#include "utils/datetime.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/optional.hpp"
+#include "utils/units.hpp"
+
+namespace store {
+
+
+/// Policies to apply when garbage-collecting the store directory.
+///
+/// The latest run of every test suite and the runs that are still in progress
+/// are always kept regardless of these settings.
+struct gc_policy {
+    /// Number of most recent runs to keep for each test suite.
+    utils::optional< std::size_t > keep_last;
+
+    /// Number of most recent runs with failures to keep for each test suite.
+    ///
+    /// These are kept in addition to the ones selected by keep_last.
+    utils::optional< std::size_t > keep_failed;
+
+    /// Maximum total size of the results files to keep.
+    ///
+    /// Once the other policies have been applied, the oldest runs are deleted
+    /// until the store fits in this size.  Runs without failures go first.
+    utils::optional< utils::units::bytes > max_size;
+
+    /// Age after which the output of passed test cases is dropped.
+    utils::optional< utils::datetime::delta > strip_passed_output_age;
+
+    /// Whether to rebuild the kept results files to reclaim unused space.
+    bool compact;
+
+    gc_policy(void);
+};
+
+
+/// Actions performed, or that would be performed, by gc().
+struct gc_result {
+    /// Results files that were deleted.
+    std::vector< utils::fs::path > removed;
+
+    /// Results files from which the output of passed test cases was dropped.
+    std::vector< utils::fs::path > stripped;
+
+    /// Results files that were compacted.
+    std::vector< utils::fs::path > compacted;
+
+    /// Total size of the results files before doing anything.
+    utils::units::bytes size_before;
+
+    /// Total size of the results files after garbage-collecting them.
+    ///
+    /// When no changes are made, this only accounts for the removed files.
+    utils::units::bytes size_after;
+};
+
+
+namespace detail {
+
+
+std::set< utils::fs::path > select_removals(
+    const catalog_entries&,
+    const std::map< utils::fs::path, utils::units::bytes >&,
+    const std::set< utils::fs::path >&, const gc_policy&);
+
+
+}  // namespace detail
+
+
+gc_result gc(const utils::fs::path&, const gc_policy&, const bool);
+
+
+}  // namespace store
+
+#endif  // !defined(STORE_GC_HPP)
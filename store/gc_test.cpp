@@ -0,0 +1,353 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "store/gc.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+
+#include <atf-c++.hpp>
+
+#include "model/context.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "store/catalog.hpp"
+#include "store/layout.hpp"
+#include "store/read_backend.hpp"
+#include "store/read_transaction.hpp"
+#include "store/write_backend.hpp"
+#include "store/write_transaction.hpp"
+#include "utils/datetime.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/logging/operations.hpp"
+#include "utils/optional.ipp"
+#include "utils/units.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace logging = utils::logging;
+namespace units = utils::units;
+
+using utils::none;
+using utils::optional;
+
+
+namespace {
+
+
+/// Creates a catalog entry for select_removals tests.
+///
+/// \param test_suite The test suite of the run.
+/// \param timestamp The timestamp of the run.
+/// \param failed Whether the run had failures.
+///
+/// \return A new catalog entry.
+static store::catalog_entry
+make_entry(const std::string& test_suite, const std::string& timestamp,
+           const bool failed)
+{
+    store::results_summary summary;
+    summary.counts[model::test_result_passed] = 3;
+    if (failed)
+        summary.counts[model::test_result_failed] = 1;
+    return store::catalog_entry(
+        fs::path(F("results.%s.%s.db") % test_suite % timestamp), test_suite,
+        timestamp, utils::make_optional(summary));
+}
+
+
+/// Creates a results file for a finished run in the store directory.
+///
+/// \param test_suite The test suite of the run.
+/// \param timestamp The timestamp of the run.
+/// \param result The result of the only test case in the run.
+///
+/// \return The path to the new results file.
+static fs::path
+create_run(const std::string& test_suite, const std::string& timestamp,
+           const model::test_result& result)
+{
+    const fs::path store_dir = store::layout::query_store_dir();
+    fs::mkdir_p(store_dir, 0755);
+    const fs::path file = store_dir / (
+        F("results.%s.%s.db") % test_suite % timestamp);
+
+    const model::test_program test_program = model::test_program_builder(
+        "plain", fs::path("the_test"), fs::path("/root"), "suite")
+        .add_test_case("main")
+        .build();
+
+    atf::utils::create_file("stdout.txt", "Some output\n");
+
+    store::write_backend backend = store::write_backend::open_rw(file);
+    store::write_transaction tx = backend.start_write();
+    tx.put_context(model::context(fs::path("/root"),
+                                  std::map< std::string, std::string >()));
+    const int64_t tp_id = tx.put_test_program(test_program);
+    const int64_t tc_id = tx.put_test_case(test_program, "main", tp_id);
+    tx.put_test_case_file("__STDOUT__", fs::path("stdout.txt"), tc_id);
+    tx.put_result(result, tc_id, datetime::timestamp::from_microseconds(1000),
+                  datetime::timestamp::from_microseconds(2000));
+    tx.commit();
+    backend.close();
+
+    return file;
+}
+
+
+/// Checks whether a results file holds any test case output.
+///
+/// \param file The results file to query.
+///
+/// \return True if the test case has stdout contents.
+static bool
+has_output(const fs::path& file)
+{
+    store::read_backend backend = store::read_backend::open_ro(file);
+    store::read_transaction tx = backend.start_read();
+    store::results_iterator iter = tx.get_results();
+    ATF_REQUIRE(iter);
+    return !iter.stdout_contents().empty();
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(select_removals__no_policies);
+ATF_TEST_CASE_BODY(select_removals__no_policies)
+{
+    store::catalog_entries entries;
+    entries.push_back(make_entry("a", "20140101-000000-000000", false));
+    entries.push_back(make_entry("a", "20140102-000000-000000", false));
+    entries.push_back(make_entry("b", "20140101-000000-000000", true));
+
+    ATF_REQUIRE(store::detail::select_removals(
+        entries, std::map< fs::path, units::bytes >(), std::set< fs::path >(),
+        store::gc_policy()).empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(select_removals__keep_last);
+ATF_TEST_CASE_BODY(select_removals__keep_last)
+{
+    store::catalog_entries entries;
+    entries.push_back(make_entry("a", "20140103-000000-000000", false));
+    entries.push_back(make_entry("a", "20140101-000000-000000", false));
+    entries.push_back(make_entry("a", "20140102-000000-000000", false));
+    entries.push_back(make_entry("b", "20140101-000000-000000", false));
+
+    store::gc_policy policy;
+    policy.keep_last = utils::make_optional(std::size_t(0));
+
+    std::set< fs::path > exp_removals;
+    exp_removals.insert(entries[1].file);
+    exp_removals.insert(entries[2].file);
+    ATF_REQUIRE(exp_removals == store::detail::select_removals(
+        entries, std::map< fs::path, units::bytes >(), std::set< fs::path >(),
+        policy));
+
+    policy.keep_last = utils::make_optional(std::size_t(2));
+    exp_removals.clear();
+    exp_removals.insert(entries[1].file);
+    ATF_REQUIRE(exp_removals == store::detail::select_removals(
+        entries, std::map< fs::path, units::bytes >(), std::set< fs::path >(),
+        policy));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(select_removals__keep_failed);
+ATF_TEST_CASE_BODY(select_removals__keep_failed)
+{
+    store::catalog_entries entries;
+    entries.push_back(make_entry("a", "20140105-000000-000000", false));
+    entries.push_back(make_entry("a", "20140104-000000-000000", true));
+    entries.push_back(make_entry("a", "20140103-000000-000000", false));
+    entries.push_back(make_entry("a", "20140102-000000-000000", true));
+    entries.push_back(make_entry("a", "20140101-000000-000000", true));
+
+    store::gc_policy policy;
+    policy.keep_last = utils::make_optional(std::size_t(1));
+    policy.keep_failed = utils::make_optional(std::size_t(2));
+
+    std::set< fs::path > exp_removals;
+    exp_removals.insert(entries[2].file);
+    exp_removals.insert(entries[4].file);
+    ATF_REQUIRE(exp_removals == store::detail::select_removals(
+        entries, std::map< fs::path, units::bytes >(), std::set< fs::path >(),
+        policy));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(select_removals__max_size);
+ATF_TEST_CASE_BODY(select_removals__max_size)
+{
+    store::catalog_entries entries;
+    entries.push_back(make_entry("a", "20140104-000000-000000", false));
+    entries.push_back(make_entry("a", "20140103-000000-000000", false));
+    entries.push_back(make_entry("a", "20140102-000000-000000", true));
+    entries.push_back(make_entry("a", "20140101-000000-000000", false));
+    entries.push_back(make_entry("b", "20140101-000000-000000", false));
+
+    std::map< fs::path, units::bytes > sizes;
+    for (store::catalog_entries::const_iterator iter = entries.begin();
+         iter != entries.end(); ++iter)
+        sizes[(*iter).file] = units::bytes(100);
+
+    store::gc_policy policy;
+    policy.max_size = utils::make_optional(units::bytes(250));
+
+    // Runs without failures go first, oldest first, and the latest run of
+    // every test suite is never deleted.
+    std::set< fs::path > exp_removals;
+    exp_removals.insert(entries[3].file);
+    exp_removals.insert(entries[1].file);
+    exp_removals.insert(entries[2].file);
+    ATF_REQUIRE(exp_removals == store::detail::select_removals(
+        entries, sizes, std::set< fs::path >(), policy));
+
+    policy.max_size = utils::make_optional(units::bytes(10));
+    ATF_REQUIRE(exp_removals == store::detail::select_removals(
+        entries, sizes, std::set< fs::path >(), policy));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(select_removals__live);
+ATF_TEST_CASE_BODY(select_removals__live)
+{
+    store::catalog_entries entries;
+    entries.push_back(make_entry("a", "20140103-000000-000000", false));
+    entries.push_back(make_entry("a", "20140102-000000-000000", false));
+    entries.push_back(make_entry("a", "20140101-000000-000000", false));
+
+    std::set< fs::path > live;
+    live.insert(entries[1].file);
+
+    store::gc_policy policy;
+    policy.keep_last = utils::make_optional(std::size_t(1));
+
+    std::set< fs::path > exp_removals;
+    exp_removals.insert(entries[2].file);
+    ATF_REQUIRE(exp_removals == store::detail::select_removals(
+        entries, std::map< fs::path, units::bytes >(), live, policy));
+}
+
+
+ATF_TEST_CASE(gc__remove_and_strip);
+ATF_TEST_CASE_HEAD(gc__remove_and_strip)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(gc__remove_and_strip)
+{
+    const model::test_result passed(model::test_result_passed);
+    const model::test_result failed(model::test_result_failed, "Oops");
+    const fs::path old1 = create_run("s", "20140101-000000-000000", passed);
+    const fs::path old2 = create_run("s", "20140102-000000-000000", failed);
+    const fs::path recent = create_run("s", "20140103-000000-000000", passed);
+
+    store::gc_policy policy;
+    policy.keep_last = utils::make_optional(std::size_t(1));
+    policy.keep_failed = utils::make_optional(std::size_t(1));
+    policy.strip_passed_output_age = utils::make_optional(
+        datetime::delta(60, 0));
+    policy.compact = true;
+
+    const fs::path store_dir = store::layout::query_store_dir();
+    {
+        const store::gc_result result = store::gc(store_dir, policy, true);
+        ATF_REQUIRE_EQ(1, result.removed.size());
+        ATF_REQUIRE_EQ(old1, result.removed[0]);
+        ATF_REQUIRE_EQ(1, result.stripped.size());
+        ATF_REQUIRE_EQ(recent, result.stripped[0]);
+        ATF_REQUIRE_EQ(2, result.compacted.size());
+        ATF_REQUIRE(fs::exists(old1));
+        ATF_REQUIRE(has_output(recent));
+    }
+
+    const store::gc_result result = store::gc(store_dir, policy, false);
+    ATF_REQUIRE_EQ(1, result.removed.size());
+    ATF_REQUIRE_EQ(old1, result.removed[0]);
+    ATF_REQUIRE(!fs::exists(old1));
+    ATF_REQUIRE(fs::exists(old2));
+    ATF_REQUIRE(has_output(old2));
+    ATF_REQUIRE(!has_output(recent));
+    ATF_REQUIRE(result.size_after < result.size_before);
+
+    ATF_REQUIRE_EQ(2, store::catalog::open(store_dir).list(none).size());
+}
+
+
+ATF_TEST_CASE(gc__remove_companion_files);
+ATF_TEST_CASE_HEAD(gc__remove_companion_files)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(gc__remove_companion_files)
+{
+    const model::test_result passed(model::test_result_passed);
+    const fs::path old = create_run("s", "20140101-000000-000000", passed);
+    const fs::path recent = create_run("s", "20140102-000000-000000", passed);
+    const uint64_t db_sizes = fs::file_size(old) + fs::file_size(recent);
+
+    // Leftovers of an unclean termination, which only fit within the size
+    // limit if their space is accounted for.
+    atf::utils::create_file(old.str() + "-wal", std::string(100000, 'x'));
+    atf::utils::create_file(old.str() + "-shm", std::string(1000, 'x'));
+
+    store::gc_policy policy;
+    policy.max_size = units::bytes(db_sizes + 10000);
+
+    const fs::path store_dir = store::layout::query_store_dir();
+    const store::gc_result result = store::gc(store_dir, policy, false);
+    ATF_REQUIRE_EQ(1, result.removed.size());
+    ATF_REQUIRE_EQ(old, result.removed[0]);
+    ATF_REQUIRE_EQ(units::bytes(db_sizes + 101000), result.size_before);
+    ATF_REQUIRE(!fs::exists(old));
+    ATF_REQUIRE(!fs::exists(fs::path(old.str() + "-wal")));
+    ATF_REQUIRE(!fs::exists(fs::path(old.str() + "-shm")));
+    ATF_REQUIRE(fs::exists(recent));
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, select_removals__no_policies);
+    ATF_ADD_TEST_CASE(tcs, select_removals__keep_last);
+    ATF_ADD_TEST_CASE(tcs, select_removals__keep_failed);
+    ATF_ADD_TEST_CASE(tcs, select_removals__max_size);
+    ATF_ADD_TEST_CASE(tcs, select_removals__live);
+
+    ATF_ADD_TEST_CASE(tcs, gc__remove_and_strip);
+    ATF_ADD_TEST_CASE(tcs, gc__remove_companion_files);
+}
@@ -30,7 +30,9 @@
 
 #include <algorithm>
 #include <cstring>
+#include <vector>
 
+#include "store/catalog.hpp"
 #include "store/exceptions.hpp"
 #include "utils/datetime.hpp"
 #include "utils/format/macros.hpp"
@@ -56,43 +58,44 @@ using utils::optional;
 namespace {
 
 
-/// Finds the results file for the latest run of the given test suite.
+/// Finds the results files of all the runs of a test suite by scanning.
+///
+/// This is the fallback for when the catalog of the store directory cannot be
+/// used.
 ///
+/// \param store_dir Path to the store directory.
 /// \param test_suite Identifier of the test suite to query.
 ///
-/// \return Path to the located database holding the most recent data for the
-/// given test suite.
+/// \return Paths to the results files of the test suite, sorted from oldest to
+/// newest.  May be empty.
 ///
-/// \throw store::error If no previous results file can be found.
-static fs::path
-find_latest(const std::string& test_suite)
+/// \throw store::error If the store directory cannot be scanned.
+static std::vector< fs::path >
+scan_history(const fs::path& store_dir, const std::string& test_suite)
 {
-    const fs::path store_dir = layout::query_store_dir();
     try {
         const text::regex preg = text::regex::compile(
             F("^results.%s.[0-9]{8}-[0-9]{6}-[0-9]{6}.db$") % test_suite, 0);
 
-        std::string latest;
+        std::vector< std::string > names;
 
         const fs::directory dir(store_dir);
         for (fs::directory::const_iterator iter = dir.begin();
              iter != dir.end(); ++iter) {
             const text::regex_matches matches = preg.match(iter->name);
             if (matches) {
-                if (latest.empty() || iter->name > latest) {
-                    latest = iter->name;
-                }
+                names.push_back(iter->name);
             } else {
                 // Not a database file; skip.
             }
         }
+        std::sort(names.begin(), names.end());
 
-        if (latest.empty())
-            throw store::error(
-                F("No previous results file found for test suite %s")
-                % test_suite);
-
-        return store_dir / latest;
+        std::vector< fs::path > files;
+        for (std::vector< std::string >::const_iterator iter = names.begin();
+             iter != names.end(); ++iter)
+            files.push_back(store_dir / *iter);
+        return files;
     } catch (const fs::system_error& e) {
         LW(F("Failed to open store dir %s: %s") % store_dir % e.what());
         throw store::error(F("No previous results file found for test suite %s")
@@ -103,6 +106,62 @@ find_latest(const std::string& test_suite)
 }
 
 
+/// Finds the results file for the latest run of a test suite by scanning.
+///
+/// This is the fallback for when the catalog of the store directory cannot be
+/// used.
+///
+/// \param store_dir Path to the store directory.
+/// \param test_suite Identifier of the test suite to query.
+///
+/// \return Path to the located database holding the most recent data for the
+/// given test suite.
+///
+/// \throw store::error If no previous results file can be found.
+static fs::path
+scan_latest(const fs::path& store_dir, const std::string& test_suite)
+{
+    const std::vector< fs::path > files = scan_history(store_dir, test_suite);
+    if (files.empty())
+        throw store::error(
+            F("No previous results file found for test suite %s")
+            % test_suite);
+    return files.back();
+}
+
+
+/// Finds the results file for the latest run of the given test suite.
+///
+/// \param test_suite Identifier of the test suite to query.
+///
+/// \return Path to the located database holding the most recent data for the
+/// given test suite.
+///
+/// \throw store::error If no previous results file can be found.
+static fs::path
+find_latest(const std::string& test_suite)
+{
+    const fs::path store_dir = layout::query_store_dir();
+    if (!fs::exists(store_dir))
+        throw store::error(F("No previous results file found for test suite %s")
+                           % test_suite);
+
+    optional< fs::path > latest;
+    try {
+        store::catalog catalog = store::catalog::open(store_dir);
+        latest = catalog.find_latest(test_suite);
+    } catch (const store::error& e) {
+        LW(F("Cannot use the catalog of %s: %s") % store_dir % e.what());
+        return scan_latest(store_dir, test_suite);
+    }
+
+    if (!latest)
+        throw store::error(F("No previous results file found for test suite %s")
+                           % test_suite);
+    return latest.get();
+}
+
+
 /// Computes the identifier of a new tests results file.
 ///
 /// \param test_suite Identifier of the test suite.
@@ -172,6 +231,48 @@ layout::find_results(const std::string& id)
 }
 
 
+/// Resolves the results files of the most recent runs of a test suite.
+///
+/// \param test_suite Identifier of the test suite to query.
+/// \param limit Maximum number of results files to return.  The newest ones
+///     are kept.
+///
+/// \return Paths to the results files, sorted from oldest to newest.
+///
+/// \throw store::error If there are no results files for the test suite.
+std::vector< fs::path >
+layout::find_history(const std::string& test_suite, const std::size_t limit)
+{
+    LI(F("Searching for the last %s results files of test suite %s") % limit %
+       test_suite);
+
+    const fs::path store_dir = query_store_dir();
+    if (!fs::exists(store_dir))
+        throw store::error(F("No previous results file found for test suite %s")
+                           % test_suite);
+
+    std::vector< fs::path > files;
+    try {
+        store::catalog catalog = store::catalog::open(store_dir);
+        const store::catalog_entries entries = catalog.list(
+            utils::make_optional(test_suite));
+        for (store::catalog_entries::const_iterator iter = entries.begin();
+             iter != entries.end(); ++iter)
+            files.push_back((*iter).file);
+    } catch (const store::error& e) {
+        LW(F("Cannot use the catalog of %s: %s") % store_dir % e.what());
+        files = scan_history(store_dir, test_suite);
+    }
+
+    if (files.empty())
+        throw store::error(F("No previous results file found for test suite %s")
+                           % test_suite);
+    if (files.size() > limit)
+        files.erase(files.begin(), files.end() - limit);
+    return files;
+}
+
+
 /// Computes the path to a new database for the given test suite.
 ///
 /// \param id Identifier of the test suite to create.
@@ -33,6 +33,7 @@ extern "C" {
 }
 
 #include <iostream>
+#include <vector>
 
 #include <atf-c++.hpp>
 
@@ -227,6 +228,55 @@ ATF_TEST_CASE_BODY(find_results__not_found)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(find_history__ok);
+ATF_TEST_CASE_BODY(find_history__ok)
+{
+    const fs::path store_dir = layout::query_store_dir();
+    fs::mkdir_p(store_dir, 0755);
+
+    const std::string base = (store_dir / "results.foo_bar.").str();
+    atf::utils::create_file(base + "20140614-194515-123456.db", "");
+    atf::utils::create_file(base + "20130614-194515-999999.db", "");
+    atf::utils::create_file(base + "20140613-194515-000000.db", "");
+    atf::utils::create_file(
+        (store_dir / "results.foo.20140615-111111-000000.db").str(), "");
+
+    {
+        std::vector< fs::path > exp_files;
+        exp_files.push_back(fs::path(base + "20130614-194515-999999.db"));
+        exp_files.push_back(fs::path(base + "20140613-194515-000000.db"));
+        exp_files.push_back(fs::path(base + "20140614-194515-123456.db"));
+        ATF_REQUIRE(exp_files == layout::find_history("foo_bar", 10));
+    }
+
+    {
+        std::vector< fs::path > exp_files;
+        exp_files.push_back(fs::path(base + "20140613-194515-000000.db"));
+        exp_files.push_back(fs::path(base + "20140614-194515-123456.db"));
+        ATF_REQUIRE(exp_files == layout::find_history("foo_bar", 2));
+    }
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(find_history__not_found);
+ATF_TEST_CASE_BODY(find_history__not_found)
+{
+    ATF_REQUIRE_THROW_RE(
+        store::error,
+        "No previous results file found for test suite foo_bar",
+        layout::find_history("foo_bar", 10));
+
+    const fs::path store_dir = layout::query_store_dir();
+    fs::mkdir_p(store_dir, 0755);
+    atf::utils::create_file(
+        (store_dir / "results.foo.20140615-111111-000000.db").str(), "");
+    ATF_REQUIRE_THROW_RE(
+        store::error,
+        "No previous results file found for test suite foo_bar",
+        layout::find_history("foo_bar", 10));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(new_db__new);
 ATF_TEST_CASE_BODY(new_db__new)
 {
@@ -336,6 +386,9 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, find_results__id_with_timestamp);
     ATF_ADD_TEST_CASE(tcs, find_results__not_found);
 
+    ATF_ADD_TEST_CASE(tcs, find_history__ok);
+    ATF_ADD_TEST_CASE(tcs, find_history__not_found);
+
     ATF_ADD_TEST_CASE(tcs, new_db__new);
     ATF_ADD_TEST_CASE(tcs, new_db__explicit);
 
@@ -136,10 +136,37 @@ migrate_schema_step(const fs::path& file,
 }
 
 
+/// Initializes a new results file with the first chunked schema.
+///
+/// We cannot use store::detail::initialize here because the migration from
+/// the historical database expects the tables of the first chunked schema
+/// version, not those of the current one.
+///
+/// \param db The empty database to initialize.
+///
+/// \throw error If there is a problem initializing the database.
+static void
+initialize_chunk(sqlite::database& db)
+{
+    const fs::path schema = fs::path(
+        utils::getenv_with_default("KYUA_STOREDIR", KYUA_STOREDIR)) /
+        (F("schema_v%s.sql") % first_chunked_schema_version);
+
+    try {
+        db.exec(utils::read_file(schema));
+    } catch (const sqlite::error& e) {
+        throw store::error(F("Failed to initialize database: %s") % e.what());
+    } catch (const std::runtime_error& e) {
+        throw store::error(F("Cannot read database schema '%s'") % schema);
+    }
+}
+
+
 /// Given a historical database, chunks it up into results files.
 ///
 /// The given database is DELETED on success given that it will have been
-/// split up into various different files.
+/// split up into various different files.  Each of these files is brought up
+/// to the current schema version.
 ///
 /// \param old_file Path to the old database.
 static void
@@ -194,13 +221,17 @@ chunk_database(const fs::path& old_file)
             fs::mkdir_p(new_file.branch_path(), 0755);
             sqlite::database db = store::detail::open_and_setup(
                 new_file, sqlite::open_readwrite | sqlite::open_create);
-            store::detail::initialize(db);
+            initialize_chunk(db);
             db.close();
             migrate_schema_step(new_file,
                                 first_chunked_schema_version - 1,
                                 first_chunked_schema_version,
                                 utils::make_optional(action_id),
                                 utils::make_optional(old_file));
+            for (int i = first_chunked_schema_version;
+                 i < store::detail::current_schema_version; ++i) {
+                migrate_schema_step(new_file, i, i + 1);
+            }
         } catch (...) {
             // TODO(jmmv): Handle this better.
             fs::unlink(new_file);
@@ -278,10 +309,14 @@ store::migrate_schema(const utils::fs::path& file)
 
     detail::backup_database(file, version_from);
 
-    int i;
-    for (i = version_from; i < first_chunked_schema_version - 1; ++i) {
-        migrate_schema_step(file, i, i + 1);
+    if (version_from < first_chunked_schema_version) {
+        for (int i = version_from; i < first_chunked_schema_version - 1; ++i) {
+            migrate_schema_step(file, i, i + 1);
+        }
+        chunk_database(file);
+    } else {
+        for (int i = version_from; i < version_to; ++i) {
+            migrate_schema_step(file, i, i + 1);
+        }
     }
-    chunk_database(file);
-    INV(version_to == first_chunked_schema_version);
 }
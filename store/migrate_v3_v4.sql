@@ -0,0 +1,160 @@
+-- Copyright 2026 The Kyua Authors.
+-- All rights reserved.
+--
+-- Redistribution and use in source and binary forms, with or without
+-- modification, are permitted provided that the following conditions are
+-- met:
+--
+-- * Redistributions of source code must retain the above copyright
+--   notice, this list of conditions and the following disclaimer.
+-- * Redistributions in binary form must reproduce the above copyright
+--   notice, this list of conditions and the following disclaimer in the
+--   documentation and/or other materials provided with the distribution.
+-- * Neither the name of Google Inc. nor the names of its contributors
+--   may be used to endorse or promote products derived from this software
+--   without specific prior written permission.
+--
+-- THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+-- "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+-- LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+-- A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+-- OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+-- SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+-- LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+-- DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+-- THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+-- (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+-- OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+-- \file store/migrate_v3_v4.sql
+-- Migration of a database with version 3 of the schema to version 4.
+--
+-- Version 4 appeared in Kyua 0.13 and its changes were:
+--
+-- * Interning of metadata objects.  Test programs and test cases with
+--   identical metadata now share a single metadata object, and the new
+--   metadata_digests table allows locating existing objects when writing
+--   new ones.  Duplicate objects already in the database are merged.
+--
+-- * Replacement of the end_time column of the test_results table with a
+--   duration column.  Durations are what reports need and take less space.
+--
+-- * Addition of indexes to support the ordering and filtering used by
+--   reports, and removal of the redundant index_metadatas_by_id.
+
+
+BEGIN TRANSACTION;
+
+
+--
+-- Merge duplicate metadata objects.
+--
+-- SQLite offers no hash function to compute the digests of the existing
+-- objects, so we compare their full contents instead.  The contents are
+-- only used within this migration, so it does not matter that their
+-- representation is not the same as the one used by the digests.  The
+-- merged objects do not get a digest, which means that they will not be
+-- reused by future writes; this is harmless.
+--
+
+
+CREATE TEMPORARY TABLE metadata_contents AS
+    SELECT metadata_id,
+        group_concat(length(property_name) || ':' || property_name ||
+                     length(ifnull(property_value, '')) || ':' ||
+                     ifnull(property_value, ''), '') AS contents
+    FROM (SELECT * FROM metadatas ORDER BY metadata_id, property_name)
+    GROUP BY metadata_id;
+
+CREATE TEMPORARY TABLE metadata_renames AS
+    SELECT metadata_contents.metadata_id AS old_id,
+        canonical.metadata_id AS new_id
+    FROM metadata_contents
+        JOIN (SELECT MIN(metadata_id) AS metadata_id, contents
+              FROM metadata_contents GROUP BY contents) AS canonical
+        ON metadata_contents.contents == canonical.contents
+    WHERE metadata_contents.metadata_id != canonical.metadata_id;
+
+UPDATE test_programs
+    SET metadata_id = (SELECT new_id FROM metadata_renames
+                       WHERE old_id == test_programs.metadata_id)
+    WHERE metadata_id IN (SELECT old_id FROM metadata_renames);
+
+UPDATE test_cases
+    SET metadata_id = (SELECT new_id FROM metadata_renames
+                       WHERE old_id == test_cases.metadata_id)
+    WHERE metadata_id IN (SELECT old_id FROM metadata_renames);
+
+DELETE FROM metadatas
+    WHERE metadata_id IN (SELECT old_id FROM metadata_renames);
+
+DROP TABLE metadata_renames;
+DROP TABLE metadata_contents;
+
+
+DROP INDEX index_metadatas_by_id;
+
+CREATE TABLE metadata_digests (
+    metadata_id INTEGER PRIMARY KEY,
+    digest INTEGER NOT NULL
+);
+
+CREATE INDEX index_metadata_digests_by_digest
+    ON metadata_digests (digest);
+
+
+--
+-- Replace end times with durations.
+--
+
+
+CREATE TABLE new_test_results (
+    test_case_id INTEGER PRIMARY KEY REFERENCES test_cases,
+    result_type TEXT NOT NULL,
+    result_reason TEXT,
+
+    start_time TIMESTAMP NOT NULL,
+    duration INTEGER NOT NULL CHECK (duration >= 0)
+);
+
+INSERT INTO new_test_results
+    SELECT test_case_id, result_type, result_reason, start_time,
+        max(end_time - start_time, 0)
+    FROM test_results;
+
+DROP TABLE test_results;
+ALTER TABLE new_test_results RENAME TO test_results;
+
+CREATE INDEX index_test_results_by_result_type
+    ON test_results (result_type);
+
+
+--
+-- Add indexes for reports.
+--
+
+
+CREATE INDEX index_test_programs_by_relative_path
+    ON test_programs (relative_path);
+
+CREATE INDEX index_test_programs_by_absolute_path
+    ON test_programs (absolute_path, test_program_id);
+
+DROP INDEX index_test_cases_by_test_programs_id;
+CREATE INDEX index_test_cases_by_test_program_id_and_name
+    ON test_cases (test_program_id, name);
+
+CREATE INDEX index_test_case_files_by_file_id
+    ON test_case_files (file_id);
+
+
+--
+-- Update the metadata version.
+--
+
+
+INSERT INTO metadata (timestamp, schema_version)
+    VALUES (strftime('%s', 'now'), 4);
+
+
+COMMIT TRANSACTION;
@@ -28,6 +28,16 @@
 
 #include "store/read_backend.hpp"
 
+extern "C" {
+#include <sys/file.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+#include <cerrno>
+#include <cstring>
+
 #include "store/exceptions.hpp"
 #include "store/metadata.hpp"
 #include "store/read_transaction.hpp"
@@ -35,12 +45,55 @@
 #include "utils/format/macros.hpp"
 #include "utils/fs/path.hpp"
 #include "utils/noncopyable.hpp"
+#include "utils/optional.ipp"
 #include "utils/sqlite/database.hpp"
 #include "utils/sqlite/exceptions.hpp"
+#include "utils/sqlite/statement.ipp"
 
 namespace fs = utils::fs;
 namespace sqlite = utils::sqlite;
 
+using utils::optional;
+
+
+/// Ensures that the schema of a database matches the one we implement.
+///
+/// \param metadata_ The metadata for the loaded database.
+///
+/// \throw integrity_error If the schema in the database is too modern,
+///     which might indicate some form of corruption or an old binary.
+/// \throw old_schema_error If the schema in the database is older than our
+///     currently-implemented version and needs an upgrade.  The caller can
+///     use migrate_schema() to fix this problem.
+void
+store::detail::check_schema_version(const metadata& metadata_)
+{
+    const int database_version = metadata_.schema_version();
+
+    if (database_version == detail::current_schema_version) {
+        // OK.
+    } else if (database_version < detail::current_schema_version) {
+        throw old_schema_error(database_version);
+    } else if (database_version > detail::current_schema_version) {
+        throw integrity_error(
+            F("Database at schema version %s, which is newer than the "
+              "supported version %s")
+            % database_version % detail::current_schema_version);
+    }
+}
+
+
+/// Computes the path to the lock file held while a database is written to.
+///
+/// \param file The database file.
+///
+/// \return The path to the lock file.
+fs::path
+store::detail::live_lock_file(const fs::path& file)
+{
+    return fs::path(file.str() + "-live");
+}
+
 
 /// Opens a database and defines session pragmas.
 ///
@@ -59,6 +112,9 @@ store::detail::open_and_setup(const fs::path& file, const int flags)
     try {
         sqlite::database database = sqlite::database::open(file, flags);
         database.exec("PRAGMA foreign_keys = ON");
+        // A results file may be read while a test run is writing to it, so
+        // wait for the other party to release its locks instead of failing.
+        database.exec("PRAGMA busy_timeout = 10000");
         return database;
     } catch (const sqlite::error& e) {
         throw store::error(F("Cannot open '%s': %s") % file % e.what());
@@ -86,18 +142,7 @@ struct store::read_backend::impl : utils::noncopyable {
     impl(sqlite::database& database_, const metadata& metadata_) :
         database(database_)
     {
-        const int database_version = metadata_.schema_version();
-
-        if (database_version == detail::current_schema_version) {
-            // OK.
-        } else if (database_version < detail::current_schema_version) {
-            throw old_schema_error(database_version);
-        } else if (database_version > detail::current_schema_version) {
-            throw integrity_error(
-                F("Database at schema version %s, which is newer than the "
-                  "supported version %s")
-                % database_version % detail::current_schema_version);
-        }
+        detail::check_schema_version(metadata_);
     }
 };
 
@@ -150,6 +195,49 @@ store::read_backend::database(void)
 }
 
 
+/// Checks whether a test run is still writing to the database.
+///
+/// The write backend holds a lock on a file next to the database for as long
+/// as it is open.  The lock is released by the kernel when the writer
+/// terminates, even abruptly, so a run that was killed is not considered to be
+/// in progress.
+///
+/// \return True if the database is still being written to; false otherwise.
+///
+/// \throw store::error If there is a problem querying the lock.
+bool
+store::read_backend::is_live(void)
+{
+    const optional< fs::path > file = _pimpl->database.db_filename();
+    if (!file)
+        return false;
+    const fs::path lock_file = detail::live_lock_file(file.get());
+
+    const int fd = ::open(lock_file.c_str(), O_RDONLY);
+    if (fd == -1) {
+        const int original_errno = errno;
+        if (original_errno == ENOENT)
+            return false;
+        throw store::error(F("Cannot open %s: %s") % lock_file %
+                           std::strerror(original_errno));
+    }
+
+    bool live;
+    if (::flock(fd, LOCK_SH | LOCK_NB) == -1) {
+        const int original_errno = errno;
+        if (original_errno != EWOULDBLOCK) {
+            ::close(fd);
+            throw store::error(F("Cannot query lock of %s: %s") % lock_file %
+                               std::strerror(original_errno));
+        }
+        live = true;
+    } else
+        live = false;
+    ::close(fd);
+    return live;
+}
+
+
 /// Opens a read-only transaction.
 ///
 /// \return A new transaction.
@@ -34,6 +34,7 @@
 
 #include "store/read_backend_fwd.hpp"
 
+#include "store/metadata_fwd.hpp"
 #include "store/read_transaction_fwd.hpp"
 #include "utils/fs/path_fwd.hpp"
 #include "utils/shared_ptr.hpp"
@@ -45,6 +46,8 @@ namespace store {
 namespace detail {
 
 
+void check_schema_version(const metadata&);
+utils::fs::path live_lock_file(const utils::fs::path&);
 utils::sqlite::database open_and_setup(const utils::fs::path&, const int);
 
 
@@ -67,6 +70,7 @@ public:
     void close(void);
 
     utils::sqlite::database& database(void);
+    bool is_live(void);
     read_transaction start_read(void);
 };
 
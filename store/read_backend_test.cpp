@@ -28,6 +28,14 @@
 
 #include "store/read_backend.hpp"
 
+extern "C" {
+#include <sys/wait.h>
+
+#include <unistd.h>
+}
+
+#include <cstdlib>
+
 #include <atf-c++.hpp>
 
 #include "store/exceptions.hpp"
@@ -140,6 +148,58 @@ ATF_TEST_CASE_BODY(read_backend__close)
 }
 
 
+ATF_TEST_CASE(read_backend__is_live);
+ATF_TEST_CASE_HEAD(read_backend__is_live)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(read_backend__is_live)
+{
+    store::write_backend writer = store::write_backend::open_rw(
+        fs::path("test.db"));
+    {
+        store::read_backend backend = store::read_backend::open_ro(
+            fs::path("test.db"));
+        ATF_REQUIRE(backend.is_live());
+    }
+    writer.close();
+    {
+        store::read_backend backend = store::read_backend::open_ro(
+            fs::path("test.db"));
+        ATF_REQUIRE(!backend.is_live());
+    }
+}
+
+
+ATF_TEST_CASE(read_backend__is_live__killed_writer);
+ATF_TEST_CASE_HEAD(read_backend__is_live__killed_writer)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(read_backend__is_live__killed_writer)
+{
+    const pid_t pid = ::fork();
+    ATF_REQUIRE(pid != -1);
+    if (pid == 0) {
+        store::write_backend writer = store::write_backend::open_rw(
+            fs::path("test.db"));
+        // Terminate without closing the backend, as if the run was killed.
+        ::_exit(EXIT_SUCCESS);
+    }
+    int status;
+    ATF_REQUIRE_EQ(pid, ::waitpid(pid, &status, 0));
+    ATF_REQUIRE(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+
+    ATF_REQUIRE(fs::exists(store::detail::live_lock_file(
+        fs::path("test.db"))));
+    store::read_backend backend = store::read_backend::open_ro(
+        fs::path("test.db"));
+    ATF_REQUIRE(!backend.is_live());
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, detail__open_and_setup__ok);
@@ -149,4 +209,6 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, read_backend__open_ro__missing_file);
     ATF_ADD_TEST_CASE(tcs, read_backend__open_ro__integrity_error);
     ATF_ADD_TEST_CASE(tcs, read_backend__close);
+    ATF_ADD_TEST_CASE(tcs, read_backend__is_live);
+    ATF_ADD_TEST_CASE(tcs, read_backend__is_live__killed_writer);
 }
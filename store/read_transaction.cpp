@@ -32,14 +32,19 @@ extern "C" {
 #include <stdint.h>
 }
 
+#include <algorithm>
 #include <map>
+#include <sstream>
+#include <streambuf>
 #include <utility>
+#include <vector>
 
 #include "model/context.hpp"
 #include "model/metadata.hpp"
 #include "model/test_case.hpp"
 #include "model/test_program.hpp"
 #include "model/test_result.hpp"
+#include "model/types.hpp"
 #include "store/dbtypes.hpp"
 #include "store/exceptions.hpp"
 #include "store/read_backend.hpp"
@@ -50,6 +55,7 @@ extern "C" {
 #include "utils/noncopyable.hpp"
 #include "utils/optional.ipp"
 #include "utils/sanity.hpp"
+#include "utils/sqlite/blob_reader.hpp"
 #include "utils/sqlite/database.hpp"
 #include "utils/sqlite/exceptions.hpp"
 #include "utils/sqlite/statement.ipp"
@@ -90,33 +96,342 @@ get_env_vars(sqlite::database& db)
 }
 
 
-/// Retrieves a metadata object.
+/// Accumulates the metadata properties of consecutive rows of a statement.
 ///
-/// \param db The SQLite database.
-/// \param metadata_id The identifier of the metadata.
+/// The statement must yield the properties in the property_name and
+/// property_value columns, which may be NULL if the object has no metadata
+/// (e.g. as a result of a LEFT JOIN).  All rows for which the given id_column
+/// matches the given id are consumed.
+///
+/// \param stmt The statement to read from, positioned at the first row to
+///     consider.
+/// \param [in,out] valid Whether the statement has a current row.  Updated as
+///     the statement is stepped.
+/// \param id_column The name of the column that identifies the object the
+///     metadata belongs to.
+/// \param id The identifier of the object whose metadata to read.
+/// \param [out] properties The collection into which to store the properties.
 ///
-/// \return A new metadata object.
+/// \throw sqlite::error If there is a problem reading the data.
+static void
+read_metadata_rows(sqlite::statement& stmt, bool& valid, const char* id_column,
+                   const int64_t id, model::properties_map& properties)
+{
+    const int id_col = stmt.column_id(id_column);
+    const int name_col = stmt.column_id("property_name");
+    while (valid && stmt.column_int64(id_col) == id) {
+        if (stmt.column_type(name_col) != sqlite::type_null) {
+            const std::string name = stmt.safe_column_text("property_name");
+            const std::string value = stmt.safe_column_text("property_value");
+            properties[name] = value;
+        }
+        valid = stmt.step();
+    }
+}
+
+
+/// Constructs a metadata object from its textual properties.
+///
+/// \param properties The properties as read by read_metadata_rows().
+///
+/// \return The new metadata object.
+///
+/// \throw model::error If any of the properties is invalid.
 static model::metadata
-get_metadata(sqlite::database& db, const int64_t metadata_id)
+build_metadata(const model::properties_map& properties)
 {
     model::metadata_builder builder;
+    for (model::properties_map::const_iterator iter = properties.begin();
+         iter != properties.end(); ++iter)
+        builder.set_string((*iter).first, (*iter).second);
+    return builder.build();
+}
 
-    sqlite::statement stmt = db.create_statement(
-        "SELECT * FROM metadatas WHERE metadata_id == :metadata_id");
-    stmt.bind(":metadata_id", metadata_id);
-    while (stmt.step()) {
-        const std::string name = stmt.safe_column_text("property_name");
-        const std::string value = stmt.safe_column_text("property_value");
-        builder.set_string(name, value);
+
+/// SQL condition to select results, along with the values of its parameters.
+///
+/// The values are kept aside and bound once the statement that embeds the
+/// condition is prepared, so that user input never becomes part of the query.
+class results_condition {
+    /// The SQL expression, to be used in a WHERE clause.
+    std::string _sql;
+
+    /// Values of the :text<N> parameters in the expression.
+    std::vector< std::string > _texts;
+
+    /// Values of the :type<N> parameters in the expression.
+    std::vector< model::test_result_type > _types;
+
+    /// Adds a text parameter to the condition.
+    ///
+    /// \param value The value of the parameter.
+    ///
+    /// \return The name of the parameter to embed in the expression.
+    std::string
+    text_param(const std::string& value)
+    {
+        _texts.push_back(value);
+        return F(":text%s") % (_texts.size() - 1);
     }
 
-    return builder.build();
+public:
+    /// Translates a results filter into an SQL condition.
+    ///
+    /// The selection of test programs mimics engine::test_filter: a path
+    /// selects the test program with that name or, if no test case is given,
+    /// any test program in the directory with that name.  The latter is
+    /// expressed as a range on the relative path so that it can be resolved
+    /// by an index.
+    ///
+    /// \param filter The filter to translate.
+    /// \param programs_only Whether to only select the test programs that
+    ///     contain the selected test cases.  The resulting condition only
+    ///     refers to the test_programs table.
+    results_condition(const store::results_filter& filter,
+                      const bool programs_only)
+    {
+        std::string test_cases;
+        for (store::test_case_ids_set::const_iterator
+                 iter = filter.test_cases.begin();
+             iter != filter.test_cases.end(); ++iter) {
+            const std::string program = (*iter).first.str();
+            const std::string& name = (*iter).second;
+
+            if (!test_cases.empty())
+                test_cases += " OR ";
+            if (programs_only && !name.empty()) {
+                test_cases += F("test_programs.relative_path == %s") %
+                    text_param(program);
+            } else if (name.empty()) {
+                // '0' is the character that follows '/'.
+                test_cases += F("test_programs.relative_path == %s OR "
+                                "(test_programs.relative_path >= %s AND "
+                                "test_programs.relative_path < %s)") %
+                    text_param(program) % text_param(program + "/") %
+                    text_param(program + "0");
+            } else {
+                test_cases += F("(test_programs.relative_path == %s AND "
+                                "test_cases.name == %s)") %
+                    text_param(program) % text_param(name);
+            }
+        }
+
+        std::string types;
+        for (std::set< model::test_result_type >::const_iterator
+                 iter = filter.types.begin();
+             !programs_only && iter != filter.types.end(); ++iter) {
+            if (!types.empty())
+                types += ", ";
+            types += F(":type%s") % _types.size();
+            _types.push_back(*iter);
+        }
+
+        _sql = "1";
+        if (!test_cases.empty())
+            _sql += " AND (" + test_cases + ")";
+        if (!types.empty()) {
+            // The unary plus prevents using the index on the result type when
+            // we are selecting test programs: their index is more selective.
+            _sql += F(" AND %stest_results.result_type IN (%s)") %
+                (test_cases.empty() ? "" : "+") % types;
+        }
+    }
+
+    /// Gets the SQL expression.
+    ///
+    /// \return A string suitable for a WHERE clause.
+    const std::string&
+    sql(void) const
+    {
+        return _sql;
+    }
+
+    /// Binds the values of the parameters of the condition to a statement.
+    ///
+    /// \param stmt The statement that embeds the condition.
+    ///
+    /// \throw sqlite::error If the parameters cannot be bound.
+    void
+    bind(sqlite::statement& stmt) const
+    {
+        for (std::vector< std::string >::size_type i = 0; i < _texts.size();
+             ++i) {
+            stmt.bind((F(":text%s") % i).str().c_str(), _texts[i]);
+        }
+        for (std::vector< model::test_result_type >::size_type i = 0;
+             i < _types.size(); ++i) {
+            store::bind_test_result_type(
+                stmt, (F(":type%s") % i).str().c_str(), _types[i]);
+        }
+    }
+};
+
+
+/// Query to fetch test programs along with their metadata.
+///
+/// Must be completed with filtering and ordering clauses, and the ordering must
+/// keep all rows of a single test program together.
+static const char* test_programs_query =
+    "SELECT test_programs.test_program_id, test_programs.interface, "
+    "    test_programs.relative_path, test_programs.root, "
+    "    test_programs.test_suite_name, "
+    "    metadatas.property_name, metadatas.property_value "
+    "FROM test_programs "
+    "    LEFT JOIN metadatas "
+    "    ON test_programs.metadata_id = metadatas.metadata_id ";
+
+
+/// Query to fetch test cases along with their metadata.
+///
+/// Must be completed with filtering and ordering clauses, and the ordering must
+/// keep all rows of a single test case together and all test cases of a single
+/// test program together.
+static const char* test_cases_query =
+    "SELECT test_cases.test_program_id, test_cases.test_case_id, "
+    "    test_cases.name, "
+    "    metadatas.property_name, metadatas.property_value "
+    "FROM test_programs "
+    "    JOIN test_cases "
+    "    ON test_programs.test_program_id = test_cases.test_program_id "
+    "    LEFT JOIN metadatas "
+    "    ON test_cases.metadata_id = metadatas.metadata_id ";
+
+
+/// Builds a test program from the current rows of the bulk queries.
+///
+/// \param programs Statement based on test_programs_query positioned at the
+///     first row of the test program to load.
+/// \param [in,out] programs_valid Whether programs has a current row.
+/// \param cases Statement based on test_cases_query positioned at or before
+///     the first row of the test cases of the program to load.  Rows
+///     belonging to other test programs are skipped, so the caller must ensure
+///     that the orderings of both statements match.
+/// \param [in,out] cases_valid Whether cases has a current row.
+///
+/// \return The loaded test program.
+///
+/// \throw sqlite::error If there is a problem reading the data.
+static model::test_program_ptr
+build_test_program(sqlite::statement& programs, bool& programs_valid,
+                   sqlite::statement& cases, bool& cases_valid)
+{
+    PRE(programs_valid);
+    const int64_t id = programs.safe_column_int64("test_program_id");
+    const std::string interface = programs.safe_column_text("interface");
+    const fs::path relative_path(programs.safe_column_text("relative_path"));
+    const fs::path root(programs.safe_column_text("root"));
+    const std::string test_suite_name = programs.safe_column_text(
+        "test_suite_name");
+
+    model::properties_map metadata;
+    read_metadata_rows(programs, programs_valid, "test_program_id", id,
+                       metadata);
+
+    const int program_id_col = cases.column_id("test_program_id");
+    while (cases_valid && cases.column_int64(program_id_col) != id)
+        cases_valid = cases.step();
+
+    // The test cases of a test program tend to share their metadata, and
+    // building a metadata object costs far more than reading its properties,
+    // so only build each distinct set of properties once.
+    std::map< model::properties_map, model::metadata > built_metadata;
+
+    model::test_cases_map_builder test_cases;
+    while (cases_valid && cases.column_int64(program_id_col) == id) {
+        const int64_t test_case_id = cases.safe_column_int64("test_case_id");
+        const std::string name = cases.safe_column_text("name");
+
+        model::properties_map properties;
+        read_metadata_rows(cases, cases_valid, "test_case_id", test_case_id,
+                           properties);
+        std::map< model::properties_map, model::metadata >::const_iterator
+            test_case_metadata = built_metadata.find(properties);
+        if (test_case_metadata == built_metadata.end())
+            test_case_metadata = built_metadata.insert(std::make_pair(
+                properties, build_metadata(properties))).first;
+        LD(F("Loaded test case '%s'") % name);
+        test_cases.add(name, (*test_case_metadata).second);
+    }
+
+    const model::test_program_ptr test_program(new model::test_program(
+        interface, relative_path, root, test_suite_name,
+        build_metadata(metadata), test_cases.build()));
+    LD(F("Loaded test program '%s'") % test_program->relative_path());
+    return test_program;
 }
 
 
+/// Sequentially loads test programs in the same order as a results scan.
+///
+/// Loading a test program the naive way requires a query per test case to
+/// fetch its metadata.  Instead, this walks two statements in lockstep with the
+/// results scan: one for the test programs and one for all of their test cases,
+/// both with their metadata.  This way, the whole scan costs a constant number
+/// of queries and only one test program is kept in memory at any given time.
+class test_programs_loader : utils::noncopyable {
+    /// Statement to fetch the test programs, in scan order.
+    sqlite::statement _programs;
+
+    /// Whether _programs has a current row.
+    bool _programs_valid;
+
+    /// Statement to fetch the test cases, in scan order.
+    sqlite::statement _cases;
+
+    /// Whether _cases has a current row.
+    bool _cases_valid;
+
+public:
+    /// Constructor.
+    ///
+    /// \param db The database to load the test programs from.
+    /// \param condition The condition to select the test programs to load,
+    ///     which can only refer to the test_programs table.
+    /// \param order_by The ORDER BY clause of the results scan, which can only
+    ///     refer to the test_programs table.
+    ///
+    /// \throw sqlite::error If the queries cannot be prepared.
+    test_programs_loader(sqlite::database& db,
+                         const results_condition& condition,
+                         const std::string& order_by) :
+        _programs(db.create_statement(
+            std::string(test_programs_query) + "WHERE " + condition.sql() +
+            " " + order_by)),
+        _cases(db.create_statement(
+            std::string(test_cases_query) + "WHERE " + condition.sql() + " " +
+            order_by + ", test_cases.test_case_id"))
+    {
+        condition.bind(_programs);
+        _programs_valid = _programs.step();
+        condition.bind(_cases);
+        _cases_valid = _cases.step();
+    }
+
+    /// Loads the next test program with the given identifier.
+    ///
+    /// \param id The identifier of the test program to load.
+    ///
+    /// \return The loaded test program, or a null pointer if the test program
+    /// is not ahead of the current position of the scan.
+    ///
+    /// \throw sqlite::error If there is a problem reading the data.
+    model::test_program_ptr
+    load(const int64_t id)
+    {
+        const int id_col = _programs.column_id("test_program_id");
+        while (_programs_valid && _programs.column_int64(id_col) != id)
+            _programs_valid = _programs.step();
+        if (!_programs_valid)
+            return model::test_program_ptr();
+        return build_test_program(_programs, _programs_valid, _cases,
+                                  _cases_valid);
+    }
+};
+
+
 /// Gets a file from the database.
 ///
-/// \param db The database to query the file from.
+/// \param stmt The statement to query the file with.  Must not be stepped yet.
 /// \param file_id The identifier of the file to be queried.
 ///
 /// \return A textual representation of the file contents.
@@ -124,10 +439,8 @@ get_metadata(sqlite::database& db, const int64_t metadata_id)
 /// \throw integrity_error If there is any problem in the loaded data or if the
 ///     file cannot be found.
 static std::string
-get_file(sqlite::database& db, const int64_t file_id)
+get_file(sqlite::statement& stmt, const int64_t file_id)
 {
-    sqlite::statement stmt = db.create_statement(
-        "SELECT contents FROM files WHERE file_id == :file_id");
     stmt.bind(":file_id", file_id);
     if (!stmt.step())
         throw store::integrity_error(F("Cannot find referenced file %s") %
@@ -148,37 +461,6 @@ get_file(sqlite::database& db, const int64_t file_id)
 }
 
 
-/// Gets all the test cases within a particular test program.
-///
-/// \param db The database to query the information from.
-/// \param test_program_id The identifier of the test program whose test cases
-///     to query.
-///
-/// \return The collection of loaded test cases.
-///
-/// \throw integrity_error If there is any problem in the loaded data.
-static model::test_cases_map
-get_test_cases(sqlite::database& db, const int64_t test_program_id)
-{
-    model::test_cases_map_builder test_cases;
-
-    sqlite::statement stmt = db.create_statement(
-        "SELECT name, metadata_id "
-        "FROM test_cases WHERE test_program_id == :test_program_id");
-    stmt.bind(":test_program_id", test_program_id);
-    while (stmt.step()) {
-        const std::string name = stmt.safe_column_text("name");
-        const int64_t metadata_id = stmt.safe_column_int64("metadata_id");
-
-        const model::metadata metadata = get_metadata(db, metadata_id);
-        LD(F("Loaded test case '%s'") % name);
-        test_cases.add(name, metadata);
-    }
-
-    return test_cases.build();
-}
-
-
 /// Retrieves a result from the database.
 ///
 /// \param stmt The statement with the data for the result to load.
@@ -212,6 +494,86 @@ parse_result(sqlite::statement& stmt, const char* type_column,
 }
 
 
+/// Size of the chunks in which to read the files of the store.
+static const int file_chunk_size = 64 * 1024;
+
+
+/// Stream buffer that reads a file of the store in chunks.
+///
+/// Files are held in BLOBs that can be arbitrarily large, so this only keeps a
+/// chunk of the file in memory at any given time.
+class file_streambuf : public std::streambuf {
+    /// Reader for the BLOB holding the contents of the file.
+    sqlite::blob_reader _reader;
+
+    /// Position in the file of the next chunk to read.
+    int _offset;
+
+    /// Memory holding the last chunk read from the file.
+    std::vector< char > _buffer;
+
+protected:
+    /// Reads the next chunk of the file once the current one is consumed.
+    ///
+    /// \return The next character of the file, or EOF if there are no more.
+    ///
+    /// \throw store::integrity_error If the file cannot be read.
+    int_type
+    underflow(void)
+    {
+        if (gptr() < egptr())
+            return traits_type::to_int_type(*gptr());
+
+        int count;
+        try {
+            count = _reader.read(&_buffer[0], _buffer.size(), _offset);
+        } catch (const sqlite::error& e) {
+            throw store::integrity_error(e.what());
+        }
+        if (count == 0)
+            return traits_type::eof();
+        _offset += count;
+
+        setg(&_buffer[0], &_buffer[0], &_buffer[0] + count);
+        return traits_type::to_int_type(*gptr());
+    }
+
+public:
+    /// Constructor.
+    ///
+    /// \param reader_ Reader for the BLOB holding the contents of the file.
+    explicit file_streambuf(const sqlite::blob_reader& reader_) :
+        _reader(reader_),
+        _offset(0),
+        _buffer(std::min(file_chunk_size, std::max(1, reader_.size())))
+    {
+    }
+};
+
+
+/// Input stream over a file of the store.
+///
+/// Errors raised while reading the file are propagated to the caller instead
+/// of just marking the stream as bad, as otherwise the contents of the file
+/// would appear to be silently truncated.
+class file_istream : public std::istream {
+    /// The buffer that feeds this stream.
+    file_streambuf _buffer;
+
+public:
+    /// Constructor.
+    ///
+    /// \param reader Reader for the BLOB holding the contents of the file.
+    explicit file_istream(const sqlite::blob_reader& reader) :
+        std::istream(NULL),
+        _buffer(reader)
+    {
+        rdbuf(&_buffer);
+        exceptions(std::ios::badbit);
+    }
+};
+
+
 }  // anonymous namespace
 
 
@@ -229,27 +591,62 @@ store::detail::get_test_program(read_backend& backend_, const int64_t id)
 {
     sqlite::database& db = backend_.database();
 
-    model::test_program_ptr test_program;
-    sqlite::statement stmt = db.create_statement(
-        "SELECT * FROM test_programs WHERE test_program_id == :id");
-    stmt.bind(":id", id);
-    stmt.step();
-    const std::string interface = stmt.safe_column_text("interface");
-    test_program.reset(new model::test_program(
-        interface,
-        fs::path(stmt.safe_column_text("relative_path")),
-        fs::path(stmt.safe_column_text("root")),
-        stmt.safe_column_text("test_suite_name"),
-        get_metadata(db, stmt.safe_column_int64("metadata_id")),
-        get_test_cases(db, id)));
-    const bool more = stmt.step();
-    INV(!more);
-
-    LD(F("Loaded test program '%s'") % test_program->relative_path());
+    sqlite::statement programs = db.create_statement(
+        std::string(test_programs_query) +
+        "WHERE test_programs.test_program_id == :id");
+    programs.bind(":id", id);
+    bool programs_valid = programs.step();
+    if (!programs_valid)
+        throw integrity_error(F("Cannot find test program %s") % id);
+
+    sqlite::statement cases = db.create_statement(
+        std::string(test_cases_query) +
+        "WHERE test_cases.test_program_id == :id "
+        "ORDER BY test_cases.test_case_id");
+    cases.bind(":id", id);
+    bool cases_valid = cases.step();
+
+    const model::test_program_ptr test_program = build_test_program(
+        programs, programs_valid, cases, cases_valid);
+    INV(!programs_valid);
     return test_program;
 }
 
 
+/// Query to fetch test results; must be completed with filtering and ordering.
+///
+/// The identifiers of the stdout and stderr files are fetched as part of the
+/// scan so that their contents can later be loaded with a single lookup, and
+/// only if requested.
+static const char* results_query =
+    "SELECT test_programs.test_program_id, "
+    "    test_programs.interface, "
+    "    test_cases.test_case_id, test_cases.name, "
+    "    test_results.result_type, test_results.result_reason, "
+    "    test_results.duration, "
+    "    stdout_files.file_id AS stdout_file_id, "
+    "    stderr_files.file_id AS stderr_file_id "
+    "FROM test_programs "
+    "    JOIN test_cases "
+    "    ON test_programs.test_program_id = test_cases.test_program_id "
+    "    JOIN test_results "
+    "    ON test_cases.test_case_id = test_results.test_case_id "
+    "    LEFT JOIN test_case_files AS stdout_files "
+    "    ON test_cases.test_case_id = stdout_files.test_case_id "
+    "        AND stdout_files.file_name == '__STDOUT__' "
+    "    LEFT JOIN test_case_files AS stderr_files "
+    "    ON test_cases.test_case_id = stderr_files.test_case_id "
+    "        AND stderr_files.file_name == '__STDERR__' ";
+
+
+/// Ordering of the results in a full scan.
+///
+/// Keeps all the results of a test program together, which is what allows
+/// test_programs_loader to process them sequentially.
+static const char* results_order_by =
+    "ORDER BY test_programs.absolute_path, test_programs.test_program_id";
+
+
 /// Internal implementation for a results iterator.
 struct store::results_iterator::impl : utils::noncopyable {
     /// The store backend we are dealing with.
@@ -258,31 +655,103 @@ struct store::results_iterator::impl : utils::noncopyable {
     /// The statement to iterate on.
     sqlite::statement _stmt;
 
-    /// A cache for the last loaded test program.
-    optional< std::pair< int64_t, model::test_program_ptr > >
-        _last_test_program;
+    /// The statement to fetch the contents of files.
+    sqlite::statement _file_stmt;
+
+    /// Bulk loader for the test programs, if the scan is in program order.
+    std::shared_ptr< test_programs_loader > _loader;
+
+    /// Cache of the loaded test programs, keyed by their identifiers.
+    ///
+    /// If the scan is in program order, this only holds the last loaded test
+    /// program to keep memory usage bounded.
+    std::map< int64_t, model::test_program_ptr > _test_programs;
 
     /// Whether the iterator is still valid or not.
     bool _valid;
 
     /// Constructor.
-    impl(store::read_backend& backend_) :
+    ///
+    /// \param backend_ The store backend we are dealing with.
+    /// \param stmt_ The statement to iterate on, based on results_query.  Must
+    ///     be fully bound and not yet stepped.
+    /// \param loader_ Bulk loader for the test programs if stmt_ is ordered by
+    ///     results_order_by, or null otherwise.
+    impl(store::read_backend& backend_, const sqlite::statement& stmt_,
+         std::shared_ptr< test_programs_loader > loader_) :
         _backend(backend_),
-        _stmt(backend_.database().create_statement(
-            "SELECT test_programs.test_program_id, "
-            "    test_programs.interface, "
-            "    test_cases.test_case_id, test_cases.name, "
-            "    test_results.result_type, test_results.result_reason, "
-            "    test_results.start_time, test_results.end_time "
-            "FROM test_programs "
-            "    JOIN test_cases "
-            "    ON test_programs.test_program_id = test_cases.test_program_id "
-            "    JOIN test_results "
-            "    ON test_cases.test_case_id = test_results.test_case_id "
-            "ORDER BY test_programs.absolute_path, test_cases.name"))
+        _stmt(stmt_),
+        _file_stmt(backend_.database().create_statement(
+            "SELECT contents FROM files WHERE file_id == :file_id")),
+        _loader(loader_)
     {
         _valid = _stmt.step();
     }
+
+    /// Gets a test program, loading it if necessary.
+    ///
+    /// \param id The identifier of the test program.
+    ///
+    /// \return The test program.
+    model::test_program_ptr
+    get_test_program(const int64_t id)
+    {
+        const std::map< int64_t, model::test_program_ptr >::const_iterator
+            iter = _test_programs.find(id);
+        if (iter != _test_programs.end())
+            return (*iter).second;
+
+        model::test_program_ptr test_program;
+        if (_loader) {
+            test_program = _loader->load(id);
+            _test_programs.clear();
+        }
+        if (!test_program)
+            test_program = detail::get_test_program(_backend, id);
+        _test_programs[id] = test_program;
+        return test_program;
+    }
+
+    /// Gets the contents of a file referenced by the current result.
+    ///
+    /// \param column The name of the column holding the file identifier.
+    ///
+    /// \return The contents of the file, or an empty string if there is no
+    /// file.
+    std::string
+    get_file_contents(const char* column)
+    {
+        const int id_col = _stmt.column_id(column);
+        if (_stmt.column_type(id_col) == sqlite::type_null)
+            return "";
+        _file_stmt.reset();
+        return get_file(_file_stmt, _stmt.column_int64(id_col));
+    }
+
+    /// Opens a stream over a file referenced by the current result.
+    ///
+    /// \param column The name of the column holding the file identifier.
+    ///
+    /// \return A stream over the contents of the file, which is empty if there
+    /// is no file.
+    ///
+    /// \throw integrity_error If the referenced file cannot be found.
+    std::shared_ptr< std::istream >
+    get_file_stream(const char* column)
+    {
+        const int id_col = _stmt.column_id(column);
+        if (_stmt.column_type(id_col) == sqlite::type_null)
+            return std::shared_ptr< std::istream >(new std::istringstream());
+
+        const int64_t file_id = _stmt.column_int64(id_col);
+        try {
+            return std::shared_ptr< std::istream >(new file_istream(
+                _backend.database().open_blob("files", "contents", file_id)));
+        } catch (const sqlite::error& e) {
+            throw store::integrity_error(F("Cannot open referenced file %s: %s")
+                                         % file_id % e.what());
+        }
+    }
 };
 
 
@@ -328,15 +797,25 @@ store::results_iterator::operator bool(void) const
 const model::test_program_ptr
 store::results_iterator::test_program(void) const
 {
-    const int64_t id = _pimpl->_stmt.safe_column_int64("test_program_id");
-    if (!_pimpl->_last_test_program ||
-        _pimpl->_last_test_program.get().first != id)
-    {
-        const model::test_program_ptr tp = detail::get_test_program(
-            _pimpl->_backend, id);
-        _pimpl->_last_test_program = std::make_pair(id, tp);
+    try {
+        return _pimpl->get_test_program(
+            _pimpl->_stmt.safe_column_int64("test_program_id"));
+    } catch (const sqlite::error& e) {
+        throw integrity_error(e.what());
     }
-    return _pimpl->_last_test_program.get().second;
+}
+
+
+/// Gets the identifier of the test case pointed by the iterator.
+///
+/// Identifiers grow monotonically as test cases are stored, so they can be used
+/// to query the results added to a database since a previous scan.
+///
+/// \return The identifier of the test case in the database.
+int64_t
+store::results_iterator::test_case_id(void) const
+{
+    return _pimpl->_stmt.safe_column_int64("test_case_id");
 }
 
 
@@ -369,37 +848,7 @@ store::results_iterator::result(void) const
 datetime::delta
 store::results_iterator::duration(void) const
 {
-    const datetime::timestamp start_time = column_timestamp(
-        _pimpl->_stmt, "start_time");
-    const datetime::timestamp end_time = column_timestamp(
-        _pimpl->_stmt, "end_time");
-    return end_time - start_time;
-}
-
-
-/// Gets a file from a test case.
-///
-/// \param db The database to query the file from.
-/// \param test_case_id The identifier of the test case.
-/// \param filename The name of the file to be retrieved.
-///
-/// \return A textual representation of the file contents.
-///
-/// \throw integrity_error If there is any problem in the loaded data or if the
-///     file cannot be found.
-static std::string
-get_test_case_file(sqlite::database& db, const int64_t test_case_id,
-                   const char* filename)
-{
-    sqlite::statement stmt = db.create_statement(
-        "SELECT file_id FROM test_case_files "
-        "WHERE test_case_id == :test_case_id AND file_name == :file_name");
-    stmt.bind(":test_case_id", test_case_id);
-    stmt.bind(":file_name", filename);
-    if (stmt.step())
-        return get_file(db, stmt.safe_column_int64("file_id"));
-    else
-        return "";
+    return column_delta(_pimpl->_stmt, "duration");
 }
 
 
@@ -410,9 +859,7 @@ get_test_case_file(sqlite::database& db, const int64_t test_case_id,
 std::string
 store::results_iterator::stdout_contents(void) const
 {
-    return get_test_case_file(_pimpl->_backend.database(),
-                              _pimpl->_stmt.safe_column_int64("test_case_id"),
-                              "__STDOUT__");
+    return _pimpl->get_file_contents("stdout_file_id");
 }
 
 
@@ -423,9 +870,158 @@ store::results_iterator::stdout_contents(void) const
 std::string
 store::results_iterator::stderr_contents(void) const
 {
-    return get_test_case_file(_pimpl->_backend.database(),
-                              _pimpl->_stmt.safe_column_int64("test_case_id"),
-                              "__STDERR__");
+    return _pimpl->get_file_contents("stderr_file_id");
+}
+
+
+/// Opens a stream over the stdout of a test case.
+///
+/// Unlike stdout_contents(), this does not load the whole output in memory, so
+/// it is the preferred way to process outputs of arbitrary size.  The stream
+/// must be destroyed before the transaction is finished.
+///
+/// \return A stream over the stdout contents of the test case.  This may of
+/// course be empty if the test case didn't print anything.  Reading from the
+/// stream raises integrity_error if the file cannot be read.
+std::shared_ptr< std::istream >
+store::results_iterator::stdout_stream(void) const
+{
+    return _pimpl->get_file_stream("stdout_file_id");
+}
+
+
+/// Opens a stream over the stderr of a test case.
+///
+/// Unlike stderr_contents(), this does not load the whole output in memory, so
+/// it is the preferred way to process outputs of arbitrary size.  The stream
+/// must be destroyed before the transaction is finished.
+///
+/// \return A stream over the stderr contents of the test case.  This may of
+/// course be empty if the test case didn't print anything.  Reading from the
+/// stream raises integrity_error if the file cannot be read.
+std::shared_ptr< std::istream >
+store::results_iterator::stderr_stream(void) const
+{
+    return _pimpl->get_file_stream("stderr_file_id");
+}
+
+
+/// Internal implementation for an outcomes iterator.
+struct store::outcomes_iterator::impl : utils::noncopyable {
+    /// The store backend we are dealing with.
+    store::read_backend _backend;
+
+    /// The statement to iterate on.
+    sqlite::statement _stmt;
+
+    /// Column holding the relative path of the test program.
+    const int _path_col;
+
+    /// Column holding the name of the test case.
+    const int _name_col;
+
+    /// Whether the iterator is still valid or not.
+    bool _valid;
+
+    /// Constructor.
+    ///
+    /// \param backend_ The store backend we are dealing with.
+    /// \param stmt_ The statement to iterate on.  Must be fully bound and not
+    ///     yet stepped.
+    impl(store::read_backend& backend_, const sqlite::statement& stmt_) :
+        _backend(backend_),
+        _stmt(stmt_),
+        _path_col(_stmt.column_id("relative_path")),
+        _name_col(_stmt.column_id("name"))
+    {
+        _valid = _stmt.step();
+    }
+};
+
+
+/// Constructor.
+///
+/// \param pimpl_ The internal implementation details of the iterator.
+store::outcomes_iterator::outcomes_iterator(std::shared_ptr< impl > pimpl_) :
+    _pimpl(pimpl_)
+{
+}
+
+
+/// Destructor.
+store::outcomes_iterator::~outcomes_iterator(void)
+{
+}
+
+
+/// Moves the iterator forward by one outcome.
+///
+/// \return The iterator itself.
+store::outcomes_iterator&
+store::outcomes_iterator::operator++(void)
+{
+    _pimpl->_valid = _pimpl->_stmt.step();
+    return *this;
+}
+
+
+/// Checks whether the iterator is still valid.
+///
+/// \return True if there is more elements to iterate on, false otherwise.
+store::outcomes_iterator::operator bool(void) const
+{
+    return _pimpl->_valid;
+}
+
+
+/// Gets the relative path of the test program of the current test case.
+///
+/// This is returned as a string instead of a path to avoid normalizing it on
+/// every row.  The value is already normalized in the database.
+///
+/// \return The relative path to the test program.
+std::string
+store::outcomes_iterator::test_program_path(void) const
+{
+    return _pimpl->_stmt.column_text(_pimpl->_path_col);
+}
+
+
+/// Gets the name of the current test case.
+///
+/// \return A test case name, unique within the test program.
+std::string
+store::outcomes_iterator::test_case_name(void) const
+{
+    return _pimpl->_stmt.column_text(_pimpl->_name_col);
+}
+
+
+/// Gets the type of the result of the current test case.
+///
+/// \return A test result type.
+///
+/// \throw integrity_error If the stored type is invalid.
+model::test_result_type
+store::outcomes_iterator::result_type(void) const
+{
+    try {
+        return column_test_result_type(_pimpl->_stmt, "result_type");
+    } catch (const sqlite::error& e) {
+        throw integrity_error(e.what());
+    }
+}
+
+
+/// Gets the duration of the current test case.
+///
+/// \return A time delta representing the run time of the test case.
+///
+/// \throw integrity_error If the stored duration is invalid.
+datetime::delta
+store::outcomes_iterator::duration(void) const
+{
+    return column_delta(_pimpl->_stmt, "duration");
 }
 
 
@@ -514,11 +1110,274 @@ store::read_transaction::get_context(void)
 /// \throw error If there is any problem constructing the iterator.
 store::results_iterator
 store::read_transaction::get_results(void)
+{
+    return get_results(results_filter());
+}
+
+
+/// Creates a new iterator to scan a subset of the tests results.
+///
+/// \param filter The criteria to select the results to return.
+///
+/// \return The constructed iterator.
+///
+/// \throw error If there is any problem constructing the iterator.
+store::results_iterator
+store::read_transaction::get_results(const results_filter& filter)
+{
+    try {
+        const results_condition condition(filter, false);
+        sqlite::statement stmt = _pimpl->_db.create_statement(
+            std::string(results_query) + "WHERE " + condition.sql() + " " +
+            results_order_by + ", test_cases.name");
+        condition.bind(stmt);
+        const std::shared_ptr< test_programs_loader > loader(
+            new test_programs_loader(_pimpl->_db,
+                                     results_condition(filter, true),
+                                     results_order_by));
+        return results_iterator(std::shared_ptr< results_iterator::impl >(
+           new results_iterator::impl(_pimpl->_backend, stmt, loader)));
+    } catch (const sqlite::error& e) {
+        throw error(e.what());
+    }
+}
+
+
+/// Computes aggregated information about a subset of the tests results.
+///
+/// \param filter The criteria to select the results to consider.
+///
+/// \return The summary of the selected results.
+///
+/// \throw error If there is any problem querying the database.
+store::results_summary
+store::read_transaction::get_results_summary(const results_filter& filter)
+{
+    results_summary summary;
+    try {
+        const results_condition condition(filter, false);
+        sqlite::statement stmt = _pimpl->_db.create_statement(
+            "SELECT test_results.result_type, COUNT(*) AS count, "
+            "    SUM(test_results.duration) AS duration "
+            "FROM test_programs "
+            "    JOIN test_cases "
+            "    ON test_programs.test_program_id = test_cases.test_program_id "
+            "    JOIN test_results "
+            "    ON test_cases.test_case_id = test_results.test_case_id "
+            "WHERE " + condition.sql() + " "
+            "GROUP BY test_results.result_type");
+        condition.bind(stmt);
+
+        int64_t duration = 0;
+        while (stmt.step()) {
+            const model::test_result_type type = column_test_result_type(
+                stmt, "result_type");
+            summary.counts[type] = static_cast< std::size_t >(
+                stmt.safe_column_int64("count"));
+            duration += stmt.safe_column_int64("duration");
+        }
+        summary.duration = datetime::delta::from_microseconds(duration);
+    } catch (const sqlite::error& e) {
+        throw error(F("Error computing results summary: %s") % e.what());
+    }
+    return summary;
+}
+
+
+/// Creates a new iterator to scan the most recent test results.
+///
+/// Unlike get_results(), the returned iterator yields the results in the order
+/// in which their test cases were stored.  This is intended to incrementally
+/// process a database that is still being written to.
+///
+/// \param first_test_case_id The identifier of the first test case to
+///     consider.  Results for test cases with smaller identifiers are skipped.
+///
+/// \return The constructed iterator.
+///
+/// \throw error If there is any problem constructing the iterator.
+store::results_iterator
+store::read_transaction::get_results_since(const int64_t first_test_case_id)
 {
     try {
+        sqlite::statement stmt = _pimpl->_db.create_statement(
+            std::string(results_query) +
+            "WHERE test_cases.test_case_id >= :first_test_case_id "
+            "ORDER BY test_cases.test_case_id");
+        stmt.bind(":first_test_case_id", first_test_case_id);
         return results_iterator(std::shared_ptr< results_iterator::impl >(
-           new results_iterator::impl(_pimpl->_backend)));
+           new results_iterator::impl(
+               _pimpl->_backend, stmt,
+               std::shared_ptr< test_programs_loader >())));
+    } catch (const sqlite::error& e) {
+        throw error(e.what());
+    }
+}
+
+
+/// Creates a new iterator to scan the results of specific test cases.
+///
+/// This allows picking up the results of test cases located by a previous
+/// scan, e.g. those that were still running the last time a database that is
+/// still being written to was looked at.
+///
+/// \param test_case_ids The identifiers of the test cases to consider.  Test
+///     cases without a result are skipped.
+///
+/// \return The constructed iterator, which yields the results in the same
+/// order as get_results().
+///
+/// \throw error If there is any problem constructing the iterator.
+store::results_iterator
+store::read_transaction::get_results_of(
+    const std::set< int64_t >& test_case_ids)
+{
+    std::ostringstream ids;
+    for (std::set< int64_t >::const_iterator iter = test_case_ids.begin();
+         iter != test_case_ids.end(); ++iter) {
+        if (iter != test_case_ids.begin())
+            ids << ", ";
+        ids << *iter;
+    }
+
+    try {
+        sqlite::statement stmt = _pimpl->_db.create_statement(
+            std::string(results_query) +
+            "WHERE test_cases.test_case_id IN (" + ids.str() + ") " +
+            results_order_by + ", test_cases.name");
+        return results_iterator(std::shared_ptr< results_iterator::impl >(
+           new results_iterator::impl(
+               _pimpl->_backend, stmt,
+               std::shared_ptr< test_programs_loader >())));
+    } catch (const sqlite::error& e) {
+        throw error(e.what());
+    }
+}
+
+
+/// Creates a new iterator to scan the outcomes of all test cases.
+///
+/// The outcomes are sorted by the relative path of their test program and then
+/// by the name of the test case, so the streams of different results files can
+/// be merged without holding any of them in memory.  The indexes on the test
+/// programs and test cases already provide this order, so sorting is free.
+///
+/// \return The constructed iterator.
+///
+/// \throw error If there is any problem constructing the iterator.
+store::outcomes_iterator
+store::read_transaction::get_outcomes(void)
+{
+    try {
+        const sqlite::statement stmt = _pimpl->_db.create_statement(
+            "SELECT test_programs.relative_path, test_cases.name, "
+            "    test_results.result_type, test_results.duration "
+            "FROM test_programs "
+            "    JOIN test_cases "
+            "    ON test_programs.test_program_id = test_cases.test_program_id "
+            "    JOIN test_results "
+            "    ON test_cases.test_case_id = test_results.test_case_id "
+            "ORDER BY test_programs.relative_path, test_cases.name");
+        return outcomes_iterator(std::shared_ptr< outcomes_iterator::impl >(
+           new outcomes_iterator::impl(_pimpl->_backend, stmt)));
     } catch (const sqlite::error& e) {
         throw error(e.what());
     }
 }
+
+
+/// Gets the test cases within a range that do not have a result yet.
+///
+/// Test cases are stored in the database when they start running and their
+/// results are stored when they finish.  Because test cases run in parallel,
+/// results are not necessarily added in test case order.  The value returned
+/// by this function tells the caller which test cases may still get a result
+/// in the future.
+///
+/// \param first_test_case_id The identifier of the first test case to
+///     consider.
+/// \param last_test_case_id The identifier of the last test case to consider.
+///
+/// \return The identifiers of the test cases in the range without a result.
+///
+/// \throw error If there is any problem querying the database.
+std::set< int64_t >
+store::read_transaction::get_unfinished_test_cases(
+    const int64_t first_test_case_id, const int64_t last_test_case_id)
+{
+    std::set< int64_t > ids;
+    try {
+        sqlite::statement stmt = _pimpl->_db.create_statement(
+            "SELECT test_case_id FROM test_cases "
+            "WHERE test_case_id BETWEEN :first_test_case_id "
+            "        AND :last_test_case_id "
+            "    AND test_case_id NOT IN "
+            "        (SELECT test_case_id FROM test_results)");
+        stmt.bind(":first_test_case_id", first_test_case_id);
+        stmt.bind(":last_test_case_id", last_test_case_id);
+        while (stmt.step())
+            ids.insert(stmt.safe_column_int64("test_case_id"));
+    } catch (const sqlite::error& e) {
+        throw error(e.what());
+    }
+    return ids;
+}
+
+
+/// Gets the test cases that have a result recorded in the database.
+///
+/// This is intended to resume an interrupted run: any test case returned by
+/// this function need not be executed again.
+///
+/// \return The collection of test cases that have a result.
+///
+/// \throw error If there is any problem querying the database.
+store::test_case_ids_set
+store::read_transaction::get_completed_test_cases(void)
+{
+    test_case_ids_set completed;
+    try {
+        sqlite::statement stmt = _pimpl->_db.create_statement(
+            "SELECT test_programs.relative_path, test_cases.name "
+            "FROM test_programs "
+            "    JOIN test_cases "
+            "    ON test_programs.test_program_id = test_cases.test_program_id "
+            "    JOIN test_results "
+            "    ON test_cases.test_case_id = test_results.test_case_id");
+        while (stmt.step()) {
+            completed.insert(std::make_pair(
+                fs::path(stmt.safe_column_text("relative_path")),
+                stmt.safe_column_text("name")));
+        }
+    } catch (const sqlite::error& e) {
+        throw error(F("Error loading completed test cases: %s") % e.what());
+    }
+    return completed;
+}
+
+
+/// Gets the identifiers of all test programs stored in the database.
+///
+/// If the same test program appears more than once, the oldest entry wins.
+///
+/// \return A map of test program relative paths to their identifiers.
+///
+/// \throw error If there is any problem querying the database.
+std::map< fs::path, int64_t >
+store::read_transaction::get_test_program_ids(void)
+{
+    std::map< fs::path, int64_t > ids;
+    try {
+        sqlite::statement stmt = _pimpl->_db.create_statement(
+            "SELECT relative_path, test_program_id FROM test_programs "
+            "ORDER BY test_program_id");
+        while (stmt.step()) {
+            ids.insert(std::make_pair(
+                fs::path(stmt.safe_column_text("relative_path")),
+                stmt.safe_column_int64("test_program_id")));
+        }
+    } catch (const sqlite::error& e) {
+        throw error(F("Error loading test programs: %s") % e.what());
+    }
+    return ids;
+}
@@ -38,6 +38,10 @@ extern "C" {
 #include <stdint.h>
 }
 
+#include <cstddef>
+#include <istream>
+#include <map>
+#include <set>
 #include <string>
 
 #include "model/context_fwd.hpp"
@@ -45,7 +49,9 @@ extern "C" {
 #include "model/test_result_fwd.hpp"
 #include "store/read_backend_fwd.hpp"
 #include "store/read_transaction_fwd.hpp"
-#include "utils/datetime_fwd.hpp"
+#include "utils/datetime.hpp"
+#include "utils/fs/path_fwd.hpp"
+#include "utils/optional_fwd.hpp"
 #include "utils/shared_ptr.hpp"
 
 namespace store {
@@ -60,6 +66,30 @@ model::test_program_ptr get_test_program(read_backend&, const int64_t);
 }  // namespace detail
 
 
+/// Criteria to select a subset of the results in a store.
+struct results_filter {
+    /// Test programs and test cases to select.
+    ///
+    /// Entries with an empty test case name select all test cases of the test
+    /// program, or of all test programs within the directory, named by the
+    /// path.  If this collection is empty, all test cases are selected.
+    test_case_ids_set test_cases;
+
+    /// Types of the results to select.  If empty, all types are selected.
+    std::set< model::test_result_type > types;
+};
+
+
+/// Aggregated information about a set of results.
+struct results_summary {
+    /// Number of results of each type.  Types without results are missing.
+    std::map< model::test_result_type, std::size_t > counts;
+
+    /// Accumulated run time of all the test cases.
+    utils::datetime::delta duration;
+};
+
+
 /// Iterator for the set of test case results that are part of an action.
 ///
 /// \todo Note that this is not a "standard" C++ iterator.  I have chosen to
@@ -82,12 +112,43 @@ public:
     operator bool(void) const;
 
     const model::test_program_ptr test_program(void) const;
+    int64_t test_case_id(void) const;
     std::string test_case_name(void) const;
     model::test_result result(void) const;
     utils::datetime::delta duration(void) const;
 
     std::string stdout_contents(void) const;
     std::string stderr_contents(void) const;
+    std::shared_ptr< std::istream > stdout_stream(void) const;
+    std::shared_ptr< std::istream > stderr_stream(void) const;
+};
+
+
+/// Iterator for the outcomes of the test cases that are part of an action.
+///
+/// Unlike results_iterator, this only exposes the identity, the result type and
+/// the duration of each test case, which can be read without loading any test
+/// program or output.  This is intended to aggregate data across many results
+/// files cheaply.
+class outcomes_iterator {
+    struct impl;
+
+    /// Pointer to the shared internal implementation.
+    std::shared_ptr< impl > _pimpl;
+
+    friend class read_transaction;
+    outcomes_iterator(std::shared_ptr< impl >);
+
+public:
+    ~outcomes_iterator(void);
+
+    outcomes_iterator& operator++(void);
+    operator bool(void) const;
+
+    std::string test_program_path(void) const;
+    std::string test_case_name(void) const;
+    model::test_result_type result_type(void) const;
+    utils::datetime::delta duration(void) const;
 };
 
 
@@ -111,6 +172,16 @@ public:
 
     model::context get_context(void);
     results_iterator get_results(void);
+    results_iterator get_results(const results_filter&);
+    results_summary get_results_summary(const results_filter&);
+    results_iterator get_results_since(const int64_t);
+    results_iterator get_results_of(const std::set< int64_t >&);
+    outcomes_iterator get_outcomes(void);
+    std::set< int64_t > get_unfinished_test_cases(const int64_t,
+                                                  const int64_t);
+
+    test_case_ids_set get_completed_test_cases(void);
+    std::map< utils::fs::path, int64_t > get_test_program_ids(void);
 };
 
 
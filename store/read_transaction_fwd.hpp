@@ -32,11 +32,27 @@
 #if !defined(STORE_READ_TRANSACTION_FWD_HPP)
 #define STORE_READ_TRANSACTION_FWD_HPP
 
+#include <set>
+#include <string>
+#include <utility>
+
+#include "utils/fs/path_fwd.hpp"
+
 namespace store {
 
 
+class outcomes_iterator;
 class read_transaction;
 class results_iterator;
+struct results_filter;
+struct results_summary;
+
+
+/// Collection of test cases identified by their test program and name.
+///
+/// The first component of each pair is the relative path to the test program
+/// and the second component is the name of the test case within it.
+typedef std::set< std::pair< utils::fs::path, std::string > > test_case_ids_set;
 
 
 }  // namespace store
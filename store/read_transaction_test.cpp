@@ -28,8 +28,14 @@
 
 #include "store/read_transaction.hpp"
 
+extern "C" {
+#include <unistd.h>
+}
+
 #include <map>
+#include <set>
 #include <string>
+#include <vector>
 
 #include <atf-c++.hpp>
 
@@ -42,11 +48,16 @@
 #include "store/write_backend.hpp"
 #include "store/write_transaction.hpp"
 #include "utils/datetime.hpp"
+#include "utils/format/containers.ipp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/operations.hpp"
 #include "utils/fs/path.hpp"
 #include "utils/logging/operations.hpp"
 #include "utils/optional.ipp"
 #include "utils/sqlite/database.hpp"
 #include "utils/sqlite/statement.ipp"
+#include "utils/stream.hpp"
+#include "utils/units.hpp"
 
 namespace datetime = utils::datetime;
 namespace fs = utils::fs;
@@ -249,6 +260,523 @@ ATF_TEST_CASE_BODY(get_results__many)
 }
 
 
+ATF_TEST_CASE(get_results__streams);
+ATF_TEST_CASE_HEAD(get_results__streams)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(get_results__streams)
+{
+    store::write_backend backend = store::write_backend::open_rw(
+        fs::path("test.db"));
+
+    store::write_transaction tx = backend.start_write();
+
+    const model::context context(fs::path("/foo/bar"),
+                                 std::map< std::string, std::string >());
+    tx.put_context(context);
+
+    const datetime::timestamp start_time = datetime::timestamp::from_values(
+        2012, 01, 30, 22, 10, 00, 0);
+    const datetime::timestamp end_time = datetime::timestamp::from_values(
+        2012, 01, 30, 22, 15, 30, 1234);
+
+    // Make the output span multiple chunks of the underlying reader.
+    std::string long_stdout;
+    for (int i = 0; i < 20000; ++i)
+        long_stdout += F("Line %s of the stdout\n") % i;
+
+    const model::test_program test_program = model::test_program_builder(
+        "plain", fs::path("a/prog1"), fs::path("/the/root"), "suite1")
+        .add_test_case("main")
+        .build();
+    const model::test_result result(model::test_result_passed);
+    {
+        const int64_t tp_id = tx.put_test_program(test_program);
+        const int64_t tc_id = tx.put_test_case(test_program, "main", tp_id);
+        atf::utils::create_file("prog1.out", long_stdout);
+        tx.put_test_case_file("__STDOUT__", fs::path("prog1.out"), tc_id);
+        atf::utils::create_file("prog1.err", "");
+        tx.put_test_case_file("__STDERR__", fs::path("prog1.err"), tc_id);
+        tx.put_result(result, tc_id, start_time, end_time);
+    }
+
+    tx.commit();
+    backend.close();
+
+    store::read_backend backend2 = store::read_backend::open_ro(
+        fs::path("test.db"));
+    store::read_transaction tx2 = backend2.start_read();
+    store::results_iterator iter = tx2.get_results();
+    ATF_REQUIRE(iter);
+    {
+        const std::shared_ptr< std::istream > stdout_stream =
+            iter.stdout_stream();
+        ATF_REQUIRE(long_stdout == utils::read_stream(*stdout_stream));
+        const std::shared_ptr< std::istream > stderr_stream =
+            iter.stderr_stream();
+        ATF_REQUIRE_EQ(std::istream::traits_type::eof(),
+                       stderr_stream->peek());
+    }
+    ATF_REQUIRE(!++iter);
+}
+
+
+ATF_TEST_CASE(get_results__streams__truncated_file);
+ATF_TEST_CASE_HEAD(get_results__streams__truncated_file)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(get_results__streams__truncated_file)
+{
+    store::write_backend backend = store::write_backend::open_rw(
+        fs::path("test.db"));
+
+    store::write_transaction tx = backend.start_write();
+    tx.put_context(model::context(fs::path("/foo/bar"),
+                                  std::map< std::string, std::string >()));
+
+    // Make the output span multiple chunks of the underlying reader so that
+    // most of it is read after the database is damaged.
+    std::string long_stdout;
+    for (int i = 0; i < 20000; ++i)
+        long_stdout += F("Line %s of the stdout\n") % i;
+
+    const model::test_program test_program = model::test_program_builder(
+        "plain", fs::path("a/prog1"), fs::path("/the/root"), "suite1")
+        .add_test_case("main")
+        .build();
+    {
+        const int64_t tp_id = tx.put_test_program(test_program);
+        const int64_t tc_id = tx.put_test_case(test_program, "main", tp_id);
+        atf::utils::create_file("prog1.out", long_stdout);
+        tx.put_test_case_file("__STDOUT__", fs::path("prog1.out"), tc_id);
+        tx.put_result(model::test_result(model::test_result_passed), tc_id,
+                      datetime::timestamp::from_microseconds(1000000),
+                      datetime::timestamp::from_microseconds(2000000));
+    }
+
+    tx.commit();
+    backend.close();
+
+    store::read_backend backend2 = store::read_backend::open_ro(
+        fs::path("test.db"));
+    store::read_transaction tx2 = backend2.start_read();
+    store::results_iterator iter = tx2.get_results();
+    ATF_REQUIRE(iter);
+    {
+        const std::shared_ptr< std::istream > stdout_stream =
+            iter.stdout_stream();
+        ATF_REQUIRE_EQ('L', stdout_stream->peek());
+
+        const uint64_t size = fs::file_size(fs::path("test.db"));
+        ATF_REQUIRE(::truncate("test.db", size / 2) != -1);
+
+        ATF_REQUIRE_THROW(store::integrity_error,
+                          utils::read_stream(*stdout_stream));
+    }
+}
+
+
+ATF_TEST_CASE(get_results__many_programs_with_metadata);
+ATF_TEST_CASE_HEAD(get_results__many_programs_with_metadata)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(get_results__many_programs_with_metadata)
+{
+    store::write_backend backend = store::write_backend::open_rw(
+        fs::path("test.db"));
+
+    store::write_transaction tx = backend.start_write();
+
+    const datetime::timestamp start_time = datetime::timestamp::from_values(
+        2012, 01, 30, 22, 10, 00, 0);
+    const datetime::timestamp end_time = datetime::timestamp::from_values(
+        2012, 01, 30, 22, 15, 30, 1234);
+    const model::test_result result(model::test_result_passed);
+
+    const model::test_program test_program_1 = model::test_program_builder(
+        "atf", fs::path("c/prog"), fs::path("/the/root"), "suite1")
+        .add_test_case("first", model::metadata_builder()
+                       .set_description("The first test").build())
+        .add_test_case("second", model::metadata_builder()
+                       .add_required_config("var").build())
+        .add_test_case("third", model::metadata_builder()
+                       .set_description("The first test").build())
+        .set_metadata(model::metadata_builder()
+                      .add_custom("X-program", "yes").build())
+        .build();
+    const model::test_program test_program_2 = model::test_program_builder(
+        "plain", fs::path("b/prog"), fs::path("/the/root"), "suite1")
+        .add_test_case("main")
+        .build();
+    const model::test_program test_program_3 = model::test_program_builder(
+        "atf", fs::path("a/prog"), fs::path("/the/root"), "suite1")
+        .add_test_case("main", model::metadata_builder()
+                       .set_description("The third test").build())
+        .build();
+
+    {
+        const int64_t tp_id = tx.put_test_program(test_program_1);
+        const int64_t tc1_id = tx.put_test_case(test_program_1, "first", tp_id);
+        const int64_t tc2_id = tx.put_test_case(test_program_1, "second",
+                                                tp_id);
+        // Test case sharing its metadata with the first one and without
+        // results, which must still be part of the loaded test program.
+        (void)tx.put_test_case(test_program_1, "third", tp_id);
+        tx.put_result(result, tc1_id, start_time, end_time);
+        tx.put_result(result, tc2_id, start_time, end_time);
+    }
+    {
+        // Test program without results, which the scan must skip over.
+        const int64_t tp_id = tx.put_test_program(test_program_2);
+        (void)tx.put_test_case(test_program_2, "main", tp_id);
+    }
+    {
+        const int64_t tp_id = tx.put_test_program(test_program_3);
+        const int64_t tc_id = tx.put_test_case(test_program_3, "main", tp_id);
+        tx.put_result(result, tc_id, start_time, end_time);
+    }
+
+    tx.commit();
+    backend.close();
+
+    store::read_backend backend2 = store::read_backend::open_ro(
+        fs::path("test.db"));
+    store::read_transaction tx2 = backend2.start_read();
+    store::results_iterator iter = tx2.get_results();
+    ATF_REQUIRE(iter);
+    ATF_REQUIRE_EQ(test_program_3, *iter.test_program());
+    ATF_REQUIRE_EQ("main", iter.test_case_name());
+    ATF_REQUIRE(++iter);
+    ATF_REQUIRE_EQ(test_program_1, *iter.test_program());
+    ATF_REQUIRE_EQ("first", iter.test_case_name());
+    ATF_REQUIRE(++iter);
+    ATF_REQUIRE_EQ(test_program_1, *iter.test_program());
+    ATF_REQUIRE_EQ("second", iter.test_case_name());
+    ATF_REQUIRE(!++iter);
+}
+
+
+/// Populates a database with results to validate the results filters.
+///
+/// \param db_name The database to create.
+static void
+populate_for_filters(const char* db_name)
+{
+    store::write_backend backend = store::write_backend::open_rw(
+        fs::path(db_name));
+
+    store::write_transaction tx = backend.start_write();
+
+    const datetime::timestamp start_time = datetime::timestamp::from_values(
+        2012, 01, 30, 22, 10, 00, 0);
+
+    const char* paths[] = { "dir/prog", "dir/sub/prog", "dir0/prog",
+                            "dirx/prog", NULL };
+    for (const char** path = paths; *path != NULL; ++path) {
+        const model::test_program test_program = model::test_program_builder(
+            "atf", fs::path(*path), fs::path("/the/root"), "suite")
+            .add_test_case("pass")
+            .add_test_case("fail")
+            .build();
+        const int64_t tp_id = tx.put_test_program(test_program);
+        const int64_t tc1_id = tx.put_test_case(test_program, "pass", tp_id);
+        tx.put_result(model::test_result(model::test_result_passed), tc1_id,
+                      start_time, start_time + datetime::delta(1, 0));
+        const int64_t tc2_id = tx.put_test_case(test_program, "fail", tp_id);
+        tx.put_result(model::test_result(model::test_result_failed, "Oops"),
+                      tc2_id, start_time, start_time + datetime::delta(2, 0));
+    }
+
+    tx.commit();
+    backend.close();
+}
+
+
+/// Collects the identifiers of the results returned by an iterator.
+///
+/// \param iter The iterator to scan.
+///
+/// \return The collection of program:test_case pairs returned.
+static std::set< std::string >
+collect_results(store::results_iterator iter)
+{
+    std::set< std::string > ids;
+    for (; iter; ++iter)
+        ids.insert(iter.test_program()->relative_path().str() + ":" +
+                   iter.test_case_name());
+    return ids;
+}
+
+
+ATF_TEST_CASE(get_results__filter);
+ATF_TEST_CASE_HEAD(get_results__filter)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(get_results__filter)
+{
+    populate_for_filters("test.db");
+
+    store::read_backend backend = store::read_backend::open_ro(
+        fs::path("test.db"));
+    store::read_transaction tx = backend.start_read();
+
+    {
+        store::results_filter filter;
+        filter.test_cases.insert(std::make_pair(fs::path("dir"), ""));
+        std::set< std::string > exp_ids;
+        exp_ids.insert("dir/prog:fail");
+        exp_ids.insert("dir/prog:pass");
+        exp_ids.insert("dir/sub/prog:fail");
+        exp_ids.insert("dir/sub/prog:pass");
+        ATF_REQUIRE(exp_ids == collect_results(tx.get_results(filter)));
+    }
+
+    {
+        store::results_filter filter;
+        filter.test_cases.insert(std::make_pair(fs::path("dir0/prog"), ""));
+        filter.test_cases.insert(std::make_pair(fs::path("dirx/prog"),
+                                                "pass"));
+        filter.test_cases.insert(std::make_pair(fs::path("dirx"), "fail"));
+        std::set< std::string > exp_ids;
+        exp_ids.insert("dir0/prog:fail");
+        exp_ids.insert("dir0/prog:pass");
+        exp_ids.insert("dirx/prog:pass");
+        ATF_REQUIRE(exp_ids == collect_results(tx.get_results(filter)));
+    }
+
+    {
+        store::results_filter filter;
+        filter.test_cases.insert(std::make_pair(fs::path("dir/sub"), ""));
+        filter.types.insert(model::test_result_failed);
+        std::set< std::string > exp_ids;
+        exp_ids.insert("dir/sub/prog:fail");
+        ATF_REQUIRE(exp_ids == collect_results(tx.get_results(filter)));
+    }
+
+    {
+        store::results_filter filter;
+        filter.types.insert(model::test_result_passed);
+        filter.types.insert(model::test_result_skipped);
+        std::set< std::string > exp_ids;
+        exp_ids.insert("dir/prog:pass");
+        exp_ids.insert("dir/sub/prog:pass");
+        exp_ids.insert("dir0/prog:pass");
+        exp_ids.insert("dirx/prog:pass");
+        ATF_REQUIRE(exp_ids == collect_results(tx.get_results(filter)));
+    }
+}
+
+
+ATF_TEST_CASE(get_results_summary);
+ATF_TEST_CASE_HEAD(get_results_summary)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(get_results_summary)
+{
+    populate_for_filters("test.db");
+
+    store::read_backend backend = store::read_backend::open_ro(
+        fs::path("test.db"));
+    store::read_transaction tx = backend.start_read();
+
+    {
+        const store::results_summary summary = tx.get_results_summary(
+            store::results_filter());
+        ATF_REQUIRE_EQ(2, summary.counts.size());
+        ATF_REQUIRE_EQ(4, summary.counts.find(model::test_result_passed)
+                       ->second);
+        ATF_REQUIRE_EQ(4, summary.counts.find(model::test_result_failed)
+                       ->second);
+        ATF_REQUIRE_EQ(datetime::delta(12, 0), summary.duration);
+    }
+
+    {
+        store::results_filter filter;
+        filter.test_cases.insert(std::make_pair(fs::path("dir"), ""));
+        filter.types.insert(model::test_result_failed);
+        const store::results_summary summary = tx.get_results_summary(filter);
+        ATF_REQUIRE_EQ(1, summary.counts.size());
+        ATF_REQUIRE_EQ(2, summary.counts.find(model::test_result_failed)
+                       ->second);
+        ATF_REQUIRE_EQ(datetime::delta(4, 0), summary.duration);
+    }
+
+    {
+        store::results_filter filter;
+        filter.test_cases.insert(std::make_pair(fs::path("none"), ""));
+        const store::results_summary summary = tx.get_results_summary(filter);
+        ATF_REQUIRE(summary.counts.empty());
+        ATF_REQUIRE_EQ(datetime::delta(), summary.duration);
+    }
+}
+
+
+ATF_TEST_CASE(get_outcomes);
+ATF_TEST_CASE_HEAD(get_outcomes)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(get_outcomes)
+{
+    populate_for_filters("test.db");
+
+    store::read_backend backend = store::read_backend::open_ro(
+        fs::path("test.db"));
+    store::read_transaction tx = backend.start_read();
+
+    std::vector< std::string > outcomes;
+    for (store::outcomes_iterator iter = tx.get_outcomes(); iter; ++iter) {
+        outcomes.push_back(F("%s:%s:%s:%s") % iter.test_program_path() %
+                           iter.test_case_name() %
+                           (iter.result_type() == model::test_result_passed ?
+                            "passed" : "failed") %
+                           iter.duration().seconds);
+    }
+
+    std::vector< std::string > exp_outcomes;
+    const char* paths[] = { "dir/prog", "dir/sub/prog", "dir0/prog",
+                            "dirx/prog", NULL };
+    for (const char** path = paths; *path != NULL; ++path) {
+        exp_outcomes.push_back(F("%s:fail:failed:2") % *path);
+        exp_outcomes.push_back(F("%s:pass:passed:1") % *path);
+    }
+    ATF_REQUIRE_EQ(exp_outcomes, outcomes);
+}
+
+
+ATF_TEST_CASE(get_completed_test_cases);
+ATF_TEST_CASE_HEAD(get_completed_test_cases)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(get_completed_test_cases)
+{
+    store::write_backend backend = store::write_backend::open_rw(
+        fs::path("test.db"));
+
+    store::write_transaction tx = backend.start_write();
+
+    const datetime::timestamp start_time = datetime::timestamp::from_values(
+        2012, 01, 30, 22, 10, 00, 0);
+    const datetime::timestamp end_time = datetime::timestamp::from_values(
+        2012, 01, 30, 22, 15, 30, 1234);
+
+    const model::test_program test_program = model::test_program_builder(
+        "atf", fs::path("a/prog1"), fs::path("/the/root"), "suite1")
+        .add_test_case("done")
+        .add_test_case("pending")
+        .build();
+    const int64_t tp_id = tx.put_test_program(test_program);
+    const int64_t tc_id = tx.put_test_case(test_program, "done", tp_id);
+    tx.put_result(model::test_result(model::test_result_passed), tc_id,
+                  start_time, end_time);
+    (void)tx.put_test_case(test_program, "pending", tp_id);
+
+    tx.commit();
+    backend.close();
+
+    store::read_backend backend2 = store::read_backend::open_ro(
+        fs::path("test.db"));
+    store::read_transaction tx2 = backend2.start_read();
+
+    store::test_case_ids_set exp_completed;
+    exp_completed.insert(std::make_pair(fs::path("a/prog1"), "done"));
+    ATF_REQUIRE(exp_completed == tx2.get_completed_test_cases());
+
+    std::map< fs::path, int64_t > exp_ids;
+    exp_ids.insert(std::make_pair(fs::path("a/prog1"), tp_id));
+    ATF_REQUIRE(exp_ids == tx2.get_test_program_ids());
+}
+
+
+ATF_TEST_CASE(get_results_since);
+ATF_TEST_CASE_HEAD(get_results_since)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(get_results_since)
+{
+    store::write_backend backend = store::write_backend::open_rw(
+        fs::path("test.db"));
+
+    store::write_transaction tx = backend.start_write();
+
+    const datetime::timestamp start_time = datetime::timestamp::from_values(
+        2012, 01, 30, 22, 10, 00, 0);
+    const datetime::timestamp end_time = datetime::timestamp::from_values(
+        2012, 01, 30, 22, 15, 30, 1234);
+    const model::test_result result(model::test_result_passed);
+
+    const model::test_program test_program = model::test_program_builder(
+        "atf", fs::path("a/prog1"), fs::path("/the/root"), "suite1")
+        .add_test_case("first")
+        .add_test_case("second")
+        .add_test_case("third")
+        .build();
+    const int64_t tp_id = tx.put_test_program(test_program);
+    const int64_t tc1_id = tx.put_test_case(test_program, "first", tp_id);
+    const int64_t tc2_id = tx.put_test_case(test_program, "second", tp_id);
+    const int64_t tc3_id = tx.put_test_case(test_program, "third", tp_id);
+    tx.put_result(result, tc3_id, start_time, end_time);
+    tx.put_result(result, tc1_id, start_time, end_time);
+
+    tx.commit();
+    backend.close();
+
+    store::read_backend backend2 = store::read_backend::open_ro(
+        fs::path("test.db"));
+    store::read_transaction tx2 = backend2.start_read();
+
+    {
+        store::results_iterator iter = tx2.get_results_since(0);
+        ATF_REQUIRE(iter);
+        ATF_REQUIRE_EQ(tc1_id, iter.test_case_id());
+        ATF_REQUIRE_EQ("first", iter.test_case_name());
+        ATF_REQUIRE(++iter);
+        ATF_REQUIRE_EQ(tc3_id, iter.test_case_id());
+        ATF_REQUIRE_EQ("third", iter.test_case_name());
+        ATF_REQUIRE(!++iter);
+    }
+    {
+        store::results_iterator iter = tx2.get_results_since(tc2_id);
+        ATF_REQUIRE(iter);
+        ATF_REQUIRE_EQ(tc3_id, iter.test_case_id());
+        ATF_REQUIRE(!++iter);
+    }
+
+    {
+        std::set< int64_t > ids;
+        ids.insert(tc2_id);
+        ids.insert(tc3_id);
+        store::results_iterator iter = tx2.get_results_of(ids);
+        ATF_REQUIRE(iter);
+        ATF_REQUIRE_EQ(tc3_id, iter.test_case_id());
+        ATF_REQUIRE(!++iter);
+    }
+
+    std::set< int64_t > exp_unfinished;
+    exp_unfinished.insert(tc2_id);
+    ATF_REQUIRE(exp_unfinished == tx2.get_unfinished_test_cases(tc1_id,
+                                                                tc3_id));
+    ATF_REQUIRE(exp_unfinished == tx2.get_unfinished_test_cases(tc2_id,
+                                                                tc2_id));
+    ATF_REQUIRE(tx2.get_unfinished_test_cases(tc3_id, tc3_id).empty());
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, get_context__missing);
@@ -257,4 +785,13 @@ ATF_INIT_TEST_CASES(tcs)
 
     ATF_ADD_TEST_CASE(tcs, get_results__none);
     ATF_ADD_TEST_CASE(tcs, get_results__many);
+    ATF_ADD_TEST_CASE(tcs, get_results__streams);
+    ATF_ADD_TEST_CASE(tcs, get_results__streams__truncated_file);
+    ATF_ADD_TEST_CASE(tcs, get_results__many_programs_with_metadata);
+    ATF_ADD_TEST_CASE(tcs, get_results__filter);
+    ATF_ADD_TEST_CASE(tcs, get_results_summary);
+    ATF_ADD_TEST_CASE(tcs, get_outcomes);
+
+    ATF_ADD_TEST_CASE(tcs, get_completed_test_cases);
+    ATF_ADD_TEST_CASE(tcs, get_results_since);
 }
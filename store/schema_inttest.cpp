@@ -402,7 +402,7 @@ check_action_4(const fs::path& dbpath)
         logging::set_inmemory(); \
         const std::string required_files = \
             store::detail::schema_file().str() + " " + \
-            testdata_file("testdata_v3_" #dataset ".sql").str(); \
+            testdata_file("testdata_v4_" #dataset ".sql").str(); \
         set_md_var("require.files", required_files); \
     } \
     ATF_TEST_CASE_BODY(current_schema_ ##dataset) \
@@ -413,7 +413,7 @@ check_action_4(const fs::path& dbpath)
             testpath, sqlite::open_readwrite | sqlite::open_create); \
         db.exec(utils::read_file(store::detail::schema_file())); \
         db.exec(utils::read_file(testdata_file(\
-            "testdata_v3_" #dataset ".sql"))); \
+            "testdata_v4_" #dataset ".sql"))); \
         db.close(); \
         \
         check_action_ ## dataset (testpath); \
@@ -424,6 +424,52 @@ CURRENT_SCHEMA_TEST(3);
 CURRENT_SCHEMA_TEST(4);
 
 
+/// Gets the path to the installed schema file of the first chunked version.
+///
+/// \return The path to schema_v3.sql, which lives next to the migrations.
+static fs::path
+chunked_schema_file(void)
+{
+    return store::detail::migration_file(3, 4).branch_path() / "schema_v3.sql";
+}
+
+
+#define MIGRATE_RESULTS_FILE_TEST(dataset) \
+    ATF_TEST_CASE(migrate_schema__from_v3_ ##dataset); \
+    ATF_TEST_CASE_HEAD(migrate_schema__from_v3_ ##dataset) \
+    { \
+        logging::set_inmemory(); \
+        \
+        std::string required_files = \
+            chunked_schema_file().str() + " " + \
+            testdata_file("testdata_v3_" #dataset ".sql").str(); \
+        for (int i = 3; i < store::detail::current_schema_version; ++i) \
+            required_files += " " + store::detail::migration_file( \
+                i, i + 1).str(); \
+        \
+        set_md_var("require.files", required_files); \
+    } \
+    ATF_TEST_CASE_BODY(migrate_schema__from_v3_ ##dataset) \
+    { \
+        const fs::path testpath("test.db"); \
+        \
+        sqlite::database db = sqlite::database::open( \
+            testpath, sqlite::open_readwrite | sqlite::open_create); \
+        db.exec(utils::read_file(chunked_schema_file())); \
+        db.exec(utils::read_file(testdata_file(\
+            "testdata_v3_" #dataset ".sql"))); \
+        db.close(); \
+        \
+        store::migrate_schema(testpath); \
+        \
+        check_action_ ## dataset (testpath); \
+    }
+MIGRATE_RESULTS_FILE_TEST(1);
+MIGRATE_RESULTS_FILE_TEST(2);
+MIGRATE_RESULTS_FILE_TEST(3);
+MIGRATE_RESULTS_FILE_TEST(4);
+
+
 #define MIGRATE_SCHEMA_TEST(from_version) \
     ATF_TEST_CASE(migrate_schema__from_v ##from_version); \
     ATF_TEST_CASE_HEAD(migrate_schema__from_v ##from_version) \
@@ -434,7 +480,8 @@ CURRENT_SCHEMA_TEST(4);
         const char* testdata = "testdata_v" #from_version ".sql"; \
         \
         std::string required_files = \
-            testdata_file(schema).str() + " " + testdata_file(testdata).str(); \
+            testdata_file(schema).str() + " " + testdata_file(testdata).str() \
+            + " " + chunked_schema_file().str(); \
         for (int i = from_version; i < store::detail::current_schema_version; \
              ++i) \
             required_files += " " + store::detail::migration_file( \
@@ -475,6 +522,11 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, current_schema_3);
     ATF_ADD_TEST_CASE(tcs, current_schema_4);
 
+    ATF_ADD_TEST_CASE(tcs, migrate_schema__from_v3_1);
+    ATF_ADD_TEST_CASE(tcs, migrate_schema__from_v3_2);
+    ATF_ADD_TEST_CASE(tcs, migrate_schema__from_v3_3);
+    ATF_ADD_TEST_CASE(tcs, migrate_schema__from_v3_4);
+
     ATF_ADD_TEST_CASE(tcs, migrate_schema__from_v1);
     ATF_ADD_TEST_CASE(tcs, migrate_schema__from_v2);
 }
@@ -28,17 +28,30 @@
 
 #include "store/write_backend.hpp"
 
+extern "C" {
+#include <sys/file.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+#include <cerrno>
+#include <cstring>
 #include <stdexcept>
 
+#include "store/catalog.hpp"
 #include "store/exceptions.hpp"
+#include "store/layout.hpp"
 #include "store/metadata.hpp"
 #include "store/read_backend.hpp"
+#include "store/read_transaction.hpp"
 #include "store/write_transaction.hpp"
 #include "utils/env.hpp"
 #include "utils/format/macros.hpp"
 #include "utils/fs/path.hpp"
 #include "utils/logging/macros.hpp"
 #include "utils/noncopyable.hpp"
+#include "utils/optional.ipp"
 #include "utils/sanity.hpp"
 #include "utils/stream.hpp"
 #include "utils/sqlite/database.hpp"
@@ -48,6 +61,9 @@
 namespace fs = utils::fs;
 namespace sqlite = utils::sqlite;
 
+using utils::none;
+using utils::optional;
+
 
 /// The current schema version.
 ///
@@ -60,12 +76,23 @@ namespace sqlite = utils::sqlite;
 ///
 /// This variable is not const to allow tests to modify it.  No other code
 /// should change its value.
-int store::detail::current_schema_version = 3;
+int store::detail::current_schema_version = 4;
 
 
 namespace {
 
 
+/// Number of attempts to take the lock of a database before giving up.
+///
+/// Readers briefly hold a shared lock to check if a database is live, so the
+/// lock may be unavailable for a short while even if there is no writer.
+static const int live_lock_attempts = 100;
+
+
+/// Delay between attempts to take the lock of a database, in microseconds.
+static const useconds_t live_lock_retry_usec = 10000;
+
+
 /// Checks if a database is empty (i.e. if it is new).
 ///
 /// \param db The database to check.
@@ -79,6 +106,114 @@ empty_database(sqlite::database& db)
 }
 
 
+/// Takes the lock that marks a database as being written to.
+///
+/// The lock is held on a separate file, and not on the database itself,
+/// because closing any descriptor of a file releases all the POSIX locks that
+/// the process holds on it, including those taken by SQLite.  See
+/// read_backend::is_live() for the reader side.
+///
+/// \param file The database file.
+///
+/// \return The descriptor of the lock file, which holds the lock until closed.
+///
+/// \throw store::error If the lock cannot be taken, including when another
+///     process is already writing to the database.  As readers can hold the
+///     lock for a short while, it is only deemed taken by a writer if it stays
+///     unavailable for about a second.
+static int
+lock_live(const fs::path& file)
+{
+    const fs::path lock_file = store::detail::live_lock_file(file);
+
+    const int fd = ::open(lock_file.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (fd == -1) {
+        const int original_errno = errno;
+        throw store::error(F("Cannot create %s: %s") % lock_file %
+                           std::strerror(original_errno));
+    }
+
+    // Test programs are spawned by the process that writes to the database,
+    // and they must not keep the lock alive if they outlive it.
+    if (::fcntl(fd, F_SETFD, FD_CLOEXEC) == -1) {
+        const int original_errno = errno;
+        ::close(fd);
+        throw store::error(F("Cannot lock %s: %s") % lock_file %
+                           std::strerror(original_errno));
+    }
+
+    for (int attempt = 1; ; ++attempt) {
+        if (::flock(fd, LOCK_EX | LOCK_NB) != -1)
+            return fd;
+
+        const int original_errno = errno;
+        if (original_errno == EWOULDBLOCK && attempt < live_lock_attempts) {
+            ::usleep(live_lock_retry_usec);
+            continue;
+        }
+        ::close(fd);
+        if (original_errno == EWOULDBLOCK)
+            throw store::error(F("%s is being written to by another "
+                                 "process") % file);
+        throw store::error(F("Cannot lock %s: %s") % lock_file %
+                           std::strerror(original_errno));
+    }
+}
+
+
+/// Switches a database to the journal mode used while a run is in progress.
+///
+/// Write-ahead logging allows readers to look at the results committed so far
+/// while the run continues without blocking it, and makes intermediate commits
+/// cheap.
+///
+/// \param db The database to set up.
+///
+/// \throw store::error If the journal mode cannot be changed.
+static void
+enable_live_journal(sqlite::database& db)
+{
+    try {
+        db.exec("PRAGMA journal_mode = WAL");
+        db.exec("PRAGMA synchronous = NORMAL");
+    } catch (const sqlite::error& e) {
+        throw store::error(F("Cannot set up journal: %s") % e.what());
+    }
+}
+
+
+/// Records a results file in the catalog of the store directory.
+///
+/// This is best-effort: the catalog can be reconstructed from the store
+/// directory, so failing to update it is not fatal.
+///
+/// \param file The results file.  Nothing is done if the file does not live
+///     in the store directory.
+/// \param finished Whether the run has finished and thus the summary of its
+///     results should be recorded.
+static void
+update_catalog(const fs::path& file, const bool finished)
+{
+    const fs::path store_dir = store::layout::query_store_dir();
+    if (file.branch_path() != store_dir)
+        return;
+
+    try {
+        store::catalog catalog = store::catalog::open(store_dir);
+        if (finished) {
+            store::read_backend backend = store::read_backend::open_ro(file);
+            catalog.put_summary(file, backend.start_read().get_results_summary(
+                store::results_filter()));
+            backend.close();
+        } else {
+            catalog.add(file);
+        }
+    } catch (const store::error& e) {
+        LW(F("Failed to update the catalog with %s: %s") % file % e.what());
+    }
+}
+
+
 }  // anonymous namespace
 
 
@@ -135,11 +270,89 @@ struct store::write_backend::impl : utils::noncopyable {
     /// The SQLite database this backend talks to.
     sqlite::database database;
 
+    /// Whether the database has already been closed or not.
+    bool closed;
+
+    /// Path to the database file.
+    fs::path file;
+
+    /// Descriptor of the lock file that marks the database as being written.
+    int lock_fd;
+
     /// Constructor.
     ///
     /// \param database_ The SQLite database instance.
-    impl(sqlite::database& database_) : database(database_)
+    /// \param file_ Path to the database file.
+    /// \param lock_fd_ Descriptor of the lock file, as returned by
+    ///     lock_live().  Ownership is transferred to this object.
+    impl(sqlite::database& database_, const fs::path& file_,
+         const int lock_fd_) :
+        database(database_), closed(false), file(file_), lock_fd(lock_fd_)
+    {
+    }
+
+    /// Destructor.
+    ~impl(void)
+    {
+        if (!closed) {
+            restore_journal();
+            unlock_live();
+        }
+    }
+
+    /// Releases the lock that marks the database as being written to.
+    void
+    unlock_live(void)
     {
+        PRE(lock_fd != -1);
+        // Remove the file before releasing the lock so that readers never see
+        // an unlocked lock file for a database that is still open.  A stale
+        // lock file left behind by a crash is harmless.
+        (void)::unlink(store::detail::live_lock_file(file).c_str());
+        ::close(lock_fd);
+        lock_fd = -1;
+    }
+
+    /// Restores the default journal mode.
+    ///
+    /// Leaving write-ahead logging mode requires that no other connections to
+    /// the database exist, so we retry a few times in case a reader is briefly
+    /// looking at the database.  This is best-effort: if we fail, the database
+    /// remains in write-ahead logging mode, which is still a valid state.
+    void
+    restore_journal(void)
+    {
+        for (int attempt = 1; ; ++attempt) {
+            std::string error;
+            try {
+                sqlite::statement stmt = database.create_statement(
+                    "PRAGMA journal_mode = DELETE");
+                if (stmt.step() && stmt.column_text(0) == "delete")
+                    return;
+                error = "journal mode unchanged";
+            } catch (const sqlite::error& e) {
+                error = e.what();
+            }
+            if (attempt == 50) {
+                LW(F("Failed to restore journal mode: %s") % error);
+                return;
+            }
+            ::usleep(100000);
+        }
+    }
+
+    /// Closes the database.
+    ///
+    /// This marks the end of a run, so the results file is recorded as
+    /// finished in the catalog if it lives in the store directory.
+    void
+    close(void)
+    {
+        restore_journal();
+        database.close();
+        unlock_live();
+        closed = true;
+        update_catalog(file, true);
     }
 };
 
@@ -175,8 +388,47 @@ store::write_backend::open_rw(const fs::path& file)
     if (!empty_database(db))
         throw error(F("%s already exists and is not empty; cannot open "
                       "for write") % file);
-    detail::initialize(db);
-    return write_backend(new impl(db));
+    const int lock_fd = lock_live(file);
+    try {
+        detail::initialize(db);
+        enable_live_journal(db);
+    } catch (...) {
+        ::close(lock_fd);
+        throw;
+    }
+    update_catalog(file, false);
+    return write_backend(new impl(db, file, lock_fd));
+}
+
+
+/// Opens an existing database in read-write mode to add more data to it.
+///
+/// This is used to resume a previous run that did not complete, in which case
+/// we want to append new results to the file instead of creating a new one.
+///
+/// \param file The database file to be opened.  Must exist.
+///
+/// \return The backend representation.
+///
+/// \throw store::error If there is any problem opening the database, if the
+///     database is empty or if its schema does not match the one we
+///     implement.
+store::write_backend
+store::write_backend::open_append(const fs::path& file)
+{
+    sqlite::database db = detail::open_and_setup(file, sqlite::open_readwrite);
+    if (empty_database(db))
+        throw error(F("%s is empty; cannot append to it") % file);
+    detail::check_schema_version(metadata::fetch_latest(db));
+    const int lock_fd = lock_live(file);
+    try {
+        enable_live_journal(db);
+    } catch (...) {
+        ::close(lock_fd);
+        throw;
+    }
+    update_catalog(file, false);
+    return write_backend(new impl(db, file, lock_fd));
 }
 
 
@@ -184,7 +436,7 @@ store::write_backend::open_rw(const fs::path& file)
 void
 store::write_backend::close(void)
 {
-    _pimpl->database.close();
+    _pimpl->close();
 }
 
 
@@ -68,6 +68,7 @@ public:
     ~write_backend(void);
 
     static write_backend open_rw(const utils::fs::path&);
+    static write_backend open_append(const utils::fs::path&);
     void close(void);
 
     utils::sqlite::database& database(void);
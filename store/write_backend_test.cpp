@@ -28,14 +28,32 @@
 
 #include "store/write_backend.hpp"
 
+extern "C" {
+#include <sys/file.h>
+#include <sys/wait.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+#include <cstdlib>
+
 #include <atf-c++.hpp>
 
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "store/catalog.hpp"
 #include "store/exceptions.hpp"
+#include "store/layout.hpp"
 #include "store/metadata.hpp"
+#include "store/read_backend.hpp"
+#include "store/write_transaction.hpp"
 #include "utils/datetime.hpp"
 #include "utils/env.hpp"
+#include "utils/fs/operations.hpp"
 #include "utils/fs/path.hpp"
 #include "utils/logging/operations.hpp"
+#include "utils/optional.ipp"
 #include "utils/sqlite/database.hpp"
 #include "utils/sqlite/exceptions.hpp"
 #include "utils/sqlite/statement.ipp"
@@ -106,7 +124,7 @@ ATF_TEST_CASE_WITHOUT_HEAD(detail__schema_file__builtin);
 ATF_TEST_CASE_BODY(detail__schema_file__builtin)
 {
     utils::unsetenv("KYUA_STOREDIR");
-    ATF_REQUIRE_EQ(fs::path(KYUA_STOREDIR) / "schema_v3.sql",
+    ATF_REQUIRE_EQ(fs::path(KYUA_STOREDIR) / "schema_v4.sql",
                    store::detail::schema_file());
 }
 
@@ -171,6 +189,116 @@ ATF_TEST_CASE_BODY(write_backend__open_rw__create_missing)
 }
 
 
+ATF_TEST_CASE(write_backend__open_append__ok);
+ATF_TEST_CASE_HEAD(write_backend__open_append__ok)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(write_backend__open_append__ok)
+{
+    {
+        store::write_backend backend = store::write_backend::open_rw(
+            fs::path("test.db"));
+        backend.database().exec("INSERT INTO contexts (cwd) "
+                                "VALUES ('/foo/bar')");
+    }
+    store::write_backend backend = store::write_backend::open_append(
+        fs::path("test.db"));
+    sqlite::statement stmt = backend.database().create_statement(
+        "SELECT cwd FROM contexts");
+    ATF_REQUIRE(stmt.step());
+    ATF_REQUIRE_EQ("/foo/bar", stmt.column_text(0));
+    ATF_REQUIRE(!stmt.step());
+}
+
+
+ATF_TEST_CASE(write_backend__open_append__error_if_empty);
+ATF_TEST_CASE_HEAD(write_backend__open_append__error_if_empty)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(write_backend__open_append__error_if_empty)
+{
+    {
+        sqlite::database db = sqlite::database::open(
+            fs::path("test.db"), sqlite::open_readwrite | sqlite::open_create);
+    }
+    ATF_REQUIRE_THROW_RE(store::error, "test.db is empty",
+                         store::write_backend::open_append(
+                             fs::path("test.db")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(write_backend__open_append__error_if_missing);
+ATF_TEST_CASE_BODY(write_backend__open_append__error_if_missing)
+{
+    ATF_REQUIRE_THROW_RE(store::error, "Cannot open 'test.db'",
+                         store::write_backend::open_append(
+                             fs::path("test.db")));
+}
+
+
+ATF_TEST_CASE(write_backend__open_append__error_if_live);
+ATF_TEST_CASE_HEAD(write_backend__open_append__error_if_live)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(write_backend__open_append__error_if_live)
+{
+    store::write_backend backend = store::write_backend::open_rw(
+        fs::path("test.db"));
+    ATF_REQUIRE_THROW_RE(store::error, "test.db is being written to",
+                         store::write_backend::open_append(
+                             fs::path("test.db")));
+    backend.close();
+    ATF_REQUIRE(!fs::exists(store::detail::live_lock_file(
+        fs::path("test.db"))));
+    store::write_backend::open_append(fs::path("test.db")).close();
+}
+
+
+ATF_TEST_CASE(write_backend__open_rw__waits_for_readers);
+ATF_TEST_CASE_HEAD(write_backend__open_rw__waits_for_readers)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(write_backend__open_rw__waits_for_readers)
+{
+    const fs::path lock_file = store::detail::live_lock_file(
+        fs::path("test.db"));
+
+    int fds[2];
+    ATF_REQUIRE(::pipe(fds) != -1);
+    const pid_t pid = ::fork();
+    ATF_REQUIRE(pid != -1);
+    if (pid == 0) {
+        // Mimic a reader checking if the database is live.
+        ::close(fds[0]);
+        const int fd = ::open(lock_file.c_str(), O_RDONLY | O_CREAT, 0644);
+        if (fd == -1 || ::flock(fd, LOCK_SH) == -1 ||
+            ::write(fds[1], "x", 1) != 1)
+            std::exit(EXIT_FAILURE);
+        ::usleep(200000);
+        std::exit(EXIT_SUCCESS);
+    }
+    ::close(fds[1]);
+    char ch;
+    ATF_REQUIRE_EQ(1, ::read(fds[0], &ch, 1));
+    ::close(fds[0]);
+
+    store::write_backend::open_rw(fs::path("test.db")).close();
+
+    int status;
+    ATF_REQUIRE(::waitpid(pid, &status, 0) != -1);
+    ATF_REQUIRE(WIFEXITED(status));
+    ATF_REQUIRE_EQ(EXIT_SUCCESS, WEXITSTATUS(status));
+}
+
+
 ATF_TEST_CASE(write_backend__close);
 ATF_TEST_CASE_HEAD(write_backend__close)
 {
@@ -188,6 +316,52 @@ ATF_TEST_CASE_BODY(write_backend__close)
 }
 
 
+ATF_TEST_CASE(write_backend__close__updates_catalog);
+ATF_TEST_CASE_HEAD(write_backend__close__updates_catalog)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(write_backend__close__updates_catalog)
+{
+    const fs::path store_dir = store::layout::query_store_dir();
+    fs::mkdir_p(store_dir, 0755);
+    const fs::path file = store_dir / "results.suite.20140613-194515-000000.db";
+
+    store::write_backend backend = store::write_backend::open_rw(file);
+    {
+        const store::catalog_entries entries = store::catalog::open(
+            store_dir).list(utils::none);
+        ATF_REQUIRE_EQ(1, entries.size());
+        ATF_REQUIRE_EQ(file, entries[0].file);
+        ATF_REQUIRE(!entries[0].summary);
+    }
+
+    const model::test_program test_program = model::test_program_builder(
+        "plain", fs::path("the/binary"), fs::path("/some/root"), "the-suite")
+        .add_test_case("main")
+        .build();
+    store::write_transaction tx = backend.start_write();
+    const int64_t tp_id = tx.put_test_program(test_program);
+    const int64_t tc_id = tx.put_test_case(test_program, "main", tp_id);
+    tx.put_result(model::test_result(model::test_result_passed), tc_id,
+                  datetime::timestamp::from_microseconds(1000000),
+                  datetime::timestamp::from_microseconds(3000000));
+    tx.commit();
+    backend.close();
+
+    const store::catalog_entries entries = store::catalog::open(
+        store_dir).list(utils::none);
+    ATF_REQUIRE_EQ(1, entries.size());
+    ATF_REQUIRE_EQ(file, entries[0].file);
+    ATF_REQUIRE_EQ("suite", entries[0].test_suite);
+    ATF_REQUIRE(entries[0].summary);
+    ATF_REQUIRE_EQ(datetime::delta(2, 0), entries[0].summary.get().duration);
+    ATF_REQUIRE_EQ(1, entries[0].summary.get().counts.find(
+        model::test_result_passed)->second);
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, detail__initialize__ok);
@@ -200,5 +374,11 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, write_backend__open_rw__ok_if_empty);
     ATF_ADD_TEST_CASE(tcs, write_backend__open_rw__error_if_not_empty);
     ATF_ADD_TEST_CASE(tcs, write_backend__open_rw__create_missing);
+    ATF_ADD_TEST_CASE(tcs, write_backend__open_append__ok);
+    ATF_ADD_TEST_CASE(tcs, write_backend__open_append__error_if_empty);
+    ATF_ADD_TEST_CASE(tcs, write_backend__open_append__error_if_missing);
+    ATF_ADD_TEST_CASE(tcs, write_backend__open_append__error_if_live);
+    ATF_ADD_TEST_CASE(tcs, write_backend__open_rw__waits_for_readers);
     ATF_ADD_TEST_CASE(tcs, write_backend__close);
+    ATF_ADD_TEST_CASE(tcs, write_backend__close__updates_catalog);
 }
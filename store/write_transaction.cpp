@@ -32,6 +32,7 @@ extern "C" {
 #include <stdint.h>
 }
 
+#include <cstddef>
 #include <fstream>
 #include <map>
 
@@ -112,17 +113,102 @@ last_rowid(sqlite::database& db, const std::string& table)
 }
 
 
-/// Stores a metadata object.
+/// Cache of the metadata objects stored in the database, keyed by contents.
+typedef std::map< model::properties_map, int64_t > metadata_ids_map;
+
+
+/// Computes the digest of a metadata object.
+///
+/// This is a 64-bit FNV-1a hash of the names and values of all properties.
+///
+/// \param props The properties of the metadata object.
+///
+/// \return The digest, suitable for storage in an SQLite integer column.
+static int64_t
+metadata_digest(const model::properties_map& props)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (model::properties_map::const_iterator iter = props.begin();
+         iter != props.end(); ++iter) {
+        // Include the terminating NUL characters as separators.
+        const std::string* fields[] = { &(*iter).first, &(*iter).second };
+        for (std::size_t i = 0; i < 2; ++i) {
+            const char* data = fields[i]->c_str();
+            for (std::string::size_type j = 0; j <= fields[i]->length(); ++j) {
+                hash ^= static_cast< unsigned char >(data[j]);
+                hash *= 1099511628211ULL;
+            }
+        }
+    }
+    return static_cast< int64_t >(hash);
+}
+
+
+/// Looks for an existing metadata object in the database.
+///
+/// \param db The database to query.
+/// \param props The properties of the metadata object to look for.
+/// \param digest The digest of props.
+///
+/// \return The identifier of the matching metadata object, if any.
+///
+/// \throw sqlite::error If there are problems querying the database.
+static optional< int64_t >
+find_metadata(sqlite::database& db, const model::properties_map& props,
+              const int64_t digest)
+{
+    sqlite::statement candidates = db.create_statement(
+        "SELECT metadata_id FROM metadata_digests WHERE digest == :digest");
+    candidates.bind(":digest", digest);
+    while (candidates.step()) {
+        const int64_t metadata_id = candidates.safe_column_int64(
+            "metadata_id");
+
+        model::properties_map candidate;
+        sqlite::statement stmt = db.create_statement(
+            "SELECT property_name, property_value FROM metadatas "
+            "WHERE metadata_id == :metadata_id");
+        stmt.bind(":metadata_id", metadata_id);
+        while (stmt.step()) {
+            candidate[stmt.safe_column_text("property_name")] =
+                stmt.safe_column_text("property_value");
+        }
+
+        if (candidate == props)
+            return utils::make_optional(metadata_id);
+        LD(F("Metadata digest collision with object %s") % metadata_id);
+    }
+    return none;
+}
+
+
+/// Stores a metadata object, reusing an identical one if it exists.
 ///
 /// \param db The database into which to store the information.
 /// \param md The metadata to store.
+/// \param [in,out] cache Identifiers of the metadata objects already seen by
+///     the caller.  Updated with the stored object.
 ///
-/// \return The identifier of the new metadata object.
+/// \return The identifier of the metadata object.
+///
+/// \throw sqlite::error If there are problems writing to the database.
 static int64_t
-put_metadata(sqlite::database& db, const model::metadata& md)
+put_metadata(sqlite::database& db, const model::metadata& md,
+             metadata_ids_map& cache)
 {
     const model::properties_map props = md.to_properties();
 
+    const metadata_ids_map::const_iterator cached = cache.find(props);
+    if (cached != cache.end())
+        return (*cached).second;
+
+    const int64_t digest = metadata_digest(props);
+    const optional< int64_t > existing_id = find_metadata(db, props, digest);
+    if (existing_id) {
+        cache[props] = existing_id.get();
+        return existing_id.get();
+    }
+
     const int64_t metadata_id = last_rowid(db, "metadatas");
 
     sqlite::statement stmt = db.create_statement(
@@ -138,6 +224,14 @@ put_metadata(sqlite::database& db, const model::metadata& md)
         stmt.reset();
     }
 
+    sqlite::statement digest_stmt = db.create_statement(
+        "INSERT INTO metadata_digests (metadata_id, digest) "
+        "VALUES (:metadata_id, :digest)");
+    digest_stmt.bind(":metadata_id", metadata_id);
+    digest_stmt.bind(":digest", digest);
+    digest_stmt.step_without_results();
+
+    cache[props] = metadata_id;
     return metadata_id;
 }
 
@@ -196,6 +290,12 @@ struct store::write_transaction::impl : utils::noncopyable {
     /// The backing SQLite transaction.
     sqlite::transaction _tx;
 
+    /// Metadata objects stored or found during this transaction.
+    ///
+    /// This is only valid for the duration of the transaction because the
+    /// objects it refers to vanish if the transaction is rolled back.
+    metadata_ids_map _metadata_ids;
+
     /// Opens a transaction.
     ///
     /// \param backend_ The backend this transaction is connected to.
@@ -291,7 +391,7 @@ store::write_transaction::put_test_program(
 {
     try {
         const int64_t metadata_id = put_metadata(
-            _pimpl->_db, test_program.get_metadata());
+            _pimpl->_db, test_program.get_metadata(), _pimpl->_metadata_ids);
 
         sqlite::statement stmt = _pimpl->_db.create_statement(
             "INSERT INTO test_programs (absolute_path, "
@@ -337,7 +437,7 @@ store::write_transaction::put_test_case(const model::test_program& test_program,
 
     try {
         const int64_t metadata_id = put_metadata(
-            _pimpl->_db, test_case.get_raw_metadata());
+            _pimpl->_db, test_case.get_raw_metadata(), _pimpl->_metadata_ids);
 
         sqlite::statement stmt = _pimpl->_db.create_statement(
             "INSERT INTO test_cases (test_program_id, name, metadata_id) "
@@ -416,9 +516,9 @@ store::write_transaction::put_result(const model::test_result& result,
         sqlite::statement stmt = _pimpl->_db.create_statement(
             "INSERT INTO test_results (test_case_id, result_type, "
             "                          result_reason, start_time, "
-            "                          end_time) "
+            "                          duration) "
             "VALUES (:test_case_id, :result_type, :result_reason, "
-            "        :start_time, :end_time)");
+            "        :start_time, :duration)");
         stmt.bind(":test_case_id", test_case_id);
 
         store::bind_test_result_type(stmt, ":result_type", result.type());
@@ -428,7 +528,7 @@ store::write_transaction::put_result(const model::test_result& result,
             stmt.bind(":result_reason", result.reason());
 
         store::bind_timestamp(stmt, ":start_time", start_time);
-        store::bind_timestamp(stmt, ":end_time", end_time);
+        store::bind_delta(stmt, ":duration", end_time - start_time);
 
         stmt.step_without_results();
         const int64_t result_id = _pimpl->_db.last_insert_rowid();
@@ -438,3 +538,24 @@ store::write_transaction::put_result(const model::test_result& result,
         throw error(e.what());
     }
 }
+
+
+/// Deletes any test cases that do not have a result.
+///
+/// Test cases are put into the database before they are executed, so a run
+/// that is interrupted may leave behind test cases without results.  These
+/// must be discarded before resuming the run so that the test cases can be
+/// put again once they are re-executed.
+///
+/// \throw error If there is any problem when talking to the database.
+void
+store::write_transaction::delete_unfinished_test_cases(void)
+{
+    try {
+        _pimpl->_db.exec(
+            "DELETE FROM test_cases WHERE test_case_id NOT IN "
+            "    (SELECT test_case_id FROM test_results)");
+    } catch (const sqlite::error& e) {
+        throw error(e.what());
+    }
+}
@@ -81,6 +81,8 @@ public:
     int64_t put_result(const model::test_result&, const int64_t,
                        const utils::datetime::timestamp&,
                        const utils::datetime::timestamp&);
+
+    void delete_unfinished_test_cases(void);
 };
 
 
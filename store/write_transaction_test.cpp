@@ -208,6 +208,63 @@ ATF_TEST_CASE_BODY(put_test_program__ok)
 }
 
 
+ATF_TEST_CASE(put_test_program__shared_metadata);
+ATF_TEST_CASE_HEAD(put_test_program__shared_metadata)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(put_test_program__shared_metadata)
+{
+    const model::metadata md1 = model::metadata_builder()
+        .add_custom("var1", "value1")
+        .build();
+    const model::metadata md2 = model::metadata_builder()
+        .add_custom("var1", "value2")
+        .build();
+    const model::test_program test_program_1(
+        "mock", fs::path("first"), fs::path("/root"), "the-suite", md1,
+        model::test_cases_map());
+    const model::test_program test_program_2(
+        "mock", fs::path("second"), fs::path("/root"), "the-suite", md2,
+        model::test_cases_map());
+    const model::test_program test_program_3(
+        "mock", fs::path("third"), fs::path("/root"), "the-suite", md1,
+        model::test_cases_map());
+
+    store::write_backend backend = store::write_backend::open_rw(
+        fs::path("test.db"));
+    {
+        store::write_transaction tx = backend.start_write();
+        tx.put_test_program(test_program_1);
+        tx.put_test_program(test_program_2);
+        tx.commit();
+    }
+    {
+        // Use a separate transaction so that the existing metadata object has
+        // to be found in the database.
+        store::write_transaction tx = backend.start_write();
+        tx.put_test_program(test_program_3);
+        tx.commit();
+    }
+
+    std::map< std::string, int64_t > metadata_ids;
+    sqlite::statement stmt = backend.database().create_statement(
+        "SELECT relative_path, metadata_id FROM test_programs");
+    while (stmt.step())
+        metadata_ids[stmt.safe_column_text("relative_path")] =
+            stmt.safe_column_int64("metadata_id");
+    ATF_REQUIRE_EQ(3, metadata_ids.size());
+    ATF_REQUIRE_EQ(metadata_ids["first"], metadata_ids["third"]);
+    ATF_REQUIRE(metadata_ids["first"] != metadata_ids["second"]);
+
+    sqlite::statement count_stmt = backend.database().create_statement(
+        "SELECT COUNT(*) FROM metadata_digests");
+    ATF_REQUIRE(count_stmt.step());
+    ATF_REQUIRE_EQ(2, count_stmt.column_int64(0));
+}
+
+
 ATF_TEST_CASE(put_test_case__fail);
 ATF_TEST_CASE_HEAD(put_test_case__fail)
 {
@@ -395,6 +452,41 @@ ATF_TEST_CASE_BODY(put_result__fail)
 }
 
 
+ATF_TEST_CASE(delete_unfinished_test_cases);
+ATF_TEST_CASE_HEAD(delete_unfinished_test_cases)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(delete_unfinished_test_cases)
+{
+    const model::test_program test_program = model::test_program_builder(
+        "plain", fs::path("the/binary"), fs::path("/some/root"), "the-suite")
+        .add_test_case("done")
+        .add_test_case("pending")
+        .build();
+
+    store::write_backend backend = store::write_backend::open_rw(
+        fs::path("test.db"));
+    store::write_transaction tx = backend.start_write();
+    const int64_t tp_id = tx.put_test_program(test_program);
+    const int64_t tc_id = tx.put_test_case(test_program, "done", tp_id);
+    tx.put_result(model::test_result(model::test_result_passed), tc_id,
+                  datetime::timestamp::from_microseconds(1000),
+                  datetime::timestamp::from_microseconds(2000));
+    (void)tx.put_test_case(test_program, "pending", tp_id);
+    tx.delete_unfinished_test_cases();
+    tx.commit();
+
+    sqlite::statement stmt = backend.database().create_statement(
+        "SELECT test_case_id, name FROM test_cases");
+    ATF_REQUIRE(stmt.step());
+    ATF_REQUIRE_EQ(tc_id, stmt.safe_column_int64("test_case_id"));
+    ATF_REQUIRE_EQ("done", stmt.safe_column_text("name"));
+    ATF_REQUIRE(!stmt.step());
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, commit__ok);
@@ -402,6 +494,7 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, rollback__ok);
 
     ATF_ADD_TEST_CASE(tcs, put_test_program__ok);
+    ATF_ADD_TEST_CASE(tcs, put_test_program__shared_metadata);
     ATF_ADD_TEST_CASE(tcs, put_test_case__fail);
     ATF_ADD_TEST_CASE(tcs, put_test_case_file__empty);
     ATF_ADD_TEST_CASE(tcs, put_test_case_file__some);
@@ -413,4 +506,6 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, put_result__ok__passed);
     ATF_ADD_TEST_CASE(tcs, put_result__ok__skipped);
     ATF_ADD_TEST_CASE(tcs, put_result__fail);
+
+    ATF_ADD_TEST_CASE(tcs, delete_unfinished_test_cases);
 }
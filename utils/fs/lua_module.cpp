@@ -78,6 +78,25 @@ qualify_path(lutok::state& state, const fs::path& path)
 }
 
 
+/// Gets the record of file system queries attached to the module.
+///
+/// \param state The Lua state.
+///
+/// \return The record into which to register queries, or NULL if the caller of
+/// open_fs() did not ask for them to be tracked.
+static fs::lua_queries*
+get_queries(lutok::state& state)
+{
+    lutok::stack_cleaner cleaner(state);
+
+    state.get_global("_fs_queries");
+    if (state.is_userdata(-1))
+        return *state.to_userdata< fs::lua_queries* >(-1);
+    else
+        return NULL;
+}
+
+
 /// Safely gets a path from the Lua state.
 ///
 /// \param state The Lua state.
@@ -151,7 +170,13 @@ lua_fs_exists(lutok::state& state)
     lutok::stack_cleaner cleaner(state);
 
     const fs::path path = qualify_path(state, to_path(state, -1));
-    state.push_boolean(fs::exists(path));
+    const bool exists = fs::exists(path);
+
+    fs::lua_queries* queries = get_queries(state);
+    if (queries != NULL)
+        queries->exists[path] = exists;
+
+    state.push_boolean(exists);
     cleaner.forget();
     return 1;
 }
@@ -247,6 +272,10 @@ lua_fs_files(lutok::state& state)
                                  std::strerror(original_errno));
     }
 
+    fs::lua_queries* queries = get_queries(state);
+    if (queries != NULL)
+        queries->listed.insert(path);
+
     state.push_cxx_closure(files_iterator, 1);
 
     cleaner.forget();
@@ -323,12 +352,35 @@ fs::open_fs(lutok::state& s)
 ///     the underlying file sytem.
 void
 fs::open_fs(lutok::state& s, const fs::path& start_dir)
+{
+    open_fs(s, start_dir, NULL);
+}
+
+
+/// Creates a Lua 'fs' module that keeps track of file system queries.
+///
+/// \post The global 'fs' symbol is set to a table that contains functions to a
+/// variety of utilites from the fs C++ module.
+///
+/// \param s The Lua state.
+/// \param start_dir The start directory to use in all operations that reference
+///     the underlying file sytem.
+/// \param queries If not NULL, record into which to register the file system
+///     queries issued by the Lua code.  Must remain valid for as long as the
+///     Lua code can call the module.
+void
+fs::open_fs(lutok::state& s, const fs::path& start_dir, lua_queries* queries)
 {
     lutok::stack_cleaner cleaner(s);
 
     s.push_string(start_dir.str());
     s.set_global("_fs_start_dir");
 
+    if (queries != NULL) {
+        *s.new_userdata< lua_queries* >() = queries;
+        s.set_global("_fs_queries");
+    }
+
     std::map< std::string, lutok::cxx_function > members;
     members["basename"] = lua_fs_basename;
     members["dirname"] = lua_fs_dirname;
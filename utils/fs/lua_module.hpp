@@ -32,10 +32,17 @@
 /// When the fs module is bound to Lua, the module has the concept of a "start
 /// directory".  The start directory is the directory used to qualify all
 /// relative paths, and is provided at module binding time.
+///
+/// The module can also keep track of the queries the Lua code issues against
+/// the file system, which allows callers to tell if the results of running
+/// that code may have changed.
 
 #if !defined(UTILS_FS_LUA_MODULE_HPP)
 #define UTILS_FS_LUA_MODULE_HPP
 
+#include <map>
+#include <set>
+
 #include <lutok/state.hpp>
 
 #include "utils/fs/path.hpp"
@@ -44,8 +51,21 @@ namespace utils {
 namespace fs {
 
 
+/// Record of the file system queries issued through the Lua fs module.
+///
+/// All paths are qualified with the start directory of the module.
+struct lua_queries {
+    /// Paths given to fs.exists() and the values it returned for them.
+    std::map< fs::path, bool > exists;
+
+    /// Directories whose contents were scanned with fs.files().
+    std::set< fs::path > listed;
+};
+
+
 void open_fs(lutok::state&);
 void open_fs(lutok::state&, const fs::path&);
+void open_fs(lutok::state&, const fs::path&, lua_queries*);
 
 
 }  // namespace fs
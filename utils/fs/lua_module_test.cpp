@@ -28,6 +28,9 @@
 
 #include "utils/fs/lua_module.hpp"
 
+#include <map>
+#include <set>
+
 #include <atf-c++.hpp>
 #include <lutok/operations.hpp>
 #include <lutok/state.hpp>
@@ -184,6 +187,30 @@ ATF_TEST_CASE_BODY(exists__custom_start_dir)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(exists__queries);
+ATF_TEST_CASE_BODY(exists__queries)
+{
+    lutok::state state;
+    fs::lua_queries queries;
+    fs::open_fs(state, fs::path("subdir"), &queries);
+
+    fs::mkdir(fs::path("subdir"), 0755);
+    atf::utils::create_file("subdir/foo", "");
+
+    lutok::do_string(state, "return fs.exists('foo')", 0, 1, 0);
+    lutok::do_string(state, "return fs.exists('bar')", 0, 1, 0);
+    lutok::do_string(state, "return fs.exists('/non-existent')", 0, 1, 0);
+    state.pop(3);
+
+    std::map< fs::path, bool > exp_exists;
+    exp_exists[fs::path("subdir/foo")] = true;
+    exp_exists[fs::path("subdir/bar")] = false;
+    exp_exists[fs::path("/non-existent")] = false;
+    ATF_REQUIRE(exp_exists == queries.exists);
+    ATF_REQUIRE(queries.listed.empty());
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(files__none);
 ATF_TEST_CASE_BODY(files__none)
 {
@@ -255,6 +282,30 @@ ATF_TEST_CASE_BODY(files__some_with_custom_start_dir)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(files__queries);
+ATF_TEST_CASE_BODY(files__queries)
+{
+    lutok::state state;
+    fs::lua_queries queries;
+    fs::open_fs(state, fs::path("root"), &queries);
+
+    fs::mkdir(fs::path("root"), 0755);
+    fs::mkdir(fs::path("root/subdir"), 0755);
+
+    lutok::do_string(state,
+                     "for file in fs.files('.') do end\n"
+                     "for file in fs.files('subdir') do end\n"
+                     "for file in fs.files('.') do end\n",
+                     0, 0, 0);
+
+    std::set< fs::path > exp_listed;
+    exp_listed.insert(fs::path("root"));
+    exp_listed.insert(fs::path("root/subdir"));
+    ATF_REQUIRE(exp_listed == queries.listed);
+    ATF_REQUIRE(queries.exists.empty());
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(files__fail_arg);
 ATF_TEST_CASE_BODY(files__fail_arg)
 {
@@ -361,10 +412,12 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, exists__ok);
     ATF_ADD_TEST_CASE(tcs, exists__fail);
     ATF_ADD_TEST_CASE(tcs, exists__custom_start_dir);
+    ATF_ADD_TEST_CASE(tcs, exists__queries);
 
     ATF_ADD_TEST_CASE(tcs, files__none);
     ATF_ADD_TEST_CASE(tcs, files__some);
     ATF_ADD_TEST_CASE(tcs, files__some_with_custom_start_dir);
+    ATF_ADD_TEST_CASE(tcs, files__queries);
     ATF_ADD_TEST_CASE(tcs, files__fail_arg);
     ATF_ADD_TEST_CASE(tcs, files__fail_opendir);
 
@@ -58,6 +58,7 @@ extern "C" {
 #include <string>
 
 #include "utils/auto_array.ipp"
+#include "utils/datetime.hpp"
 #include "utils/defs.hpp"
 #include "utils/env.hpp"
 #include "utils/format/macros.hpp"
@@ -65,11 +66,14 @@ extern "C" {
 #include "utils/fs/exceptions.hpp"
 #include "utils/fs/path.hpp"
 #include "utils/logging/macros.hpp"
+#include "utils/logging/operations.hpp"
 #include "utils/optional.ipp"
 #include "utils/sanity.hpp"
 #include "utils/units.hpp"
 
+namespace datetime = utils::datetime;
 namespace fs = utils::fs;
+namespace logging = utils::logging;
 namespace units = utils::units;
 
 using utils::optional;
@@ -151,6 +155,13 @@ unmount(const char* UTILS_UNUSED_PARAM(path),
 const int exit_known_error = 123;
 
 
+/// Minimum age of a modification time to trust it.
+///
+/// This is larger than the granularity of modification_time() so that any
+/// rounding done by the file system cannot hide a change.
+static const datetime::delta racy_period(2, 0);
+
+
 static void run_mount_tmpfs(const fs::path&, const uint64_t) UTILS_NORETURN;
 
 
@@ -265,6 +276,7 @@ unmount_with_umount8(const fs::path& mount_point)
 {
     PRE(!have_unmount2);
 
+    logging::flush();
     const pid_t pid = ::fork();
     if (pid == -1) {
         const int original_errno = errno;
@@ -396,6 +408,28 @@ fs::exists(const fs::path& path)
 }
 
 
+/// Queries the size of a file.
+///
+/// Symbolic links are followed.
+///
+/// \param path The file to query.
+///
+/// \return The size of the file.
+///
+/// \throw fs::system_error If the call to stat(2) fails.
+units::bytes
+fs::file_size(const fs::path& path)
+{
+    struct ::stat sb;
+    if (::stat(path.c_str(), &sb) == -1) {
+        const int original_errno = errno;
+        throw fs::system_error(F("Cannot get information about %s") % path,
+                               original_errno);
+    }
+    return units::bytes(static_cast< uint64_t >(sb.st_size));
+}
+
+
 /// Locates a file in the PATH.
 ///
 /// \param name The file to locate.
@@ -469,6 +503,28 @@ fs::is_directory(const fs::path& path)
 }
 
 
+/// Checks if a modification time is old enough to detect later changes.
+///
+/// File systems record modification times with a limited granularity, so a
+/// file modified right after we look at it may keep its modification time.
+/// Callers that cache data derived from a file must only rely on its
+/// modification time to detect changes if this returns true.
+///
+/// \param mtime The modification time of the file, as returned by
+///     modification_time().
+/// \param read_time The time at which the file was inspected.  This must be
+///     taken before reading the contents of the file.
+///
+/// \return True if any later modification of the file will alter its
+/// modification time; false otherwise.
+bool
+fs::is_stable_mtime(const datetime::timestamp& mtime,
+                    const datetime::timestamp& read_time)
+{
+    return mtime + racy_period <= read_time;
+}
+
+
 /// Creates a directory.
 ///
 /// \param dir The path to the directory to create.
@@ -617,6 +673,30 @@ fs::mkstemp(const std::string& path_template)
 }
 
 
+/// Queries the last modification time of a file.
+///
+/// Symbolic links are followed.  Note that the returned timestamp only has a
+/// granularity of seconds, as that is what we can portably obtain.
+///
+/// \param path The file to query.
+///
+/// \return The modification time of the file.
+///
+/// \throw fs::system_error If the call to stat(2) fails.
+datetime::timestamp
+fs::modification_time(const fs::path& path)
+{
+    struct ::stat sb;
+    if (::stat(path.c_str(), &sb) == -1) {
+        const int original_errno = errno;
+        throw fs::system_error(F("Cannot get information about %s") % path,
+                               original_errno);
+    }
+    return datetime::timestamp::from_microseconds(
+        static_cast< int64_t >(sb.st_mtime) * 1000000);
+}
+
+
 /// Mounts a temporary file system with unlimited size.
 ///
 /// \param in_mount_point The path on which the file system will be mounted.
@@ -647,6 +727,7 @@ fs::mount_tmpfs(const fs::path& in_mount_point, const units::bytes& size)
     const fs::path mount_point = in_mount_point.is_absolute() ?
         in_mount_point : in_mount_point.to_absolute();
 
+    logging::flush();
     const pid_t pid = ::fork();
     if (pid == -1) {
         const int original_errno = errno;
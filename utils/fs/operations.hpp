@@ -38,6 +38,7 @@
 #include <set>
 #include <string>
 
+#include "utils/datetime_fwd.hpp"
 #include "utils/fs/directory_fwd.hpp"
 #include "utils/fs/path_fwd.hpp"
 #include "utils/optional_fwd.hpp"
@@ -50,13 +51,17 @@ namespace fs {
 void copy(const fs::path&, const fs::path&);
 path current_path(void);
 bool exists(const fs::path&);
+utils::units::bytes file_size(const fs::path&);
 utils::optional< path > find_in_path(const char*);
 utils::units::bytes free_disk_space(const fs::path&);
 bool is_directory(const fs::path&);
+bool is_stable_mtime(const utils::datetime::timestamp&,
+                     const utils::datetime::timestamp&);
 void mkdir(const path&, const int);
 void mkdir_p(const path&, const int);
 fs::path mkdtemp_public(const std::string&);
 fs::path mkstemp(const std::string&);
+utils::datetime::timestamp modification_time(const fs::path&);
 void mount_tmpfs(const path&);
 void mount_tmpfs(const path&, const units::bytes&);
 void rm_r(const path&);
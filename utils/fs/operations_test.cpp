@@ -36,6 +36,7 @@ extern "C" {
 #include <dirent.h>
 #include <signal.h>
 #include <unistd.h>
+#include <utime.h>
 }
 
 #include <cerrno>
@@ -48,6 +49,7 @@ extern "C" {
 
 #include <atf-c++.hpp>
 
+#include "utils/datetime.hpp"
 #include "utils/env.hpp"
 #include "utils/format/containers.ipp"
 #include "utils/format/macros.hpp"
@@ -59,6 +61,7 @@ extern "C" {
 #include "utils/stream.hpp"
 #include "utils/units.hpp"
 
+namespace datetime = utils::datetime;
 namespace fs = utils::fs;
 namespace passwd = utils::passwd;
 namespace units = utils::units;
@@ -183,6 +186,25 @@ ATF_TEST_CASE_BODY(exists)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(file_size__ok);
+ATF_TEST_CASE_BODY(file_size__ok)
+{
+    atf::utils::create_file("empty", "");
+    ATF_REQUIRE_EQ(units::bytes(0), fs::file_size(fs::path("empty")));
+
+    atf::utils::create_file("file", "0123456789");
+    ATF_REQUIRE_EQ(units::bytes(10), fs::file_size(fs::path("file")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(file_size__fail);
+ATF_TEST_CASE_BODY(file_size__fail)
+{
+    ATF_REQUIRE_THROW_RE(fs::system_error, "Cannot get information.*missing",
+                         fs::file_size(fs::path("missing")));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(find_in_path__no_path);
 ATF_TEST_CASE_BODY(find_in_path__no_path)
 {
@@ -354,6 +376,22 @@ ATF_TEST_CASE_CLEANUP(is_directory__fail)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(is_stable_mtime);
+ATF_TEST_CASE_BODY(is_stable_mtime)
+{
+    const datetime::timestamp mtime =
+        datetime::timestamp::from_values(2016, 5, 10, 12, 30, 0, 0);
+
+    ATF_REQUIRE(!fs::is_stable_mtime(mtime, mtime));
+    ATF_REQUIRE(!fs::is_stable_mtime(mtime, mtime + datetime::delta(1, 0)));
+    ATF_REQUIRE(!fs::is_stable_mtime(mtime,
+                                     mtime + datetime::delta(1, 999999)));
+    ATF_REQUIRE(fs::is_stable_mtime(mtime, mtime + datetime::delta(2, 0)));
+    ATF_REQUIRE(fs::is_stable_mtime(mtime, mtime + datetime::delta(3600, 0)));
+    ATF_REQUIRE(!fs::is_stable_mtime(mtime + datetime::delta(10, 0), mtime));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(mkdir__ok);
 ATF_TEST_CASE_BODY(mkdir__ok)
 {
@@ -565,6 +603,28 @@ ATF_TEST_CASE_BODY(mkstemp)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(modification_time__ok);
+ATF_TEST_CASE_BODY(modification_time__ok)
+{
+    atf::utils::create_file("file", "");
+    struct ::utimbuf times;
+    times.actime = 1000;
+    times.modtime = 1234567890;
+    ATF_REQUIRE(::utime("file", &times) != -1);
+
+    ATF_REQUIRE_EQ(datetime::timestamp::from_microseconds(1234567890000000LL),
+                   fs::modification_time(fs::path("file")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(modification_time__fail);
+ATF_TEST_CASE_BODY(modification_time__fail)
+{
+    ATF_REQUIRE_THROW_RE(fs::system_error, "Cannot get information.*missing",
+                         fs::modification_time(fs::path("missing")));
+}
+
+
 static void
 test_mount_tmpfs_ok(const units::bytes& size)
 {
@@ -777,6 +837,9 @@ ATF_INIT_TEST_CASES(tcs)
 
     ATF_ADD_TEST_CASE(tcs, exists);
 
+    ATF_ADD_TEST_CASE(tcs, file_size__ok);
+    ATF_ADD_TEST_CASE(tcs, file_size__fail);
+
     ATF_ADD_TEST_CASE(tcs, find_in_path__no_path);
     ATF_ADD_TEST_CASE(tcs, find_in_path__empty_path);
     ATF_ADD_TEST_CASE(tcs, find_in_path__one_component);
@@ -790,6 +853,7 @@ ATF_INIT_TEST_CASES(tcs)
 
     ATF_ADD_TEST_CASE(tcs, is_directory__ok);
     ATF_ADD_TEST_CASE(tcs, is_directory__fail);
+    ATF_ADD_TEST_CASE(tcs, is_stable_mtime);
 
     ATF_ADD_TEST_CASE(tcs, mkdir__ok);
     ATF_ADD_TEST_CASE(tcs, mkdir__enoent);
@@ -805,6 +869,9 @@ ATF_INIT_TEST_CASES(tcs)
 
     ATF_ADD_TEST_CASE(tcs, mkstemp);
 
+    ATF_ADD_TEST_CASE(tcs, modification_time__ok);
+    ATF_ADD_TEST_CASE(tcs, modification_time__fail);
+
     ATF_ADD_TEST_CASE(tcs, mount_tmpfs__ok__default_size);
     ATF_ADD_TEST_CASE(tcs, mount_tmpfs__ok__explicit_size);
     ATF_ADD_TEST_CASE(tcs, mount_tmpfs__fail);
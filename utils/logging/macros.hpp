@@ -37,32 +37,42 @@
 #include "utils/logging/operations.hpp"
 
 
+/// Logs a message if its level is enabled.
+///
+/// The message is only evaluated if the log level lets it through, so the
+/// formatting of messages that would be discarded costs nothing.
+///
+/// \param level The level of the message.
+/// \param message The message to log.
+#define UTILS_LOGGING_LOG(level, message) \
+    do { \
+        if (utils::logging::is_enabled(level)) \
+            utils::logging::log(level, __FILE__, __LINE__, message); \
+    } while (false)
+
+
 /// Logs a debug message.
 ///
 /// \param message The message to log.
-#define LD(message) utils::logging::log(utils::logging::level_debug, \
-                                        __FILE__, __LINE__, message)
+#define LD(message) UTILS_LOGGING_LOG(utils::logging::level_debug, message)
 
 
 /// Logs an error message.
 ///
 /// \param message The message to log.
-#define LE(message) utils::logging::log(utils::logging::level_error, \
-                                        __FILE__, __LINE__, message)
+#define LE(message) UTILS_LOGGING_LOG(utils::logging::level_error, message)
 
 
 /// Logs an informational message.
 ///
 /// \param message The message to log.
-#define LI(message) utils::logging::log(utils::logging::level_info, \
-                                        __FILE__, __LINE__, message)
+#define LI(message) UTILS_LOGGING_LOG(utils::logging::level_info, message)
 
 
 /// Logs a warning message.
 ///
 /// \param message The message to log.
-#define LW(message) utils::logging::log(utils::logging::level_warning, \
-                                        __FILE__, __LINE__, message)
+#define LW(message) UTILS_LOGGING_LOG(utils::logging::level_warning, message)
 
 
 #endif  // !defined(UTILS_LOGGING_MACROS_HPP)
@@ -106,10 +106,42 @@ ATF_TEST_CASE_BODY(lw)
 }
 
 
+/// Number of times that counted_message() has been called.
+static int evaluations = 0;
+
+
+/// Returns a message and records that it has been evaluated.
+///
+/// \param message The message to return.
+///
+/// \return The message.
+static std::string
+counted_message(const char* message)
+{
+    evaluations++;
+    return message;
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(disabled_levels_not_evaluated);
+ATF_TEST_CASE_BODY(disabled_levels_not_evaluated)
+{
+    logging::set_persistency("warning", fs::path("test.log"));
+    LD(counted_message("Debug message"));
+    LI(counted_message("Info message"));
+    ATF_REQUIRE_EQ(0, evaluations);
+    LW(counted_message("Warning message"));
+    LE(counted_message("Error message"));
+    ATF_REQUIRE_EQ(2, evaluations);
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, ld);
     ATF_ADD_TEST_CASE(tcs, le);
     ATF_ADD_TEST_CASE(tcs, li);
     ATF_ADD_TEST_CASE(tcs, lw);
+
+    ATF_ADD_TEST_CASE(tcs, disabled_levels_not_evaluated);
 }
@@ -29,9 +29,11 @@
 #include "utils/logging/operations.hpp"
 
 extern "C" {
+#include <stdint.h>
 #include <unistd.h>
 }
 
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -107,9 +109,31 @@ struct global_state {
     /// Stream to the currently open log file.
     std::auto_ptr< std::ostream > logfile;
 
+    /// Whether writes to the log file are buffered or flushed on every entry.
+    bool buffered;
+
+    /// PID of the process that opened the log file.
+    ///
+    /// Subprocesses inherit the log file but may exec or terminate abruptly at
+    /// any time, so they always flush their entries right away.
+    pid_t logfile_pid;
+
+    /// Time, in seconds, of the last flush of the log file.
+    int64_t last_flush_seconds;
+
+    /// Time, in seconds, of the last formatted timestamp.
+    int64_t timestamp_seconds;
+
+    /// Last formatted timestamp, reused for all entries in the same second.
+    std::string timestamp_text;
+
     global_state() :
         log_level(logging::level_debug),
-        auto_set_persistency(true)
+        auto_set_persistency(true),
+        buffered(false),
+        logfile_pid(-1),
+        last_flush_seconds(0),
+        timestamp_seconds(0)
     {
     }
 };
@@ -140,6 +164,28 @@ get_globals(void)
 }
 
 
+/// Formats the timestamp of a log entry.
+///
+/// Log entries only have a resolution of seconds, so the formatted timestamp
+/// is reused for all the entries logged within the same second.
+///
+/// \param globals The global state of the logging module.
+/// \param now The time of the entry.
+///
+/// \return The formatted timestamp.
+static const std::string&
+format_timestamp(struct global_state* globals, const datetime::timestamp& now)
+{
+    const int64_t seconds = now.to_seconds();
+    if (globals->timestamp_text.empty() ||
+        globals->timestamp_seconds != seconds) {
+        globals->timestamp_text = now.strftime(timestamp_format);
+        globals->timestamp_seconds = seconds;
+    }
+    return globals->timestamp_text;
+}
+
+
 /// Converts a level to a printable character.
 ///
 /// \param level The level to convert.
@@ -161,6 +207,22 @@ level_to_char(const logging::level level)
 }  // anonymous namespace
 
 
+/// Writes any buffered log entries to the log file.
+///
+/// This must be called before forking so that subprocesses do not inherit,
+/// and later write, a copy of the pending entries.  It must also be called
+/// before blocking for an unbounded amount of time and before aborting, so
+/// that the log file is complete if the process never logs anything else.
+void
+logging::flush(void)
+{
+    struct global_state* globals = get_globals();
+
+    if (globals->logfile.get() != NULL)
+        globals->logfile->flush();
+}
+
+
 /// Generates a standard log name.
 ///
 /// This always adds the same timestamp to the log name for a particular run.
@@ -183,10 +245,28 @@ logging::generate_log_name(const fs::path& logdir, const std::string& progname)
 }
 
 
+/// Checks if log entries of a given level are recorded.
+///
+/// The logging macros use this to avoid evaluating the messages of entries
+/// that would be discarded anyway.
+///
+/// \param message_level The level of the entry.
+///
+/// \return True if entries of message_level are recorded; false otherwise.
+bool
+logging::is_enabled(const level message_level)
+{
+    return message_level <= get_globals()->log_level;
+}
+
+
 /// Logs an entry to the log file.
 ///
 /// If the log is not yet set to persistent mode, the entry is recorded in the
-/// in-memory backlog.  Otherwise, it is just written to disk.
+/// in-memory backlog.  Otherwise, it is just written to disk.  If the log is
+/// buffered, entries are flushed to disk when a later entry is logged in a
+/// different second, except for warnings and errors, which are always flushed
+/// right away.  Callers that block or abort must call flush() themselves.
 ///
 /// \param message_level The level of the entry.
 /// \param file The file from which the log message is generated.
@@ -214,20 +294,51 @@ logging::log(const level message_level, const char* file, const int line,
     if (message_level > globals->log_level)
         return;
 
+    const pid_t pid = ::getpid();
+
     // Update doc/troubleshooting.texi if you change the log format.
-    const std::string message = F("%s %s %s %s:%s: %s") %
-        now.strftime(timestamp_format) % level_to_char(message_level) %
-        ::getpid() % file % line % user_message;
+    std::ostringstream message;
+    message << format_timestamp(globals, now) << ' '
+            << level_to_char(message_level) << ' ' << pid << ' '
+            << file << ':' << line << ": " << user_message;
     if (globals->logfile.get() == NULL)
-        globals->backlog.push_back(std::make_pair(message_level, message));
+        globals->backlog.push_back(std::make_pair(message_level,
+                                                  message.str()));
     else {
         INV(globals->backlog.empty());
-        (*globals->logfile) << message << '\n';
-        globals->logfile->flush();
+        (*globals->logfile) << message.str() << '\n';
+        if (!globals->buffered || message_level <= level_warning ||
+            pid != globals->logfile_pid ||
+            now.to_seconds() != globals->last_flush_seconds) {
+            globals->logfile->flush();
+            globals->last_flush_seconds = now.to_seconds();
+        }
     }
 }
 
 
+/// Enables or disables the buffering of writes to the log file.
+///
+/// Buffering avoids one write to disk per log entry, which matters when
+/// debug logging is enabled.  Pending entries are written out by flush(),
+/// which is called before waiting for subprocesses, before sleeping and
+/// before aborting on a failed assertion, so entries are only held in memory
+/// while the process is busy.  The price is that debug and informational
+/// entries logged since the last flush may be lost if the process gets a
+/// fatal signal.
+///
+/// \param buffered Whether to buffer writes to the log file or not.
+void
+logging::set_buffered(const bool buffered)
+{
+    struct global_state* globals = get_globals();
+
+    globals->buffered = buffered;
+    if (!buffered && globals->logfile.get() != NULL)
+        globals->logfile->flush();
+}
+
+
 /// Sets the logging to record messages in memory for later flushing.
 ///
 /// Can be called after set_persistency to flush logs and set recording to be
@@ -288,6 +399,7 @@ logging::set_persistency(const std::string& new_level, const fs::path& path)
     } catch (const std::runtime_error& unused_error) {
         throw std::runtime_error(F("Failed to create log file %s") % path);
     }
+    globals->logfile_pid = ::getpid();
 
     for (std::vector< std::pair< logging::level, std::string > >::const_iterator
          iter = globals->backlog.begin(); iter != globals->backlog.end();
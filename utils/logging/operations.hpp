@@ -42,8 +42,11 @@ namespace utils {
 namespace logging {
 
 
+void flush(void);
 fs::path generate_log_name(const fs::path&, const std::string&);
+bool is_enabled(const level);
 void log(const level, const char*, const int, const std::string&);
+void set_buffered(const bool);
 void set_inmemory(void);
 void set_persistency(const std::string&, const fs::path&);
 
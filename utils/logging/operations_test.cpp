@@ -32,6 +32,7 @@ extern "C" {
 #include <unistd.h>
 }
 
+#include <cstddef>
 #include <fstream>
 #include <string>
 
@@ -84,6 +85,72 @@ ATF_TEST_CASE_BODY(generate_log_name__after_log)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(is_enabled);
+ATF_TEST_CASE_BODY(is_enabled)
+{
+    logging::set_inmemory();
+    ATF_REQUIRE(logging::is_enabled(logging::level_debug));
+
+    logging::set_persistency("info", fs::path("test.log"));
+    ATF_REQUIRE(logging::is_enabled(logging::level_error));
+    ATF_REQUIRE(logging::is_enabled(logging::level_warning));
+    ATF_REQUIRE(logging::is_enabled(logging::level_info));
+    ATF_REQUIRE(!logging::is_enabled(logging::level_debug));
+}
+
+
+/// Counts the number of lines in a file.
+///
+/// \param path The file to read.
+///
+/// \return The number of lines in the file.
+static std::size_t
+count_lines(const char* path)
+{
+    std::ifstream input(path);
+    ATF_REQUIRE(input);
+
+    std::size_t count = 0;
+    std::string line;
+    while (std::getline(input, line).good())
+        count++;
+    return count;
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(set_buffered);
+ATF_TEST_CASE_BODY(set_buffered)
+{
+    logging::set_persistency("debug", fs::path("test.log"));
+    logging::set_buffered(true);
+
+    datetime::set_mock_now(2011, 2, 21, 18, 30, 0, 0);
+    logging::log(logging::level_debug, "file", 1, "Debug 1");
+    ATF_REQUIRE_EQ(1, count_lines("test.log"));
+    logging::log(logging::level_info, "file", 2, "Info 1");
+    ATF_REQUIRE_EQ(1, count_lines("test.log"));
+    logging::log(logging::level_warning, "file", 3, "Warning 1");
+    ATF_REQUIRE_EQ(3, count_lines("test.log"));
+    logging::log(logging::level_debug, "file", 4, "Debug 2");
+    ATF_REQUIRE_EQ(3, count_lines("test.log"));
+    logging::flush();
+    ATF_REQUIRE_EQ(4, count_lines("test.log"));
+
+    logging::log(logging::level_debug, "file", 5, "Debug 3");
+    ATF_REQUIRE_EQ(4, count_lines("test.log"));
+    datetime::set_mock_now(2011, 2, 21, 18, 30, 1, 0);
+    logging::log(logging::level_debug, "file", 6, "Debug 4");
+    ATF_REQUIRE_EQ(6, count_lines("test.log"));
+
+    logging::log(logging::level_debug, "file", 7, "Debug 5");
+    ATF_REQUIRE_EQ(6, count_lines("test.log"));
+    logging::set_buffered(false);
+    ATF_REQUIRE_EQ(7, count_lines("test.log"));
+    logging::log(logging::level_debug, "file", 8, "Debug 6");
+    ATF_REQUIRE_EQ(8, count_lines("test.log"));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(log);
 ATF_TEST_CASE_BODY(log)
 {
@@ -341,8 +408,12 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, generate_log_name__before_log);
     ATF_ADD_TEST_CASE(tcs, generate_log_name__after_log);
 
+    ATF_ADD_TEST_CASE(tcs, is_enabled);
+
     ATF_ADD_TEST_CASE(tcs, log);
 
+    ATF_ADD_TEST_CASE(tcs, set_buffered);
+
     ATF_ADD_TEST_CASE(tcs, set_inmemory__reset);
 
     ATF_ADD_TEST_CASE(tcs, set_persistency__no_backlog);
@@ -45,6 +45,7 @@ extern "C" {
 #include "utils/format/macros.hpp"
 #include "utils/fs/path.hpp"
 #include "utils/logging/macros.hpp"
+#include "utils/logging/operations.hpp"
 #include "utils/noncopyable.hpp"
 #include "utils/process/exceptions.hpp"
 #include "utils/process/fdstream.hpp"
@@ -81,6 +82,7 @@ struct child::impl : utils::noncopyable {
 
 
 namespace fs = utils::fs;
+namespace logging = utils::logging;
 namespace process = utils::process;
 namespace signals = utils::signals;
 
@@ -197,6 +199,7 @@ process::child::fork_capture_aux(void)
 {
     std::cout.flush();
     std::cerr.flush();
+    logging::flush();
 
     int fds[2];
     if (detail::syscall_pipe(fds) == -1)
@@ -258,6 +261,7 @@ process::child::fork_files_aux(const fs::path& stdout_file,
 {
     std::cout.flush();
     std::cerr.flush();
+    logging::flush();
 
     std::auto_ptr< signals::interrupts_inhibiter > inhibiter(
         new signals::interrupts_inhibiter);
@@ -841,6 +841,24 @@ executor::executor_handle::wait_any(void)
 }
 
 
+/// Waits for completion of any forked process for a limited amount of time.
+///
+/// \param timeout Maximum amount of time to wait for.
+///
+/// \return A pointer to an object describing the waited-for subprocess, or
+/// none if no subprocess terminated before the timeout.
+optional< executor::exit_handle >
+executor::executor_handle::wait_any(const datetime::delta& timeout)
+{
+    signals::check_interrupt();
+    const optional< process::status > status = process::wait_any(timeout);
+    if (!status)
+        return none;
+    return utils::make_optional(_pimpl->post_wait(status.get().dead_pid(),
+                                                  status.get()));
+}
+
+
 /// Checks if an interrupt has fired.
 ///
 /// Calls to this function should be sprinkled in strategic places through the
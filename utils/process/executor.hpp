@@ -215,6 +215,7 @@ public:
 
     exit_handle wait(const exec_handle);
     exit_handle wait_any(void);
+    utils::optional< exit_handle > wait_any(const datetime::delta&);
 
     void check_interrupt(void) const;
 };
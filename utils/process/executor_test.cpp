@@ -416,6 +416,27 @@ ATF_TEST_CASE_BODY(integration__run_one)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(integration__wait_any_timeout);
+ATF_TEST_CASE_BODY(integration__wait_any_timeout)
+{
+    executor::executor_handle handle = executor::setup();
+
+    const executor::exec_handle exec_handle = do_spawn(handle,
+                                                       child_sleep(1));
+
+    ATF_REQUIRE(!handle.wait_any(datetime::delta(0, 100000)));
+
+    optional< executor::exit_handle > exit_handle = handle.wait_any(
+        datetime::delta(60, 0));
+    ATF_REQUIRE(exit_handle);
+    ATF_REQUIRE_EQ(exec_handle.pid(), exit_handle.get().original_pid());
+    require_exit(EXIT_SUCCESS, exit_handle.get().status());
+    exit_handle.get().cleanup();
+
+    handle.cleanup();
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(integration__run_many);
 ATF_TEST_CASE_BODY(integration__run_many)
 {
@@ -945,6 +966,7 @@ ATF_TEST_CASE_BODY(integration__prevent_clobbering_control_files)
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, integration__run_one);
+    ATF_ADD_TEST_CASE(tcs, integration__wait_any_timeout);
     ATF_ADD_TEST_CASE(tcs, integration__run_many);
 
     ATF_ADD_TEST_CASE(tcs, integration__parameters_and_output);
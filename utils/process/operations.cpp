@@ -33,27 +33,37 @@ extern "C" {
 #include <sys/wait.h>
 
 #include <signal.h>
+#include <stdint.h>
 #include <unistd.h>
 }
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
 
+#include "utils/datetime.hpp"
 #include "utils/format/macros.hpp"
 #include "utils/fs/path.hpp"
 #include "utils/logging/macros.hpp"
+#include "utils/logging/operations.hpp"
+#include "utils/optional.ipp"
 #include "utils/process/exceptions.hpp"
 #include "utils/process/system.hpp"
 #include "utils/process/status.hpp"
 #include "utils/sanity.hpp"
 #include "utils/signals/interrupts.hpp"
 
+namespace datetime = utils::datetime;
 namespace fs = utils::fs;
+namespace logging = utils::logging;
 namespace process = utils::process;
 namespace signals = utils::signals;
 
+using utils::none;
+using utils::optional;
+
 
 /// Maximum number of arguments supported by exec.
 ///
@@ -63,6 +73,13 @@ namespace signals = utils::signals;
 #define MAX_ARGS 128
 
 
+/// Interval between checks for terminated processes in timed waits.
+///
+/// This is the maximum latency that a timed wait adds to the detection of the
+/// termination of a subprocess.
+static const int64_t wait_poll_usec = 10000;
+
+
 namespace {
 
 
@@ -75,6 +92,7 @@ static process::status
 safe_wait(void)
 {
     LD("Waiting for any child process");
+    logging::flush();
     int stat_loc;
     const pid_t pid = ::wait(&stat_loc);
     if (pid == -1) {
@@ -97,6 +115,7 @@ static process::status
 safe_waitpid(const pid_t pid)
 {
     LD(F("Waiting for pid=%s") % pid);
+    logging::flush();
     int stat_loc;
     if (process::detail::syscall_waitpid(pid, &stat_loc, 0) == -1) {
         const int original_errno = errno;
@@ -271,3 +290,42 @@ process::wait_any(void)
     }
     return status;
 }
+
+
+/// Waits for completion of any subprocess for a limited amount of time.
+///
+/// \param timeout Maximum amount of time to wait for.
+///
+/// \return The termination status of the child process that terminated, or
+/// none if no child process terminated before the timeout.
+///
+/// \throw process::system_error If the call to waitpid(2) fails.
+optional< process::status >
+process::wait_any(const datetime::delta& timeout)
+{
+    const datetime::timestamp deadline = datetime::timestamp::now() + timeout;
+    for (;;) {
+        int stat_loc;
+        const pid_t pid = process::detail::syscall_waitpid(-1, &stat_loc,
+                                                           WNOHANG);
+        if (pid == -1) {
+            const int original_errno = errno;
+            throw process::system_error("Failed to wait for any child process",
+                                        original_errno);
+        } else if (pid > 0) {
+            const process::status status(pid, stat_loc);
+            {
+                signals::interrupts_inhibiter inhibiter;
+                signals::remove_pid_to_kill(status.dead_pid());
+            }
+            return utils::make_optional(status);
+        }
+
+        const datetime::timestamp now = datetime::timestamp::now();
+        if (now >= deadline)
+            return none;
+        logging::flush();
+        ::usleep(static_cast< useconds_t >(
+            std::min((deadline - now).to_microseconds(), wait_poll_usec)));
+    }
+}
@@ -34,8 +34,10 @@
 
 #include "utils/process/operations_fwd.hpp"
 
+#include "utils/datetime_fwd.hpp"
 #include "utils/defs.hpp"
 #include "utils/fs/path_fwd.hpp"
+#include "utils/optional_fwd.hpp"
 #include "utils/process/status_fwd.hpp"
 
 namespace utils {
@@ -48,6 +50,7 @@ void terminate_group(const int);
 void terminate_self_with(const status&) UTILS_NORETURN;
 status wait(const int);
 status wait_any(void);
+optional< status > wait_any(const datetime::delta&);
 
 
 }  // namespace process
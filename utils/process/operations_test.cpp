@@ -41,17 +41,24 @@ extern "C" {
 
 #include <atf-c++.hpp>
 
+#include "utils/datetime.hpp"
 #include "utils/defs.hpp"
 #include "utils/format/containers.ipp"
 #include "utils/fs/path.hpp"
+#include "utils/logging/operations.hpp"
+#include "utils/optional.ipp"
 #include "utils/process/child.ipp"
 #include "utils/process/exceptions.hpp"
 #include "utils/process/status.hpp"
 #include "utils/stacktrace.hpp"
 
+namespace datetime = utils::datetime;
 namespace fs = utils::fs;
+namespace logging = utils::logging;
 namespace process = utils::process;
 
+using utils::optional;
+
 
 namespace {
 
@@ -116,6 +123,25 @@ child_exit(void)
 }
 
 
+static void child_await_log(void) UTILS_NORETURN;
+
+
+/// Body for a process that waits for its parent to write a log entry.
+///
+/// The process exits successfully once the test.log file contains the entry
+/// and fails if the entry does not show up within a few seconds.
+static void
+child_await_log(void)
+{
+    for (int i = 0; i < 50; ++i) {
+        if (atf::utils::grep_file("Pending entry", "test.log"))
+            std::exit(EXIT_SUCCESS);
+        ::usleep(100000);
+    }
+    std::exit(EXIT_FAILURE);
+}
+
+
 static void suspend(void) UTILS_NORETURN;
 
 
@@ -408,6 +434,23 @@ ATF_TEST_CASE_BODY(wait_any__one)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(wait_any__flushes_log);
+ATF_TEST_CASE_BODY(wait_any__flushes_log)
+{
+    logging::set_persistency("debug", fs::path("test.log"));
+    logging::set_buffered(true);
+    datetime::set_mock_now(2011, 2, 21, 18, 30, 0, 0);
+
+    process::child::fork_capture(child_await_log);
+    logging::log(logging::level_debug, "file", 1, "First entry");
+    logging::log(logging::level_debug, "file", 2, "Pending entry");
+
+    const process::status status = process::wait_any();
+    ATF_REQUIRE(status.exited());
+    ATF_REQUIRE_EQ(EXIT_SUCCESS, status.exitstatus());
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(wait_any__many);
 ATF_TEST_CASE_BODY(wait_any__many)
 {
@@ -443,6 +486,52 @@ ATF_TEST_CASE_BODY(wait_any__none_is_failure)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(wait_any__timeout__one);
+ATF_TEST_CASE_BODY(wait_any__timeout__one)
+{
+    process::child::fork_capture(child_exit< 15 >);
+
+    const optional< process::status > status = process::wait_any(
+        datetime::delta(60, 0));
+    ATF_REQUIRE(status);
+    ATF_REQUIRE(status.get().exited());
+    ATF_REQUIRE_EQ(15, status.get().exitstatus());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(wait_any__timeout__expired);
+ATF_TEST_CASE_BODY(wait_any__timeout__expired)
+{
+    std::auto_ptr< process::child > child = process::child::fork_capture(
+        suspend);
+
+    const datetime::timestamp start = datetime::timestamp::now();
+    ATF_REQUIRE(!process::wait_any(datetime::delta(0, 100000)));
+    ATF_REQUIRE(datetime::timestamp::now() - start >=
+                datetime::delta(0, 100000));
+
+    ATF_REQUIRE(::kill(child->pid(), SIGKILL) != -1);
+    const optional< process::status > status = process::wait_any(
+        datetime::delta(60, 0));
+    ATF_REQUIRE(status);
+    ATF_REQUIRE(status.get().signaled());
+    ATF_REQUIRE_EQ(SIGKILL, status.get().termsig());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(wait_any__timeout__none_is_failure);
+ATF_TEST_CASE_BODY(wait_any__timeout__none_is_failure)
+{
+    try {
+        (void)process::wait_any(datetime::delta(1, 0));
+        fail("Expected exception but none raised");
+    } catch (const process::system_error& e) {
+        ATF_REQUIRE(atf::utils::grep_string("Failed to wait", e.what()));
+        ATF_REQUIRE_EQ(ECHILD, e.original_errno());
+    }
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, exec__no_args);
@@ -464,6 +553,10 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, wait__fail);
 
     ATF_ADD_TEST_CASE(tcs, wait_any__one);
+    ATF_ADD_TEST_CASE(tcs, wait_any__flushes_log);
     ATF_ADD_TEST_CASE(tcs, wait_any__many);
     ATF_ADD_TEST_CASE(tcs, wait_any__none_is_failure);
+    ATF_ADD_TEST_CASE(tcs, wait_any__timeout__one);
+    ATF_ADD_TEST_CASE(tcs, wait_any__timeout__expired);
+    ATF_ADD_TEST_CASE(tcs, wait_any__timeout__none_is_failure);
 }
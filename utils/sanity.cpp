@@ -44,6 +44,7 @@ extern "C" {
 
 #include "utils/format/macros.hpp"
 #include "utils/logging/macros.hpp"
+#include "utils/logging/operations.hpp"
 
 
 namespace {
@@ -168,6 +169,7 @@ utils::sanity_failure(const assert_type type, const char* file,
         std::cerr << ": " << message << "\n";
     else
         std::cerr << "\n";
+    utils::logging::flush();
     std::abort();
 }
 
@@ -27,7 +27,7 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 /// \file utils/shared_ptr.hpp
-/// Compatibility header to import std::shared_ptr.
+/// Compatibility header to import std::shared_ptr and std::weak_ptr.
 
 #if !defined(UTILS_SHARED_PTR_HPP)
 #define UTILS_SHARED_PTR_HPP
@@ -40,6 +40,7 @@
 #   include <tr1/memory>
 namespace std {
     using tr1::shared_ptr;
+    using tr1::weak_ptr;
 }
 #endif
 
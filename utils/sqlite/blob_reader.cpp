@@ -0,0 +1,130 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "utils/sqlite/blob_reader.hpp"
+
+extern "C" {
+#include <sqlite3.h>
+}
+
+#include <algorithm>
+
+#include "utils/noncopyable.hpp"
+#include "utils/sanity.hpp"
+#include "utils/sqlite/database.hpp"
+#include "utils/sqlite/exceptions.hpp"
+
+namespace sqlite = utils::sqlite;
+
+
+/// Internal implementation for the BLOB reader.
+struct utils::sqlite::blob_reader::impl : utils::noncopyable {
+    /// The database this BLOB belongs to.
+    database& db;
+
+    /// The SQLite 3 internal BLOB handle.
+    ::sqlite3_blob* blob;
+
+    /// Size of the BLOB in bytes.
+    int size;
+
+    /// Constructor.
+    ///
+    /// \param db_ The database this BLOB belongs to.
+    /// \param blob_ The SQLite internal BLOB handle.
+    impl(database& db_, ::sqlite3_blob* blob_) :
+        db(db_),
+        blob(blob_),
+        size(::sqlite3_blob_bytes(blob_))
+    {
+    }
+
+    /// Destructor.
+    ~impl(void)
+    {
+        ::sqlite3_blob_close(blob);
+    }
+};
+
+
+/// Initializes a BLOB reader.
+///
+/// This is an internal function.  Use database::open_blob() to instantiate one
+/// of these objects.
+///
+/// \param db The database this BLOB belongs to.
+/// \param raw_blob A void pointer representing a SQLite native BLOB handle.
+sqlite::blob_reader::blob_reader(database& db, void* raw_blob) :
+    _pimpl(new impl(db, static_cast< ::sqlite3_blob* >(raw_blob)))
+{
+}
+
+
+/// Destructor for the BLOB reader.
+///
+/// The BLOB handle is released when the last copy of the reader goes away.
+sqlite::blob_reader::~blob_reader(void)
+{
+}
+
+
+/// Gets the size of the BLOB.
+///
+/// \return The size of the BLOB in bytes.
+int
+sqlite::blob_reader::size(void) const
+{
+    return _pimpl->size;
+}
+
+
+/// Copies a range of the BLOB into memory.
+///
+/// \param buffer The memory into which to copy the data.
+/// \param length The maximum number of bytes to copy.
+/// \param offset The position of the first byte to copy.  Must not exceed
+///     the size of the BLOB.
+///
+/// \return The number of bytes copied, which is less than length only if the
+/// end of the BLOB was reached.
+///
+/// \throw api_error If the data cannot be read.
+int
+sqlite::blob_reader::read(void* buffer, const int length, const int offset)
+{
+    PRE(length >= 0);
+    PRE(offset >= 0 && offset <= _pimpl->size);
+
+    const int count = std::min(length, _pimpl->size - offset);
+    if (count > 0) {
+        if (::sqlite3_blob_read(_pimpl->blob, buffer, count, offset) !=
+            SQLITE_OK)
+            throw api_error::from_database(_pimpl->db, "sqlite3_blob_read");
+    }
+    return count;
+}
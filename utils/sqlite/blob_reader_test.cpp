@@ -0,0 +1,141 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "utils/sqlite/blob_reader.hpp"
+
+#include <cstring>
+#include <string>
+
+#include <atf-c++.hpp>
+
+#include "utils/sqlite/database.hpp"
+#include "utils/sqlite/exceptions.hpp"
+#include "utils/sqlite/statement.ipp"
+#include "utils/sqlite/test_utils.hpp"
+
+namespace sqlite = utils::sqlite;
+
+
+namespace {
+
+
+/// Creates a table with a BLOB in a database.
+///
+/// \param db The database in which to create the table.
+/// \param contents The contents of the BLOB to store in the row with
+///     identifier 1.
+static void
+create_blob(sqlite::database& db, const std::string& contents)
+{
+    db.exec("CREATE TABLE t (id INTEGER PRIMARY KEY, contents BLOB)");
+    sqlite::statement stmt = db.create_statement(
+        "INSERT INTO t VALUES (1, :contents)");
+    stmt.bind(":contents", sqlite::blob(contents.c_str(), contents.length()));
+    stmt.step_without_results();
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read__all);
+ATF_TEST_CASE_BODY(read__all)
+{
+    sqlite::database db = sqlite::database::in_memory();
+    create_blob(db, "Some text");
+
+    sqlite::blob_reader reader = db.open_blob("t", "contents", 1);
+    ATF_REQUIRE_EQ(9, reader.size());
+    char buffer[16];
+    ATF_REQUIRE_EQ(9, reader.read(buffer, sizeof(buffer), 0));
+    ATF_REQUIRE_EQ("Some text", std::string(buffer, 9));
+    ATF_REQUIRE_EQ(0, reader.read(buffer, sizeof(buffer), 9));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read__chunks);
+ATF_TEST_CASE_BODY(read__chunks)
+{
+    sqlite::database db = sqlite::database::in_memory();
+    create_blob(db, "Some text");
+
+    sqlite::blob_reader reader = db.open_blob("t", "contents", 1);
+    char buffer[4];
+    ATF_REQUIRE_EQ(4, reader.read(buffer, sizeof(buffer), 0));
+    ATF_REQUIRE_EQ("Some", std::string(buffer, 4));
+    ATF_REQUIRE_EQ(4, reader.read(buffer, sizeof(buffer), 4));
+    ATF_REQUIRE_EQ(" tex", std::string(buffer, 4));
+    ATF_REQUIRE_EQ(1, reader.read(buffer, sizeof(buffer), 8));
+    ATF_REQUIRE_EQ('t', buffer[0]);
+    ATF_REQUIRE_EQ(2, reader.read(buffer, 2, 1));
+    ATF_REQUIRE_EQ("om", std::string(buffer, 2));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read__empty);
+ATF_TEST_CASE_BODY(read__empty)
+{
+    sqlite::database db = sqlite::database::in_memory();
+    create_blob(db, "");
+
+    sqlite::blob_reader reader = db.open_blob("t", "contents", 1);
+    ATF_REQUIRE_EQ(0, reader.size());
+    char buffer[4];
+    ATF_REQUIRE_EQ(0, reader.read(buffer, sizeof(buffer), 0));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(open_blob__missing_row);
+ATF_TEST_CASE_BODY(open_blob__missing_row)
+{
+    sqlite::database db = sqlite::database::in_memory();
+    create_blob(db, "Some text");
+
+    REQUIRE_API_ERROR("sqlite3_blob_open", db.open_blob("t", "contents", 2));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(open_blob__missing_column);
+ATF_TEST_CASE_BODY(open_blob__missing_column)
+{
+    sqlite::database db = sqlite::database::in_memory();
+    create_blob(db, "Some text");
+
+    REQUIRE_API_ERROR("sqlite3_blob_open", db.open_blob("t", "foo", 1));
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, read__all);
+    ATF_ADD_TEST_CASE(tcs, read__chunks);
+    ATF_ADD_TEST_CASE(tcs, read__empty);
+
+    ATF_ADD_TEST_CASE(tcs, open_blob__missing_row);
+    ATF_ADD_TEST_CASE(tcs, open_blob__missing_column);
+}
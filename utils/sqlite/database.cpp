@@ -41,6 +41,7 @@ extern "C" {
 #include "utils/noncopyable.hpp"
 #include "utils/optional.ipp"
 #include "utils/sanity.hpp"
+#include "utils/sqlite/blob_reader.hpp"
 #include "utils/sqlite/exceptions.hpp"
 #include "utils/sqlite/statement.ipp"
 #include "utils/sqlite/transaction.hpp"
@@ -318,6 +319,29 @@ sqlite::database::create_statement(const std::string& sql)
 }
 
 
+/// Opens a BLOB for incremental reading.
+///
+/// \param table The name of the table that holds the BLOB.
+/// \param column The name of the column that holds the BLOB.
+/// \param rowid The identifier of the row that holds the BLOB.
+///
+/// \return A reader for the BLOB.
+///
+/// \throw api_error If the BLOB cannot be opened; e.g. if the row does not
+///     exist or if the cell does not hold a BLOB.
+sqlite::blob_reader
+sqlite::database::open_blob(const std::string& table,
+                            const std::string& column, const int64_t rowid)
+{
+    sqlite3_blob* blob;
+    const int error = ::sqlite3_blob_open(_pimpl->db, "main", table.c_str(),
+                                          column.c_str(), rowid, 0, &blob);
+    if (error != SQLITE_OK)
+        throw api_error::from_database(*this, "sqlite3_blob_open");
+    return blob_reader(*this, static_cast< void* >(blob));
+}
+
+
 /// Returns the row identifier of the last insert.
 ///
 /// \return A row identifier.
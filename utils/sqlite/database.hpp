@@ -42,10 +42,12 @@ extern "C" {
 }
 
 #include <cstddef>
+#include <string>
 
 #include "utils/fs/path_fwd.hpp"
 #include "utils/optional_fwd.hpp"
 #include "utils/shared_ptr.hpp"
+#include "utils/sqlite/blob_reader_fwd.hpp"
 #include "utils/sqlite/c_gate_fwd.hpp"
 #include "utils/sqlite/statement_fwd.hpp"
 #include "utils/sqlite/transaction_fwd.hpp"
@@ -100,6 +102,8 @@ public:
 
     transaction begin_transaction(void);
     statement create_statement(const std::string&);
+    blob_reader open_blob(const std::string&, const std::string&,
+                          const int64_t);
 
     int64_t last_insert_rowid(void);
 };
@@ -28,6 +28,7 @@
 
 #include "utils/text/operations.ipp"
 
+#include <istream>
 #include <sstream>
 
 #include "utils/format/macros.hpp"
@@ -36,10 +37,49 @@
 namespace text = utils::text;
 
 
-/// Replaces XML special characters from an input string.
+namespace {
+
+
+/// Lookup table of the characters that cannot appear verbatim in XML.
 ///
 /// The list of XML special characters is specified here:
 ///     http://www.w3.org/TR/xml11/#charsets
+class xml_special_characters {
+    /// Whether each character has to be replaced or not.
+    bool _special[256];
+
+public:
+    /// Constructs the lookup table.
+    xml_special_characters(void)
+    {
+        for (unsigned int c = 0; c < 256; ++c) {
+            _special[c] = (c == '"' || c == '&' || c == '<' || c == '>' ||
+                           c == '\'' ||
+                           (c >= 0x01 && c <= 0x08) ||
+                           (c >= 0x0B && c <= 0x0C) ||
+                           (c >= 0x0E && c <= 0x1F) ||
+                           (c >= 0x7F && c <= 0x84) ||
+                           (c >= 0x86 && c <= 0x9F));
+        }
+    }
+
+    /// Checks whether a character has to be replaced.
+    ///
+    /// \param c The character to check.
+    ///
+    /// \return True if the character cannot appear verbatim in XML.
+    bool
+    operator()(const unsigned char c) const
+    {
+        return _special[c];
+    }
+};
+
+
+}  // anonymous namespace
+
+
+/// Replaces XML special characters from an input string.
 ///
 /// \param in The input to quote.
 ///
@@ -48,36 +88,80 @@ std::string
 text::escape_xml(const std::string& in)
 {
     std::ostringstream quoted;
+    escape_xml(quoted, in);
+    return quoted.str();
+}
+
 
-    for (std::string::const_iterator it = in.begin();
-         it != in.end(); ++it) {
-        unsigned char c = (unsigned char)*it;
-        if (c == '"') {
-            quoted << "&quot;";
-        } else if (c == '&') {
-            quoted << "&amp;";
-        } else if (c == '<') {
-            quoted << "&lt;";
-        } else if (c == '>') {
-            quoted << "&gt;";
-        } else if (c == '\'') {
-            quoted << "&apos;";
-        } else if ((c >= 0x01 && c <= 0x08) ||
-                   (c >= 0x0B && c <= 0x0C) ||
-                   (c >= 0x0E && c <= 0x1F) ||
-                   (c >= 0x7F && c <= 0x84) ||
-                   (c >= 0x86 && c <= 0x9F)) {
-            // for RestrictedChar characters, escape them
-            // as '&amp;#[decimal ASCII value];'
-            // so that in the XML file we will see the escaped
-            // character.
-            quoted << "&amp;#" << static_cast< std::string::size_type >(*it)
-                   << ";";
-        } else {
-            quoted << *it;
+/// Writes a block of memory to a stream replacing XML special characters.
+///
+/// The input is processed in blocks: the longest run of characters that do not
+/// need escaping is located with a table lookup per character and is then
+/// written to the stream in one go.  Escaping large inputs, such as the output
+/// of test cases, is therefore dominated by the scan and not by the stream.
+///
+/// \param output The stream to write the quoted data to.
+/// \param begin The first character of the input to quote.
+/// \param end The position after the last character of the input to quote.
+static void
+escape_xml_block(std::ostream& output, const char* begin, const char* end)
+{
+    static const xml_special_characters is_special;
+
+    const char* block = begin;
+    const char* iter = block;
+    for (;;) {
+        while (iter != end && !is_special(static_cast< unsigned char >(*iter)))
+            ++iter;
+        output.write(block, iter - block);
+        if (iter == end)
+            break;
+
+        const unsigned char c = static_cast< unsigned char >(*iter);
+        switch (c) {
+        case '"': output << "&quot;"; break;
+        case '&': output << "&amp;"; break;
+        case '<': output << "&lt;"; break;
+        case '>': output << "&gt;"; break;
+        case '\'': output << "&apos;"; break;
+        default:
+            // For RestrictedChar characters, escape them as
+            // '&amp;#[decimal ASCII value];' so that in the XML file we will
+            // see the escaped character.
+            output << "&amp;#" << static_cast< unsigned int >(c) << ";";
         }
+        block = ++iter;
+    }
+}
+
+
+/// Writes a string to a stream replacing XML special characters.
+///
+/// \param output The stream to write the quoted string to.
+/// \param in The input to quote.
+void
+text::escape_xml(std::ostream& output, const std::string& in)
+{
+    escape_xml_block(output, in.data(), in.data() + in.length());
+}
+
+
+/// Copies a stream to another one replacing XML special characters.
+///
+/// The input is consumed in fixed-size chunks, so this runs in bounded memory
+/// regardless of the size of the input.
+///
+/// \param output The stream to write the quoted data to.
+/// \param input The stream to read the data to quote from.  It is read until
+///     its end.
+void
+text::escape_xml(std::ostream& output, std::istream& input)
+{
+    char buffer[64 * 1024];
+    while (input.good()) {
+        input.read(buffer, sizeof(buffer));
+        escape_xml_block(output, buffer, buffer + input.gcount());
     }
-    return quoted.str();
 }
 
 
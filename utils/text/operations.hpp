@@ -33,6 +33,8 @@
 #define UTILS_TEXT_OPERATIONS_HPP
 
 #include <cstddef>
+#include <istream>
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -41,6 +43,8 @@ namespace text {
 
 
 std::string escape_xml(const std::string&);
+void escape_xml(std::ostream&, const std::string&);
+void escape_xml(std::ostream&, std::istream&);
 std::string quote(const std::string&, const char);
 
 
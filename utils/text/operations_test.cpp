@@ -30,6 +30,7 @@
 
 #include <iostream>
 #include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -93,6 +94,61 @@ ATF_TEST_CASE_BODY(escape_xml__some_escaping)
     ATF_REQUIRE_EQ("&amp;&amp;&amp;", text::escape_xml("&&&"));
     ATF_REQUIRE_EQ("&amp;#8;&amp;#11;", text::escape_xml("\b\v"));
     ATF_REQUIRE_EQ("\t&amp;#127;BAR&amp;", text::escape_xml("\t\x7f""BAR&"));
+    ATF_REQUIRE_EQ("&amp;#128;\x85&amp;#159;\xa0",
+                   text::escape_xml("\x80\x85\x9f\xa0"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(escape_xml__stream);
+ATF_TEST_CASE_BODY(escape_xml__stream)
+{
+    std::ostringstream output;
+    output << "<a>";
+    text::escape_xml(output, "");
+    text::escape_xml(output, "foo \"bar& <tag> yay' baz");
+    text::escape_xml(output, "\b");
+    output << "</a>";
+    ATF_REQUIRE_EQ("<a>foo &quot;bar&amp; &lt;tag&gt; yay&apos; baz"
+                   "&amp;#8;</a>", output.str());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(escape_xml__istream);
+ATF_TEST_CASE_BODY(escape_xml__istream)
+{
+    std::string input;
+    std::string exp_output;
+    for (int i = 0; i < 10000; ++i) {
+        input += "A line with <special> characters & more\n";
+        exp_output += "A line with &lt;special&gt; characters &amp; more\n";
+    }
+
+    std::istringstream in(input);
+    std::ostringstream out;
+    text::escape_xml(out, in);
+    ATF_REQUIRE(exp_output == out.str());
+
+    std::istringstream empty_in("");
+    std::ostringstream empty_out;
+    text::escape_xml(empty_out, empty_in);
+    ATF_REQUIRE(empty_out.str().empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(escape_xml__large);
+ATF_TEST_CASE_BODY(escape_xml__large)
+{
+    std::string input;
+    std::string exp_output;
+    for (int i = 0; i < 10000; ++i) {
+        input += "Some long line of text without special characters\n";
+        exp_output += "Some long line of text without special characters\n";
+        if (i % 100 == 0) {
+            input += "<&>";
+            exp_output += "&lt;&amp;&gt;";
+        }
+    }
+    ATF_REQUIRE(exp_output == text::escape_xml(input));
 }
 
 
@@ -398,6 +454,9 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, escape_xml__empty);
     ATF_ADD_TEST_CASE(tcs, escape_xml__no_escaping);
     ATF_ADD_TEST_CASE(tcs, escape_xml__some_escaping);
+    ATF_ADD_TEST_CASE(tcs, escape_xml__stream);
+    ATF_ADD_TEST_CASE(tcs, escape_xml__istream);
+    ATF_ADD_TEST_CASE(tcs, escape_xml__large);
 
     ATF_ADD_TEST_CASE(tcs, quote__empty);
     ATF_ADD_TEST_CASE(tcs, quote__no_escaping);
@@ -29,8 +29,8 @@
 #include "utils/text/templates.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <fstream>
-#include <sstream>
 #include <stack>
 
 #include "utils/format/macros.hpp"
@@ -203,323 +203,354 @@ public:
 statement_def::types_map statement_def::_types;
 
 
-/// Definition of a loop.
-///
-/// This simple structure is used to keep track of the parameters of a loop.
-struct loop_def {
-    /// The name of the vector over which this loop is iterating.
-    std::string vector;
+/// Prefix that marks a line as a statement.
+static const char* statement_prefix = "%";
 
-    /// The name of the iterator defined by this loop.
-    std::string iterator;
 
-    /// Position in the input to which to rewind to on looping.
-    ///
-    /// This position points to the line after the loop statement, not the loop
-    /// itself.  This is one of the reasons why we have this structure, so that
-    /// we can maintain the data about the loop without having to re-process it.
-    std::istream::pos_type position;
+/// Delimiter to surround an expression instantiation.
+static const char* expression_delimiter = "%%";
+
+
+/// Amount of output to accumulate before writing it to the output stream.
+static const std::string::size_type output_buffer_size = 64 * 1024;
+
+
+/// Fragment of a text block: either literal text or an expression.
+struct segment {
+    /// Whether this segment is an expression to evaluate.
+    bool is_expression;
+
+    /// The literal text or the expression without its delimiters.
+    std::string text;
 
-    /// Constructs a new loop definition.
+    /// Constructs a new segment.
     ///
-    /// \param vector_ The name of the vector (first argument).
-    /// \param iterator_ The name of the iterator (second argumnet).
-    /// \param position_ Position of the next line after the loop statement.
-    loop_def(const std::string& vector_, const std::string& iterator_,
-             const std::istream::pos_type position_) :
-        vector(vector_), iterator(iterator_), position(position_)
+    /// \param is_expression_ Whether the segment is an expression.
+    /// \param text_ The literal text or the expression.
+    segment(const bool is_expression_, const std::string& text_) :
+        is_expression(is_expression_), text(text_)
     {
     }
 };
 
 
-/// Stateful class to instantiate the templates in an input stream.
+/// Instruction of a compiled template.
 ///
-/// The goal of this parser is to scan the input once and not buffer anything in
-/// memory.  The only exception are loops: loops are reinterpreted on every
-/// iteration from the same input file by rewidining the stream to the
-/// appropriate position.
-class templates_parser : utils::noncopyable {
-    /// The templates to apply.
-    ///
-    /// Note that this is not const because the parser has to have write access
-    /// to the templates.  In particular, it needs to be able to define the
-    /// iterators as regular variables.
-    text::templates_def _templates;
+/// A compiled template is a flat sequence of these nodes.  Control flow
+/// statements refer to their matching statements by index so that rendering
+/// never has to search for them.
+struct node {
+    /// Types of the nodes.
+    enum node_type {
+        /// Consecutive lines of text, possibly with expressions in them.
+        type_text,
 
-    /// Prefix that marks a line as a statement.
-    const std::string _prefix;
+        /// Beginning of a conditional.  jump points to the matching else, if
+        /// any, or to the matching endif.
+        type_if,
 
-    /// Delimiter to surround an expression instantiation.
-    const std::string _delimiter;
+        /// Alternative clause of a conditional.  jump points to the matching
+        /// endif.
+        type_else,
 
-    /// Whether to skip incoming lines or not.
-    ///
-    /// The top of the stack is true whenever we encounter a conditional that
-    /// evaluates to false or a loop that does not have any iterations left.
-    /// Under these circumstances, we need to continue scanning the input stream
-    /// until we find the matching closing endif or endloop construct.
-    ///
-    /// This is a stack rather than a plain boolean to allow us deal with
-    /// if-else clauses.
-    std::stack< bool > _skip;
+        /// End of conditional marker.
+        type_endif,
 
-    /// Current count of nested conditionals.
-    unsigned int _if_level;
+        /// Beginning of a loop.  jump points to the matching endloop.
+        type_loop,
 
-    /// Level of the top-most conditional that evaluated to false.
-    unsigned int _exit_if_level;
+        /// End of loop marker.  jump points to the matching loop.
+        type_endloop,
+    };
 
-    /// Current count of nested loops.
-    unsigned int _loop_level;
+    /// The type of the node.
+    node_type type;
 
-    /// Level of the top-most loop that does not have any iterations left.
-    unsigned int _exit_loop_level;
+    /// Contents of a text node.
+    std::vector< segment > segments;
 
-    /// Information about all the nested loops up to the current point.
-    std::stack< loop_def > _loops;
+    /// Expression of a conditional or vector name of a loop.
+    std::string arg0;
 
-    /// Checks if a line is a statement or not.
-    ///
-    /// \param line The line to validate.
-    ///
-    /// \return True if the line looks like a statement, which is determined by
-    /// checking if the line starts by the predefined prefix.
-    bool
-    is_statement(const std::string& line)
-    {
-        return ((line.length() >= _prefix.length() &&
-                 line.substr(0, _prefix.length()) == _prefix) &&
-                (line.length() < _delimiter.length() ||
-                 line.substr(0, _delimiter.length()) != _delimiter));
-    }
+    /// Iterator name of a loop.
+    std::string arg1;
 
-    /// Parses a given statement line into a statement definition.
-    ///
-    /// \param line The line to validate; it must be a valid statement.
-    ///
-    /// \return The parsed statement.
+    /// Index of the related node for control flow nodes.
+    std::size_t jump;
+
+    /// Constructs a new node.
     ///
-    /// \throw text::syntax_error If the input is not a valid statement.
-    statement_def
-    parse_statement(const std::string& line)
+    /// \param type_ The type of the node.
+    explicit node(const node_type type_) : type(type_), jump(0)
     {
-        PRE(is_statement(line));
-        return statement_def::parse(line.substr(_prefix.length()));
     }
+};
 
-    /// Processes a line from the input when not in skip mode.
-    ///
-    /// \param line The line to be processed.
-    /// \param input The input stream from which the line was read.  The current
-    ///     position in the stream must be after the line being processed.
-    /// \param output The output stream into which to write the results.
-    ///
-    /// \throw text::syntax_error If the input is not valid.
-    void
-    handle_normal(const std::string& line, std::istream& input,
-                  std::ostream& output)
-    {
-        if (!is_statement(line)) {
-            // Fast path.  Mostly to avoid an indentation level for the big
-            // chunk of code below.
-            output << line << '\n';
-            return;
-        }
 
-        const statement_def statement = parse_statement(line);
+/// Collection of nodes forming a compiled template.
+typedef std::vector< node > nodes_vector;
 
-        switch (statement.type) {
-        case statement_def::type_else:
-            _skip.top() = !_skip.top();
-            break;
 
-        case statement_def::type_endif:
-            _if_level--;
+/// Appends a literal string to a text node.
+///
+/// \param [in,out] text The text node to modify.
+/// \param literal The string to append.
+static void
+append_literal(node& text, const std::string& literal)
+{
+    if (literal.empty())
+        return;
+    if (!text.segments.empty() && !text.segments.back().is_expression)
+        text.segments.back().text += literal;
+    else
+        text.segments.push_back(segment(false, literal));
+}
+
+
+/// Splits a line of text into literals and expressions.
+///
+/// An expression is surrounded by expression_delimiter on both sides.  Lonely
+/// or unbalanced appearances of the delimiter on the input line are not
+/// considered an error, given that the user may actually want to supply that
+/// character sequence without being interpreted as a template.
+///
+/// \param line The input line, without its trailing newline.
+/// \param [in,out] text The text node to which to append the line.
+static void
+compile_text(const std::string& line, node& text)
+{
+    const std::string delimiter = expression_delimiter;
+
+    std::string::size_type last_pos = 0;
+    for (;;) {
+        const std::string::size_type open_pos = line.find(delimiter, last_pos);
+        if (open_pos == std::string::npos)
+            break;
+        const std::string::size_type close_pos = line.find(
+            delimiter, open_pos + delimiter.length());
+        if (close_pos == std::string::npos)
             break;
 
-        case statement_def::type_endloop: {
-            PRE(_loops.size() == _loop_level);
-            loop_def& loop = _loops.top();
+        append_literal(text, line.substr(last_pos, open_pos - last_pos));
+        text.segments.push_back(segment(true, line.substr(
+            open_pos + delimiter.length(),
+            close_pos - open_pos - delimiter.length())));
+        last_pos = close_pos + delimiter.length();
+    }
+    append_literal(text, line.substr(last_pos) + '\n');
+}
 
-            const std::size_t next_index = 1 + text::to_type< std::size_t >(
-                _templates.get_variable(loop.iterator));
 
-            if (next_index < _templates.get_vector(loop.vector).size()) {
-                _templates.add_variable(loop.iterator, F("%s") % next_index);
-                input.seekg(loop.position);
-            } else {
-                _loop_level--;
-                _loops.pop();
-                _templates.remove_variable(loop.iterator);
-            }
-        } break;
+/// Checks if a line is a statement or not.
+///
+/// \param line The line to validate.
+///
+/// \return True if the line looks like a statement, which is determined by
+/// checking if the line starts by the statement prefix but not by the
+/// expression delimiter.
+static bool
+is_statement(const std::string& line)
+{
+    const std::string prefix = statement_prefix;
+    const std::string delimiter = expression_delimiter;
+    return ((line.length() >= prefix.length() &&
+             line.compare(0, prefix.length(), prefix) == 0) &&
+            (line.length() < delimiter.length() ||
+             line.compare(0, delimiter.length(), delimiter) != 0));
+}
+
+
+/// Parses a template into a sequence of nodes.
+///
+/// \param input The template to parse.
+///
+/// \return The nodes of the compiled template.
+///
+/// \throw text::syntax_error If the template is not valid.
+static nodes_vector
+compile_nodes(std::istream& input)
+{
+    nodes_vector nodes;
+
+    // Indexes of the if, else and loop nodes that have not been closed yet.
+    std::stack< std::size_t > open;
 
+    std::string line;
+    while (std::getline(input, line).good()) {
+        if (!is_statement(line)) {
+            if (nodes.empty() || nodes.back().type != node::type_text)
+                nodes.push_back(node(node::type_text));
+            compile_text(line, nodes.back());
+            continue;
+        }
+
+        const statement_def statement = statement_def::parse(
+            line.substr(std::strlen(statement_prefix)));
+        switch (statement.type) {
         case statement_def::type_if: {
-            _if_level++;
-            const std::string value = _templates.evaluate(
-                statement.arguments[0]);
-            if (value.empty() || value == "0" || value == "false") {
-                _exit_if_level = _if_level;
-                _skip.push(true);
-            } else {
-                _skip.push(false);
-            }
+            node if_node(node::type_if);
+            if_node.arg0 = statement.arguments[0];
+            open.push(nodes.size());
+            nodes.push_back(if_node);
+        } break;
+
+        case statement_def::type_else: {
+            if (open.empty() || nodes[open.top()].type != node::type_if)
+                throw text::syntax_error("Unexpected 'else'");
+            nodes[open.top()].jump = nodes.size();
+            open.pop();
+            open.push(nodes.size());
+            nodes.push_back(node(node::type_else));
+        } break;
+
+        case statement_def::type_endif: {
+            if (open.empty() || (nodes[open.top()].type != node::type_if &&
+                                 nodes[open.top()].type != node::type_else))
+                throw text::syntax_error("Unexpected 'endif'");
+            nodes[open.top()].jump = nodes.size();
+            open.pop();
+            nodes.push_back(node(node::type_endif));
         } break;
 
         case statement_def::type_loop: {
-            _loop_level++;
+            node loop_node(node::type_loop);
+            loop_node.arg0 = statement.arguments[0];
+            loop_node.arg1 = statement.arguments[1];
+            open.push(nodes.size());
+            nodes.push_back(loop_node);
+        } break;
 
-            const loop_def loop(statement.arguments[0], statement.arguments[1],
-                                input.tellg());
-            if (_templates.get_vector(loop.vector).empty()) {
-                _exit_loop_level = _loop_level;
-                _skip.push(true);
-            } else {
-                _templates.add_variable(loop.iterator, "0");
-                _loops.push(loop);
-                _skip.push(false);
-            }
+        case statement_def::type_endloop: {
+            if (open.empty() || nodes[open.top()].type != node::type_loop)
+                throw text::syntax_error("Unexpected 'endloop'");
+            node& loop_node = nodes[open.top()];
+            loop_node.jump = nodes.size();
+
+            node endloop_node(node::type_endloop);
+            endloop_node.arg0 = loop_node.arg0;
+            endloop_node.arg1 = loop_node.arg1;
+            endloop_node.jump = open.top();
+            open.pop();
+            nodes.push_back(endloop_node);
         } break;
         }
     }
 
-    /// Processes a line from the input when in skip mode.
+    if (!open.empty())
+        throw text::syntax_error(F("Unterminated '%s'") %
+                                 (nodes[open.top()].type == node::type_loop ?
+                                  "loop" : "if"));
+
+    return nodes;
+}
+
+
+/// Output sink that writes to a stream in large chunks.
+class buffered_writer : utils::noncopyable {
+    /// The stream into which to write the output.
+    std::ostream& _output;
+
+    /// Output accumulated but not yet written.
+    std::string _buffer;
+
+public:
+    /// Constructor.
     ///
-    /// \param line The line to be processed.
+    /// \param output_ The stream into which to write the output.
+    explicit buffered_writer(std::ostream& output_) : _output(output_)
+    {
+        _buffer.reserve(output_buffer_size);
+    }
+
+    /// Appends text to the output.
     ///
-    /// \throw text::syntax_error If the input is not valid.
+    /// \param text The text to append.
     void
-    handle_skip(const std::string& line)
+    write(const std::string& text)
     {
-        PRE(_skip.top());
+        _buffer += text;
+        if (_buffer.length() >= output_buffer_size)
+            flush();
+    }
 
-        if (!is_statement(line))
-            return;
+    /// Writes any pending output to the stream.
+    void
+    flush(void)
+    {
+        _output.write(_buffer.data(), _buffer.length());
+        _buffer.clear();
+    }
+};
 
-        const statement_def statement = parse_statement(line);
-        switch (statement.type) {
-        case statement_def::type_else:
-            if (_exit_if_level == _if_level)
-                _skip.top() = !_skip.top();
-            break;
 
-        case statement_def::type_endif:
-            INV(_if_level >= _exit_if_level);
-            if (_if_level == _exit_if_level)
-                _skip.top() = false;
-            _if_level--;
-            _skip.pop();
+/// Renders a compiled template.
+///
+/// \param nodes The compiled template.
+/// \param templates The templates to apply.  Loop iterators are defined in
+///     here as regular variables while the loops run.
+/// \param writer The sink into which to write the results.
+///
+/// \throw text::syntax_error If any expression cannot be evaluated.
+static void
+render(const nodes_vector& nodes, text::templates_def& templates,
+       buffered_writer& writer)
+{
+    std::size_t pc = 0;
+    while (pc < nodes.size()) {
+        const node& current = nodes[pc];
+        switch (current.type) {
+        case node::type_text:
+            for (std::vector< segment >::const_iterator iter =
+                     current.segments.begin();
+                 iter != current.segments.end(); ++iter) {
+                if ((*iter).is_expression)
+                    writer.write(templates.evaluate((*iter).text));
+                else
+                    writer.write((*iter).text);
+            }
+            ++pc;
             break;
 
-        case statement_def::type_endloop:
-            INV(_loop_level >= _exit_loop_level);
-            if (_loop_level == _exit_loop_level)
-                _skip.top() = false;
-            _loop_level--;
-            _skip.pop();
-            break;
+        case node::type_if: {
+            const std::string value = templates.evaluate(current.arg0);
+            if (value.empty() || value == "0" || value == "false")
+                pc = current.jump + 1;
+            else
+                ++pc;
+        } break;
 
-        case statement_def::type_if:
-            _if_level++;
-            _skip.push(true);
+        case node::type_else:
+            // Only reached at the end of the taken branch of the conditional.
+            pc = current.jump + 1;
             break;
 
-        case statement_def::type_loop:
-            _loop_level++;
-            _skip.push(true);
+        case node::type_endif:
+            ++pc;
             break;
 
-        default:
+        case node::type_loop:
+            if (templates.get_vector(current.arg0).empty()) {
+                pc = current.jump + 1;
+            } else {
+                templates.add_variable(current.arg1, "0");
+                ++pc;
+            }
             break;
-        }
-    }
 
-    /// Evaluates expressions on a given input line.
-    ///
-    /// An expression is surrounded by _delimiter on both sides.  We scan the
-    /// string from left to right finding any expressions that may appear, yank
-    /// them out and call templates_def::evaluate() to get their value.
-    ///
-    /// Lonely or unbalanced appearances of _delimiter on the input line are
-    /// not considered an error, given that the user may actually want to supply
-    /// that character sequence without being interpreted as a template.
-    ///
-    /// \param in_line The input line from which to evaluate expressions.
-    ///
-    /// \return The evaluated line.
-    ///
-    /// \throw text::syntax_error If the expressions in the line are malformed.
-    std::string
-    evaluate(const std::string& in_line)
-    {
-        std::string out_line;
-
-        std::string::size_type last_pos = 0;
-        while (last_pos != std::string::npos) {
-            const std::string::size_type open_pos = in_line.find(
-                _delimiter, last_pos);
-            if (open_pos == std::string::npos) {
-                out_line += in_line.substr(last_pos);
-                last_pos = std::string::npos;
+        case node::type_endloop: {
+            const std::size_t next_index = 1 + text::to_type< std::size_t >(
+                templates.get_variable(current.arg1));
+            if (next_index < templates.get_vector(current.arg0).size()) {
+                templates.add_variable(current.arg1, F("%s") % next_index);
+                pc = current.jump + 1;
             } else {
-                const std::string::size_type close_pos = in_line.find(
-                    _delimiter, open_pos + _delimiter.length());
-                if (close_pos == std::string::npos) {
-                    out_line += in_line.substr(last_pos);
-                    last_pos = std::string::npos;
-                } else {
-                    out_line += in_line.substr(last_pos, open_pos - last_pos);
-                    out_line += _templates.evaluate(in_line.substr(
-                        open_pos + _delimiter.length(),
-                        close_pos - open_pos - _delimiter.length()));
-                    last_pos = close_pos + _delimiter.length();
-                }
+                templates.remove_variable(current.arg1);
+                ++pc;
             }
-        }
-
-        return out_line;
-    }
-
-public:
-    /// Constructs a new template parser.
-    ///
-    /// \param templates_ The templates to apply to the processed file.
-    /// \param prefix_ The prefix that identifies lines as statements.
-    /// \param delimiter_ Delimiter to surround a variable instantiation.
-    templates_parser(const text::templates_def& templates_,
-                     const std::string& prefix_,
-                     const std::string& delimiter_) :
-        _templates(templates_),
-        _prefix(prefix_),
-        _delimiter(delimiter_),
-        _if_level(0),
-        _exit_if_level(0),
-        _loop_level(0),
-        _exit_loop_level(0)
-    {
-    }
-
-    /// Applies the templates to a given input.
-    ///
-    /// \param input The stream to which to apply the templates.
-    /// \param output The stream into which to write the results.
-    ///
-    /// \throw text::syntax_error If the input is not valid.  Note that the
-    ///     is not guaranteed to be unmodified on exit if an error is
-    ///     encountered.
-    void
-    instantiate(std::istream& input, std::ostream& output)
-    {
-        std::string line;
-        while (std::getline(input, line).good()) {
-            if (!_skip.empty() && _skip.top())
-                handle_skip(line);
-            else
-                handle_normal(evaluate(line), input, output);
+        } break;
         }
     }
-};
+}
 
 
 }  // anonymous namespace
@@ -724,8 +755,130 @@ text::templates_def::evaluate(const std::string& expression) const
 }
 
 
+/// Internal implementation of a compiled template.
+struct text::compiled_template::impl : utils::noncopyable {
+    /// The instructions of the template.
+    nodes_vector nodes;
+
+    /// Whether the template has any loops.
+    ///
+    /// Templates without loops do not need to define iterators, so they can be
+    /// rendered without copying the caller's templates.
+    bool has_loops;
+
+    /// Constructor.
+    ///
+    /// \param nodes_ The instructions of the template.
+    explicit impl(const nodes_vector& nodes_) :
+        nodes(nodes_), has_loops(false)
+    {
+        for (nodes_vector::const_iterator iter = nodes.begin();
+             iter != nodes.end(); ++iter) {
+            if ((*iter).type == node::type_loop)
+                has_loops = true;
+        }
+    }
+};
+
+
+/// Constructs a new compiled template.
+///
+/// \param pimpl_ Reference-counted pointer to the shared implementation.
+text::compiled_template::compiled_template(std::shared_ptr< impl > pimpl_) :
+    _pimpl(pimpl_)
+{
+}
+
+
+/// Destructor.
+text::compiled_template::~compiled_template(void)
+{
+}
+
+
+/// Parses a template.
+///
+/// Statements are recognized before any expressions are evaluated, so the
+/// structure of the template is fixed once compiled.
+///
+/// \param input The template to parse.
+///
+/// \return The compiled template.
+///
+/// \throw text::syntax_error If the template is not valid.
+text::compiled_template
+text::compiled_template::compile(std::istream& input)
+{
+    return compiled_template(std::shared_ptr< impl >(
+        new impl(compile_nodes(input))));
+}
+
+
+/// Parses a template stored in a file.
+///
+/// \param input_file The path to the template to parse.
+///
+/// \return The compiled template.
+///
+/// \throw text::error If the input file cannot be opened.
+/// \throw text::syntax_error If the template is not valid.
+text::compiled_template
+text::compiled_template::compile(const fs::path& input_file)
+{
+    std::ifstream input(input_file.c_str());
+    if (!input)
+        throw text::error(F("Failed to open %s for read") % input_file);
+    return compile(input);
+}
+
+
+/// Applies a set of templates to this template.
+///
+/// \param templates The templates to use.
+/// \param output The stream to which to write the processed text.  Note that
+///     the output is buffered internally and written in large chunks.
+///
+/// \throw text::syntax_error If there is any problem evaluating the templates.
+///     The output may be incomplete in this case.
+void
+text::compiled_template::instantiate(const templates_def& templates,
+                                     std::ostream& output) const
+{
+    buffered_writer writer(output);
+    if (_pimpl->has_loops) {
+        templates_def scoped_templates = templates;
+        render(_pimpl->nodes, scoped_templates, writer);
+    } else {
+        // The templates are only modified to define loop iterators.
+        render(_pimpl->nodes, const_cast< templates_def& >(templates), writer);
+    }
+    writer.flush();
+}
+
+
+/// Applies a set of templates to this template and writes an output file.
+///
+/// \param templates The templates to use.
+/// \param output_file The path to the file into which to write the output.
+///
+/// \throw text::error If the output file cannot be opened.
+/// \throw text::syntax_error If there is any problem evaluating the templates.
+void
+text::compiled_template::instantiate(const templates_def& templates,
+                                     const fs::path& output_file) const
+{
+    std::ofstream output(output_file.c_str());
+    if (!output)
+        throw text::error(F("Failed to open %s for write") % output_file);
+    instantiate(templates, output);
+}
+
+
 /// Applies a set of templates to an input stream.
 ///
+/// Callers that process the same input multiple times should use
+/// compiled_template instead to parse the input only once.
+///
 /// \param templates The templates to use.
 /// \param input The input to process.
 /// \param output The stream to which to write the processed text.
@@ -735,8 +888,7 @@ void
 text::instantiate(const templates_def& templates,
                   std::istream& input, std::ostream& output)
 {
-    templates_parser parser(templates, "%", "%%");
-    parser.instantiate(input, output);
+    compiled_template::compile(input).instantiate(templates, output);
 }
 
 
@@ -752,13 +904,5 @@ void
 text::instantiate(const templates_def& templates,
                   const fs::path& input_file, const fs::path& output_file)
 {
-    std::ifstream input(input_file.c_str());
-    if (!input)
-        throw text::error(F("Failed to open %s for read") % input_file);
-
-    std::ofstream output(output_file.c_str());
-    if (!output)
-        throw text::error(F("Failed to open %s for write") % output_file);
-
-    instantiate(templates, input, output);
+    compiled_template::compile(input_file).instantiate(templates, output_file);
 }
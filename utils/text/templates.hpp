@@ -63,6 +63,7 @@
 #include <vector>
 
 #include "utils/fs/path_fwd.hpp"
+#include "utils/shared_ptr.hpp"
 
 namespace utils {
 namespace text {
@@ -112,6 +113,30 @@ public:
 };
 
 
+/// Template parsed into a form that can be instantiated repeatedly.
+///
+/// Parsing a template is more expensive than applying a set of templates to
+/// it, so callers that generate many documents out of the same template should
+/// compile it once and reuse the compiled form.
+class compiled_template {
+    struct impl;
+
+    /// Pointer to shared implementation.
+    std::shared_ptr< impl > _pimpl;
+
+    compiled_template(std::shared_ptr< impl >);
+
+public:
+    ~compiled_template(void);
+
+    static compiled_template compile(std::istream&);
+    static compiled_template compile(const fs::path&);
+
+    void instantiate(const templates_def&, std::ostream&) const;
+    void instantiate(const templates_def&, const fs::path&) const;
+};
+
+
 void instantiate(const templates_def&, std::istream&, std::ostream&);
 void instantiate(const templates_def&, const fs::path&, const fs::path&);
 
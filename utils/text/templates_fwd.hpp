@@ -36,6 +36,7 @@ namespace utils {
 namespace text {
 
 
+class compiled_template;
 class templates_def;
 
 
@@ -30,6 +30,7 @@
 
 #include <fstream>
 #include <sstream>
+#include <string>
 
 #include <atf-c++.hpp>
 
@@ -899,6 +900,117 @@ ATF_TEST_CASE_BODY(instantiate__invalid_narguments)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(instantiate__unexpected_statement);
+ATF_TEST_CASE_BODY(instantiate__unexpected_statement)
+{
+    do_test_fail(text::templates_def(), "%else\n", "Unexpected 'else'");
+    do_test_fail(text::templates_def(), "%endif\n", "Unexpected 'endif'");
+    do_test_fail(text::templates_def(), "%endloop\n", "Unexpected 'endloop'");
+    do_test_fail(text::templates_def(), "%if a\n%endloop\n",
+                 "Unexpected 'endloop'");
+    do_test_fail(text::templates_def(), "%loop a i\n%else\n",
+                 "Unexpected 'else'");
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(instantiate__unterminated_statement);
+ATF_TEST_CASE_BODY(instantiate__unterminated_statement)
+{
+    do_test_fail(text::templates_def(), "%if a\n", "Unterminated 'if'");
+    do_test_fail(text::templates_def(), "%if a\n%else\n",
+                 "Unterminated 'if'");
+    do_test_fail(text::templates_def(), "%loop a i\n", "Unterminated 'loop'");
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(compiled_template__reuse);
+ATF_TEST_CASE_BODY(compiled_template__reuse)
+{
+    std::istringstream input(
+        "Title: %%title%%\n"
+        "%if defined(subtitle)\n"
+        "Subtitle: %%subtitle%%\n"
+        "%endif\n"
+        "%loop items i\n"
+        "* %%items(i)%%\n"
+        "%endloop\n");
+    const text::compiled_template compiled =
+        text::compiled_template::compile(input);
+
+    {
+        text::templates_def templates;
+        templates.add_variable("title", "first");
+        templates.add_vector("items");
+        templates.add_to_vector("items", "a");
+        templates.add_to_vector("items", "b");
+
+        std::ostringstream output;
+        compiled.instantiate(templates, output);
+        ATF_REQUIRE_EQ("Title: first\n* a\n* b\n", output.str());
+        ATF_REQUIRE(!templates.exists("i"));
+    }
+
+    {
+        text::templates_def templates;
+        templates.add_variable("title", "second");
+        templates.add_variable("subtitle", "more");
+        templates.add_vector("items");
+
+        std::ostringstream output;
+        compiled.instantiate(templates, output);
+        ATF_REQUIRE_EQ("Title: second\nSubtitle: more\n", output.str());
+    }
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(compiled_template__large_output);
+ATF_TEST_CASE_BODY(compiled_template__large_output)
+{
+    std::istringstream input(
+        "%loop items i\n"
+        "%%items(i)%%\n"
+        "%endloop\n");
+    const text::compiled_template compiled =
+        text::compiled_template::compile(input);
+
+    const std::string item(1000, 'x');
+    text::templates_def templates;
+    templates.add_vector("items");
+    for (int i = 0; i < 1000; ++i)
+        templates.add_to_vector("items", item);
+
+    std::ostringstream output;
+    compiled.instantiate(templates, output);
+
+    std::string exp_output;
+    for (int i = 0; i < 1000; ++i)
+        exp_output += item + "\n";
+    ATF_REQUIRE(exp_output == output.str());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(compiled_template__files);
+ATF_TEST_CASE_BODY(compiled_template__files)
+{
+    atf::utils::create_file("input.txt", "The string is: %%string%%\n");
+    const text::compiled_template compiled =
+        text::compiled_template::compile(fs::path("input.txt"));
+
+    // Modifying the template must not affect the compiled version.
+    atf::utils::create_file("input.txt", "Something else\n");
+
+    text::templates_def templates;
+    templates.add_variable("string", "Hello, world!");
+    compiled.instantiate(templates, fs::path("output.txt"));
+    ATF_REQUIRE(atf::utils::compare_file(
+        "output.txt", "The string is: Hello, world!\n"));
+
+    ATF_REQUIRE_THROW_RE(text::error, "Failed to open missing.txt for read",
+                         text::compiled_template::compile(
+                             fs::path("missing.txt")));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(instantiate__files__ok);
 ATF_TEST_CASE_BODY(instantiate__files__ok)
 {
@@ -994,6 +1106,12 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, instantiate__empty_statement);
     ATF_ADD_TEST_CASE(tcs, instantiate__unknown_statement);
     ATF_ADD_TEST_CASE(tcs, instantiate__invalid_narguments);
+    ATF_ADD_TEST_CASE(tcs, instantiate__unexpected_statement);
+    ATF_ADD_TEST_CASE(tcs, instantiate__unterminated_statement);
+
+    ATF_ADD_TEST_CASE(tcs, compiled_template__reuse);
+    ATF_ADD_TEST_CASE(tcs, compiled_template__large_output);
+    ATF_ADD_TEST_CASE(tcs, compiled_template__files);
 
     ATF_ADD_TEST_CASE(tcs, instantiate__files__ok);
     ATF_ADD_TEST_CASE(tcs, instantiate__files__input_error);